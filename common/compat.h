@@ -0,0 +1,122 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+#ifndef _COMPAT_H
+#define	_COMPAT_H
+
+/*
+ * The illumos definitions that the code in this directory and the tools using
+ * it rely on, for building them on Linux to play captures back (see iocap.h
+ * and the tools' makefiles).  Besides the basic types, that's the part of
+ * libnvpair.h that describes a packed nvlist, which is all pnvl.c needs: the
+ * values are the ones in the packed buffers, so they must match illumos.  On
+ * illumos this is empty.
+ */
+#ifndef	__sun
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <sys/types.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+typedef unsigned char uchar_t;
+typedef unsigned int uint_t;
+typedef unsigned long ulong_t;
+typedef long long longlong_t;
+typedef unsigned long long u_longlong_t;
+typedef enum { B_FALSE = 0, B_TRUE = 1 } boolean_t;
+typedef longlong_t hrtime_t;
+
+#define	NANOSEC			1000000000LL
+
+#define	NV_VERSION		0
+#define	NV_ENCODE_NATIVE	0
+#define	NV_ENCODE_XDR		1
+#define	NV_UNIQUE_NAME		0x1
+#define	NV_UNIQUE_NAME_TYPE	0x2
+
+typedef enum {
+	DATA_TYPE_DONTCARE = -1,
+	DATA_TYPE_UNKNOWN = 0,
+	DATA_TYPE_BOOLEAN,
+	DATA_TYPE_BYTE,
+	DATA_TYPE_INT16,
+	DATA_TYPE_UINT16,
+	DATA_TYPE_INT32,
+	DATA_TYPE_UINT32,
+	DATA_TYPE_INT64,
+	DATA_TYPE_UINT64,
+	DATA_TYPE_STRING,
+	DATA_TYPE_BYTE_ARRAY,
+	DATA_TYPE_INT16_ARRAY,
+	DATA_TYPE_UINT16_ARRAY,
+	DATA_TYPE_INT32_ARRAY,
+	DATA_TYPE_UINT32_ARRAY,
+	DATA_TYPE_INT64_ARRAY,
+	DATA_TYPE_UINT64_ARRAY,
+	DATA_TYPE_STRING_ARRAY,
+	DATA_TYPE_HRTIME,
+	DATA_TYPE_NVLIST,
+	DATA_TYPE_NVLIST_ARRAY,
+	DATA_TYPE_BOOLEAN_VALUE,
+	DATA_TYPE_INT8,
+	DATA_TYPE_UINT8,
+	DATA_TYPE_BOOLEAN_ARRAY,
+	DATA_TYPE_INT8_ARRAY,
+	DATA_TYPE_UINT8_ARRAY,
+	DATA_TYPE_DOUBLE
+} data_type_t;
+
+static inline hrtime_t
+gethrtime(void)
+{
+	struct timespec ts;
+
+	(void) clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((hrtime_t)ts.tv_sec * NANOSEC + ts.tv_nsec);
+}
+
+static inline void
+atomic_inc_64(volatile uint64_t *target)
+{
+	(void) __atomic_add_fetch(target, 1, __ATOMIC_SEQ_CST);
+}
+
+static inline uint64_t
+atomic_inc_64_nv(volatile uint64_t *target)
+{
+	return (__atomic_add_fetch(target, 1, __ATOMIC_SEQ_CST));
+}
+
+#if defined(__GLIBC__) && !__GLIBC_PREREQ(2, 38)
+static inline size_t
+strlcpy(char *dst, const char *src, size_t len)
+{
+	size_t slen = strlen(src);
+
+	if (len != 0) {
+		size_t n = slen < len ? slen : len - 1;
+
+		(void) memcpy(dst, src, n);
+		dst[n] = '\0';
+	}
+	return (slen);
+}
+#endif
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* !__sun */
+
+#endif	/* _COMPAT_H */
@@ -0,0 +1,343 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+/*
+ * Recording and playing back ioctls (see iocap.h).
+ *
+ * A capture file is an iocap_hdr_t followed by one record per ioctl, each an
+ * iocap_rec_t, then the argument structure as it was when the ioctl returned,
+ * then the part of its data buffer that the ioctl filled in, padded out to a
+ * multiple of 8 bytes.  Everything is in the byte order of the system that
+ * recorded it, and the argument structures are copied as they are, so a
+ * capture can only be played back by a build with the same structure layout:
+ * the same byte order and the same pointer size, both of which are checked.
+ * errno values are recorded as numbers, so a failure recorded on one OS may be
+ * reported as a different error when played back on another.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifdef	__sun
+#include <stropts.h>
+#elif !defined(IOCAP_PLAYBACK_ONLY)
+#include <sys/ioctl.h>
+#endif
+
+#include "iocap.h"
+
+#define	IOCAP_MAGIC	0x494f4341	/* "IOCA" */
+#define	IOCAP_CIGAM	0x41434f49	/* the same, byte-swapped */
+#define	IOCAP_VERSION	1
+#define	IOCAP_ALIGN(x)	(((x) + 7) & ~(uint64_t)7)
+
+typedef struct iocap_hdr {
+	uint32_t ich_magic;		/* IOCAP_MAGIC */
+	uint16_t ich_version;		/* IOCAP_VERSION */
+	uint8_t ich_ptrsz;		/* sizeof (void *) when recorded */
+	uint8_t ich_pad[9];
+} iocap_hdr_t;
+
+typedef struct iocap_rec {
+	uint32_t icr_cmd;		/* ioctl command */
+	int32_t icr_rv;			/* what ioctl() returned */
+	int32_t icr_errno;		/* errno, if it failed */
+	uint32_t icr_argsz;		/* size of argument structure */
+	uint64_t icr_datalen;		/* bytes of data buffer recorded */
+} iocap_rec_t;
+
+struct iocap {
+	int ic_fd;			/* device, unless playing back */
+	FILE *ic_out;			/* capture being recorded */
+	int ic_err;			/* first error writing ic_out */
+	char *ic_buf;			/* capture being played back */
+	const char **ic_recs;		/* its records */
+	size_t ic_nrecs;		/* number of records */
+	size_t ic_next;			/* next record to play back */
+	pthread_mutex_t ic_lock;	/* protects ic_out and ic_next */
+};
+
+static uint64_t
+iocap_getlen(const void *lenp, size_t lensz)
+{
+	uint32_t len32;
+	uint64_t len64;
+
+	if (lensz == sizeof (len32)) {
+		(void) memcpy(&len32, lenp, sizeof (len32));
+		return (len32);
+	}
+	(void) memcpy(&len64, lenp, sizeof (len64));
+	return (len64);
+}
+
+/*
+ * Read a capture file into memory and index its records.
+ */
+static int
+iocap_load(iocap_t *ic, const char *file)
+{
+	iocap_hdr_t hdr;
+	iocap_rec_t rec;
+	struct stat st;
+	const char *p, *end;
+	size_t n, len;
+	ssize_t rv;
+	int fd, err, pass;
+
+	if ((fd = open(file, O_RDONLY)) < 0)
+		return (errno);
+	if (fstat(fd, &st) != 0 || (ic->ic_buf = malloc(st.st_size)) == NULL) {
+		err = errno;
+		(void) close(fd);
+		return (err);
+	}
+	for (len = 0; len < (size_t)st.st_size; len += rv) {
+		if ((rv = read(fd, ic->ic_buf + len, st.st_size - len)) <= 0) {
+			err = rv < 0 ? errno : EINVAL;
+			(void) close(fd);
+			return (err);
+		}
+	}
+	(void) close(fd);
+
+	if (len < sizeof (hdr))
+		return (EINVAL);
+	(void) memcpy(&hdr, ic->ic_buf, sizeof (hdr));
+	if (hdr.ich_magic != IOCAP_MAGIC) {
+		return (hdr.ich_magic == IOCAP_CIGAM ? ENOTSUP : EINVAL);
+	}
+	if (hdr.ich_version != IOCAP_VERSION ||
+	    hdr.ich_ptrsz != sizeof (void *))
+		return (ENOTSUP);
+
+	/*
+	 * The first pass checks and counts the records, the second indexes
+	 * them.
+	 */
+	end = ic->ic_buf + len;
+	for (pass = 0; pass < 2; pass++) {
+		p = ic->ic_buf + sizeof (hdr);
+		for (n = 0; p < end; n++) {
+			if ((size_t)(end - p) < sizeof (rec))
+				return (EINVAL);
+			(void) memcpy(&rec, p, sizeof (rec));
+			len = end - p - sizeof (rec);
+			if (rec.icr_argsz > len ||
+			    rec.icr_datalen > len - rec.icr_argsz)
+				return (EINVAL);
+			if (pass == 1)
+				ic->ic_recs[n] = p;
+			len = sizeof (rec) + rec.icr_argsz + rec.icr_datalen;
+			p += MIN(IOCAP_ALIGN(len), (size_t)(end - p));
+		}
+		if (n == 0)
+			return (EINVAL);
+		if (pass == 0 &&
+		    (ic->ic_recs = calloc(n, sizeof (char *))) == NULL)
+			return (errno);
+		ic->ic_nrecs = n;
+	}
+	return (0);
+}
+
+/*
+ * Open the device, or, if replay is given, the capture to play back in its
+ * place.  If record is given, every ioctl is recorded to it.
+ */
+iocap_t *
+iocap_open(const char *dev, int oflag, const char *record, const char *replay)
+{
+	iocap_t *ic;
+	int err;
+
+	if (record != NULL && replay != NULL) {
+		errno = EINVAL;
+		return (NULL);
+	}
+	if ((ic = calloc(1, sizeof (iocap_t))) == NULL)
+		return (NULL);
+	ic->ic_fd = -1;
+	(void) pthread_mutex_init(&ic->ic_lock, NULL);
+
+	if (replay != NULL) {
+		if ((err = iocap_load(ic, replay)) != 0)
+			goto fail;
+		return (ic);
+	}
+
+#ifdef	IOCAP_PLAYBACK_ONLY
+	(void) dev;
+	(void) oflag;
+	err = ENOTSUP;
+	goto fail;
+#else
+	if ((ic->ic_fd = open(dev, oflag)) < 0) {
+		err = errno;
+		goto fail;
+	}
+	if (record != NULL) {
+		iocap_hdr_t hdr = { 0 };
+
+		hdr.ich_magic = IOCAP_MAGIC;
+		hdr.ich_version = IOCAP_VERSION;
+		hdr.ich_ptrsz = sizeof (void *);
+		if ((ic->ic_out = fopen(record, "w")) == NULL ||
+		    fwrite(&hdr, sizeof (hdr), 1, ic->ic_out) != 1) {
+			err = errno;
+			goto fail;
+		}
+	}
+	return (ic);
+#endif
+
+fail:
+	(void) iocap_close(ic);
+	errno = err;
+	return (NULL);
+}
+
+static void
+iocap_record(iocap_t *ic, int cmd, int rv, int err, const void *arg,
+    size_t argsz, const void *data, size_t datalen)
+{
+	static const char pad[8];
+	iocap_rec_t rec;
+	size_t len = sizeof (rec) + argsz + datalen;
+
+	rec.icr_cmd = (uint32_t)cmd;
+	rec.icr_rv = rv;
+	rec.icr_errno = rv < 0 ? err : 0;
+	rec.icr_argsz = (uint32_t)argsz;
+	rec.icr_datalen = datalen;
+
+	(void) pthread_mutex_lock(&ic->ic_lock);
+	if (ic->ic_err == 0 &&
+	    (fwrite(&rec, sizeof (rec), 1, ic->ic_out) != 1 ||
+	    fwrite(arg, 1, argsz, ic->ic_out) != argsz ||
+	    (datalen > 0 &&
+	    fwrite(data, 1, datalen, ic->ic_out) != datalen) ||
+	    fwrite(pad, 1, IOCAP_ALIGN(len) - len, ic->ic_out) !=
+	    IOCAP_ALIGN(len) - len))
+		ic->ic_err = errno != 0 ? errno : EIO;
+	(void) pthread_mutex_unlock(&ic->ic_lock);
+}
+
+static int
+iocap_replay(iocap_t *ic, int cmd, void *arg, size_t argsz, void **bufp,
+    uint64_t bufsz)
+{
+	iocap_rec_t rec;
+	const char *p;
+	void *buf;
+
+	(void) pthread_mutex_lock(&ic->ic_lock);
+	p = ic->ic_recs[ic->ic_next];
+	if (++ic->ic_next == ic->ic_nrecs)
+		ic->ic_next = 0;
+	(void) pthread_mutex_unlock(&ic->ic_lock);
+
+	(void) memcpy(&rec, p, sizeof (rec));
+	if (rec.icr_cmd != (uint32_t)cmd || rec.icr_argsz != argsz) {
+		errno = EPROTO;
+		return (-1);
+	}
+	if (rec.icr_rv < 0) {
+		errno = rec.icr_errno;
+		return (rec.icr_rv);
+	}
+	buf = bufp != NULL ? *bufp : NULL;
+	if (rec.icr_datalen > 0 && (buf == NULL || rec.icr_datalen > bufsz)) {
+		errno = EOVERFLOW;
+		return (-1);
+	}
+
+	/*
+	 * The recorded argument points at the recording process's buffer, so
+	 * the caller's own is put back.
+	 */
+	(void) memcpy(arg, p + sizeof (rec), argsz);
+	if (bufp != NULL)
+		*bufp = buf;
+	if (rec.icr_datalen > 0)
+		(void) memcpy(buf, p + sizeof (rec) + argsz, rec.icr_datalen);
+	return (rec.icr_rv);
+}
+
+/*
+ * Issue an ioctl, or play back the next one recorded.  arg is the argument
+ * structure, of argsz bytes, and bufp, lenp and lensz describe its data
+ * buffer, if any (see IOCAP_BUF()).  Returns what ioctl() would.
+ */
+int
+iocap_ioctl(iocap_t *ic, int cmd, void *arg, size_t argsz, void **bufp,
+    void *lenp, size_t lensz)
+{
+	uint64_t bufsz = 0, datalen = 0;
+	int rv, err;
+
+	if (bufp != NULL) {
+		if (lensz != sizeof (uint32_t) && lensz != sizeof (uint64_t)) {
+			errno = EINVAL;
+			return (-1);
+		}
+		bufsz = iocap_getlen(lenp, lensz);
+	}
+	if (ic->ic_recs != NULL)
+		return (iocap_replay(ic, cmd, arg, argsz, bufp, bufsz));
+
+#ifdef	IOCAP_PLAYBACK_ONLY
+	rv = -1;
+	err = ENOTSUP;
+#else
+	rv = ioctl(ic->ic_fd, cmd, arg);
+	err = errno;
+#endif
+	if (ic->ic_out != NULL) {
+		if (rv >= 0 && bufp != NULL && *bufp != NULL)
+			datalen = MIN(iocap_getlen(lenp, lensz), bufsz);
+		iocap_record(ic, cmd, rv, err, arg, argsz,
+		    bufp != NULL ? *bufp : NULL, datalen);
+	}
+	errno = err;
+	return (rv);
+}
+
+/*
+ * Close the device or capture.  A failure to write any part of a recording is
+ * reported here.
+ */
+int
+iocap_close(iocap_t *ic)
+{
+	int err = 0;
+
+	if (ic->ic_fd >= 0)
+		(void) close(ic->ic_fd);
+	if (ic->ic_out != NULL) {
+		err = ic->ic_err;
+		if (fclose(ic->ic_out) != 0 && err == 0)
+			err = errno;
+	}
+	(void) pthread_mutex_destroy(&ic->ic_lock);
+	free(ic->ic_recs);
+	free(ic->ic_buf);
+	free(ic);
+	if (err != 0) {
+		errno = err;
+		return (-1);
+	}
+	return (0);
+}
@@ -0,0 +1,53 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+#ifndef _IOCAP_H
+#define	_IOCAP_H
+
+/*
+ * A thin layer between the tools and the device they issue ioctls to, which
+ * can record every ioctl and its result to a capture file, or play a capture
+ * back in place of the device, so the code that decodes and prints the output
+ * can be run (and timed) without the device, or the system, it came from.
+ *
+ * An ioctl argument is a fixed-size structure that may point to one data
+ * buffer, whose size is in another member of the structure: on the way in it's
+ * the size of the buffer, and on the way out how much of it was filled in.
+ * IOCAP_BUF() names those two members for iocap_ioctl(), and IOCAP_NOBUF is
+ * used for an ioctl without one.
+ *
+ * Playback hands out the recorded ioctls in order, starting over from the
+ * first once they run out, and fails with EPROTO if the request doesn't match
+ * the one recorded.  It's safe to issue ioctls from several threads at once.
+ *
+ * Built with IOCAP_PLAYBACK_ONLY, as the tools are on Linux, there's no device
+ * to talk to: iocap_open() fails with ENOTSUP unless it's given a capture to
+ * play back.
+ */
+
+#include <sys/types.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+typedef struct iocap iocap_t;
+
+#define	IOCAP_BUF(buf, len)	((void **)&(buf)), &(len), sizeof (len)
+#define	IOCAP_NOBUF		NULL, NULL, 0
+
+extern iocap_t *iocap_open(const char *, int, const char *, const char *);
+extern int iocap_ioctl(iocap_t *, int, void *, size_t, void **, void *,
+    size_t);
+extern int iocap_close(iocap_t *);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _IOCAP_H */
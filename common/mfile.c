@@ -0,0 +1,126 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+/*
+ * Write and map files that are used in place; see mfile.h.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "mfile.h"
+
+/*
+ * Write size bytes to a temporary file next to the given path and rename it
+ * into place.
+ */
+int
+mfile_write(const void *buf, size_t size, const char *path)
+{
+	char tmp[PATH_MAX];
+	const char *p = buf;
+	size_t resid = size;
+	ssize_t n;
+	int fd;
+
+	if ((size_t)snprintf(tmp, sizeof (tmp), "%s.XXXXXX", path) >=
+	    sizeof (tmp)) {
+		(void) fprintf(stderr, "%s: path too long\n", path);
+		return (-1);
+	}
+	if ((fd = mkstemp(tmp)) < 0) {
+		(void) fprintf(stderr, "failed to create %s (%s)\n", tmp,
+		    strerror(errno));
+		return (-1);
+	}
+	while (resid > 0) {
+		if ((n = write(fd, p, resid)) < 0) {
+			if (errno == EINTR)
+				continue;
+			(void) fprintf(stderr, "failed to write %s (%s)\n",
+			    tmp, strerror(errno));
+			goto err;
+		}
+		p += n;
+		resid -= n;
+	}
+	if (fchmod(fd, 0644) != 0 || fsync(fd) != 0) {
+		(void) fprintf(stderr, "failed to sync %s (%s)\n", tmp,
+		    strerror(errno));
+		goto err;
+	}
+	if (rename(tmp, path) != 0) {
+		(void) fprintf(stderr, "failed to rename %s to %s (%s)\n", tmp,
+		    path, strerror(errno));
+		goto err;
+	}
+	(void) close(fd);
+	return (0);
+err:
+	(void) close(fd);
+	(void) unlink(tmp);
+	return (-1);
+}
+
+/*
+ * Map a file written by mfile_write().  It must be at least minsize bytes
+ * long, and check() is given the mapping and its size and must return 0 if
+ * it's valid.
+ */
+int
+mfile_open(const char *path, const char *what, size_t minsize,
+    int (*check)(const void *, size_t), void **addrp)
+{
+	struct stat st;
+	void *addr;
+	int fd;
+
+	if ((fd = open(path, O_RDONLY)) < 0) {
+		(void) fprintf(stderr, "failed to open %s (%s)\n", path,
+		    strerror(errno));
+		return (-1);
+	}
+	if (fstat(fd, &st) != 0) {
+		(void) fprintf(stderr, "failed to stat %s (%s)\n", path,
+		    strerror(errno));
+		(void) close(fd);
+		return (-1);
+	}
+	if ((size_t)st.st_size < minsize) {
+		(void) fprintf(stderr, "%s: not a %s\n", path, what);
+		(void) close(fd);
+		return (-1);
+	}
+	addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	(void) close(fd);
+	if (addr == MAP_FAILED) {
+		(void) fprintf(stderr, "failed to map %s (%s)\n", path,
+		    strerror(errno));
+		return (-1);
+	}
+	if (check(addr, st.st_size) != 0) {
+		(void) fprintf(stderr, "%s: not a valid %s\n", path, what);
+		(void) munmap(addr, st.st_size);
+		return (-1);
+	}
+	*addrp = addr;
+	return (0);
+}
+
+void
+mfile_close(void *addr, size_t size)
+{
+	(void) munmap(addr, size);
+}
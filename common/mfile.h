@@ -0,0 +1,43 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+#ifndef _MFILE_H
+#define	_MFILE_H
+
+/*
+ * Files that are built in memory, written out whole and then mmap'd and used
+ * as-is, like fmdev's CPU table and gen-diagcode's index.  mfile_write()
+ * replaces the file atomically, so that readers never see a partial one.
+ * mfile_open() maps it and has the caller's check function validate it before
+ * returning it, so that nothing else needs to be careful of what's in it.
+ * Errors are reported on stderr, naming the file as "a <what>".
+ */
+
+#include <sys/types.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/*
+ * For check functions: whether an array of n elements of sz bytes at offset
+ * off is 8-byte aligned and lies within a file of size bytes.
+ */
+#define	MFILE_FITS(off, n, sz, size)	\
+	((off) % 8 == 0 && (off) <= (size) && (n) <= ((size) - (off)) / (sz))
+
+extern int mfile_write(const void *, size_t, const char *);
+extern int mfile_open(const char *, const char *, size_t,
+    int (*)(const void *, size_t), void **);
+extern void mfile_close(void *, size_t);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _MFILE_H */
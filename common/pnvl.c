@@ -0,0 +1,739 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+/*
+ * Read packed nvlists in place; see pnvl.h.
+ *
+ * A packed nvlist is a 4-byte header (encoding, byte order and two reserved
+ * bytes) followed by the top-level nvlist.  Each nvlist, top-level or
+ * embedded, is its version and nvflag as two 32-bit words, then its pairs,
+ * then an end marker.  The two encodings differ in how a pair is laid out:
+ *
+ *   native	A copy of the in-memory nvpair_t: a 32-bit total size (a
+ *		multiple of 8), 16-bit name size, 16 reserved bits, 32-bit
+ *		element count and 32-bit type, then the NUL-terminated name
+ *		and, 8-byte aligned, the value in host byte order.  An embedded
+ *		nvlist (or nvlist array) value is only a placeholder nvlist_t
+ *		(or array of pointers and nvlist_t's): the nvlists themselves
+ *		follow the pair.  String arrays are a placeholder array of
+ *		pointers followed by the strings.  The end marker is a 32-bit
+ *		zero.
+ *
+ *   XDR	Big-endian 32-bit words: the encoded size of the pair (which
+ *		covers any nvlists embedded in it), its decoded size, the name
+ *		as an XDR string (length, then bytes padded to 4), the type and
+ *		the element count, then the value.  Values narrower than 32
+ *		bits take 32, arrays other than byte arrays start with their
+ *		element count, and string and nvlist arrays are simply their
+ *		elements one after the other.  The end marker is two zero words.
+ *
+ * XDR pairs are skipped by their encoded size.  Native pairs that embed
+ * nvlists can only be skipped by walking those nvlists.
+ */
+#include <errno.h>
+#ifdef	__sun
+#include <libnvpair.h>
+#endif
+#include <stdint.h>
+#include <string.h>
+
+#include "pnvl.h"
+
+#define	PNVL_MAXDEPTH	20	/* as nvpair_max_recursion */
+#define	PNVL_NVP_SIZE	16	/* sizeof (nvpair_t) */
+#define	PNVL_NVL_SIZE	24	/* sizeof (nvlist_t) */
+#define	PNVL_PTR_SIZE	8	/* placeholder pointers are 64 bits */
+#define	PNVL_ALIGN4(x)	(((x) + 3) & ~(size_t)3)
+#define	PNVL_ALIGN8(x)	(((x) + 7) & ~(size_t)7)
+
+#define	PNVL_ISXDR(nvl)	((nvl)->pn_encoding == NV_ENCODE_XDR)
+
+static uint32_t
+pnvl_get32(const pnvl_t *nvl, const uchar_t *p)
+{
+	uint32_t v;
+
+	if (PNVL_ISXDR(nvl)) {
+		return (((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+		    ((uint32_t)p[2] << 8) | p[3]);
+	}
+	(void) memcpy(&v, p, sizeof (v));
+	return (v);
+}
+
+static uint64_t
+pnvl_get64(const pnvl_t *nvl, const uchar_t *p)
+{
+	uint64_t v;
+
+	if (PNVL_ISXDR(nvl)) {
+		return (((uint64_t)pnvl_get32(nvl, p) << 32) |
+		    pnvl_get32(nvl, p + 4));
+	}
+	(void) memcpy(&v, p, sizeof (v));
+	return (v);
+}
+
+/*
+ * Set up a cursor for the nvlist that starts at p, below the given one.
+ */
+static int
+pnvl_nvlist_at(const pnvl_t *parent, const uchar_t *p, uint_t depth,
+    pnvl_t *nvl)
+{
+	if (depth > PNVL_MAXDEPTH)
+		return (EFAULT);
+	if (p > parent->pn_end || parent->pn_end - p < 8)
+		return (EFAULT);
+
+	nvl->pn_end = parent->pn_end;
+	nvl->pn_encoding = parent->pn_encoding;
+	nvl->pn_depth = depth;
+	nvl->pn_version = (int32_t)pnvl_get32(parent, p);
+	nvl->pn_nvflag = pnvl_get32(parent, p + 4);
+	nvl->pn_pairs = p + 8;
+	if (nvl->pn_version != NV_VERSION)
+		return (ENOTSUP);
+	return (0);
+}
+
+int
+pnvl_init(pnvl_t *nvl, const void *buf, size_t len)
+{
+	const uchar_t *p = buf;
+	uint16_t one = 1;
+	uint8_t host_endian = *(uint8_t *)&one;
+
+	if (len < 4)
+		return (EFAULT);
+	if (p[0] != NV_ENCODE_NATIVE && p[0] != NV_ENCODE_XDR)
+		return (ENOTSUP);
+	if (p[0] == NV_ENCODE_NATIVE && p[1] != host_endian)
+		return (ENOTSUP);
+
+	nvl->pn_end = p + len;
+	nvl->pn_encoding = p[0];
+	return (pnvl_nvlist_at(nvl, p + 4, 0, nvl));
+}
+
+static int pnvl_skip(const pnvl_t *, const uchar_t **);
+
+/*
+ * Skip the n nvlists that start at p, returning the end of the last.
+ */
+static int
+pnvl_skip_n(const pnvl_t *parent, const uchar_t *p, uint_t n,
+    const uchar_t **endp)
+{
+	pnvl_t nvl;
+	int err;
+
+	for (; n > 0; n--) {
+		if ((err = pnvl_nvlist_at(parent, p, parent->pn_depth + 1,
+		    &nvl)) != 0 || (err = pnvl_skip(&nvl, &p)) != 0)
+			return (err);
+	}
+	*endp = p;
+	return (0);
+}
+
+/*
+ * Decode the pair that starts at p.  At the end marker, return ENOENT with
+ * pp_next pointing just past it.
+ */
+static int
+pnvl_pair_at(pnvl_pair_t *pp, const uchar_t *p)
+{
+	const pnvl_t *nvl = &pp->pp_nvl;
+	size_t avail = nvl->pn_end - p, size, namesz;
+	int16_t nsz;
+
+	pp->pp_pair = p;
+	if (!PNVL_ISXDR(nvl)) {
+		if (avail < 4)
+			return (EFAULT);
+		if ((size = pnvl_get32(nvl, p)) == 0) {
+			pp->pp_next = p + 4;
+			return (ENOENT);
+		}
+		if (size < PNVL_NVP_SIZE || size > avail || size % 8 != 0)
+			return (EFAULT);
+
+		(void) memcpy(&nsz, p + 4, sizeof (nsz));
+		pp->pp_nelem = pnvl_get32(nvl, p + 8);
+		pp->pp_type = (data_type_t)pnvl_get32(nvl, p + 12);
+		if (nsz < 1 || PNVL_NVP_SIZE + (size_t)nsz > size ||
+		    p[PNVL_NVP_SIZE + nsz - 1] != '\0')
+			return (EFAULT);
+		pp->pp_name = (const char *)p + PNVL_NVP_SIZE;
+		pp->pp_namelen = nsz - 1;
+		pp->pp_value = p + PNVL_ALIGN8(PNVL_NVP_SIZE + (size_t)nsz);
+		pp->pp_vend = p + size;
+		if (pp->pp_value > pp->pp_vend)
+			return (EFAULT);
+
+		switch (pp->pp_type) {
+		case DATA_TYPE_NVLIST:
+			return (pnvl_skip_n(nvl, pp->pp_vend, 1,
+			    &pp->pp_next));
+		case DATA_TYPE_NVLIST_ARRAY:
+			return (pnvl_skip_n(nvl, pp->pp_vend, pp->pp_nelem,
+			    &pp->pp_next));
+		default:
+			pp->pp_next = pp->pp_vend;
+			return (0);
+		}
+	}
+
+	if (avail < 8)
+		return (EFAULT);
+	size = pnvl_get32(nvl, p);
+	if (size == 0 && pnvl_get32(nvl, p + 4) == 0) {
+		pp->pp_next = p + 8;
+		return (ENOENT);
+	}
+	if (size < 24 || size > avail || size % 4 != 0)
+		return (EFAULT);
+	namesz = pnvl_get32(nvl, p + 8);
+	if (namesz > size - 20 || 20 + PNVL_ALIGN4(namesz) > size)
+		return (EFAULT);
+	pp->pp_name = (const char *)p + 12;
+	pp->pp_namelen = namesz;
+	pp->pp_type = (data_type_t)pnvl_get32(nvl,
+	    p + 12 + PNVL_ALIGN4(namesz));
+	pp->pp_nelem = pnvl_get32(nvl, p + 16 + PNVL_ALIGN4(namesz));
+	pp->pp_value = p + 20 + PNVL_ALIGN4(namesz);
+	pp->pp_vend = pp->pp_next = p + size;
+	return (0);
+}
+
+int
+pnvl_first(const pnvl_t *nvl, pnvl_pair_t *pp)
+{
+	pp->pp_nvl = *nvl;
+	return (pnvl_pair_at(pp, nvl->pn_pairs));
+}
+
+int
+pnvl_next(pnvl_pair_t *pp)
+{
+	return (pnvl_pair_at(pp, pp->pp_next));
+}
+
+/*
+ * Walk an nvlist to its end marker, returning the end of the nvlist.
+ */
+static int
+pnvl_skip(const pnvl_t *nvl, const uchar_t **endp)
+{
+	pnvl_pair_t pp;
+	int err;
+
+	for (err = pnvl_first(nvl, &pp); err == 0; err = pnvl_next(&pp))
+		continue;
+	if (err != ENOENT)
+		return (err);
+	*endp = pp.pp_next;
+	return (0);
+}
+
+boolean_t
+pnvl_name_is(const pnvl_pair_t *pp, const char *name)
+{
+	return (strlen(name) == pp->pp_namelen &&
+	    memcmp(pp->pp_name, name, pp->pp_namelen) == 0);
+}
+
+int
+pnvl_lookup(const pnvl_t *nvl, const char *name, pnvl_pair_t *pp)
+{
+	int err;
+
+	for (err = pnvl_first(nvl, pp); err == 0; err = pnvl_next(pp)) {
+		if (pnvl_name_is(pp, name))
+			return (0);
+	}
+	return (err);
+}
+
+/*
+ * Describe an integer type: its native width, whether it's signed and
+ * whether it's an array.  Returns 0 for other types.
+ */
+static size_t
+pnvl_intinfo(data_type_t type, boolean_t *sgnp, boolean_t *arrp)
+{
+	*arrp = B_FALSE;
+	*sgnp = B_FALSE;
+
+	switch (type) {
+	case DATA_TYPE_BYTE_ARRAY:
+	case DATA_TYPE_UINT8_ARRAY:
+		*arrp = B_TRUE;
+		/* FALLTHROUGH */
+	case DATA_TYPE_BYTE:
+	case DATA_TYPE_UINT8:
+		return (1);
+	case DATA_TYPE_INT8_ARRAY:
+		*arrp = B_TRUE;
+		/* FALLTHROUGH */
+	case DATA_TYPE_INT8:
+		*sgnp = B_TRUE;
+		return (1);
+	case DATA_TYPE_UINT16_ARRAY:
+		*arrp = B_TRUE;
+		/* FALLTHROUGH */
+	case DATA_TYPE_UINT16:
+		return (2);
+	case DATA_TYPE_INT16_ARRAY:
+		*arrp = B_TRUE;
+		/* FALLTHROUGH */
+	case DATA_TYPE_INT16:
+		*sgnp = B_TRUE;
+		return (2);
+	case DATA_TYPE_BOOLEAN_ARRAY:
+	case DATA_TYPE_UINT32_ARRAY:
+		*arrp = B_TRUE;
+		/* FALLTHROUGH */
+	case DATA_TYPE_BOOLEAN_VALUE:
+	case DATA_TYPE_UINT32:
+		return (4);
+	case DATA_TYPE_INT32_ARRAY:
+		*arrp = B_TRUE;
+		/* FALLTHROUGH */
+	case DATA_TYPE_INT32:
+		*sgnp = B_TRUE;
+		return (4);
+	case DATA_TYPE_UINT64_ARRAY:
+		*arrp = B_TRUE;
+		/* FALLTHROUGH */
+	case DATA_TYPE_UINT64:
+		return (8);
+	case DATA_TYPE_INT64_ARRAY:
+		*arrp = B_TRUE;
+		/* FALLTHROUGH */
+	case DATA_TYPE_INT64:
+	case DATA_TYPE_HRTIME:
+		*sgnp = B_TRUE;
+		return (8);
+	default:
+		return (0);
+	}
+}
+
+/*
+ * Fetch element i of an integer value, sign-extended if its type is signed.
+ */
+static int
+pnvl_int(const pnvl_pair_t *pp, uint_t i, uint64_t *vp, boolean_t *sgnp)
+{
+	const pnvl_t *nvl = &pp->pp_nvl;
+	const uchar_t *p = pp->pp_value;
+	boolean_t arr;
+	size_t width, ewidth;
+	uint64_t v;
+	uint16_t v16;
+
+	if ((width = pnvl_intinfo(pp->pp_type, sgnp, &arr)) == 0)
+		return (EINVAL);
+	if (arr ? i >= pp->pp_nelem : i != 0)
+		return (EINVAL);
+
+	if (!PNVL_ISXDR(nvl)) {
+		ewidth = width;
+	} else if (pp->pp_type == DATA_TYPE_BYTE_ARRAY) {
+		ewidth = 1;
+	} else {
+		ewidth = width == 8 ? 8 : 4;
+		if (arr)
+			p += 4;
+	}
+	if (p > pp->pp_vend)
+		return (EFAULT);
+	if (i > (pp->pp_vend - p) / ewidth ||
+	    (size_t)(pp->pp_vend - p) - i * ewidth < ewidth)
+		return (EFAULT);
+	p += i * ewidth;
+
+	switch (ewidth) {
+	case 1:
+		v = *p;
+		break;
+	case 2:
+		(void) memcpy(&v16, p, sizeof (v16));
+		v = v16;
+		break;
+	case 4:
+		v = pnvl_get32(nvl, p);
+		break;
+	default:
+		v = pnvl_get64(nvl, p);
+		break;
+	}
+
+	if (width < 8) {
+		v &= (1ULL << (width * 8)) - 1;
+		if (*sgnp && (v & (1ULL << (width * 8 - 1))) != 0)
+			v |= ~((1ULL << (width * 8)) - 1);
+	}
+	*vp = v;
+	return (0);
+}
+
+int
+pnvl_value_int64(const pnvl_pair_t *pp, uint_t i, int64_t *vp)
+{
+	boolean_t sgn;
+	uint64_t v;
+	int err;
+
+	if ((err = pnvl_int(pp, i, &v, &sgn)) != 0)
+		return (err);
+	if (!sgn && v > INT64_MAX)
+		return (ERANGE);
+	*vp = (int64_t)v;
+	return (0);
+}
+
+int
+pnvl_value_uint64(const pnvl_pair_t *pp, uint_t i, uint64_t *vp)
+{
+	boolean_t sgn;
+	uint64_t v;
+	int err;
+
+	if ((err = pnvl_int(pp, i, &v, &sgn)) != 0)
+		return (err);
+	if (sgn && (int64_t)v < 0)
+		return (ERANGE);
+	*vp = v;
+	return (0);
+}
+
+int
+pnvl_value_double(const pnvl_pair_t *pp, double *vp)
+{
+	uint64_t v;
+
+	if (pp->pp_type != DATA_TYPE_DOUBLE)
+		return (EINVAL);
+	if (pp->pp_vend - pp->pp_value < 8)
+		return (EFAULT);
+	v = pnvl_get64(&pp->pp_nvl, pp->pp_value);
+	(void) memcpy(vp, &v, sizeof (*vp));
+	return (0);
+}
+
+int
+pnvl_value_string(const pnvl_pair_t *pp, uint_t i, const char **sp,
+    size_t *lenp)
+{
+	const pnvl_t *nvl = &pp->pp_nvl;
+	const uchar_t *p = pp->pp_value, *nul;
+	size_t len = 0;
+	uint_t n;
+
+	if (pp->pp_type == DATA_TYPE_STRING ? i != 0 :
+	    pp->pp_type != DATA_TYPE_STRING_ARRAY || i >= pp->pp_nelem)
+		return (EINVAL);
+
+	if (!PNVL_ISXDR(nvl) && pp->pp_type == DATA_TYPE_STRING_ARRAY) {
+		if (pp->pp_nelem > (pp->pp_vend - p) / PNVL_PTR_SIZE)
+			return (EFAULT);
+		p += (size_t)pp->pp_nelem * PNVL_PTR_SIZE;
+	}
+
+	for (n = 0; n <= i; n++) {
+		if (n > 0)
+			p += PNVL_ISXDR(nvl) ? PNVL_ALIGN4(len) : len + 1;
+		if (p > pp->pp_vend)
+			return (EFAULT);
+		if (PNVL_ISXDR(nvl)) {
+			if (pp->pp_vend - p < 4)
+				return (EFAULT);
+			len = pnvl_get32(nvl, p);
+			p += 4;
+			if (len > (size_t)(pp->pp_vend - p))
+				return (EFAULT);
+		} else {
+			if ((nul = memchr(p, '\0', pp->pp_vend - p)) == NULL)
+				return (EFAULT);
+			len = nul - p;
+		}
+	}
+
+	*sp = (const char *)p;
+	*lenp = len;
+	return (0);
+}
+
+int
+pnvl_value_nvlist(const pnvl_pair_t *pp, uint_t i, pnvl_t *nvl)
+{
+	const pnvl_t *parent = &pp->pp_nvl;
+	const uchar_t *p;
+	int err;
+
+	if (pp->pp_type == DATA_TYPE_NVLIST ? i != 0 :
+	    pp->pp_type != DATA_TYPE_NVLIST_ARRAY || i >= pp->pp_nelem)
+		return (EINVAL);
+
+	/*
+	 * Native nvlists follow the pair; XDR ones are its value.
+	 */
+	p = PNVL_ISXDR(parent) ? pp->pp_value : pp->pp_vend;
+	if ((err = pnvl_skip_n(parent, p, i, &p)) != 0)
+		return (err);
+	return (pnvl_nvlist_at(parent, p, parent->pn_depth + 1, nvl));
+}
+
+/*
+ * Move a cursor on an element of an nvlist array on to the next element.
+ * The caller must know that there is one (from the array's pp_nelem).
+ */
+int
+pnvl_nvlist_next(pnvl_t *nvl)
+{
+	const uchar_t *end;
+	int err;
+
+	if ((err = pnvl_skip(nvl, &end)) != 0)
+		return (err);
+	return (pnvl_nvlist_at(nvl, end, nvl->pn_depth, nvl));
+}
+
+int
+pnvl_lookup_int64(const pnvl_t *nvl, const char *name, int64_t *vp)
+{
+	pnvl_pair_t pp;
+	int err;
+
+	if ((err = pnvl_lookup(nvl, name, &pp)) != 0)
+		return (err);
+	return (pnvl_value_int64(&pp, 0, vp));
+}
+
+int
+pnvl_lookup_uint64(const pnvl_t *nvl, const char *name, uint64_t *vp)
+{
+	pnvl_pair_t pp;
+	int err;
+
+	if ((err = pnvl_lookup(nvl, name, &pp)) != 0)
+		return (err);
+	return (pnvl_value_uint64(&pp, 0, vp));
+}
+
+int
+pnvl_lookup_string(const pnvl_t *nvl, const char *name, const char **sp,
+    size_t *lenp)
+{
+	pnvl_pair_t pp;
+	int err;
+
+	if ((err = pnvl_lookup(nvl, name, &pp)) != 0)
+		return (err);
+	return (pnvl_value_string(&pp, 0, sp, lenp));
+}
+
+int
+pnvl_lookup_nvlist(const pnvl_t *nvl, const char *name, pnvl_t *child)
+{
+	pnvl_pair_t pp;
+	int err;
+
+	if ((err = pnvl_lookup(nvl, name, &pp)) != 0)
+		return (err);
+	return (pnvl_value_nvlist(&pp, 0, child));
+}
+
+static void
+pnvl_indent(FILE *fp, uint_t depth)
+{
+	while (depth-- > 0)
+		(void) fputc('\t', fp);
+}
+
+/*
+ * Print one element of a leaf value in the same format as nvlist_print().
+ */
+static int
+pnvl_print_elem(FILE *fp, const pnvl_pair_t *pp, uint_t i)
+{
+	const char *s;
+	size_t len;
+	uint64_t v;
+	double d;
+	int err;
+
+	switch (pp->pp_type) {
+	case DATA_TYPE_BOOLEAN:
+		(void) fputs("1", fp);
+		return (0);
+	case DATA_TYPE_STRING:
+	case DATA_TYPE_STRING_ARRAY:
+		if ((err = pnvl_value_string(pp, i, &s, &len)) != 0)
+			return (err);
+		(void) fprintf(fp, "%.*s", (int)len, s);
+		return (0);
+	case DATA_TYPE_DOUBLE:
+		if ((err = pnvl_value_double(pp, &d)) != 0)
+			return (err);
+		(void) fprintf(fp, "0x%f", d);
+		return (0);
+	default:
+		break;
+	}
+
+	if ((err = pnvl_value_uint64(pp, i, &v)) == ERANGE)
+		err = pnvl_value_int64(pp, i, (int64_t *)&v);
+	if (err != 0)
+		return (err);
+
+	switch (pp->pp_type) {
+	case DATA_TYPE_BYTE:
+	case DATA_TYPE_BYTE_ARRAY:
+		(void) fprintf(fp, "0x%2.2x", (uint_t)v);
+		break;
+	case DATA_TYPE_UINT8:
+	case DATA_TYPE_UINT8_ARRAY:
+	case DATA_TYPE_UINT16:
+	case DATA_TYPE_UINT16_ARRAY:
+	case DATA_TYPE_UINT32:
+	case DATA_TYPE_UINT32_ARRAY:
+		(void) fprintf(fp, "0x%x", (uint_t)v);
+		break;
+	case DATA_TYPE_UINT64:
+	case DATA_TYPE_UINT64_ARRAY:
+	case DATA_TYPE_HRTIME:
+		(void) fprintf(fp, "0x%llx", (u_longlong_t)v);
+		break;
+	case DATA_TYPE_INT64:
+	case DATA_TYPE_INT64_ARRAY:
+		(void) fprintf(fp, "%lld", (longlong_t)v);
+		break;
+	default:
+		(void) fprintf(fp, "%d", (int)v);
+		break;
+	}
+	return (0);
+}
+
+static void
+pnvl_print_name(FILE *fp, const pnvl_t *nvl, const pnvl_pair_t *pp)
+{
+	pnvl_indent(fp, nvl->pn_depth + 1);
+	(void) fprintf(fp, "%.*s = ", (int)pp->pp_namelen, pp->pp_name);
+}
+
+static int
+pnvl_print_nvl(FILE *fp, const pnvl_t *nvl)
+{
+	pnvl_pair_t pp;
+	pnvl_t child;
+	uint_t i, n;
+	int err;
+
+	pnvl_indent(fp, nvl->pn_depth);
+	(void) fprintf(fp, "nvlist version: %d\n", nvl->pn_version);
+
+	/*
+	 * As in nvlist_print(), every pair ends with an extra newline after
+	 * whatever it printed, which leaves an empty line after an embedded
+	 * nvlist, and an empty array prints nothing but that newline.
+	 */
+	for (err = pnvl_first(nvl, &pp); err == 0; err = pnvl_next(&pp)) {
+		switch (pp.pp_type) {
+		case DATA_TYPE_NVLIST:
+			pnvl_print_name(fp, nvl, &pp);
+			(void) fprintf(fp, "(embedded nvlist)\n");
+			if ((err = pnvl_value_nvlist(&pp, 0, &child)) != 0 ||
+			    (err = pnvl_print_nvl(fp, &child)) != 0)
+				return (err);
+			pnvl_indent(fp, nvl->pn_depth + 1);
+			(void) fprintf(fp, "(end %.*s)\n", (int)pp.pp_namelen,
+			    pp.pp_name);
+			(void) fputc('\n', fp);
+			continue;
+		case DATA_TYPE_NVLIST_ARRAY:
+			pnvl_print_name(fp, nvl, &pp);
+			(void) fprintf(fp, "(array of embedded nvlists)\n");
+			for (i = 0; i < pp.pp_nelem; i++) {
+				pnvl_indent(fp, nvl->pn_depth + 1);
+				(void) fprintf(fp, "(start %.*s[%u])\n",
+				    (int)pp.pp_namelen, pp.pp_name, i);
+				if (i == 0)
+					err = pnvl_value_nvlist(&pp, 0, &child);
+				else
+					err = pnvl_nvlist_next(&child);
+				if (err != 0 ||
+				    (err = pnvl_print_nvl(fp, &child)) != 0)
+					return (err);
+				pnvl_indent(fp, nvl->pn_depth + 1);
+				(void) fprintf(fp, "(end %.*s[%u])\n",
+				    (int)pp.pp_namelen, pp.pp_name, i);
+			}
+			(void) fputc('\n', fp);
+			continue;
+		case DATA_TYPE_BOOLEAN:
+		case DATA_TYPE_BOOLEAN_VALUE:
+		case DATA_TYPE_BYTE:
+		case DATA_TYPE_INT8:
+		case DATA_TYPE_UINT8:
+		case DATA_TYPE_INT16:
+		case DATA_TYPE_UINT16:
+		case DATA_TYPE_INT32:
+		case DATA_TYPE_UINT32:
+		case DATA_TYPE_INT64:
+		case DATA_TYPE_UINT64:
+		case DATA_TYPE_HRTIME:
+		case DATA_TYPE_DOUBLE:
+		case DATA_TYPE_STRING:
+			n = 1;
+			break;
+		case DATA_TYPE_BOOLEAN_ARRAY:
+		case DATA_TYPE_BYTE_ARRAY:
+		case DATA_TYPE_INT8_ARRAY:
+		case DATA_TYPE_UINT8_ARRAY:
+		case DATA_TYPE_INT16_ARRAY:
+		case DATA_TYPE_UINT16_ARRAY:
+		case DATA_TYPE_INT32_ARRAY:
+		case DATA_TYPE_UINT32_ARRAY:
+		case DATA_TYPE_INT64_ARRAY:
+		case DATA_TYPE_UINT64_ARRAY:
+		case DATA_TYPE_STRING_ARRAY:
+			n = pp.pp_nelem;
+			break;
+		default:
+			pnvl_print_name(fp, nvl, &pp);
+			(void) fprintf(fp, "unknown data type (%d)\n",
+			    pp.pp_type);
+			continue;
+		}
+
+		for (i = 0; i < n; i++) {
+			if (i == 0)
+				pnvl_print_name(fp, nvl, &pp);
+			else
+				(void) fputc(' ', fp);
+			if ((err = pnvl_print_elem(fp, &pp, i)) != 0)
+				return (err);
+		}
+		(void) fputc('\n', fp);
+	}
+	return (err == ENOENT ? 0 : err);
+}
+
+/*
+ * Print an nvlist in the format of nvlist_print().
+ */
+int
+pnvl_print(FILE *fp, const pnvl_t *nvl)
+{
+	return (pnvl_print_nvl(fp, nvl));
+}
@@ -0,0 +1,86 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+#ifndef _PNVL_H
+#define	_PNVL_H
+
+/*
+ * A reader for packed nvlists (as produced by nvlist_pack(), in either the
+ * native or the XDR encoding) that works on the packed buffer in place.
+ * Nothing is allocated: a pnvl_t and a pnvl_pair_t are just cursors into the
+ * caller's buffer, which must stay around for as long as they're used.
+ *
+ * Every function returns 0 on success or an errno value: ENOENT at the end of
+ * an nvlist or for a name that isn't there, EINVAL for a value of the wrong
+ * type or an index out of range, ERANGE for an integer that doesn't fit the
+ * type asked for, EFAULT for a malformed buffer, and ENOTSUP for a native
+ * buffer of the other byte order.
+ *
+ * Strings are returned with their length, as XDR strings aren't always
+ * NUL-terminated in the buffer.
+ */
+
+#include <stdio.h>
+#ifdef	__sun
+#include <libnvpair.h>
+#endif
+
+#include "compat.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+typedef struct pnvl {
+	const uchar_t *pn_end;		/* end of the packed buffer */
+	const uchar_t *pn_pairs;	/* first pair of this nvlist */
+	int32_t pn_version;		/* nvl_version */
+	uint32_t pn_nvflag;		/* nvl_nvflag (NV_UNIQUE_NAME etc.) */
+	uint8_t pn_encoding;		/* NV_ENCODE_NATIVE or NV_ENCODE_XDR */
+	uint8_t pn_depth;		/* nesting depth, from 0 at the top */
+} pnvl_t;
+
+typedef struct pnvl_pair {
+	pnvl_t pp_nvl;			/* nvlist this pair is in */
+	const uchar_t *pp_pair;		/* start of this pair */
+	const uchar_t *pp_value;	/* start of its value */
+	const uchar_t *pp_vend;		/* end of its value */
+	const uchar_t *pp_next;		/* start of the next pair */
+	const char *pp_name;		/* name (not NUL-terminated in XDR) */
+	uint32_t pp_namelen;		/* length of name */
+	data_type_t pp_type;		/* type of value */
+	uint32_t pp_nelem;		/* number of elements in value */
+} pnvl_pair_t;
+
+extern int pnvl_init(pnvl_t *, const void *, size_t);
+extern int pnvl_first(const pnvl_t *, pnvl_pair_t *);
+extern int pnvl_next(pnvl_pair_t *);
+extern int pnvl_lookup(const pnvl_t *, const char *, pnvl_pair_t *);
+extern boolean_t pnvl_name_is(const pnvl_pair_t *, const char *);
+
+extern int pnvl_value_int64(const pnvl_pair_t *, uint_t, int64_t *);
+extern int pnvl_value_uint64(const pnvl_pair_t *, uint_t, uint64_t *);
+extern int pnvl_value_double(const pnvl_pair_t *, double *);
+extern int pnvl_value_string(const pnvl_pair_t *, uint_t, const char **,
+    size_t *);
+extern int pnvl_value_nvlist(const pnvl_pair_t *, uint_t, pnvl_t *);
+extern int pnvl_nvlist_next(pnvl_t *);
+
+extern int pnvl_lookup_int64(const pnvl_t *, const char *, int64_t *);
+extern int pnvl_lookup_uint64(const pnvl_t *, const char *, uint64_t *);
+extern int pnvl_lookup_string(const pnvl_t *, const char *, const char **,
+    size_t *);
+extern int pnvl_lookup_nvlist(const pnvl_t *, const char *, pnvl_t *);
+
+extern int pnvl_print(FILE *, const pnvl_t *);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _PNVL_H */
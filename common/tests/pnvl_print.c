@@ -0,0 +1,170 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+/*
+ * Check that pnvl_print() prints a packed nvlist exactly as nvlist_print()
+ * prints it unpacked, in both encodings.  The nvlist has a pair of every type
+ * the tools see, an empty array, and nvlists and nvlist arrays embedded two
+ * deep with pairs following them, which is where the layouts are easiest to
+ * get wrong.  Exits 0 if the output matches and 1, after printing both, if it
+ * doesn't.
+ */
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libnvpair.h>
+
+#include "pnvl.h"
+
+static nvlist_t *
+mknvl(void)
+{
+	nvlist_t *nvl;
+
+	if (nvlist_alloc(&nvl, NV_UNIQUE_NAME, 0) != 0)
+		err(EXIT_FAILURE, "failed to allocate nvlist");
+	return (nvl);
+}
+
+static nvlist_t *
+mkleaves(int seed)
+{
+	nvlist_t *nvl = mknvl();
+	uint32_t u32[] = { 1, 2, 0xdeadbeef };
+	int64_t i64[] = { -1, 0, 1 };
+	uchar_t bytes[] = { 0, 0x7f, 0xff };
+	char *strs[] = { "one", "", "three" };
+
+	if (nvlist_add_boolean(nvl, "flag") != 0 ||
+	    nvlist_add_boolean_value(nvl, "bool", B_TRUE) != 0 ||
+	    nvlist_add_byte(nvl, "byte", 0x5a) != 0 ||
+	    nvlist_add_int8(nvl, "int8", -8) != 0 ||
+	    nvlist_add_uint8(nvl, "uint8", 200) != 0 ||
+	    nvlist_add_int16(nvl, "int16", -16) != 0 ||
+	    nvlist_add_uint16(nvl, "uint16", 60000) != 0 ||
+	    nvlist_add_int32(nvl, "int32", -seed) != 0 ||
+	    nvlist_add_uint32(nvl, "uint32", seed) != 0 ||
+	    nvlist_add_int64(nvl, "int64", -(1LL << 40)) != 0 ||
+	    nvlist_add_uint64(nvl, "uint64", 1ULL << 63) != 0 ||
+	    nvlist_add_hrtime(nvl, "hrtime", 123456789) != 0 ||
+	    nvlist_add_double(nvl, "double", 1.5) != 0 ||
+	    nvlist_add_string(nvl, "string", "a string") != 0 ||
+	    nvlist_add_string(nvl, "empty", "") != 0 ||
+	    nvlist_add_uint32_array(nvl, "uint32s", u32, 3) != 0 ||
+	    nvlist_add_int64_array(nvl, "int64s", i64, 3) != 0 ||
+	    nvlist_add_byte_array(nvl, "bytes", bytes, 3) != 0 ||
+	    nvlist_add_string_array(nvl, "strings", strs, 3) != 0 ||
+	    nvlist_add_uint32_array(nvl, "none", u32, 0) != 0)
+		err(EXIT_FAILURE, "failed to build nvlist");
+	return (nvl);
+}
+
+static nvlist_t *
+mktest(void)
+{
+	nvlist_t *top = mknvl();
+	nvlist_t *emb = mkleaves(1);
+	nvlist_t *inner = mkleaves(2);
+	nvlist_t *arr[2];
+
+	arr[0] = mkleaves(3);
+	arr[1] = mknvl();
+
+	if (nvlist_add_string(top, "first", "before") != 0 ||
+	    nvlist_add_nvlist(arr[1], "inner", inner) != 0 ||
+	    nvlist_add_uint32(arr[1], "after-inner", 4) != 0 ||
+	    nvlist_add_nvlist_array(emb, "list", arr, 2) != 0 ||
+	    nvlist_add_string(emb, "after-list", "after") != 0 ||
+	    nvlist_add_nvlist(top, "emb", emb) != 0 ||
+	    nvlist_add_string(top, "after-emb", "after") != 0 ||
+	    nvlist_add_nvlist_array(top, "last", arr, 2) != 0)
+		err(EXIT_FAILURE, "failed to build nvlist");
+
+	nvlist_free(emb);
+	nvlist_free(inner);
+	nvlist_free(arr[0]);
+	nvlist_free(arr[1]);
+	return (top);
+}
+
+/*
+ * Read back everything written to a temporary file, NUL-terminated.
+ */
+static char *
+slurp(FILE *fp, size_t *lenp)
+{
+	long len;
+	char *buf;
+
+	if (fflush(fp) != 0 || (len = ftell(fp)) < 0)
+		err(EXIT_FAILURE, "failed to write temporary file");
+	if ((buf = malloc(len + 1)) == NULL)
+		err(EXIT_FAILURE, "failed to allocate %ld bytes", len + 1);
+	rewind(fp);
+	if (fread(buf, 1, len, fp) != (size_t)len)
+		err(EXIT_FAILURE, "failed to read temporary file");
+	buf[len] = '\0';
+	*lenp = len;
+	return (buf);
+}
+
+static int
+check(nvlist_t *nvl, int encoding, const char *desc)
+{
+	FILE *want_fp, *got_fp;
+	char *want, *got, *packed = NULL;
+	size_t want_len, got_len, packed_len = 0;
+	pnvl_t pnvl;
+	int ret, rv;
+
+	if ((ret = nvlist_pack(nvl, &packed, &packed_len, encoding, 0)) != 0)
+		errx(EXIT_FAILURE, "failed to pack %s nvlist: %s", desc,
+		    strerror(ret));
+
+	if ((want_fp = tmpfile()) == NULL || (got_fp = tmpfile()) == NULL)
+		err(EXIT_FAILURE, "failed to create temporary file");
+
+	nvlist_print(want_fp, nvl);
+	if ((ret = pnvl_init(&pnvl, packed, packed_len)) != 0 ||
+	    (ret = pnvl_print(got_fp, &pnvl)) != 0)
+		errx(EXIT_FAILURE, "failed to print %s nvlist: %s", desc,
+		    strerror(ret));
+
+	want = slurp(want_fp, &want_len);
+	got = slurp(got_fp, &got_len);
+
+	if (want_len == got_len && memcmp(want, got, want_len) == 0) {
+		(void) printf("%s: ok\n", desc);
+		rv = 0;
+	} else {
+		(void) printf("%s: mismatch\n--- nvlist_print\n%s"
+		    "--- pnvl_print\n%s", desc, want, got);
+		rv = 1;
+	}
+
+	free(want);
+	free(got);
+	free(packed);
+	(void) fclose(want_fp);
+	(void) fclose(got_fp);
+	return (rv);
+}
+
+int
+main(void)
+{
+	nvlist_t *nvl = mktest();
+	int rv = 0;
+
+	rv |= check(nvl, NV_ENCODE_NATIVE, "native");
+	rv |= check(nvl, NV_ENCODE_XDR, "XDR");
+
+	nvlist_free(nvl);
+	return (rv);
+}
@@ -9,35 +9,43 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <fcntl.h>
-#include <libnvpair.h>
 #include <string.h>
-#include <stropts.h>
+#include <strings.h>
 #include <unistd.h>
-#include <sys/ddi_ufm.h>
 #include <sys/types.h>
+#ifdef	__sun
+#include <sys/ddi_ufm.h>
+#endif
+
+#include "iocap.h"
+#include "pnvl.h"
+#include "ufm_compat.h"
 
 #define	EXIT_USAGE	2
 
 static const char *pname;
-static const char optstr[] = "d:i:";
+static const char optstr[] = "C:d:i:P:";
 
 static void
 usage()
 {
-	(void) fprintf(stderr, "usage: %s -d <devpath> -i <ioctl>\n\n"
+	(void) fprintf(stderr, "usage: %s [-C file | -P file] -d <devpath> "
+	    "-i <ioctl>\n\n"
 	    "where \'ioctl\' can be:\n"
-	    "getcaps, reportsz, report\n\n", pname);
+	    "getcaps, reportsz, report\n\n"
+	    "-C records every ioctl issued, and its output, to a capture file, "
+	    "and -P\nplays one back in place of %s.\n\n", pname, DDI_UFM_DEV);
 }
 
 static int
-do_getcaps(int fd, int cmd, char *devpath)
+do_getcaps(iocap_t *ic, int cmd, char *devpath)
 {
 	ufm_ioc_getcaps_t ioc = { 0 };
 
 	ioc.ufmg_version = DDI_UFM_CURRENT_VERSION;
 	(void) strcpy(ioc.ufmg_devpath, devpath);
 
-	if (ioctl(fd, cmd, &ioc) < 0) {
+	if (iocap_ioctl(ic, cmd, &ioc, sizeof (ioc), IOCAP_NOBUF) < 0) {
 		(void) fprintf(stderr, "getcaps ioctl failed (%s)\n",
 		    strerror(errno));
 		return (-1);
@@ -52,14 +60,14 @@ do_getcaps(int fd, int cmd, char *devpath)
 }
 
 static int
-do_reportsz(int fd, int cmd, char *devpath)
+do_reportsz(iocap_t *ic, int cmd, char *devpath)
 {
 	ufm_ioc_bufsz_t ioc = { 0 };
 
 	ioc.ufbz_version = DDI_UFM_CURRENT_VERSION;
 	(void) strcpy(ioc.ufbz_devpath, devpath);
 
-	if (ioctl(fd, cmd, &ioc) < 0) {
+	if (iocap_ioctl(ic, cmd, &ioc, sizeof (ioc), IOCAP_NOBUF) < 0) {
 		(void) fprintf(stderr, "reportsz ioctl failed (%s)\n",
 		    strerror(errno));
 		return (-1);
@@ -72,13 +80,14 @@ do_reportsz(int fd, int cmd, char *devpath)
 
 
 static int
-do_report(int fd, int cmd, char *devpath)
+do_report(iocap_t *ic, int cmd, char *devpath)
 {
 	ufm_ioc_report_t ioc = { 0 };
-	nvlist_t *nvl = NULL, **images;
+	pnvl_t nvl;
 	uint_t nimages;
+	int err;
 
-	if ((ioc.ufmr_bufsz = (size_t)do_reportsz(fd, UFM_IOC_REPORTSZ,
+	if ((ioc.ufmr_bufsz = (size_t)do_reportsz(ic, UFM_IOC_REPORTSZ,
 	    devpath)) < 0)
 		return (-1);
 
@@ -88,41 +97,51 @@ do_report(int fd, int cmd, char *devpath)
 	ioc.ufmr_version = DDI_UFM_CURRENT_VERSION;
 	(void) strcpy(ioc.ufmr_devpath, devpath);
 
-	if (ioctl(fd, cmd, &ioc) < 0) {
+	if (iocap_ioctl(ic, cmd, &ioc, sizeof (ioc),
+	    IOCAP_BUF(ioc.ufmr_buf, ioc.ufmr_bufsz)) < 0) {
 		(void) fprintf(stderr, "report ioctl failed (%s)\n",
 		    strerror(errno));
 		return (-1);
 	}
 
-	if (nvlist_unpack(ioc.ufmr_buf, ioc.ufmr_bufsz, &nvl,
-	    NV_ENCODE_NATIVE) != 0) {
-		(void) fprintf(stderr, "failed to unpack nvlist");
+	/*
+	 * Print the packed nvlist where it lies rather than unpacking it.
+	 */
+	if ((err = pnvl_init(&nvl, ioc.ufmr_buf, ioc.ufmr_bufsz)) != 0 ||
+	    (err = pnvl_print(stdout, &nvl)) != 0) {
+		(void) fprintf(stderr, "failed to decode nvlist (%s)\n",
+		    strerror(err));
 		free(ioc.ufmr_buf);
 		return (-1);
 	}
 	free(ioc.ufmr_buf);
 
-	nvlist_print(stdout, nvl);
-
 	return (0);
 }
 
 int
 main(int argc, char **argv)
 {
-	char c, *ioc = NULL, *devpath = NULL;
-	int cmd, fd, ret;
+	char c, *ioc = NULL, *devpath = NULL, *capout = NULL, *capin = NULL;
+	iocap_t *ic;
+	int cmd, ret;
 
 	pname = argv[0];
 	while (optind < argc) {
 		while ((c = getopt(argc, argv, optstr)) != -1) {
 			switch (c) {
+			case 'C':
+				capout = optarg;
+				break;
 			case 'd':
 				devpath = optarg;
 				break;
 			case 'i':
 				ioc = optarg;
 				break;
+			case 'P':
+				capin = optarg;
+				break;
 			default:
 				usage();
 				return (EXIT_USAGE);
@@ -135,6 +154,11 @@ main(int argc, char **argv)
 		usage();
 		return (EXIT_USAGE);
 	}
+	if (capout != NULL && capin != NULL) {
+		(void) fprintf(stderr, "-C and -P are mutually exclusive\n");
+		usage();
+		return (EXIT_USAGE);
+	}
 
 	if (strcasecmp(ioc, "getcaps") == 0) {
 		cmd = UFM_IOC_GETCAPS;
@@ -148,28 +172,39 @@ main(int argc, char **argv)
 		return (EXIT_USAGE);
 	}
 
-	if ((fd = open(DDI_UFM_DEV, O_RDONLY)) < 0) {
-		(void) fprintf(stderr, "failed to open %s (%s)\n", DDI_UFM_DEV,
-		    strerror(errno));
+#ifdef	IOCAP_PLAYBACK_ONLY
+	if (capin == NULL) {
+		(void) fprintf(stderr, "this build can only play captures "
+		    "back, with -P\n");
+		usage();
+		return (EXIT_USAGE);
+	}
+#endif
+	if ((ic = iocap_open(DDI_UFM_DEV, O_RDONLY, capout, capin)) == NULL) {
+		(void) fprintf(stderr, "failed to open %s (%s)\n",
+		    capin != NULL ? capin : DDI_UFM_DEV, strerror(errno));
 		return (EXIT_FAILURE);
 	}
 
 	switch (cmd) {
 	case UFM_IOC_GETCAPS:
-		ret = do_getcaps(fd, cmd, devpath);
+		ret = do_getcaps(ic, cmd, devpath);
 		break;
 	case UFM_IOC_REPORTSZ:
-		ret = do_reportsz(fd, cmd, devpath);
+		ret = do_reportsz(ic, cmd, devpath);
 		break;
 	case UFM_IOC_REPORT:
-		ret = do_report(fd, cmd, devpath);
+		ret = do_report(ic, cmd, devpath);
 		break;
 	default:
 		break;
 	}
 
 out:
-	(void) close(fd);
+	if (iocap_close(ic) != 0) {
+		(void) fprintf(stderr, "failed to write %s (%s)\n", capout,
+		    strerror(errno));
+	}
 
 	return ((ret < 0) ? EXIT_SUCCESS : EXIT_FAILURE);
 }
@@ -0,0 +1,68 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+#ifndef _UFM_COMPAT_H
+#define	_UFM_COMPAT_H
+
+/*
+ * The parts of sys/ddi_ufm.h that ufm-ioctl uses, for building it on Linux to
+ * play captures back (see Makefile.com).  A capture records each ioctl's
+ * command and argument structure as they were on illumos, so these have to
+ * match the amd64 definitions exactly; in particular the paths are illumos'
+ * MAXPATHLEN long, not Linux's.  On illumos this is empty.
+ */
+#ifndef	__sun
+
+#include <sys/types.h>
+
+#include "compat.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define	DDI_UFM_DEV		"/dev/ufm"
+#define	DDI_UFM_VERSION_ONE	1
+#define	DDI_UFM_CURRENT_VERSION	DDI_UFM_VERSION_ONE
+
+#define	UFM_MAXPATHLEN		1024
+
+#define	UFM_IOC			(('u' << 24) | ('f' << 16) | ('m' << 8))
+#define	UFM_IOC_GETCAPS		(UFM_IOC | 1)
+#define	UFM_IOC_REPORTSZ	(UFM_IOC | 2)
+#define	UFM_IOC_REPORT		(UFM_IOC | 3)
+
+typedef enum ddi_ufm_cap {
+	DDI_UFM_CAP_REPORT	= 1 << 0
+} ddi_ufm_cap_t;
+
+typedef struct ufm_ioc_getcaps {
+	uint_t ufmg_version;		/* DDI_UFM_VERSION */
+	uint_t ufmg_caps;		/* UFM Caps */
+	char ufmg_devpath[UFM_MAXPATHLEN];
+} ufm_ioc_getcaps_t;
+
+typedef struct ufm_ioc_bufsz {
+	uint_t ufbz_version;		/* DDI_UFM_VERSION */
+	size_t ufbz_size;		/* sz of buf to be returned by ioctl */
+	char ufbz_devpath[UFM_MAXPATHLEN];
+} ufm_ioc_bufsz_t;
+
+typedef struct ufm_ioc_report {
+	uint_t ufmr_version;		/* DDI_UFM_VERSION */
+	size_t ufmr_bufsz;		/* size of caller-supplied buffer */
+	caddr_t ufmr_buf;		/* buf to hold packed output nvl */
+	char ufmr_devpath[UFM_MAXPATHLEN];
+} ufm_ioc_report_t;
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* !__sun */
+
+#endif	/* _UFM_COMPAT_H */
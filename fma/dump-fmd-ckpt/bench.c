@@ -0,0 +1,337 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+/*
+ * "dump-fmd-ckpt bench" measures how fast checkpoints can be decoded.  Each
+ * pass runs every file through dump_ckpt(), which is exactly what the main
+ * command does, with the output thrown away.  By default the records are
+ * handed to a format that ignores them, so that only the decoder is measured;
+ * with -o, the named format's rendering is included too.
+ *
+ * An untimed first pass counts the records in each file and warms the page
+ * cache, so the numbers reported are for decoding rather than for disk I/O.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifdef	__sun
+#include <fcntl.h>
+#include <procfs.h>
+#endif
+
+#include "dump-fmd-ckpt.h"
+
+#define	BENCH_PASSES	10	/* default number of timed passes */
+
+/*
+ * Records seen by the null format.  Only the untimed pass looks at this.
+ */
+static uint64_t bench_nrecs;
+
+/*ARGSUSED*/
+static void
+null_hdr(dump_out_t *o, fcf_view_t *fv)
+{
+}
+
+/*ARGSUSED*/
+static void
+null_sec(dump_out_t *o, fcf_view_t *fv, fcf_secidx_t sid)
+{
+}
+
+/*ARGSUSED*/
+static void
+null_secend(dump_out_t *o, fcf_secidx_t sid)
+{
+}
+
+/*ARGSUSED*/
+static void
+null_str(dump_out_t *o, fcf_secidx_t sid, uint32_t off, const char *s)
+{
+	bench_nrecs++;
+}
+
+/*ARGSUSED*/
+static void
+null_module(dump_out_t *o, fcf_view_t *fv, fcf_secidx_t sid,
+    const fcf_module_t *fmmod)
+{
+	bench_nrecs++;
+}
+
+/*ARGSUSED*/
+static void
+null_case(dump_out_t *o, fcf_view_t *fv, fcf_secidx_t sid,
+    const fcf_case_t *fmcase)
+{
+	bench_nrecs++;
+}
+
+/*ARGSUSED*/
+static void
+null_buf(dump_out_t *o, fcf_view_t *fv, fcf_secidx_t sid, uint_t i,
+    const fcf_buf_t *buf)
+{
+	bench_nrecs++;
+}
+
+/*ARGSUSED*/
+static void
+null_buffer(dump_out_t *o, fcf_secidx_t sid, const uchar_t *data,
+    size_t size)
+{
+	bench_nrecs++;
+}
+
+/*ARGSUSED*/
+static void
+null_serd(dump_out_t *o, fcf_view_t *fv, fcf_secidx_t sid, uint_t i,
+    const fcf_serd_t *sgp)
+{
+	bench_nrecs++;
+}
+
+/*ARGSUSED*/
+static void
+null_event(dump_out_t *o, fcf_secidx_t sid, uint_t i, const fcf_event_t *ep)
+{
+	bench_nrecs++;
+}
+
+/*ARGSUSED*/
+static void
+null_nvl(dump_out_t *o, fcf_secidx_t sid, uint_t i, const char *buf,
+    size_t size)
+{
+	bench_nrecs++;
+}
+
+static const dump_fmt_t dump_fmt_null = {
+	.df_name = "none",
+	.df_hdr = null_hdr,
+	.df_sec = null_sec,
+	.df_secend = null_secend,
+	.df_str = null_str,
+	.df_module = null_module,
+	.df_case = null_case,
+	.df_buf = null_buf,
+	.df_buffer = null_buffer,
+	.df_serd = null_serd,
+	.df_event = null_event,
+	.df_nvl = null_nvl
+};
+
+/*
+ * Return the peak resident set size of this process in kilobytes.  illumos
+ * doesn't maintain ru_maxrss, so there we sample the current size from
+ * /proc and the caller keeps track of the peak.
+ */
+static uint64_t
+bench_rss(void)
+{
+#ifdef	__sun
+	psinfo_t ps;
+	int fd;
+	ssize_t n = -1;
+
+	if ((fd = open("/proc/self/psinfo", O_RDONLY)) >= 0) {
+		n = read(fd, &ps, sizeof (ps));
+		(void) close(fd);
+	}
+	return (n == sizeof (ps) ? (uint64_t)ps.pr_rssize : 0);
+#else
+	struct rusage ru;
+
+	if (getrusage(RUSAGE_SELF, &ru) != 0)
+		return (0);
+	return ((uint64_t)ru.ru_maxrss);
+#endif
+}
+
+static double
+bench_now(void)
+{
+	struct timespec ts;
+
+	(void) clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((double)ts.tv_sec + (double)ts.tv_nsec / 1e9);
+}
+
+/*
+ * Return the time it takes to decode the checkpoint at path in seconds, as
+ * the best of the given number of passes, or -1 if it can't be decoded.  The
+ * compact subcommand uses this to report how much faster a checkpoint loads
+ * after compaction.
+ */
+double
+bench_load(const char *path, uint_t passes)
+{
+	dump_sel_t sel = { 0 };
+	dump_out_t *out;
+	dump_ctx_t dc;
+	FILE *null;
+	double start, secs, best = -1;
+	uint_t pass;
+
+	if ((null = fopen("/dev/null", "w")) == NULL)
+		return (-1);
+	if ((out = malloc(sizeof (dump_out_t))) == NULL) {
+		(void) fclose(null);
+		return (-1);
+	}
+
+	dc.dc_out = out;
+	dc.dc_err = stderr;
+	dc.dc_sel = &sel;
+	dc.dc_atoms = NULL;
+	out_init(out, null, &dump_fmt_null);
+
+	for (pass = 0; pass < passes; pass++) {
+		start = bench_now();
+		if (dump_ckpt(&dc, path) != 0) {
+			best = -1;
+			break;
+		}
+		secs = bench_now() - start;
+		if (best < 0 || secs < best)
+			best = secs;
+	}
+
+	(void) out_fini(out);
+	free(out);
+	(void) fclose(null);
+	return (best);
+}
+
+static void
+bench_usage(void)
+{
+	(void) fprintf(stderr, "usage: %s bench [-n passes] [-o format] "
+	    "<ckpt file> ...\n\n", pname);
+}
+
+int
+do_bench(int argc, char **argv)
+{
+	const dump_fmt_t *fmt = &dump_fmt_null;
+	dump_sel_t sel = { 0 };
+	dump_out_t *out;
+	dump_ctx_t dc;
+	FILE *null;
+	struct stat64 st;
+	uint64_t bytes = 0, nrecs, rss, peak = 0;
+	long passes = BENCH_PASSES, pass;
+	double start, secs;
+	char *end;
+	int c, i, rv = 0;
+
+	while ((c = getopt(argc, argv, "n:o:")) != -1) {
+		switch (c) {
+		case 'n':
+			errno = 0;
+			passes = strtol(optarg, &end, 10);
+			if (errno != 0 || *end != '\0' || passes < 1) {
+				(void) fprintf(stderr, "invalid number of "
+				    "passes: %s\n", optarg);
+				return (2);
+			}
+			break;
+		case 'o':
+			if ((fmt = parse_fmt(optarg)) == NULL)
+				return (2);
+			break;
+		default:
+			bench_usage();
+			return (2);
+		}
+	}
+
+	if (optind == argc) {
+		bench_usage();
+		return (2);
+	}
+
+	for (i = optind; i < argc; i++) {
+		if (stat64(argv[i], &st) != 0) {
+			(void) fprintf(stderr, "failed to stat %s (%s)\n",
+			    argv[i], strerror(errno));
+			return (1);
+		}
+		bytes += (uint64_t)st.st_size;
+	}
+
+	/*
+	 * The output buffer is large, so don't put it on the stack.
+	 */
+	if ((null = fopen("/dev/null", "w")) == NULL ||
+	    (out = malloc(sizeof (dump_out_t))) == NULL) {
+		(void) fprintf(stderr, "failed to set up output\n");
+		return (1);
+	}
+
+	dc.dc_out = out;
+	dc.dc_err = stderr;
+	dc.dc_sel = &sel;
+	dc.dc_atoms = NULL;
+	if (fmt == &dump_fmt_bin &&
+	    (dc.dc_atoms = fcf_atomtab_create()) == NULL) {
+		(void) fprintf(stderr, "failed to allocate memory\n");
+		return (1);
+	}
+
+	/*
+	 * Any file that can't be decoded is reported once, here, and stops
+	 * the benchmark before it starts.
+	 */
+	out_init(out, null, &dump_fmt_null);
+	for (i = optind; i < argc; i++) {
+		if (dump_ckpt(&dc, argv[i]) != 0)
+			rv = 1;
+	}
+	nrecs = bench_nrecs;
+	if (rv != 0)
+		goto out;
+
+	(void) out_fini(out);
+	out_init(out, null, fmt);
+	start = bench_now();
+	for (pass = 0; pass < passes; pass++) {
+		for (i = optind; i < argc; i++)
+			(void) dump_ckpt(&dc, argv[i]);
+		if ((rss = bench_rss()) > peak)
+			peak = rss;
+	}
+	secs = bench_now() - start;
+	if (secs <= 0)
+		secs = 1e-9;
+
+	(void) printf("format:     %s\n", fmt->df_name);
+	(void) printf("files:      %d (%llu bytes, %llu records)\n",
+	    argc - optind, (u_longlong_t)bytes, (u_longlong_t)nrecs);
+	(void) printf("passes:     %ld in %.3f s\n", passes, secs);
+	(void) printf("throughput: %.1f MB/s, %.0f records/s\n",
+	    (double)bytes * passes / secs / (1024 * 1024),
+	    (double)nrecs * passes / secs);
+	(void) printf("peak rss:   %llu KB\n", (u_longlong_t)peak);
+
+out:
+	(void) out_fini(out);
+	free(out);
+	(void) fclose(null);
+	fcf_atomtab_destroy(dc.dc_atoms);
+	return (rv);
+}
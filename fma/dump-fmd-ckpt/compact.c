@@ -0,0 +1,544 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+/*
+ * "dump-fmd-ckpt compact" rewrites a checkpoint with only the state that fmd
+ * would actually restore from it, so that a module whose checkpoint has grown
+ * over a long uptime loads faster the next time fmd starts.
+ *
+ * The new file is built by walking the module, case and SERD engine records
+ * of the old one and copying just the sections they refer to, so sections
+ * that nothing refers to (orphaned buffers, event lists and the like, extra
+ * string tables and sections of unknown types) are left behind.  Cases in
+ * the states given with -d (by default, the solved and close_wait cases that
+ * fmd would only finish closing) are dropped along with everything that only
+ * they refer to; -k keeps every case.  fmd doesn't checkpoint closed cases,
+ * so there's no such state to drop.  Every string is re-interned, so the
+ * new string table holds each string that's still referenced exactly once.
+ * A section that's shared by several records stays shared.
+ *
+ * The records are rewritten in the host's byte order, so this also converts
+ * a checkpoint written on a system of the other byte order.  Any reference
+ * that doesn't resolve is treated as an error rather than being dropped,
+ * since a checkpoint that fmd would reject shouldn't be quietly "fixed".
+ *
+ * The checkpoint is replaced atomically (see fcf_writer_save()), but fmd
+ * isn't aware of it, so this is meant to be run while fmd is stopped.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <strings.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "dump-fmd-ckpt.h"
+
+#define	COMPACT_PASSES	5	/* passes over each file to time loading */
+#define	COMPACT_DROP	((1U << FCF_CASE_SOLVED) | (1U << FCF_CASE_CLOSE_WAIT))
+
+typedef struct compact {
+	fcf_view_t *c_view;		/* checkpoint being compacted */
+	fcf_writer_t c_fw;		/* compacted checkpoint */
+	fcf_secidx_t *c_map;		/* new index of each old section */
+	uchar_t *c_seen;		/* section is used by a dropped case */
+	uint_t c_drop;			/* mask of (1 << case state) to drop */
+	uint_t c_ncases;		/* cases kept */
+	uint_t c_ndropped;		/* cases dropped */
+} compact_t;
+
+static int
+compact_error(compact_t *c, const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	(void) vsnprintf(c->c_view->fv_errmsg, sizeof (c->c_view->fv_errmsg),
+	    fmt, ap);
+	va_end(ap);
+	return (-1);
+}
+
+static void *
+compact_alloc(compact_t *c, size_t n, size_t size)
+{
+	void *p;
+
+	if (n == 0)
+		return (NULL);
+	if ((p = calloc(n, size)) == NULL)
+		(void) compact_error(c, "failed to allocate memory");
+	return (p);
+}
+
+static int
+compact_str(compact_t *c, fcf_secidx_t sid, fcf_stridx_t idx,
+    fcf_stridx_t *np)
+{
+	const char *s;
+
+	if ((s = fcf_strtab_lookup(&c->c_view->fv_strtab, idx)) == NULL) {
+		return (compact_error(c, "section %u: invalid string "
+		    "reference 0x%x", sid, idx));
+	}
+	*np = fcf_writer_str(&c->c_fw, s);
+	return (0);
+}
+
+/*
+ * Copy a section that holds no references (a buffer, event list or nvlist
+ * list) if it hasn't been already, and return its new index.
+ */
+static int
+compact_copy(compact_t *c, fcf_secidx_t sid, uint_t type, fcf_secidx_t *np)
+{
+	fcf_view_t *fv = c->c_view;
+	const fcf_sec_t *sp;
+	const void *data;
+	size_t size;
+	uint_t align, n;
+
+	if (sid == FCF_SECIDX_NONE) {
+		*np = FCF_SECIDX_NONE;
+		return (0);
+	}
+	if ((data = fcf_view_data(fv, sid, type, &size)) == NULL)
+		return (-1);
+	if (c->c_map[sid] != FCF_SECIDX_NONE) {
+		*np = c->c_map[sid];
+		return (0);
+	}
+
+	sp = fcf_view_sec(fv, sid);
+	switch (type) {
+	case FCF_SECT_EVENTS:
+		if (fcf_view_nrecs(fv, sid, type, sizeof (fcf_event_t),
+		    &n) != 0)
+			return (-1);
+		align = sizeof (uint64_t);
+		break;
+	case FCF_SECT_NVLISTS:
+		align = sizeof (uint64_t);
+		break;
+	default:
+		align = 1;
+		break;
+	}
+
+	*np = c->c_map[sid] = fcf_writer_sec(&c->c_fw, type, align,
+	    sp->fcfs_entsize, data, size);
+	return (0);
+}
+
+static int
+compact_bufs(compact_t *c, fcf_secidx_t sid, fcf_secidx_t *np)
+{
+	fcf_view_t *fv = c->c_view;
+	const fcf_buf_t *bp;
+	fcf_buf_t *bufs;
+	uint_t i, n;
+
+	if (sid == FCF_SECIDX_NONE) {
+		*np = FCF_SECIDX_NONE;
+		return (0);
+	}
+	if (fcf_view_nrecs(fv, sid, FCF_SECT_BUFS, sizeof (fcf_buf_t),
+	    &n) != 0)
+		return (-1);
+	if (c->c_map[sid] != FCF_SECIDX_NONE) {
+		*np = c->c_map[sid];
+		return (0);
+	}
+
+	if ((bufs = compact_alloc(c, n, sizeof (fcf_buf_t))) == NULL && n != 0)
+		return (-1);
+	for (i = 0; i < n; i++) {
+		bp = fcf_view_rec(fv, sid, FCF_SECT_BUFS, sizeof (fcf_buf_t),
+		    i);
+		if (compact_str(c, sid, bp->fcfb_name,
+		    &bufs[i].fcfb_name) != 0 ||
+		    compact_copy(c, bp->fcfb_data, FCF_SECT_BUFFER,
+		    &bufs[i].fcfb_data) != 0) {
+			free(bufs);
+			return (-1);
+		}
+	}
+
+	*np = c->c_map[sid] = fcf_writer_sec(&c->c_fw, FCF_SECT_BUFS,
+	    sizeof (uint32_t), sizeof (fcf_buf_t), bufs,
+	    n * sizeof (fcf_buf_t));
+	free(bufs);
+	return (0);
+}
+
+static int
+compact_module(compact_t *c, fcf_secidx_t sid)
+{
+	fcf_view_t *fv = c->c_view;
+	const fcf_module_t *mp;
+	fcf_module_t *mods, *nmp;
+	uint_t i, n;
+
+	if (fcf_view_nrecs(fv, sid, FCF_SECT_MODULE, sizeof (fcf_module_t),
+	    &n) != 0)
+		return (-1);
+	if ((mods = compact_alloc(c, n, sizeof (fcf_module_t))) == NULL &&
+	    n != 0)
+		return (-1);
+
+	for (i = 0; i < n; i++) {
+		mp = fcf_view_rec(fv, sid, FCF_SECT_MODULE,
+		    sizeof (fcf_module_t), i);
+		nmp = &mods[i];
+		if (compact_str(c, sid, mp->fcfm_name, &nmp->fcfm_name) != 0 ||
+		    compact_str(c, sid, mp->fcfm_path, &nmp->fcfm_path) != 0 ||
+		    compact_str(c, sid, mp->fcfm_desc, &nmp->fcfm_desc) != 0 ||
+		    compact_str(c, sid, mp->fcfm_vers, &nmp->fcfm_vers) != 0 ||
+		    compact_bufs(c, mp->fcfm_bufs, &nmp->fcfm_bufs) != 0) {
+			free(mods);
+			return (-1);
+		}
+	}
+
+	(void) fcf_writer_sec(&c->c_fw, FCF_SECT_MODULE, sizeof (uint32_t), 0,
+	    mods, n * sizeof (fcf_module_t));
+	free(mods);
+	return (0);
+}
+
+/*
+ * Note the sections used by a case that's being dropped, so that they aren't
+ * counted as orphans.  The case is going away, so its references aren't
+ * checked.
+ */
+static void
+compact_mark(compact_t *c, const fcf_case_t *cp)
+{
+	fcf_view_t *fv = c->c_view;
+	const fcf_buf_t *bp;
+	uint_t i, n;
+
+	if (cp->fcfc_bufs < fv->fv_secnum) {
+		c->c_seen[cp->fcfc_bufs] = 1;
+		if (fcf_view_nrecs(fv, cp->fcfc_bufs, FCF_SECT_BUFS,
+		    sizeof (fcf_buf_t), &n) != 0)
+			n = 0;
+		for (i = 0; i < n; i++) {
+			bp = fcf_view_rec(fv, cp->fcfc_bufs, FCF_SECT_BUFS,
+			    sizeof (fcf_buf_t), i);
+			if (bp->fcfb_data < fv->fv_secnum)
+				c->c_seen[bp->fcfb_data] = 1;
+		}
+	}
+	if (cp->fcfc_principal < fv->fv_secnum)
+		c->c_seen[cp->fcfc_principal] = 1;
+	if (cp->fcfc_events < fv->fv_secnum)
+		c->c_seen[cp->fcfc_events] = 1;
+	if (cp->fcfc_suspects < fv->fv_secnum)
+		c->c_seen[cp->fcfc_suspects] = 1;
+}
+
+static int
+compact_case(compact_t *c, fcf_secidx_t sid)
+{
+	fcf_view_t *fv = c->c_view;
+	const fcf_case_t *cp;
+	fcf_case_t *cases, *ncp;
+	uint_t i, n, nkept = 0;
+
+	if (fcf_view_nrecs(fv, sid, FCF_SECT_CASE, sizeof (fcf_case_t),
+	    &n) != 0)
+		return (-1);
+	if ((cases = compact_alloc(c, n, sizeof (fcf_case_t))) == NULL &&
+	    n != 0)
+		return (-1);
+
+	for (i = 0; i < n; i++) {
+		cp = fcf_view_rec(fv, sid, FCF_SECT_CASE, sizeof (fcf_case_t),
+		    i);
+		if (cp->fcfc_state < 32 &&
+		    (c->c_drop & (1U << cp->fcfc_state)) != 0) {
+			compact_mark(c, cp);
+			c->c_ndropped++;
+			continue;
+		}
+
+		ncp = &cases[nkept++];
+		ncp->fcfc_state = cp->fcfc_state;
+		if (compact_str(c, sid, cp->fcfc_uuid, &ncp->fcfc_uuid) != 0 ||
+		    compact_bufs(c, cp->fcfc_bufs, &ncp->fcfc_bufs) != 0 ||
+		    compact_copy(c, cp->fcfc_principal, FCF_SECT_EVENTS,
+		    &ncp->fcfc_principal) != 0 ||
+		    compact_copy(c, cp->fcfc_events, FCF_SECT_EVENTS,
+		    &ncp->fcfc_events) != 0 ||
+		    compact_copy(c, cp->fcfc_suspects, FCF_SECT_NVLISTS,
+		    &ncp->fcfc_suspects) != 0) {
+			free(cases);
+			return (-1);
+		}
+		c->c_ncases++;
+	}
+
+	if (nkept != 0) {
+		(void) fcf_writer_sec(&c->c_fw, FCF_SECT_CASE,
+		    sizeof (uint32_t), 0, cases, nkept * sizeof (fcf_case_t));
+	}
+	free(cases);
+	return (0);
+}
+
+static int
+compact_serd(compact_t *c, fcf_secidx_t sid)
+{
+	fcf_view_t *fv = c->c_view;
+	const fcf_serd_t *sgp;
+	fcf_serd_t *sgs, *nsgp;
+	uint_t i, n;
+
+	if (fcf_view_nrecs(fv, sid, FCF_SECT_SERD, sizeof (fcf_serd_t),
+	    &n) != 0)
+		return (-1);
+	if ((sgs = compact_alloc(c, n, sizeof (fcf_serd_t))) == NULL && n != 0)
+		return (-1);
+
+	for (i = 0; i < n; i++) {
+		sgp = fcf_view_rec(fv, sid, FCF_SECT_SERD, sizeof (fcf_serd_t),
+		    i);
+		nsgp = &sgs[i];
+		nsgp->fcfd_n = sgp->fcfd_n;
+		nsgp->fcfd_t = sgp->fcfd_t;
+		if (compact_str(c, sid, sgp->fcfd_name,
+		    &nsgp->fcfd_name) != 0 ||
+		    compact_copy(c, sgp->fcfd_events, FCF_SECT_EVENTS,
+		    &nsgp->fcfd_events) != 0) {
+			free(sgs);
+			return (-1);
+		}
+	}
+
+	(void) fcf_writer_sec(&c->c_fw, FCF_SECT_SERD, sizeof (uint64_t),
+	    sizeof (fcf_serd_t), sgs, n * sizeof (fcf_serd_t));
+	free(sgs);
+	return (0);
+}
+
+/*
+ * Copy everything that's reachable from the module, case and SERD engine
+ * records into the writer, in the order fmd wrote it.
+ */
+static int
+compact_view(compact_t *c)
+{
+	fcf_view_t *fv = c->c_view;
+	fcf_secidx_t i;
+	int rv;
+
+	if (fcf_view_strings(fv, NULL) != 0)
+		return (-1);
+
+	c->c_map = compact_alloc(c, fv->fv_secnum, sizeof (fcf_secidx_t));
+	c->c_seen = compact_alloc(c, fv->fv_secnum, sizeof (uchar_t));
+	if (c->c_map == NULL || c->c_seen == NULL)
+		return (-1);
+
+	for (i = 0; i < fv->fv_secnum; i++) {
+		switch (fcf_view_sec(fv, i)->fcfs_type) {
+		case FCF_SECT_MODULE:
+			rv = compact_module(c, i);
+			break;
+		case FCF_SECT_CASE:
+			rv = compact_case(c, i);
+			break;
+		case FCF_SECT_SERD:
+			rv = compact_serd(c, i);
+			break;
+		default:
+			rv = 0;
+			break;
+		}
+		if (rv != 0)
+			return (-1);
+	}
+	return (0);
+}
+
+/*
+ * Count the sections that weren't copied, other than the records themselves,
+ * the string table and those that belonged to dropped cases.
+ */
+static uint_t
+compact_orphans(compact_t *c)
+{
+	fcf_view_t *fv = c->c_view;
+	boolean_t strtab = B_FALSE;
+	fcf_secidx_t i;
+	uint_t n = 0;
+
+	for (i = 1; i < fv->fv_secnum; i++) {
+		switch (fcf_view_sec(fv, i)->fcfs_type) {
+		case FCF_SECT_MODULE:
+		case FCF_SECT_CASE:
+		case FCF_SECT_SERD:
+			continue;
+		case FCF_SECT_STRTAB:
+			if (!strtab) {
+				strtab = B_TRUE;
+				continue;
+			}
+			break;
+		}
+		if (c->c_map[i] == FCF_SECIDX_NONE && !c->c_seen[i])
+			n++;
+	}
+	return (n);
+}
+
+static int
+parse_states(char *arg, uint_t *maskp)
+{
+	char *p, *q;
+	uint32_t state;
+
+	for (p = strtok_r(arg, ",", &q); p != NULL;
+	    p = strtok_r(NULL, ",", &q)) {
+		for (state = FCF_CASE_UNSOLVED; state <= FCF_CASE_CLOSE_WAIT;
+		    state++) {
+			if (strcasecmp(p, fcf_case_state_name(state)) == 0)
+				break;
+		}
+		if (state > FCF_CASE_CLOSE_WAIT) {
+			(void) fprintf(stderr, "invalid case state: %s\n", p);
+			return (-1);
+		}
+		*maskp |= 1U << state;
+	}
+	return (0);
+}
+
+static void
+compact_usage(void)
+{
+	(void) fprintf(stderr, "usage: %s compact [-d state[,...] | -k] "
+	    "[-o output] <ckpt file>\n\n"
+	    "where \'state\' can be:\n"
+	    "unsolved, solved, close_wait\n\n"
+	    "-d defaults to solved,close_wait; -k keeps every case\n\n",
+	    pname);
+}
+
+int
+do_compact(int argc, char **argv)
+{
+	compact_t c;
+	fcf_view_t fv;
+	struct stat64 st;
+	const char *path, *opath = NULL;
+	uint64_t cgen, osize;
+	uint_t osecs, ostrs, orphans;
+	double otime, ntime;
+	boolean_t dflag = B_FALSE, keep = B_FALSE;
+	int ch, rv = 1;
+
+	(void) memset(&c, 0, sizeof (c));
+	while ((ch = getopt(argc, argv, "d:ko:")) != -1) {
+		switch (ch) {
+		case 'd':
+			if (parse_states(optarg, &c.c_drop) != 0)
+				return (2);
+			dflag = B_TRUE;
+			break;
+		case 'k':
+			keep = B_TRUE;
+			break;
+		case 'o':
+			opath = optarg;
+			break;
+		default:
+			compact_usage();
+			return (2);
+		}
+	}
+
+	if (argc - optind != 1 || (dflag && keep)) {
+		compact_usage();
+		return (2);
+	}
+	if (!dflag && !keep)
+		c.c_drop = COMPACT_DROP;
+	path = argv[optind];
+	if (opath == NULL)
+		opath = path;
+
+	if (stat64(path, &st) != 0) {
+		(void) fprintf(stderr, "failed to stat %s (%s)\n", path,
+		    strerror(errno));
+		return (1);
+	}
+
+	/*
+	 * Time the load before anything is changed, since the file may be
+	 * about to be replaced.
+	 */
+	if ((otime = bench_load(path, COMPACT_PASSES)) < 0)
+		return (1);
+
+	if (fcf_view_open(&fv, path) != 0) {
+		(void) fprintf(stderr, "%s\n", fv.fv_errmsg);
+		return (1);
+	}
+	c.c_view = &fv;
+
+	if (fcf_writer_init(&c.c_fw) != 0) {
+		(void) fprintf(stderr, "%s\n", c.c_fw.fw_errmsg);
+		goto out;
+	}
+	if (compact_view(&c) != 0) {
+		(void) fprintf(stderr, "%s: %s\n", path, fv.fv_errmsg);
+		goto out;
+	}
+
+	osize = fv.fv_size;
+	osecs = fv.fv_secnum;
+	ostrs = fv.fv_strtab.fs_nstrs;
+	cgen = fv.fv_hdr->fcfh_cgen;
+	orphans = compact_orphans(&c);
+
+	if (fcf_writer_save(&c.c_fw, opath, cgen) != 0) {
+		(void) fprintf(stderr, "%s\n", c.c_fw.fw_errmsg);
+		goto out;
+	}
+	if (chmod(opath, st.st_mode & 07777) != 0) {
+		(void) fprintf(stderr, "failed to set mode of %s (%s)\n",
+		    opath, strerror(errno));
+	}
+	if ((ntime = bench_load(opath, COMPACT_PASSES)) < 0)
+		goto out;
+
+	(void) printf("%s: %llu -> %llu bytes (%.1f%% smaller)\n", opath,
+	    (u_longlong_t)osize, (u_longlong_t)c.c_fw.fw_filesz,
+	    osize == 0 ? 0.0 : 100.0 * ((double)osize -
+	    (double)c.c_fw.fw_filesz) / (double)osize);
+	(void) printf("  sections: %u -> %u (%u orphaned)\n", osecs,
+	    c.c_fw.fw_nsecs, orphans);
+	(void) printf("  cases:    %u -> %u\n", c.c_ncases + c.c_ndropped,
+	    c.c_ncases);
+	(void) printf("  strings:  %u -> %u\n", ostrs, c.c_fw.fw_nstrs);
+	(void) printf("  load:     %.3f ms -> %.3f ms\n", otime * 1000,
+	    ntime * 1000);
+	rv = 0;
+
+out:
+	fcf_writer_fini(&c.c_fw);
+	fcf_view_close(&fv);
+	free(c.c_map);
+	free(c.c_seen);
+	return (rv);
+}
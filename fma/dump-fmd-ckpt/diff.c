@@ -0,0 +1,904 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+/*
+ * "dump-fmd-ckpt diff" compares two checkpoints of the same module and
+ * reports only the module buffers, cases and SERD engines that differ.
+ *
+ * The comparison is hash-first.  If both files have the same section layout
+ * and every section hashes the same, the checkpoints are equivalent and
+ * nothing is decoded at all.  Otherwise each file is reduced to a list of
+ * items (module buffers keyed by name, cases keyed by UUID and SERD engines
+ * keyed by name), each with a "deep" hash that covers the item's record and,
+ * recursively, the sections it refers to.  String references are hashed by
+ * content, not by string table offset, and section references by the hash of
+ * the referenced data, so items compare equal even if fmd laid the two files
+ * out differently.  Items whose deep hashes match are skipped; only the ones
+ * that differ are decoded to report what changed.
+ *
+ * diff(1) exit status conventions are followed: 0 if the checkpoints are
+ * equivalent, 1 if they differ and 2 on error.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+#include "dump-fmd-ckpt.h"
+
+#define	DIFF_BUF	0	/* module buffer */
+#define	DIFF_CASE	1	/* case */
+#define	DIFF_SERD	2	/* SERD engine */
+
+typedef struct diff_item {
+	uint_t di_kind;			/* DIFF_* */
+	const fcf_atom_t *di_key;	/* buffer name, case UUID, SERD name */
+	fcf_secidx_t di_sid;		/* section containing record */
+	uint_t di_idx;			/* index of record in section */
+	uint64_t di_hash;		/* deep hash of item */
+} diff_item_t;
+
+/*
+ * The header is only printed once there's a difference to report, so that
+ * equivalent checkpoints produce no output at all.
+ */
+typedef struct diff {
+	const char *d_banner;		/* printed before the header */
+	fcf_view_t *d_old;		/* old checkpoint, if any */
+	fcf_view_t *d_new;		/* new checkpoint, if any */
+	boolean_t d_hdrdone;		/* header has been printed */
+} diff_t;
+
+typedef struct diff_file {
+	diff_t *df_diff;		/* comparison this file is part of */
+	fcf_view_t *df_view;		/* mapped checkpoint */
+	uint64_t *df_deep;		/* deep hash of each section */
+	uchar_t *df_deepdone;		/* df_deep[i] is valid */
+	const fcf_module_t *df_mod;	/* module record, if any */
+	diff_item_t *df_items;		/* items, sorted by kind, key */
+	uint_t df_nitems;		/* number of items */
+	uint_t df_alloc;		/* allocated entries in df_items */
+} diff_file_t;
+
+static void
+diff_printf(diff_t *d, const char *fmt, ...)
+{
+	va_list ap;
+
+	if (!d->d_hdrdone) {
+		if (d->d_banner != NULL)
+			(void) printf("%s\n", d->d_banner);
+		if (d->d_old != NULL) {
+			(void) printf("--- %s (cgen %" PRIu64 ")\n",
+			    d->d_old->fv_path, d->d_old->fv_hdr->fcfh_cgen);
+		}
+		if (d->d_new != NULL) {
+			(void) printf("+++ %s (cgen %" PRIu64 ")\n",
+			    d->d_new->fv_path, d->d_new->fv_hdr->fcfh_cgen);
+		}
+		d->d_hdrdone = B_TRUE;
+	}
+
+	va_start(ap, fmt);
+	(void) vprintf(fmt, ap);
+	va_end(ap);
+}
+
+static void
+diff_error(diff_file_t *df)
+{
+	(void) fprintf(stderr, "%s: %s\n", df->df_view->fv_path,
+	    df->df_view->fv_errmsg);
+}
+
+static uint64_t
+diff_strhash(diff_file_t *df, fcf_stridx_t sid)
+{
+	const fcf_atom_t *fa = fcf_view_atom(df->df_view, sid);
+
+	return (fa != NULL ? fa->fa_hash : 0);
+}
+
+static int diff_deep(diff_file_t *, fcf_secidx_t, uint_t, uint64_t *);
+
+static int
+diff_deep_bufs(diff_file_t *df, fcf_secidx_t sid, uint64_t *hp)
+{
+	fcf_view_t *fv = df->df_view;
+	const fcf_buf_t *bp;
+	uint64_t h = 0, v[2];
+	uint_t i, n;
+
+	if (fcf_view_nrecs(fv, sid, FCF_SECT_BUFS, sizeof (fcf_buf_t),
+	    &n) != 0)
+		return (-1);
+
+	for (i = 0; i < n; i++) {
+		bp = fcf_view_rec(fv, sid, FCF_SECT_BUFS, sizeof (fcf_buf_t),
+		    i);
+		v[0] = diff_strhash(df, bp->fcfb_name);
+		if (diff_deep(df, bp->fcfb_data, FCF_SECT_BUFFER, &v[1]) != 0)
+			return (-1);
+		h = fcf_hash(v, sizeof (v), h);
+	}
+
+	*hp = h;
+	return (0);
+}
+
+/*
+ * Compute the deep hash of section sid, which must be of the given type.
+ * FCF_SECIDX_NONE hashes to zero.
+ */
+static int
+diff_deep(diff_file_t *df, fcf_secidx_t sid, uint_t type, uint64_t *hp)
+{
+	fcf_view_t *fv = df->df_view;
+	size_t size;
+	int rv;
+
+	if (sid == FCF_SECIDX_NONE) {
+		*hp = 0;
+		return (0);
+	}
+	if (fcf_view_data(fv, sid, type, &size) == NULL)
+		return (-1);
+
+	if (df->df_deepdone[sid]) {
+		*hp = df->df_deep[sid];
+		return (0);
+	}
+
+	switch (type) {
+	case FCF_SECT_BUFS:
+		rv = diff_deep_bufs(df, sid, &df->df_deep[sid]);
+		break;
+	case FCF_SECT_BUFFER:
+	case FCF_SECT_EVENTS:
+	case FCF_SECT_NVLISTS:
+		rv = fcf_view_sechash(fv, sid, &df->df_deep[sid]);
+		break;
+	default:
+		rv = -1;
+		break;
+	}
+	if (rv != 0)
+		return (-1);
+
+	df->df_deepdone[sid] = 1;
+	*hp = df->df_deep[sid];
+	return (0);
+}
+
+static int
+diff_add(diff_file_t *df, uint_t kind, fcf_stridx_t key, fcf_secidx_t sid,
+    uint_t idx, uint64_t hash)
+{
+	diff_item_t *dip;
+
+	if (df->df_nitems == df->df_alloc) {
+		uint_t alloc = df->df_alloc == 0 ? 32 : df->df_alloc * 2;
+
+		if ((dip = realloc(df->df_items,
+		    alloc * sizeof (diff_item_t))) == NULL) {
+			(void) snprintf(df->df_view->fv_errmsg,
+			    sizeof (df->df_view->fv_errmsg),
+			    "failed to allocate memory");
+			return (-1);
+		}
+		df->df_items = dip;
+		df->df_alloc = alloc;
+	}
+
+	dip = &df->df_items[df->df_nitems++];
+	dip->di_kind = kind;
+	dip->di_key = fcf_view_atom(df->df_view, key);
+	dip->di_sid = sid;
+	dip->di_idx = idx;
+	dip->di_hash = hash;
+
+	if (dip->di_key == NULL) {
+		(void) snprintf(df->df_view->fv_errmsg,
+		    sizeof (df->df_view->fv_errmsg), "section %u: invalid "
+		    "string reference 0x%x", sid, key);
+		return (-1);
+	}
+	return (0);
+}
+
+static int
+diff_item_cmp(const void *l, const void *r)
+{
+	const diff_item_t *li = l, *ri = r;
+
+	if (li->di_kind != ri->di_kind)
+		return (li->di_kind < ri->di_kind ? -1 : 1);
+	if (li->di_key->fa_id != ri->di_key->fa_id)
+		return (li->di_key->fa_id < ri->di_key->fa_id ? -1 : 1);
+	return (0);
+}
+
+/*
+ * Reduce the checkpoint to its list of items and their deep hashes.
+ */
+static int
+diff_load(diff_file_t *df)
+{
+	fcf_view_t *fv = df->df_view;
+	const fcf_sec_t *sp;
+	const fcf_case_t *cp;
+	const fcf_serd_t *sgp;
+	const fcf_buf_t *bp;
+	uint64_t v[6];
+	fcf_secidx_t i;
+	uint_t j, n;
+
+	if ((df->df_deep = calloc(fv->fv_secnum, sizeof (uint64_t))) == NULL ||
+	    (df->df_deepdone = calloc(fv->fv_secnum, 1)) == NULL) {
+		(void) snprintf(fv->fv_errmsg, sizeof (fv->fv_errmsg),
+		    "failed to allocate memory");
+		return (-1);
+	}
+
+	for (i = 0; i < fv->fv_secnum; i++) {
+		sp = fcf_view_sec(fv, i);
+
+		switch (sp->fcfs_type) {
+		case FCF_SECT_MODULE:
+			if (df->df_mod != NULL)
+				break;
+			if ((df->df_mod = fcf_view_rec(fv, i, FCF_SECT_MODULE,
+			    sizeof (fcf_module_t), 0)) == NULL)
+				return (-1);
+			if (df->df_mod->fcfm_bufs == FCF_SECIDX_NONE)
+				break;
+			if (fcf_view_nrecs(fv, df->df_mod->fcfm_bufs,
+			    FCF_SECT_BUFS, sizeof (fcf_buf_t), &n) != 0)
+				return (-1);
+			for (j = 0; j < n; j++) {
+				bp = fcf_view_rec(fv, df->df_mod->fcfm_bufs,
+				    FCF_SECT_BUFS, sizeof (fcf_buf_t), j);
+				if (diff_deep(df, bp->fcfb_data,
+				    FCF_SECT_BUFFER, &v[0]) != 0 ||
+				    diff_add(df, DIFF_BUF, bp->fcfb_name,
+				    df->df_mod->fcfm_bufs, j, v[0]) != 0)
+					return (-1);
+			}
+			break;
+
+		case FCF_SECT_CASE:
+			if ((cp = fcf_view_rec(fv, i, FCF_SECT_CASE,
+			    sizeof (fcf_case_t), 0)) == NULL)
+				return (-1);
+			v[0] = diff_strhash(df, cp->fcfc_uuid);
+			v[1] = cp->fcfc_state;
+			if (diff_deep(df, cp->fcfc_bufs, FCF_SECT_BUFS,
+			    &v[2]) != 0 ||
+			    diff_deep(df, cp->fcfc_principal, FCF_SECT_EVENTS,
+			    &v[3]) != 0 ||
+			    diff_deep(df, cp->fcfc_events, FCF_SECT_EVENTS,
+			    &v[4]) != 0 ||
+			    diff_deep(df, cp->fcfc_suspects, FCF_SECT_NVLISTS,
+			    &v[5]) != 0)
+				return (-1);
+			if (diff_add(df, DIFF_CASE, cp->fcfc_uuid, i, 0,
+			    fcf_hash(v, sizeof (v), 0)) != 0)
+				return (-1);
+			break;
+
+		case FCF_SECT_SERD:
+			if (fcf_view_nrecs(fv, i, FCF_SECT_SERD,
+			    sizeof (fcf_serd_t), &n) != 0)
+				return (-1);
+			for (j = 0; j < n; j++) {
+				sgp = fcf_view_rec(fv, i, FCF_SECT_SERD,
+				    sizeof (fcf_serd_t), j);
+				v[0] = diff_strhash(df, sgp->fcfd_name);
+				v[1] = sgp->fcfd_n;
+				v[2] = sgp->fcfd_t;
+				if (diff_deep(df, sgp->fcfd_events,
+				    FCF_SECT_EVENTS, &v[3]) != 0 ||
+				    diff_add(df, DIFF_SERD, sgp->fcfd_name, i,
+				    j, fcf_hash(v, 4 * sizeof (uint64_t),
+				    0)) != 0)
+					return (-1);
+			}
+			break;
+		}
+	}
+
+	qsort(df->df_items, df->df_nitems, sizeof (diff_item_t),
+	    diff_item_cmp);
+	return (0);
+}
+
+/*
+ * Return B_TRUE if the two files have identical section tables and every
+ * section's data hashes the same, in which case there's nothing to decode.
+ */
+static boolean_t
+diff_identical(diff_file_t *odf, diff_file_t *ndf)
+{
+	fcf_view_t *ofv = odf->df_view, *nfv = ndf->df_view;
+	uint64_t oh, nh;
+	fcf_secidx_t i;
+
+	if (ofv->fv_secnum != nfv->fv_secnum)
+		return (B_FALSE);
+
+	for (i = 0; i < ofv->fv_secnum; i++) {
+		if (bcmp(fcf_view_sec(ofv, i), fcf_view_sec(nfv, i),
+		    sizeof (fcf_sec_t)) != 0)
+			return (B_FALSE);
+	}
+	for (i = 0; i < ofv->fv_secnum; i++) {
+		if (fcf_view_sechash(ofv, i, &oh) != 0 ||
+		    fcf_view_sechash(nfv, i, &nh) != 0 || oh != nh)
+			return (B_FALSE);
+	}
+	return (B_TRUE);
+}
+
+static int
+diff_event_cmp(const void *l, const void *r)
+{
+	const fcf_event_t *le = l, *re = r;
+
+	if (le->fcfe_todsec != re->fcfe_todsec)
+		return (le->fcfe_todsec < re->fcfe_todsec ? -1 : 1);
+	if (le->fcfe_todnsec != re->fcfe_todnsec)
+		return (le->fcfe_todnsec < re->fcfe_todnsec ? -1 : 1);
+	if (le->fcfe_inode != re->fcfe_inode)
+		return (le->fcfe_inode < re->fcfe_inode ? -1 : 1);
+	if (le->fcfe_offset != re->fcfe_offset)
+		return (le->fcfe_offset < re->fcfe_offset ? -1 : 1);
+	return (0);
+}
+
+/*
+ * Copy the events in an EVENTS section out so that they can be sorted.
+ */
+static fcf_event_t *
+diff_events(diff_file_t *df, fcf_secidx_t sid, uint_t *np)
+{
+	fcf_view_t *fv = df->df_view;
+	fcf_event_t *evs;
+	uint_t i, n = 0;
+
+	*np = 0;
+	if (sid != FCF_SECIDX_NONE && fcf_view_nrecs(fv, sid,
+	    FCF_SECT_EVENTS, sizeof (fcf_event_t), &n) != 0) {
+		diff_error(df);
+		n = 0;
+	}
+	if ((evs = calloc(n + 1, sizeof (fcf_event_t))) == NULL)
+		return (NULL);
+
+	for (i = 0; i < n; i++) {
+		bcopy(fcf_view_rec(fv, sid, FCF_SECT_EVENTS,
+		    sizeof (fcf_event_t), i), &evs[i], sizeof (fcf_event_t));
+	}
+	qsort(evs, n, sizeof (fcf_event_t), diff_event_cmp);
+
+	*np = n;
+	return (evs);
+}
+
+static void
+diff_print_event(diff_file_t *df, const char *what, const fcf_atom_t *key,
+    char sign, const fcf_event_t *ep)
+{
+	diff_printf(df->df_diff, "~ %s %s: %c event %" PRIu64 ".%09" PRIu64
+	    " dev %u,%u inode %" PRIu64 " offset %" PRIu64 "\n", what,
+	    key->fa_str, sign, ep->fcfe_todsec, ep->fcfe_todnsec,
+	    ep->fcfe_major, ep->fcfe_minor, ep->fcfe_inode, ep->fcfe_offset);
+}
+
+static void
+diff_eventlists(const char *what, const fcf_atom_t *key, diff_file_t *odf,
+    fcf_secidx_t osid, diff_file_t *ndf, fcf_secidx_t nsid)
+{
+	fcf_event_t *oevs, *nevs;
+	uint_t on, nn, oi = 0, ni = 0;
+	int cmp;
+
+	oevs = diff_events(odf, osid, &on);
+	nevs = diff_events(ndf, nsid, &nn);
+	if (oevs == NULL || nevs == NULL) {
+		(void) fprintf(stderr, "failed to allocate memory\n");
+		goto out;
+	}
+
+	while (oi < on || ni < nn) {
+		if (oi == on)
+			cmp = 1;
+		else if (ni == nn)
+			cmp = -1;
+		else
+			cmp = diff_event_cmp(&oevs[oi], &nevs[ni]);
+
+		if (cmp < 0) {
+			diff_print_event(odf, what, key, '-', &oevs[oi++]);
+		} else if (cmp > 0) {
+			diff_print_event(ndf, what, key, '+', &nevs[ni++]);
+		} else {
+			oi++;
+			ni++;
+		}
+	}
+out:
+	free(oevs);
+	free(nevs);
+}
+
+static size_t
+diff_bufsize(diff_file_t *df, fcf_secidx_t sid)
+{
+	size_t size = 0;
+
+	if (sid != FCF_SECIDX_NONE)
+		(void) fcf_view_data(df->df_view, sid, FCF_SECT_BUFFER, &size);
+	return (size);
+}
+
+/*
+ * Report the differences between the buffers of two versions of a case.
+ */
+static void
+diff_buflists(const fcf_atom_t *key, diff_file_t *odf, fcf_secidx_t osid,
+    diff_file_t *ndf, fcf_secidx_t nsid)
+{
+	diff_file_t *dfs[2] = { odf, ndf };
+	fcf_secidx_t sids[2] = { osid, nsid };
+	uint_t n[2] = { 0, 0 }, i, j, k;
+	const fcf_buf_t *bp, *obp;
+	const fcf_atom_t *name;
+	uint64_t h, oh;
+
+	for (k = 0; k < 2; k++) {
+		if (sids[k] != FCF_SECIDX_NONE &&
+		    fcf_view_nrecs(dfs[k]->df_view, sids[k], FCF_SECT_BUFS,
+		    sizeof (fcf_buf_t), &n[k]) != 0)
+			diff_error(dfs[k]);
+	}
+
+	/*
+	 * Buffer lists are short, so a simple nested loop will do.  Buffers
+	 * that only exist on one side are reported from that side.
+	 */
+	for (k = 0; k < 2; k++) {
+		for (i = 0; i < n[k]; i++) {
+			bp = fcf_view_rec(dfs[k]->df_view, sids[k],
+			    FCF_SECT_BUFS, sizeof (fcf_buf_t), i);
+			name = fcf_view_atom(dfs[k]->df_view, bp->fcfb_name);
+			obp = NULL;
+			for (j = 0; name != NULL && j < n[1 - k]; j++) {
+				obp = fcf_view_rec(dfs[1 - k]->df_view,
+				    sids[1 - k], FCF_SECT_BUFS,
+				    sizeof (fcf_buf_t), j);
+				if (fcf_view_atom(dfs[1 - k]->df_view,
+				    obp->fcfb_name) == name)
+					break;
+				obp = NULL;
+			}
+			if (name == NULL)
+				continue;
+
+			if (obp == NULL) {
+				diff_printf(odf->df_diff, "~ case %s: %c buf "
+				    "%s (%zu bytes)\n", key->fa_str,
+				    k == 0 ? '-' : '+', name->fa_str,
+				    diff_bufsize(dfs[k], bp->fcfb_data));
+				continue;
+			}
+			if (k == 1)
+				continue;
+
+			if (diff_deep(dfs[0], bp->fcfb_data, FCF_SECT_BUFFER,
+			    &oh) != 0 || diff_deep(dfs[1], obp->fcfb_data,
+			    FCF_SECT_BUFFER, &h) != 0 || oh != h) {
+				diff_printf(odf->df_diff, "~ case %s: buf %s "
+				    "changed (%zu -> %zu bytes)\n", key->fa_str,
+				    name->fa_str, diff_bufsize(dfs[0],
+				    bp->fcfb_data), diff_bufsize(dfs[1],
+				    obp->fcfb_data));
+			}
+		}
+	}
+}
+
+static uint_t
+diff_nrecs(diff_file_t *df, fcf_secidx_t sid, uint_t type, size_t recsz)
+{
+	uint_t n = 0;
+
+	if (sid != FCF_SECIDX_NONE &&
+	    fcf_view_nrecs(df->df_view, sid, type, recsz, &n) != 0)
+		n = 0;
+	return (n);
+}
+
+static uint_t
+diff_nnvl(diff_file_t *df, fcf_secidx_t sid)
+{
+	const char *buf;
+	size_t off = 0, size;
+	uint_t n = 0;
+
+	if (sid == FCF_SECIDX_NONE)
+		return (0);
+	while (fcf_view_nvl(df->df_view, sid, &off, &buf, &size) > 0)
+		n++;
+	return (n);
+}
+
+/*
+ * Describe an item that only exists in one of the files.
+ */
+static void
+diff_print_item(char sign, diff_file_t *df, const diff_item_t *dip)
+{
+	fcf_view_t *fv = df->df_view;
+	const fcf_case_t *cp;
+	const fcf_serd_t *sgp;
+	const fcf_buf_t *bp;
+
+	switch (dip->di_kind) {
+	case DIFF_BUF:
+		bp = fcf_view_rec(fv, dip->di_sid, FCF_SECT_BUFS,
+		    sizeof (fcf_buf_t), dip->di_idx);
+		diff_printf(df->df_diff, "%c buf %s (%zu bytes)\n", sign,
+		    dip->di_key->fa_str, diff_bufsize(df, bp->fcfb_data));
+		break;
+	case DIFF_CASE:
+		cp = fcf_view_rec(fv, dip->di_sid, FCF_SECT_CASE,
+		    sizeof (fcf_case_t), 0);
+		diff_printf(df->df_diff, "%c case %s (%s, %u events, %u "
+		    "suspects)\n", sign, dip->di_key->fa_str,
+		    fcf_case_state_name(cp->fcfc_state), diff_nrecs(df,
+		    cp->fcfc_events, FCF_SECT_EVENTS, sizeof (fcf_event_t)),
+		    diff_nnvl(df, cp->fcfc_suspects));
+		break;
+	case DIFF_SERD:
+		sgp = fcf_view_rec(fv, dip->di_sid, FCF_SECT_SERD,
+		    sizeof (fcf_serd_t), dip->di_idx);
+		diff_printf(df->df_diff, "%c serd %s (N=%u, T=%" PRIu64
+		    "ns, %u events)\n", sign, dip->di_key->fa_str,
+		    sgp->fcfd_n, sgp->fcfd_t,
+		    diff_nrecs(df, sgp->fcfd_events, FCF_SECT_EVENTS,
+		    sizeof (fcf_event_t)));
+		break;
+	}
+}
+
+/*
+ * Report the differences between two suspect lists.  Suspects are compared
+ * by the hash of their packed nvlist.
+ */
+static void
+diff_suspects(const fcf_atom_t *key, diff_file_t *odf, fcf_secidx_t osid,
+    diff_file_t *ndf, fcf_secidx_t nsid)
+{
+	diff_file_t *dfs[2] = { odf, ndf };
+	fcf_secidx_t sids[2] = { osid, nsid };
+	const char *buf, *obuf;
+	size_t off, ooff, size, osize;
+	uint_t i, k;
+	boolean_t found;
+
+	for (k = 0; k < 2; k++) {
+		if (sids[k] == FCF_SECIDX_NONE)
+			continue;
+		for (off = 0, i = 0; fcf_view_nvl(dfs[k]->df_view, sids[k],
+		    &off, &buf, &size) > 0; i++) {
+			found = B_FALSE;
+			ooff = 0;
+			while (!found && sids[1 - k] != FCF_SECIDX_NONE &&
+			    fcf_view_nvl(dfs[1 - k]->df_view, sids[1 - k],
+			    &ooff, &obuf, &osize) > 0) {
+				found = size == osize &&
+				    bcmp(buf, obuf, size) == 0;
+			}
+			if (!found) {
+				diff_printf(odf->df_diff, "~ case %s: %c "
+				    "suspect %u (%zu bytes)\n", key->fa_str,
+				    k == 0 ? '-' : '+', i, size);
+			}
+		}
+	}
+}
+
+/*
+ * Decode and report the differences between two versions of an item whose
+ * deep hashes differ.
+ */
+static void
+diff_changed(diff_file_t *odf, const diff_item_t *odip, diff_file_t *ndf,
+    const diff_item_t *ndip)
+{
+	const fcf_case_t *ocp, *ncp;
+	const fcf_serd_t *osgp, *nsgp;
+	const fcf_buf_t *obp, *nbp;
+	uint64_t oh, nh;
+
+	switch (odip->di_kind) {
+	case DIFF_BUF:
+		obp = fcf_view_rec(odf->df_view, odip->di_sid, FCF_SECT_BUFS,
+		    sizeof (fcf_buf_t), odip->di_idx);
+		nbp = fcf_view_rec(ndf->df_view, ndip->di_sid, FCF_SECT_BUFS,
+		    sizeof (fcf_buf_t), ndip->di_idx);
+		diff_printf(odf->df_diff, "~ buf %s: changed (%zu -> %zu "
+		    "bytes)\n", odip->di_key->fa_str,
+		    diff_bufsize(odf, obp->fcfb_data),
+		    diff_bufsize(ndf, nbp->fcfb_data));
+		break;
+
+	case DIFF_CASE:
+		ocp = fcf_view_rec(odf->df_view, odip->di_sid, FCF_SECT_CASE,
+		    sizeof (fcf_case_t), 0);
+		ncp = fcf_view_rec(ndf->df_view, ndip->di_sid, FCF_SECT_CASE,
+		    sizeof (fcf_case_t), 0);
+		if (ocp->fcfc_state != ncp->fcfc_state) {
+			diff_printf(odf->df_diff, "~ case %s: state %s -> %s\n",
+			    odip->di_key->fa_str,
+			    fcf_case_state_name(ocp->fcfc_state),
+			    fcf_case_state_name(ncp->fcfc_state));
+		}
+		if (diff_deep(odf, ocp->fcfc_principal, FCF_SECT_EVENTS,
+		    &oh) != 0 || diff_deep(ndf, ncp->fcfc_principal,
+		    FCF_SECT_EVENTS, &nh) != 0 || oh != nh) {
+			diff_printf(odf->df_diff, "~ case %s: principal event "
+			    "changed\n", odip->di_key->fa_str);
+		}
+		if (diff_deep(odf, ocp->fcfc_events, FCF_SECT_EVENTS,
+		    &oh) != 0 || diff_deep(ndf, ncp->fcfc_events,
+		    FCF_SECT_EVENTS, &nh) != 0 || oh != nh) {
+			diff_eventlists("case", odip->di_key, odf,
+			    ocp->fcfc_events, ndf, ncp->fcfc_events);
+		}
+		if (diff_deep(odf, ocp->fcfc_suspects, FCF_SECT_NVLISTS,
+		    &oh) != 0 || diff_deep(ndf, ncp->fcfc_suspects,
+		    FCF_SECT_NVLISTS, &nh) != 0 || oh != nh) {
+			diff_suspects(odip->di_key, odf, ocp->fcfc_suspects,
+			    ndf, ncp->fcfc_suspects);
+		}
+		if (diff_deep(odf, ocp->fcfc_bufs, FCF_SECT_BUFS,
+		    &oh) != 0 || diff_deep(ndf, ncp->fcfc_bufs,
+		    FCF_SECT_BUFS, &nh) != 0 || oh != nh) {
+			diff_buflists(odip->di_key, odf, ocp->fcfc_bufs, ndf,
+			    ncp->fcfc_bufs);
+		}
+		break;
+
+	case DIFF_SERD:
+		osgp = fcf_view_rec(odf->df_view, odip->di_sid, FCF_SECT_SERD,
+		    sizeof (fcf_serd_t), odip->di_idx);
+		nsgp = fcf_view_rec(ndf->df_view, ndip->di_sid, FCF_SECT_SERD,
+		    sizeof (fcf_serd_t), ndip->di_idx);
+		if (osgp->fcfd_n != nsgp->fcfd_n ||
+		    osgp->fcfd_t != nsgp->fcfd_t) {
+			diff_printf(odf->df_diff, "~ serd %s: N=%u, T=%" PRIu64
+			    "ns -> N=%u, T=%" PRIu64 "ns\n",
+			    odip->di_key->fa_str,
+			    osgp->fcfd_n, osgp->fcfd_t, nsgp->fcfd_n,
+			    nsgp->fcfd_t);
+		}
+		diff_eventlists("serd", odip->di_key, odf, osgp->fcfd_events,
+		    ndf, nsgp->fcfd_events);
+		break;
+	}
+}
+
+static boolean_t
+diff_module(diff_file_t *odf, diff_file_t *ndf)
+{
+	static const char *const fields[] = { "path", "desc", "vers" };
+	const fcf_module_t *om = odf->df_mod, *nm = ndf->df_mod;
+	fcf_stridx_t osids[3], nsids[3];
+	boolean_t changed = B_FALSE;
+	uint_t i;
+
+	osids[0] = om->fcfm_path;
+	osids[1] = om->fcfm_desc;
+	osids[2] = om->fcfm_vers;
+	nsids[0] = nm->fcfm_path;
+	nsids[1] = nm->fcfm_desc;
+	nsids[2] = nm->fcfm_vers;
+
+	for (i = 0; i < 3; i++) {
+		const char *os = fcf_view_str(odf->df_view, osids[i]);
+		const char *ns = fcf_view_str(ndf->df_view, nsids[i]);
+
+		if (strcmp(os, ns) != 0) {
+			diff_printf(odf->df_diff, "~ module %s: \"%s\" -> "
+			    "\"%s\"\n", fields[i], os, ns);
+			changed = B_TRUE;
+		}
+	}
+	return (changed);
+}
+
+static void
+diff_fini(diff_file_t *df)
+{
+	free(df->df_items);
+	free(df->df_deep);
+	free(df->df_deepdone);
+}
+
+/*
+ * Compare the two files and print their differences, preceded by the banner
+ * (if any) and a header naming the files.  Nothing is printed if they're
+ * equivalent.  Returns 0 if they're equivalent, 1 if they differ and 2 on
+ * error.  Both views must already have been opened, with string tables
+ * interned in the same atom table.
+ */
+int
+diff_views(fcf_view_t *ofv, fcf_view_t *nfv, const char *banner)
+{
+	diff_t d = { 0 };
+	diff_file_t odf = { 0 }, ndf = { 0 };
+	const diff_item_t *oi, *ni, *oend, *nend;
+	const char *oname, *nname;
+	int cmp, status = 0;
+
+	d.d_banner = banner;
+	d.d_old = ofv;
+	d.d_new = nfv;
+	odf.df_diff = ndf.df_diff = &d;
+	odf.df_view = ofv;
+	ndf.df_view = nfv;
+
+	if (diff_identical(&odf, &ndf))
+		goto out;
+
+	if (diff_load(&odf) != 0) {
+		diff_error(&odf);
+		status = 2;
+		goto out;
+	}
+	if (diff_load(&ndf) != 0) {
+		diff_error(&ndf);
+		status = 2;
+		goto out;
+	}
+
+	if (odf.df_mod != NULL && ndf.df_mod != NULL) {
+		oname = fcf_view_str(odf.df_view, odf.df_mod->fcfm_name);
+		nname = fcf_view_str(ndf.df_view, ndf.df_mod->fcfm_name);
+		if (strcmp(oname, nname) != 0) {
+			(void) fprintf(stderr, "checkpoints are for different "
+			    "modules (%s, %s)\n", oname, nname);
+			status = 2;
+			goto out;
+		}
+		if (diff_module(&odf, &ndf))
+			status = 1;
+	}
+
+	oi = odf.df_items;
+	oend = oi + odf.df_nitems;
+	ni = ndf.df_items;
+	nend = ni + ndf.df_nitems;
+
+	while (oi < oend || ni < nend) {
+		if (oi == oend)
+			cmp = 1;
+		else if (ni == nend)
+			cmp = -1;
+		else
+			cmp = diff_item_cmp(oi, ni);
+
+		if (cmp < 0) {
+			diff_print_item('-', &odf, oi++);
+			status = 1;
+		} else if (cmp > 0) {
+			diff_print_item('+', &ndf, ni++);
+			status = 1;
+		} else {
+			if (oi->di_hash != ni->di_hash) {
+				diff_changed(&odf, oi, &ndf, ni);
+				status = 1;
+			}
+			oi++;
+			ni++;
+		}
+	}
+
+out:
+	diff_fini(&odf);
+	diff_fini(&ndf);
+
+	return (status);
+}
+
+/*
+ * Report everything in a checkpoint as having been added.  Returns 0 if it's
+ * empty, 1 otherwise and 2 on error.
+ */
+int
+diff_view_items(fcf_view_t *fv, const char *banner)
+{
+	diff_t d = { 0 };
+	diff_file_t df = { 0 };
+	uint_t i;
+	int status;
+
+	d.d_banner = banner;
+	d.d_new = fv;
+	df.df_diff = &d;
+	df.df_view = fv;
+
+	if (diff_load(&df) != 0) {
+		diff_error(&df);
+		status = 2;
+	} else {
+		for (i = 0; i < df.df_nitems; i++)
+			diff_print_item('+', &df, &df.df_items[i]);
+		status = df.df_nitems != 0 ? 1 : 0;
+	}
+
+	diff_fini(&df);
+	return (status);
+}
+
+static void
+diff_usage(void)
+{
+	(void) fprintf(stderr, "usage: %s diff old-checkpoint "
+	    "new-checkpoint\n\n", pname);
+}
+
+int
+do_diff(int argc, char **argv)
+{
+	fcf_view_t ofv, nfv;
+	fcf_atomtab_t *fat;
+	int c, oerr, nerr, status = 2;
+
+	while ((c = getopt(argc, argv, "")) != -1) {
+		diff_usage();
+		return (2);
+	}
+	if (argc - optind != 2) {
+		diff_usage();
+		return (2);
+	}
+
+	if ((fat = fcf_atomtab_create()) == NULL) {
+		(void) fprintf(stderr, "failed to allocate memory\n");
+		return (2);
+	}
+
+	/*
+	 * Both string tables are interned in the same atom table, so that
+	 * strings can be compared between the files by identity.
+	 */
+	if ((oerr = fcf_view_open(&ofv, argv[optind])) != 0)
+		(void) fprintf(stderr, "%s\n", ofv.fv_errmsg);
+	if ((nerr = fcf_view_open(&nfv, argv[optind + 1])) != 0)
+		(void) fprintf(stderr, "%s\n", nfv.fv_errmsg);
+
+	if (oerr != 0 || nerr != 0)
+		status = 2;
+	else if (fcf_view_strings(&ofv, fat) != 0)
+		(void) fprintf(stderr, "%s: %s\n", ofv.fv_path, ofv.fv_errmsg);
+	else if (fcf_view_strings(&nfv, fat) != 0)
+		(void) fprintf(stderr, "%s: %s\n", nfv.fv_path, nfv.fv_errmsg);
+	else
+		status = diff_views(&ofv, &nfv, NULL);
+
+	fcf_view_close(&ofv);
+	fcf_view_close(&nfv);
+	fcf_atomtab_destroy(fat);
+	return (status);
+}
@@ -8,229 +8,483 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <errno.h>
-#include <fcntl.h>
+#include <inttypes.h>
+#include <stdarg.h>
 #include <string.h>
+#include <unistd.h>
 #include <sys/types.h>
-#include <sys/stat.h>
 
-/*
- * These headers aren't delivered, so we'll have to build against an ON source
- * tree.  See the comments in the makefile.
- */
-#include <fmd_ckpt.h>
-#include <fmd_module.h>
+#include "fcf.h"
+#include "dump-fmd-ckpt.h"
 
-typedef struct fmd_ckpt_strtab {
-	char *ckp_strp;		/* string table pointer */
-	size_t ckp_strsz;	/* string table size */
-} fmd_ckpt_strtab_t;
+const char *pname;
+static const char optstr[] = "o:s:t:";
 
-static fmd_ckpt_strtab_t strtab = { 0 };
+static void
+usage()
+{
+	(void) fprintf(stderr, "usage: %s [-o format] [-s secidx[,...]] "
+	    "[-t type[,...]] <ckpt file>\n"
+	    "       %s scan [-j nthreads] [-o format] [-s secidx[,...]] "
+	    "[-t type[,...]] [root]\n"
+	    "       %s diff <old ckpt file> <new ckpt file>\n"
+	    "       %s watch [-p] [-i interval] [root]\n"
+	    "       %s gen [-b bufsize] [-c cases] [-d serd engines] "
+	    "[-e events] [-g cgen]\n"
+	    "           [-m module] [-n suspects] [-r seed] [-S size] "
+	    "<ckpt file>\n"
+	    "       %s bench [-n passes] [-o format] <ckpt file> ...\n"
+	    "       %s compact [-d state[,...] | -k] [-o output] <ckpt file>\n"
+	    "       %s tar [-o format] [-s secidx[,...]] [-t type[,...]] "
+	    "[archive ...]\n"
+	    "       %s export -d dir [root | store | archive | ckpt file] ...\n"
+	    "       %s history [-i interval] -d store [root]\n"
+	    "       %s history -l -d store [module]\n"
+	    "       %s history -d store [-g generation] -o output module\n"
+	    "       %s serd [-j nthreads] [-n N[,...]] [-t T[,...]]\n"
+	    "           [root | store | archive | ckpt file] ...\n\n"
+	    "where \'type\' can be:\n"
+	    "strtab, module, case, bufs, buffer, serd, events, nvlists\n\n"
+	    "and \'format\' can be:\n"
+	    "text (the default), json, binary\n\n"
+	    "and \'state\' can be:\n"
+	    "unsolved, solved, close_wait\n\n",
+	    pname, pname, pname, pname, pname, pname, pname, pname, pname,
+	    pname, pname, pname, pname);
+}
 
 /*
- * adapted from fcf_hdr() in usr/src/cmd/fm/fmd/common/fmd_mdb.c
+ * Errors go to their own stream, but flush the output first so that they
+ * appear in order when both end up in the same place.
  */
 static void
-dump_fcf_hdr(fcf_hdr_t *h)
-{
-	(void) printf("==========\n");
-	(void) printf("FCF Header\n");
-	(void) printf("==========\n");
-        (void) printf("fcfh_ident.id_magic = 0x%x, %c, %c, %c\n",
-            h->fcfh_ident[FCF_ID_MAG0], h->fcfh_ident[FCF_ID_MAG1],
-            h->fcfh_ident[FCF_ID_MAG2], h->fcfh_ident[FCF_ID_MAG3]);
-
-	switch (h->fcfh_ident[FCF_ID_MODEL]) {
-	case FCF_MODEL_ILP32:
-                (void) printf("fcfh_ident.id_model = ILP32\n");
-                break;
-	case FCF_MODEL_LP64:
-                (void) printf("fcfh_ident.id_model = LP64\n");
-                break;
-	default:
-                (void) printf("fcfh_ident.id_model = 0x%x\n",
-                    h->fcfh_ident[FCF_ID_MODEL]);
+dump_error(dump_ctx_t *dc, const char *fmt, ...)
+{
+	va_list ap;
+
+	out_flush(dc->dc_out);
+
+	va_start(ap, fmt);
+	(void) vfprintf(dc->dc_err, fmt, ap);
+	va_end(ap);
+}
+
+static void
+dump_sec_strtab(dump_ctx_t *dc, fcf_view_t *fv, fcf_secidx_t sid)
+{
+	dump_out_t *o = dc->dc_out;
+	fcf_strtab_t fs;
+	const char *strs;
+	size_t size;
+	uint32_t i;
+
+	if ((strs = fcf_view_data(fv, sid, FCF_SECT_STRTAB, &size)) == NULL) {
+		dump_error(dc, "%s\n", fv->fv_errmsg);
+		return;
 	}
 
-	switch (h->fcfh_ident[FCF_ID_ENCODING]) {
-	case FCF_ENCODE_LSB:
-                (void) printf("fcfh_ident.id_encoding = LSB\n");
-                break;
-	case FCF_ENCODE_MSB:
-                (void) printf("fcfh_ident.id_encoding = MSB\n");
-                break;
-	default:
-                (void) printf("fcfh_ident.id_encoding = 0x%x\n",
-                    h->fcfh_ident[FCF_ID_ENCODING]);
+	if (fcf_strtab_init(&fs, strs, size, NULL, fv->fv_errmsg,
+	    sizeof (fv->fv_errmsg)) != 0) {
+		dump_error(dc, "section %u: %s\n", sid, fv->fv_errmsg);
+	} else {
+		for (i = 0; i < fs.fs_nstrs; i++) {
+			o->do_fmt->df_str(o, sid, fs.fs_offs[i],
+			    strs + fs.fs_offs[i]);
+		}
+		o->do_fmt->df_secend(o, sid);
 	}
+	fcf_strtab_fini(&fs);
+}
 
-	(void) printf("fcfh_ident.id_version = %u\n",
-            h->fcfh_ident[FCF_ID_VERSION]);
+static void
+dump_sec_module(dump_ctx_t *dc, fcf_view_t *fv, fcf_secidx_t sid)
+{
+	dump_out_t *o = dc->dc_out;
+	const fcf_module_t *fmmod;
+
+	if ((fmmod = fcf_view_rec(fv, sid, FCF_SECT_MODULE,
+	    sizeof (fcf_module_t), 0)) == NULL) {
+		dump_error(dc, "%s\n", fv->fv_errmsg);
+		return;
+	}
 
-	(void) printf("fcfh_flags = 0x%x\n", h->fcfh_flags);
-	(void) printf("fcfh_hdrsize = %u bytes\n", h->fcfh_hdrsize);
-	(void) printf("fcfh_secsize = %u bytes\n", h->fcfh_secsize);
-	(void) printf("fcfh_secnum = %u\n", h->fcfh_secnum);
-	(void) printf("fcfh_secoff = %llu bytes\n", h->fcfh_secoff);
-	(void) printf("fcfh_filesz = %llu bytes\n", h->fcfh_filesz);
-	(void) printf("fcfh_cgen = %llu\n\n", h->fcfh_cgen);
+	o->do_fmt->df_module(o, fv, sid, fmmod);
+	o->do_fmt->df_secend(o, sid);
 }
 
-static const char *
-getstr(fcf_stridx_t sid)
+static void
+dump_sec_case(dump_ctx_t *dc, fcf_view_t *fv, fcf_secidx_t sid)
 {
-        return (sid < strtab.ckp_strsz ? strtab.ckp_strp + sid : "<CORRUPT>");
+	dump_out_t *o = dc->dc_out;
+	const fcf_case_t *fmcase;
+
+	if ((fmcase = fcf_view_rec(fv, sid, FCF_SECT_CASE,
+	    sizeof (fcf_case_t), 0)) == NULL) {
+		dump_error(dc, "%s\n", fv->fv_errmsg);
+		return;
+	}
+
+	o->do_fmt->df_case(o, fv, sid, fmcase);
+	o->do_fmt->df_secend(o, sid);
 }
 
 static void
-dump_sec_case(fcf_case_t *fmcase)
+dump_sec_bufs(dump_ctx_t *dc, fcf_view_t *fv, fcf_secidx_t sid)
 {
-	(void) printf("fcfc_uuid = %s (0x%x)\n",
-	    getstr(fmcase->fcfc_uuid), fmcase->fcfc_uuid);
-	(void) printf("fcfc_state = %u\n", fmcase->fcfc_state);
-	(void) printf("fcfc_bufs = %u\n", fmcase->fcfc_bufs);
-	(void) printf("fcfc_events = %u\n", fmcase->fcfc_events);
-	(void) printf("fcfc_suspects = %u\n\n", fmcase->fcfc_suspects);
+	dump_out_t *o = dc->dc_out;
+	uint_t i, n;
+
+	if (fcf_view_nrecs(fv, sid, FCF_SECT_BUFS, sizeof (fcf_buf_t),
+	    &n) != 0) {
+		dump_error(dc, "%s\n", fv->fv_errmsg);
+		return;
+	}
+
+	for (i = 0; i < n; i++) {
+		o->do_fmt->df_buf(o, fv, sid, i, fcf_view_rec(fv, sid,
+		    FCF_SECT_BUFS, sizeof (fcf_buf_t), i));
+	}
+	o->do_fmt->df_secend(o, sid);
 }
 
 static void
-dump_sec_module(fcf_module_t *fmmod)
+dump_sec_buffer(dump_ctx_t *dc, fcf_view_t *fv, fcf_secidx_t sid)
 {
-	(void) printf("fcfm_name = %s (0x%x)\n",
-	    getstr(fmmod->fcfm_name), fmmod->fcfm_name);
-	(void) printf("fcfm_path = %s (0x%x)\n",
-	    getstr(fmmod->fcfm_path), fmmod->fcfm_path);
-	(void) printf("fcfm_desc = %s (0x%x)\n",
-	    getstr(fmmod->fcfm_desc), fmmod->fcfm_desc);	
-	(void) printf("fcfm_vers = %s (0x%x)\n\n",
-	    getstr(fmmod->fcfm_vers), fmmod->fcfm_vers);
+	dump_out_t *o = dc->dc_out;
+	const uchar_t *data;
+	size_t size;
+
+	if ((data = fcf_view_data(fv, sid, FCF_SECT_BUFFER, &size)) == NULL) {
+		dump_error(dc, "%s\n", fv->fv_errmsg);
+		return;
+	}
+
+	o->do_fmt->df_buffer(o, sid, data, size);
+	o->do_fmt->df_secend(o, sid);
 }
 
 static void
-dump_sec_hdr(fcf_sec_t *s, char *ckpt_buf)
-{
-	fcf_case_t *fmcase;
-	fcf_module_t *fmmod;
-
-        static const char *const types[] = {
-                "none",         /* FCF_SECT_NONE */
-                "strtab",       /* FCF_SECT_STRTAB */
-                "module",       /* FCF_SECT_MODULE */
-                "case",         /* FCF_SECT_CASE */
-                "bufs",         /* FCF_SECT_BUFS */
-                "buffer",       /* FCF_SECT_BUFFER */
-                "serd",         /* FCF_SECT_SERD */
-                "events",       /* FCF_SECT_EVENTS */
-                "nvlists",      /* FCF_SECT_NVLISTS */
-        };
-
-	(void) printf("%-10s %-5s %-5s %-5s %-6s %-5s\n",
-	    "TYPE", "ALIGN", "FLAGS", "ENTSZ", "OFF", "SIZE");
-
-	if (s->fcfs_type < sizeof (types) / sizeof (types[0]))
-		(void) printf("%-10s ", types[s->fcfs_type]);
-	else
-		(void) printf("%-10u ", s->fcfs_type);
-
-	(void) printf("%-5u %-#5x %-#5x %-6llx %-#5llx\n\n", s->fcfs_align,
-	    s->fcfs_flags, s->fcfs_entsize, s->fcfs_offset, s->fcfs_size);
+dump_sec_serd(dump_ctx_t *dc, fcf_view_t *fv, fcf_secidx_t sid)
+{
+	dump_out_t *o = dc->dc_out;
+	uint_t i, n;
+
+	if (fcf_view_nrecs(fv, sid, FCF_SECT_SERD, sizeof (fcf_serd_t),
+	    &n) != 0) {
+		dump_error(dc, "%s\n", fv->fv_errmsg);
+		return;
+	}
+
+	for (i = 0; i < n; i++) {
+		o->do_fmt->df_serd(o, fv, sid, i, fcf_view_rec(fv, sid,
+		    FCF_SECT_SERD, sizeof (fcf_serd_t), i));
+	}
+	o->do_fmt->df_secend(o, sid);
+}
+
+static void
+dump_sec_events(dump_ctx_t *dc, fcf_view_t *fv, fcf_secidx_t sid)
+{
+	dump_out_t *o = dc->dc_out;
+	uint_t i, n;
+
+	if (fcf_view_nrecs(fv, sid, FCF_SECT_EVENTS, sizeof (fcf_event_t),
+	    &n) != 0) {
+		dump_error(dc, "%s\n", fv->fv_errmsg);
+		return;
+	}
+
+	for (i = 0; i < n; i++) {
+		o->do_fmt->df_event(o, sid, i, fcf_view_rec(fv, sid,
+		    FCF_SECT_EVENTS, sizeof (fcf_event_t), i));
+	}
+	o->do_fmt->df_secend(o, sid);
+}
+
+static void
+dump_sec_nvlists(dump_ctx_t *dc, fcf_view_t *fv, fcf_secidx_t sid)
+{
+	dump_out_t *o = dc->dc_out;
+	const char *buf;
+	size_t off = 0, size;
+	uint_t i;
+	int rv;
+
+	for (i = 0; (rv = fcf_view_nvl(fv, sid, &off, &buf, &size)) > 0; i++)
+		o->do_fmt->df_nvl(o, sid, i, buf, size);
+	if (rv < 0)
+		dump_error(dc, "%s\n", fv->fv_errmsg);
+	o->do_fmt->df_secend(o, sid);
+}
+
+static void
+dump_sec_hdr(dump_ctx_t *dc, fcf_view_t *fv, fcf_secidx_t sid)
+{
+	const fcf_sec_t *s = fcf_view_sec(fv, sid);
+
+	dc->dc_out->do_fmt->df_sec(dc->dc_out, fv, sid);
 
 	switch (s->fcfs_type) {
 	case (FCF_SECT_NONE):
 		break;
-	case (FCF_SECT_CASE):
-		fmcase = (fcf_case_t *)(ckpt_buf + s->fcfs_offset);
-		dump_sec_case(fmcase);
+	case (FCF_SECT_STRTAB):
+		dump_sec_strtab(dc, fv, sid);
 		break;
 	case (FCF_SECT_MODULE):
-		fmmod = (fcf_module_t *)(ckpt_buf + s->fcfs_offset);
-		dump_sec_module(fmmod);
+		dump_sec_module(dc, fv, sid);
+		break;
+	case (FCF_SECT_CASE):
+		dump_sec_case(dc, fv, sid);
 		break;
-	case (FCF_SECT_STRTAB):
 	case (FCF_SECT_BUFS):
+		dump_sec_bufs(dc, fv, sid);
+		break;
 	case (FCF_SECT_BUFFER):
+		dump_sec_buffer(dc, fv, sid);
+		break;
 	case (FCF_SECT_SERD):
+		dump_sec_serd(dc, fv, sid);
+		break;
 	case (FCF_SECT_EVENTS):
+		dump_sec_events(dc, fv, sid);
+		break;
 	case (FCF_SECT_NVLISTS):
+		dump_sec_nvlists(dc, fv, sid);
 		break;
 	default:
-		(void) fprintf(stderr, "Unrecognized section type: %u\n",
+		dump_error(dc, "Unrecognized section type: %u\n",
 		    s->fcfs_type);
 	}
 }
 
+/*
+ * Parse a comma-separated list of section indices (-s) or section type names
+ * (-t) into the selection.  Sections that aren't selected are skipped without
+ * their data ever being touched.
+ */
 int
-main(int argc, char **argv)
+parse_secs(char *arg, dump_sel_t *sel)
 {
-	int fd, i;
-	struct stat64 st;
-	char *ckbuf = NULL;
-	fcf_hdr_t *hdr;
-	fcf_sec_t *sec;
+	char *p, *end, *last;
+	ulong_t sid;
 
-	if (argc != 2) {
-		(void) fprintf(stderr, "\nUsage: %s <ckpt file>\n\n",
-		    argv[0]);
-		exit (2);
+	for (p = strtok_r(arg, ",", &last); p != NULL;
+	    p = strtok_r(NULL, ",", &last)) {
+		errno = 0;
+		sid = strtoul(p, &end, 0);
+		if (errno != 0 || *end != '\0' || sid > UINT32_MAX) {
+			(void) fprintf(stderr, "invalid section index: %s\n",
+			    p);
+			return (-1);
+		}
+		if (sel->ds_nsecs == DUMP_MAXSEL) {
+			(void) fprintf(stderr, "too many sections selected\n");
+			return (-1);
+		}
+		sel->ds_secs[sel->ds_nsecs++] = (fcf_secidx_t)sid;
 	}
+	return (0);
+}
 
-	if ((fd = open(argv[1], O_RDONLY)) < 0 || fstat64(fd, &st) < 0) {
-		(void) fprintf(stderr, "Failed to open checkpoint file: %s "
-		    "(%s)\n", argv[1], strerror(errno));
-	}
+const dump_fmt_t *
+parse_fmt(const char *arg)
+{
+	const dump_fmt_t *fmt;
+
+	if ((fmt = dump_fmt_lookup(arg)) == NULL)
+		(void) fprintf(stderr, "invalid output format: %s\n", arg);
+	return (fmt);
+}
 
-	if (! S_ISREG(st.st_mode)) {
-		(void) fprintf(stderr, "ABORT: not a regular file\n");
-		goto out;
+int
+parse_types(char *arg, dump_sel_t *sel)
+{
+	char *p, *last;
+	uint_t type;
+
+	for (p = strtok_r(arg, ",", &last); p != NULL;
+	    p = strtok_r(NULL, ",", &last)) {
+		if (fcf_sect_type(p, &type) != 0) {
+			(void) fprintf(stderr, "invalid section type: %s\n", p);
+			return (-1);
+		}
+		sel->ds_types |= 1U << type;
 	}
+	return (0);
+}
+
+static boolean_t
+dump_selected(const dump_sel_t *sel, fcf_secidx_t sid, uint_t type)
+{
+	uint_t i;
+
+	if (sel->ds_types != 0 && (type >= 32 ||
+	    (sel->ds_types & (1U << type)) == 0))
+		return (B_FALSE);
 
-	if ((ckbuf = calloc(st.st_size, 1)) == NULL) {
-		(void) fprintf(stderr, "failed to allocate %u byte buffer\n",
-		    st.st_size);
-		goto out;
+	if (sel->ds_nsecs == 0)
+		return (B_TRUE);
+
+	for (i = 0; i < sel->ds_nsecs; i++) {
+		if (sel->ds_secs[i] == sid)
+			return (B_TRUE);
 	}
+	return (B_FALSE);
+}
 
-	(void) read(fd, ckbuf, st.st_size); 
+static boolean_t
+dump_needstrs(const dump_sel_t *sel)
+{
+	const uint_t strtypes = (1U << FCF_SECT_MODULE) |
+	    (1U << FCF_SECT_CASE) | (1U << FCF_SECT_BUFS) |
+	    (1U << FCF_SECT_SERD);
 
-	hdr = (fcf_hdr_t *)ckbuf;
+	return (sel->ds_types == 0 || (sel->ds_types & strtypes) != 0);
+}
+
+/*
+ * Dump the selected sections of a checkpoint whose view has been opened
+ * successfully.
+ */
+void
+dump_view(dump_ctx_t *dc, fcf_view_t *fv)
+{
+	fcf_secidx_t i;
+	const fcf_sec_t *sp;
 
 	/*
-	 * First as a sanity checl, verify the magic number matches what we'd
-	 * expect for an fmd checkpoint file.
+	 * If we're going to need strings, index the string table now so
+	 * that a corrupt table is reported once, up front.
 	 */
-	if (bcmp(hdr->fcfh_ident, FCF_MAG_STRING, FCF_MAG_STRLEN) != 0) {
-		(void) fprintf(stderr, "ABORT: not an fmd checkpoint file\n");
-		goto out;
+	if (dump_needstrs(dc->dc_sel) &&
+	    fcf_view_strings(fv, dc->dc_atoms) != 0)
+		dump_error(dc, "WARNING: %s\n", fv->fv_errmsg);
+
+	dc->dc_out->do_fmt->df_hdr(dc->dc_out, fv);
+
+	for (i = 0; i < fv->fv_secnum; i++) {
+		sp = fcf_view_sec(fv, i);
+		if (dump_selected(dc->dc_sel, i, sp->fcfs_type))
+			dump_sec_hdr(dc, fv, i);
 	}
-	
-	dump_fcf_hdr(hdr);
+	out_flush(dc->dc_out);
+}
+
+/*
+ * Report a checkpoint that couldn't be opened.
+ */
+void
+dump_abort(dump_ctx_t *dc, fcf_view_t *fv)
+{
+	dump_error(dc, "ABORT: %s\n", fv->fv_errmsg);
+}
+
+/*
+ * Dump the selected sections of a single checkpoint file.  Returns 0 on
+ * success and -1 if the file couldn't be opened or isn't a checkpoint.
+ */
+int
+dump_ckpt(dump_ctx_t *dc, const char *path)
+{
+	fcf_view_t fv;
+	int rv = -1;
 
 	/*
-	 * Iterate through the section headers to find a pointer to the
-	 * string table section.
+	 * The view validates the magic number and the bounds of the section
+	 * header table before we look at anything else.
 	 */
-        for (i = 0; i < hdr->fcfh_secnum; i++) {
-                sec = (void *)hdr + hdr->fcfh_secoff + hdr->fcfh_secsize * i;
-		if (sec->fcfs_type != FCF_SECT_STRTAB)
-			continue;
+	if (fcf_view_open(&fv, path) != 0) {
+		dump_abort(dc, &fv);
+	} else {
+		dump_view(dc, &fv);
+		rv = 0;
+	}
 
-		strtab.ckp_strp = ckbuf + sec->fcfs_offset;
-		strtab.ckp_strsz = sec->fcfs_size;
-		break;
-        }
+	fcf_view_close(&fv);
+	out_flush(dc->dc_out);
+
+	return (rv);
+}
+
+int
+main(int argc, char **argv)
+{
+	dump_sel_t sel = { 0 };
+	const dump_fmt_t *fmt = &dump_fmt_text;
+	dump_out_t out;
+	dump_ctx_t dc;
+	int c, rv;
+
+	pname = argv[0];
 
-	for (i = 0; i < hdr->fcfh_secnum; i++) {
-		sec = (void *)hdr + hdr->fcfh_secoff + hdr->fcfh_secsize * i;
-		(void) printf("=============\n");
-		(void) printf("SECTION %u (addr: %lx)\n", i, sec);
-		(void) printf("=============\n");
-		dump_sec_hdr(sec, ckbuf);
+	if (argc > 1 && strcmp(argv[1], "scan") == 0)
+		return (do_scan(argc - 1, argv + 1));
+	if (argc > 1 && strcmp(argv[1], "diff") == 0)
+		return (do_diff(argc - 1, argv + 1));
+	if (argc > 1 && strcmp(argv[1], "watch") == 0)
+		return (do_watch(argc - 1, argv + 1));
+	if (argc > 1 && strcmp(argv[1], "gen") == 0)
+		return (do_gen(argc - 1, argv + 1));
+	if (argc > 1 && strcmp(argv[1], "bench") == 0)
+		return (do_bench(argc - 1, argv + 1));
+	if (argc > 1 && strcmp(argv[1], "compact") == 0)
+		return (do_compact(argc - 1, argv + 1));
+	if (argc > 1 && strcmp(argv[1], "tar") == 0)
+		return (do_tar(argc - 1, argv + 1));
+	if (argc > 1 && strcmp(argv[1], "export") == 0)
+		return (do_export(argc - 1, argv + 1));
+	if (argc > 1 && strcmp(argv[1], "history") == 0)
+		return (do_history(argc - 1, argv + 1));
+	if (argc > 1 && strcmp(argv[1], "serd") == 0)
+		return (do_serd(argc - 1, argv + 1));
+
+	while ((c = getopt(argc, argv, optstr)) != -1) {
+		switch (c) {
+		case 'o':
+			if ((fmt = parse_fmt(optarg)) == NULL)
+				return (2);
+			break;
+		case 's':
+			if (parse_secs(optarg, &sel) != 0)
+				return (2);
+			break;
+		case 't':
+			if (parse_types(optarg, &sel) != 0)
+				return (2);
+			break;
+		default:
+			usage();
+			return (2);
+		}
 	}
 
-out:
-	free(ckbuf);
-	(void) close(fd);
+	if (argc - optind != 1) {
+		usage();
+		return (2);
+	}
 
-	return (0);
-}
+	/*
+	 * The binary format refers to strings by atom, so it needs them
+	 * interned.
+	 */
+	dc.dc_atoms = NULL;
+	if (fmt == &dump_fmt_bin &&
+	    (dc.dc_atoms = fcf_atomtab_create()) == NULL) {
+		(void) fprintf(stderr, "failed to allocate memory\n");
+		return (1);
+	}
+
+	out_init(&out, stdout, fmt);
+	dc.dc_out = &out;
+	dc.dc_err = stderr;
+	dc.dc_sel = &sel;
 
+	rv = dump_ckpt(&dc, argv[optind]);
+	if (out_fini(&out) != 0) {
+		(void) fprintf(stderr, "failed to write output\n");
+		rv = -1;
+	}
+	fcf_atomtab_destroy(dc.dc_atoms);
+
+	return (rv == 0 ? 0 : 1);
+}
@@ -0,0 +1,85 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+#ifndef _DUMP_FMD_CKPT_H
+#define	_DUMP_FMD_CKPT_H
+
+#include <stdio.h>
+#include <sys/types.h>
+
+#include "fcf.h"
+#include "out.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define	DUMP_MAXSEL	64
+#define	CKPT_DEFROOT	"/var/fm/fmd/ckpt"
+
+/*
+ * Sections selected with -s and/or -t.  An empty selection selects all.
+ */
+typedef struct dump_sel {
+	uint_t ds_types;		/* mask of (1 << FCF_SECT_*) */
+	uint_t ds_nsecs;		/* number of entries in ds_secs */
+	fcf_secidx_t ds_secs[DUMP_MAXSEL]; /* selected section indices */
+} dump_sel_t;
+
+/*
+ * Where the output of dumping one checkpoint goes.  The scan subcommand
+ * points these at a per-file buffer so that files can be decoded in parallel
+ * and still be reported in order.
+ */
+typedef struct dump_ctx {
+	dump_out_t *dc_out;		/* decoded output */
+	FILE *dc_err;			/* errors */
+	const dump_sel_t *dc_sel;	/* sections to dump */
+	fcf_atomtab_t *dc_atoms;	/* shared atom table, if any */
+} dump_ctx_t;
+
+/*
+ * Called with the path and contents of each checkpoint found by
+ * ckpt_input(), tar_walk() or hist_walk().
+ */
+typedef int ckpt_func_t(const char *, const void *, size_t, void *);
+
+extern const char *pname;
+
+extern int parse_secs(char *, dump_sel_t *);
+extern int parse_types(char *, dump_sel_t *);
+extern const dump_fmt_t *parse_fmt(const char *);
+extern int dump_ckpt(dump_ctx_t *, const char *);
+extern void dump_view(dump_ctx_t *, fcf_view_t *);
+extern void dump_abort(dump_ctx_t *, fcf_view_t *);
+
+extern int ckpt_walk(const char *,
+    int (*)(const char *, const char *, void *), void *);
+extern int ckpt_input(const char *, ckpt_func_t *, void *);
+extern int tar_walk(const char *, ckpt_func_t *, void *);
+extern int hist_walk(const char *, ckpt_func_t *, void *);
+extern boolean_t hist_is_store(const char *);
+
+extern int do_scan(int, char **);
+extern int do_diff(int, char **);
+extern int do_watch(int, char **);
+extern int do_gen(int, char **);
+extern int do_bench(int, char **);
+extern int do_compact(int, char **);
+extern int do_tar(int, char **);
+extern int do_export(int, char **);
+extern int do_history(int, char **);
+extern int do_serd(int, char **);
+extern double bench_load(const char *, uint_t);
+extern int diff_views(fcf_view_t *, fcf_view_t *, const char *);
+extern int diff_view_items(fcf_view_t *, const char *);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _DUMP_FMD_CKPT_H */
@@ -0,0 +1,682 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+/*
+ * "dump-fmd-ckpt export" turns any number of checkpoints into a set of
+ * column-oriented tables, for asking questions of a whole fleet's fmd state
+ * at once rather than one file at a time.
+ *
+ * There are four tables: modules, cases, serd (engines) and events.  Each
+ * column of each table is a separate file, <table>.<column>, holding one
+ * fixed-width value per row in host byte order, so that a column can be
+ * mapped or read straight into an array.  Strings are dictionary-encoded:
+ * string columns hold 32-bit ids, and strings.dict holds the strings in id
+ * order, each terminated by a NUL.  A text file named "schema" lists the
+ * tables, their row counts and their columns' types.
+ *
+ * Rows are streamed out as each checkpoint is decoded, so memory use is
+ * bounded by the number of distinct strings, not the number of files.  The
+ * rows of the records of a corrupt checkpoint that could be decoded are kept,
+ * but a case or SERD engine is only written, events and all, if every section
+ * it refers to can be.  The nevents column of the cases and serd tables is the
+ * number of rows each owns in the events table, so a case's includes its
+ * principal event, which is usually one of its events as well.  A write error
+ * on any column stops the export.
+ *
+ * Checkpoints are found by ckpt_input(), so they can come from directories
+ * laid out like /var/fm/fmd/ckpt, from history stores and from tar archives,
+ * which means support bundles don't need to be extracted first.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "dump-fmd-ckpt.h"
+
+#define	EXP_BUFSZ	(64 * 1024)	/* stdio buffer for each column */
+
+typedef enum exp_type {
+	EXP_U32,
+	EXP_U64,
+	EXP_STR				/* uint32_t id in strings.dict */
+} exp_type_t;
+
+typedef struct exp_col {
+	const char *ec_name;		/* column name */
+	exp_type_t ec_type;		/* type of values */
+	FILE *ec_fp;			/* column file */
+} exp_col_t;
+
+typedef struct exp_table {
+	const char *et_name;		/* table name */
+	exp_col_t *et_cols;		/* columns */
+	uint_t et_ncols;		/* number of columns */
+	uint64_t et_nrows;		/* rows written */
+} exp_table_t;
+
+#define	EXP_NCOLS(c)	(sizeof (c) / sizeof (c[0]))
+
+enum {
+	MOD_FILE, MOD_CGEN, MOD_NAME, MOD_PATH, MOD_DESC, MOD_VERS, MOD_NBUFS,
+	MOD_BUFSIZE, MOD_NCASES, MOD_NSERD
+};
+
+static exp_col_t exp_mod_cols[] = {
+	{ "file", EXP_STR },
+	{ "cgen", EXP_U64 },
+	{ "name", EXP_STR },
+	{ "path", EXP_STR },
+	{ "desc", EXP_STR },
+	{ "vers", EXP_STR },
+	{ "nbufs", EXP_U32 },
+	{ "bufsize", EXP_U64 },
+	{ "ncases", EXP_U32 },
+	{ "nserd", EXP_U32 },
+};
+
+enum {
+	CASE_FILE, CASE_MODULE, CASE_UUID, CASE_STATE, CASE_TOD, CASE_NEVENTS,
+	CASE_NSUSPECTS, CASE_NBUFS
+};
+
+static exp_col_t exp_case_cols[] = {
+	{ "file", EXP_STR },
+	{ "module", EXP_STR },
+	{ "uuid", EXP_STR },
+	{ "state", EXP_U32 },
+	{ "tod", EXP_U64 },
+	{ "nevents", EXP_U32 },
+	{ "nsuspects", EXP_U32 },
+	{ "nbufs", EXP_U32 },
+};
+
+enum {
+	SERD_FILE, SERD_MODULE, SERD_NAME, SERD_N, SERD_T, SERD_NEVENTS,
+	SERD_TOD
+};
+
+static exp_col_t exp_serd_cols[] = {
+	{ "file", EXP_STR },
+	{ "module", EXP_STR },
+	{ "name", EXP_STR },
+	{ "n", EXP_U32 },
+	{ "t", EXP_U64 },
+	{ "nevents", EXP_U32 },
+	{ "tod", EXP_U64 },
+};
+
+enum {
+	EV_FILE, EV_MODULE, EV_OWNER, EV_ROLE, EV_TODSEC, EV_TODNSEC,
+	EV_MAJOR, EV_MINOR, EV_INODE, EV_OFFSET
+};
+
+static exp_col_t exp_event_cols[] = {
+	{ "file", EXP_STR },
+	{ "module", EXP_STR },
+	{ "owner", EXP_STR },
+	{ "role", EXP_STR },
+	{ "todsec", EXP_U64 },
+	{ "todnsec", EXP_U64 },
+	{ "major", EXP_U32 },
+	{ "minor", EXP_U32 },
+	{ "inode", EXP_U64 },
+	{ "offset", EXP_U64 },
+};
+
+typedef struct exp {
+	const char *e_dir;		/* output directory */
+	fcf_atomtab_t *e_atoms;		/* string dictionary */
+	exp_table_t e_mods;
+	exp_table_t e_cases;
+	exp_table_t e_serd;
+	exp_table_t e_events;
+	uint32_t e_role_case;		/* id of "case" */
+	uint32_t e_role_principal;	/* id of "principal" */
+	uint32_t e_role_serd;		/* id of "serd" */
+	uint_t e_nfiles;		/* checkpoints exported */
+	uint_t e_nfailed;		/* checkpoints with errors */
+	boolean_t e_nomem;		/* an allocation failed */
+	boolean_t e_werr;		/* a column couldn't be written */
+} exp_t;
+
+static const char *exp_type_name[] = { "u32", "u64", "str" };
+
+static uint32_t
+exp_str(exp_t *e, const char *s)
+{
+	const fcf_atom_t *fa;
+
+	if ((fa = fcf_atom_intern(e->e_atoms, s, strlen(s))) == NULL) {
+		e->e_nomem = B_TRUE;
+		return (0);
+	}
+	return (fa->fa_id);
+}
+
+static uint32_t
+exp_viewstr(exp_t *e, fcf_view_t *fv, fcf_stridx_t sid)
+{
+	return (exp_str(e, fcf_view_str(fv, sid)));
+}
+
+static void
+exp_row(exp_table_t *et, const uint64_t *v)
+{
+	exp_col_t *ec;
+	uint32_t v32;
+	uint_t i;
+
+	for (i = 0; i < et->et_ncols; i++) {
+		ec = &et->et_cols[i];
+		if (ec->ec_type == EXP_U64) {
+			(void) fwrite(&v[i], sizeof (uint64_t), 1, ec->ec_fp);
+		} else {
+			v32 = (uint32_t)v[i];
+			(void) fwrite(&v32, sizeof (uint32_t), 1, ec->ec_fp);
+		}
+	}
+	et->et_nrows++;
+}
+
+static int
+exp_open(exp_t *e, exp_table_t *et, const char *name, exp_col_t *cols,
+    uint_t ncols)
+{
+	char path[MAXPATHLEN];
+	uint_t i;
+
+	et->et_name = name;
+	et->et_cols = cols;
+	et->et_ncols = ncols;
+
+	for (i = 0; i < ncols; i++) {
+		(void) snprintf(path, sizeof (path), "%s/%s.%s", e->e_dir,
+		    name, cols[i].ec_name);
+		if ((cols[i].ec_fp = fopen(path, "w")) == NULL) {
+			(void) fprintf(stderr, "failed to create %s (%s)\n",
+			    path, strerror(errno));
+			return (-1);
+		}
+		(void) setvbuf(cols[i].ec_fp, NULL, _IOFBF, EXP_BUFSZ);
+	}
+	return (0);
+}
+
+/*
+ * Check for a write error on any column of a table.
+ */
+static int
+exp_check(exp_t *e, exp_table_t *et)
+{
+	uint_t i;
+
+	for (i = 0; i < et->et_ncols; i++) {
+		if (ferror(et->et_cols[i].ec_fp)) {
+			(void) fprintf(stderr, "failed to write %s/%s.%s "
+			    "(%s)\n", e->e_dir, et->et_name,
+			    et->et_cols[i].ec_name, strerror(errno));
+			e->e_werr = B_TRUE;
+			return (-1);
+		}
+	}
+	return (0);
+}
+
+static int
+exp_close(exp_t *e, exp_table_t *et)
+{
+	uint_t i;
+	int rv = 0;
+
+	for (i = 0; i < et->et_ncols; i++) {
+		if (et->et_cols[i].ec_fp == NULL)
+			continue;
+		if (fclose(et->et_cols[i].ec_fp) != 0 && !e->e_werr) {
+			(void) fprintf(stderr, "failed to write %s/%s.%s "
+			    "(%s)\n", e->e_dir, et->et_name,
+			    et->et_cols[i].ec_name, strerror(errno));
+			rv = -1;
+		}
+		et->et_cols[i].ec_fp = NULL;
+	}
+	return (rv);
+}
+
+static int
+exp_nevents(fcf_view_t *fv, fcf_secidx_t sid, uint_t *np)
+{
+	*np = 0;
+	if (sid == FCF_SECIDX_NONE)
+		return (0);
+	return (fcf_view_nrecs(fv, sid, FCF_SECT_EVENTS, sizeof (fcf_event_t),
+	    np));
+}
+
+/*
+ * Export the n events of a case or SERD engine, which exp_nevents() has
+ * counted, and return the time of the first.
+ */
+static void
+exp_events(exp_t *e, fcf_view_t *fv, const uint64_t *key, fcf_secidx_t sid,
+    uint32_t owner, uint32_t role, uint_t n, uint64_t *todp)
+{
+	const fcf_event_t *ep;
+	uint64_t v[EXP_NCOLS(exp_event_cols)];
+	uint_t i;
+
+	v[EV_FILE] = key[0];
+	v[EV_MODULE] = key[1];
+	v[EV_OWNER] = owner;
+	v[EV_ROLE] = role;
+	for (i = 0; i < n; i++) {
+		ep = fcf_view_rec(fv, sid, FCF_SECT_EVENTS,
+		    sizeof (fcf_event_t), i);
+		if (i == 0 && todp != NULL)
+			*todp = ep->fcfe_todsec;
+		v[EV_TODSEC] = ep->fcfe_todsec;
+		v[EV_TODNSEC] = ep->fcfe_todnsec;
+		v[EV_MAJOR] = ep->fcfe_major;
+		v[EV_MINOR] = ep->fcfe_minor;
+		v[EV_INODE] = ep->fcfe_inode;
+		v[EV_OFFSET] = ep->fcfe_offset;
+		exp_row(&e->e_events, v);
+	}
+}
+
+static int
+exp_nvls(fcf_view_t *fv, fcf_secidx_t sid, uint_t *np)
+{
+	const char *buf;
+	size_t off = 0, size;
+	uint_t n = 0;
+	int rv;
+
+	*np = 0;
+	if (sid == FCF_SECIDX_NONE)
+		return (0);
+	while ((rv = fcf_view_nvl(fv, sid, &off, &buf, &size)) == 1)
+		n++;
+	*np = n;
+	return (rv);
+}
+
+static int
+exp_case(exp_t *e, fcf_view_t *fv, const uint64_t *key, fcf_secidx_t sid,
+    uint_t *np)
+{
+	const fcf_case_t *cp;
+	uint64_t v[EXP_NCOLS(exp_case_cols)];
+	uint_t i, nrecs, nprinc, nevents, nsuspects, nbufs;
+	uint32_t uuid;
+
+	if (fcf_view_nrecs(fv, sid, FCF_SECT_CASE, sizeof (fcf_case_t),
+	    &nrecs) != 0)
+		return (-1);
+
+	for (i = 0; i < nrecs; i++) {
+		cp = fcf_view_rec(fv, sid, FCF_SECT_CASE, sizeof (fcf_case_t),
+		    i);
+
+		/*
+		 * Everything that can fail is checked before any of the case's
+		 * events are written, so that none is left without its case.
+		 */
+		nbufs = 0;
+		if (exp_nevents(fv, cp->fcfc_principal, &nprinc) != 0 ||
+		    exp_nevents(fv, cp->fcfc_events, &nevents) != 0 ||
+		    exp_nvls(fv, cp->fcfc_suspects, &nsuspects) != 0 ||
+		    (cp->fcfc_bufs != FCF_SECIDX_NONE &&
+		    fcf_view_nrecs(fv, cp->fcfc_bufs, FCF_SECT_BUFS,
+		    sizeof (fcf_buf_t), &nbufs) != 0))
+			return (-1);
+		uuid = exp_viewstr(e, fv, cp->fcfc_uuid);
+
+		v[CASE_FILE] = key[0];
+		v[CASE_MODULE] = key[1];
+		v[CASE_UUID] = uuid;
+		v[CASE_STATE] = cp->fcfc_state;
+		v[CASE_TOD] = 0;
+		exp_events(e, fv, key, cp->fcfc_principal, uuid,
+		    e->e_role_principal, nprinc, &v[CASE_TOD]);
+		exp_events(e, fv, key, cp->fcfc_events, uuid, e->e_role_case,
+		    nevents, NULL);
+		v[CASE_NEVENTS] = nprinc + nevents;
+		v[CASE_NSUSPECTS] = nsuspects;
+		v[CASE_NBUFS] = nbufs;
+		exp_row(&e->e_cases, v);
+		(*np)++;
+	}
+	return (0);
+}
+
+static int
+exp_serd(exp_t *e, fcf_view_t *fv, const uint64_t *key, fcf_secidx_t sid,
+    uint_t *np)
+{
+	const fcf_serd_t *sgp;
+	uint64_t v[EXP_NCOLS(exp_serd_cols)];
+	uint_t n, i, nrecs;
+	uint32_t name;
+
+	if (fcf_view_nrecs(fv, sid, FCF_SECT_SERD, sizeof (fcf_serd_t),
+	    &nrecs) != 0)
+		return (-1);
+
+	for (i = 0; i < nrecs; i++) {
+		sgp = fcf_view_rec(fv, sid, FCF_SECT_SERD, sizeof (fcf_serd_t),
+		    i);
+		if (exp_nevents(fv, sgp->fcfd_events, &n) != 0)
+			return (-1);
+		name = exp_viewstr(e, fv, sgp->fcfd_name);
+
+		v[SERD_FILE] = key[0];
+		v[SERD_MODULE] = key[1];
+		v[SERD_NAME] = name;
+		v[SERD_N] = sgp->fcfd_n;
+		v[SERD_T] = sgp->fcfd_t;
+		v[SERD_TOD] = 0;
+		exp_events(e, fv, key, sgp->fcfd_events, name, e->e_role_serd,
+		    n, &v[SERD_TOD]);
+		v[SERD_NEVENTS] = n;
+		exp_row(&e->e_serd, v);
+		(*np)++;
+	}
+	return (0);
+}
+
+/*
+ * Export one checkpoint.  The module record is found first, since every
+ * other row is keyed by the module's name, and its row is written last, once
+ * its cases and SERD engines have been counted.
+ */
+static int
+exp_view(exp_t *e, fcf_view_t *fv)
+{
+	const fcf_module_t *mp = NULL;
+	const fcf_buf_t *bp;
+	uint64_t key[2], v[EXP_NCOLS(exp_mod_cols)];
+	size_t size;
+	fcf_secidx_t i;
+	uint_t j, n, ncases = 0, nserd = 0;
+	int rv = 0;
+
+	for (i = 0; i < fv->fv_secnum; i++) {
+		if (fcf_view_sec(fv, i)->fcfs_type == FCF_SECT_MODULE) {
+			if ((mp = fcf_view_rec(fv, i, FCF_SECT_MODULE,
+			    sizeof (fcf_module_t), 0)) == NULL)
+				return (-1);
+			break;
+		}
+	}
+
+	key[0] = exp_str(e, fv->fv_path);
+	key[1] = mp != NULL ? exp_viewstr(e, fv, mp->fcfm_name) : exp_str(e,
+	    "");
+
+	for (i = 0; i < fv->fv_secnum && rv == 0; i++) {
+		switch (fcf_view_sec(fv, i)->fcfs_type) {
+		case FCF_SECT_CASE:
+			rv = exp_case(e, fv, key, i, &ncases);
+			break;
+		case FCF_SECT_SERD:
+			rv = exp_serd(e, fv, key, i, &nserd);
+			break;
+		}
+	}
+
+	v[MOD_FILE] = key[0];
+	v[MOD_CGEN] = fv->fv_hdr->fcfh_cgen;
+	v[MOD_NAME] = key[1];
+	v[MOD_PATH] = mp != NULL ? exp_viewstr(e, fv, mp->fcfm_path) : key[1];
+	v[MOD_DESC] = mp != NULL ? exp_viewstr(e, fv, mp->fcfm_desc) : key[1];
+	v[MOD_VERS] = mp != NULL ? exp_viewstr(e, fv, mp->fcfm_vers) : key[1];
+	v[MOD_NBUFS] = 0;
+	v[MOD_BUFSIZE] = 0;
+	v[MOD_NCASES] = ncases;
+	v[MOD_NSERD] = nserd;
+
+	if (mp != NULL && mp->fcfm_bufs != FCF_SECIDX_NONE) {
+		if (fcf_view_nrecs(fv, mp->fcfm_bufs, FCF_SECT_BUFS,
+		    sizeof (fcf_buf_t), &n) != 0) {
+			rv = -1;
+			n = 0;
+		}
+		for (j = 0; j < n; j++) {
+			bp = fcf_view_rec(fv, mp->fcfm_bufs, FCF_SECT_BUFS,
+			    sizeof (fcf_buf_t), j);
+			if (bp->fcfb_data != FCF_SECIDX_NONE &&
+			    fcf_view_data(fv, bp->fcfb_data, FCF_SECT_BUFFER,
+			    &size) != NULL)
+				v[MOD_BUFSIZE] += size;
+		}
+		v[MOD_NBUFS] = n;
+	}
+	exp_row(&e->e_mods, v);
+
+	return (rv);
+}
+
+static void
+exp_report(exp_t *e, fcf_view_t *fv, int rv)
+{
+	e->e_nfiles++;
+	if (rv != 0) {
+		(void) fprintf(stderr, "%s\n", fv->fv_errmsg);
+		e->e_nfailed++;
+	}
+}
+
+static int
+exp_ckpt_cb(const char *path, const void *buf, size_t size, void *arg)
+{
+	exp_t *e = arg;
+	fcf_view_t fv;
+	int rv;
+
+	if ((rv = fcf_view_open_mem(&fv, path, buf, size)) == 0)
+		rv = exp_view(e, &fv);
+	exp_report(e, &fv, rv);
+	fcf_view_close(&fv);
+	if (exp_check(e, &e->e_mods) != 0 || exp_check(e, &e->e_cases) != 0 ||
+	    exp_check(e, &e->e_serd) != 0 || exp_check(e, &e->e_events) != 0)
+		return (-1);
+	return (e->e_nomem ? -1 : 0);
+}
+
+static void
+exp_schema_table(FILE *fp, const exp_table_t *et)
+{
+	uint_t i;
+
+	(void) fprintf(fp, "table %s %llu\n", et->et_name,
+	    (u_longlong_t)et->et_nrows);
+	for (i = 0; i < et->et_ncols; i++) {
+		(void) fprintf(fp, "column %s.%s %s\n", et->et_name,
+		    et->et_cols[i].ec_name,
+		    exp_type_name[et->et_cols[i].ec_type]);
+	}
+}
+
+/*
+ * Write the string dictionary and the schema, which is written last so that
+ * its presence means the export is complete.  It's written to schema.tmp and
+ * renamed into place, so that it's never seen half written.
+ */
+static int
+exp_finish(exp_t *e)
+{
+	char path[MAXPATHLEN], tmp[MAXPATHLEN];
+	const fcf_atom_t *fa;
+	uint32_t i, n = fcf_atomtab_count(e->e_atoms);
+	FILE *fp;
+
+	(void) snprintf(path, sizeof (path), "%s/strings.dict", e->e_dir);
+	if ((fp = fopen(path, "w")) == NULL)
+		goto err;
+	for (i = 0; i < n; i++) {
+		fa = fcf_atom_byid(e->e_atoms, i);
+		(void) fwrite(fa->fa_str, 1, fa->fa_len + 1, fp);
+	}
+	if (fclose(fp) != 0)
+		goto err;
+
+	(void) snprintf(path, sizeof (path), "%s/schema.tmp", e->e_dir);
+	if ((fp = fopen(path, "w")) == NULL)
+		goto err;
+	(void) fprintf(fp, "# dump-fmd-ckpt export of %u checkpoints, "
+	    "%u with errors\n", e->e_nfiles, e->e_nfailed);
+#ifdef	_BIG_ENDIAN
+	(void) fprintf(fp, "byteorder big\n");
+#else
+	(void) fprintf(fp, "byteorder little\n");
+#endif
+	(void) fprintf(fp, "dictionary strings.dict %u\n", n);
+	exp_schema_table(fp, &e->e_mods);
+	exp_schema_table(fp, &e->e_cases);
+	exp_schema_table(fp, &e->e_serd);
+	exp_schema_table(fp, &e->e_events);
+	if (fclose(fp) != 0)
+		goto err;
+
+	(void) strlcpy(tmp, path, sizeof (tmp));
+	(void) snprintf(path, sizeof (path), "%s/schema", e->e_dir);
+	if (rename(tmp, path) != 0)
+		goto err;
+	return (0);
+
+err:
+	(void) fprintf(stderr, "failed to write %s (%s)\n", path,
+	    strerror(errno));
+	return (-1);
+}
+
+static void
+exp_usage(void)
+{
+	(void) fprintf(stderr, "usage: %s export -d dir [root | store | "
+	    "archive | ckpt file] ...\n\n"
+	    "root defaults to %s; archives may be gzip'd\n\n", pname,
+	    CKPT_DEFROOT);
+}
+
+int
+do_export(int argc, char **argv)
+{
+	static char *defroot[] = { CKPT_DEFROOT };
+	char path[MAXPATHLEN];
+	exp_t e;
+	char **args;
+	struct stat64 st;
+	int c, i, nargs, rv = 0;
+
+	(void) memset(&e, 0, sizeof (e));
+	while ((c = getopt(argc, argv, "d:")) != -1) {
+		switch (c) {
+		case 'd':
+			e.e_dir = optarg;
+			break;
+		default:
+			exp_usage();
+			return (2);
+		}
+	}
+	if (e.e_dir == NULL) {
+		exp_usage();
+		return (2);
+	}
+
+	args = argv + optind;
+	nargs = argc - optind;
+	if (nargs == 0) {
+		args = defroot;
+		nargs = 1;
+	}
+
+	if (mkdir(e.e_dir, 0755) != 0 && (errno != EEXIST ||
+	    stat64(e.e_dir, &st) != 0 || !S_ISDIR(st.st_mode))) {
+		(void) fprintf(stderr, "failed to create %s (%s)\n", e.e_dir,
+		    strerror(errno != EEXIST ? errno : ENOTDIR));
+		return (1);
+	}
+
+	if ((e.e_atoms = fcf_atomtab_create()) == NULL) {
+		(void) fprintf(stderr, "failed to allocate memory\n");
+		return (1);
+	}
+	e.e_role_case = exp_str(&e, "case");
+	e.e_role_principal = exp_str(&e, "principal");
+	e.e_role_serd = exp_str(&e, "serd");
+
+	/*
+	 * The columns of an earlier export to the same directory are about to
+	 * be truncated, so its schema has to go first: otherwise, if this
+	 * export fails, it would be left describing them.
+	 */
+	(void) snprintf(path, sizeof (path), "%s/schema", e.e_dir);
+	if (unlink(path) != 0 && errno != ENOENT) {
+		(void) fprintf(stderr, "failed to remove %s (%s)\n", path,
+		    strerror(errno));
+		rv = 1;
+		goto out;
+	}
+
+	if (exp_open(&e, &e.e_mods, "modules", exp_mod_cols,
+	    EXP_NCOLS(exp_mod_cols)) != 0 ||
+	    exp_open(&e, &e.e_cases, "cases", exp_case_cols,
+	    EXP_NCOLS(exp_case_cols)) != 0 ||
+	    exp_open(&e, &e.e_serd, "serd", exp_serd_cols,
+	    EXP_NCOLS(exp_serd_cols)) != 0 ||
+	    exp_open(&e, &e.e_events, "events", exp_event_cols,
+	    EXP_NCOLS(exp_event_cols)) != 0) {
+		rv = 1;
+		goto out;
+	}
+
+	for (i = 0; i < nargs && !e.e_nomem && !e.e_werr; i++) {
+		if (ckpt_input(args[i], exp_ckpt_cb, &e) != 0)
+			rv = 1;
+	}
+	if (e.e_nomem) {
+		(void) fprintf(stderr, "failed to allocate memory\n");
+		rv = 1;
+	}
+	if (e.e_werr)
+		rv = 1;
+
+out:
+	if (exp_close(&e, &e.e_mods) != 0)
+		rv = 1;
+	if (exp_close(&e, &e.e_cases) != 0)
+		rv = 1;
+	if (exp_close(&e, &e.e_serd) != 0)
+		rv = 1;
+	if (exp_close(&e, &e.e_events) != 0)
+		rv = 1;
+	if (rv == 0 && exp_finish(&e) != 0)
+		rv = 1;
+
+	if (rv == 0) {
+		(void) printf("%u checkpoints exported to %s, %u with errors: "
+		    "%llu modules, %llu cases, %llu SERD engines, %llu events, "
+		    "%u strings\n", e.e_nfiles, e.e_dir, e.e_nfailed,
+		    (u_longlong_t)e.e_mods.et_nrows,
+		    (u_longlong_t)e.e_cases.et_nrows,
+		    (u_longlong_t)e.e_serd.et_nrows,
+		    (u_longlong_t)e.e_events.et_nrows,
+		    fcf_atomtab_count(e.e_atoms));
+		if (e.e_nfailed != 0)
+			rv = 1;
+	}
+	fcf_atomtab_destroy(e.e_atoms);
+	return (rv);
+}
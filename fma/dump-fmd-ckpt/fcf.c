@@ -0,0 +1,595 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+/*
+ * Read-only, mmap-backed accessors for FCF checkpoint files.
+ *
+ * The checks here are modelled on the ones fmd itself performs when it
+ * restores a checkpoint (see fmd_ckpt_open() in
+ * usr/src/cmd/fm/fmd/common/fmd_ckpt.c), except that a bad section is only
+ * reported when something actually tries to use it.  That way the tool can
+ * still show as much as possible of a partially corrupt file.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <sys/types.h>
+
+#include "fcf.h"
+
+static const char *const fcf_sect_names[] = {
+	"none",		/* FCF_SECT_NONE */
+	"strtab",	/* FCF_SECT_STRTAB */
+	"module",	/* FCF_SECT_MODULE */
+	"case",		/* FCF_SECT_CASE */
+	"bufs",		/* FCF_SECT_BUFS */
+	"buffer",	/* FCF_SECT_BUFFER */
+	"serd",		/* FCF_SECT_SERD */
+	"events",	/* FCF_SECT_EVENTS */
+	"nvlists",	/* FCF_SECT_NVLISTS */
+};
+
+#define	FCF_NSECT_NAMES	\
+	(sizeof (fcf_sect_names) / sizeof (fcf_sect_names[0]))
+
+#if FCF_ENCODE_NATIVE == FCF_ENCODE_LSB
+#define	FCF_ENCODE_FOREIGN	FCF_ENCODE_MSB
+#else
+#define	FCF_ENCODE_FOREIGN	FCF_ENCODE_LSB
+#endif
+
+const char *
+fcf_sect_name(uint_t type)
+{
+	return (type < FCF_NSECT_NAMES ? fcf_sect_names[type] : NULL);
+}
+
+int
+fcf_sect_type(const char *name, uint_t *typep)
+{
+	for (uint_t i = 0; i < FCF_NSECT_NAMES; i++) {
+		if (strcmp(name, fcf_sect_names[i]) == 0) {
+			*typep = i;
+			return (0);
+		}
+	}
+	return (-1);
+}
+
+const char *
+fcf_case_state_name(uint32_t state)
+{
+	switch (state) {
+	case FCF_CASE_UNSOLVED:
+		return ("UNSOLVED");
+	case FCF_CASE_SOLVED:
+		return ("SOLVED");
+	case FCF_CASE_CLOSE_WAIT:
+		return ("CLOSE_WAIT");
+	default:
+		return ("<UNKNOWN>");
+	}
+}
+
+static void
+fcf_view_error(fcf_view_t *fv, const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	(void) vsnprintf(fv->fv_errmsg, sizeof (fv->fv_errmsg), fmt, ap);
+	va_end(ap);
+}
+
+static int fcf_view_init(fcf_view_t *);
+
+/*
+ * Map the checkpoint file at the specified path and validate its header and
+ * section header table.  On failure, -1 is returned and fv_errmsg describes
+ * the problem.  fcf_view_close() must be called in either case.
+ */
+int
+fcf_view_open(fcf_view_t *fv, const char *path)
+{
+	struct stat64 st;
+	void *base;
+
+	(void) memset(fv, 0, sizeof (fcf_view_t));
+	fv->fv_path = path;
+
+	if ((fv->fv_fd = open(path, O_RDONLY)) < 0 ||
+	    fstat64(fv->fv_fd, &st) < 0) {
+		fcf_view_error(fv, "failed to open checkpoint file: %s (%s)",
+		    path, strerror(errno));
+		return (-1);
+	}
+	if (!S_ISREG(st.st_mode)) {
+		fcf_view_error(fv, "%s: not a regular file", path);
+		return (-1);
+	}
+	if ((uint64_t)st.st_size < sizeof (fcf_hdr_t)) {
+		fcf_view_error(fv, "%s: file is too small to be an fmd "
+		    "checkpoint file", path);
+		return (-1);
+	}
+	if ((uint64_t)st.st_size > SIZE_MAX) {
+		fcf_view_error(fv, "%s: file is too large to map", path);
+		return (-1);
+	}
+
+	base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE,
+	    fv->fv_fd, 0);
+	if (base == MAP_FAILED) {
+		fcf_view_error(fv, "failed to map %s (%s)", path,
+		    strerror(errno));
+		return (-1);
+	}
+	fv->fv_base = base;
+	fv->fv_size = (size_t)st.st_size;
+
+	/*
+	 * Sections are generally visited in an arbitrary order, and many are
+	 * never visited at all, so don't let read-ahead pull in the whole
+	 * file on the first fault.
+	 */
+	(void) madvise((caddr_t)base, fv->fv_size, MADV_RANDOM);
+
+	return (fcf_view_init(fv));
+}
+
+/*
+ * Like fcf_view_open(), but for a checkpoint that's already in memory, such
+ * as a member of an archive.  The buffer must be 64-bit aligned and must
+ * remain valid until the view is closed; name is used in error messages.
+ */
+int
+fcf_view_open_mem(fcf_view_t *fv, const char *name, const void *buf,
+    size_t size)
+{
+	(void) memset(fv, 0, sizeof (fcf_view_t));
+	fv->fv_path = name;
+	fv->fv_fd = -1;
+
+	if (size < sizeof (fcf_hdr_t)) {
+		fcf_view_error(fv, "%s: file is too small to be an fmd "
+		    "checkpoint file", name);
+		return (-1);
+	}
+	if (!IS_P2ALIGNED(buf, sizeof (uint64_t))) {
+		fcf_view_error(fv, "%s: checkpoint buffer is misaligned", name);
+		return (-1);
+	}
+	fv->fv_base = buf;
+	fv->fv_size = size;
+
+	return (fcf_view_init(fv));
+}
+
+/*
+ * Validate the header and section header table of the checkpoint at fv_base.
+ */
+static int
+fcf_view_init(fcf_view_t *fv)
+{
+	const char *path = fv->fv_path;
+	const fcf_hdr_t *hdr;
+
+	hdr = fv->fv_hdr = (const fcf_hdr_t *)fv->fv_base;
+
+	if (bcmp(hdr->fcfh_ident, FCF_MAG_STRING, FCF_MAG_STRLEN) != 0) {
+		fcf_view_error(fv, "%s: not an fmd checkpoint file", path);
+		return (-1);
+	}
+
+	/*
+	 * A file of the other byte order is read through a swapped copy of
+	 * its header.  The data model doesn't matter: the FCF structures are
+	 * laid out identically for ILP32 and LP64.
+	 */
+	if (hdr->fcfh_ident[FCF_ID_ENCODING] == FCF_ENCODE_FOREIGN) {
+		if ((fv->fv_hdrcopy = malloc(sizeof (fcf_hdr_t))) == NULL) {
+			fcf_view_error(fv, "failed to allocate memory");
+			return (-1);
+		}
+		bcopy(hdr, fv->fv_hdrcopy, sizeof (fcf_hdr_t));
+		fcf_swap_hdr(fv->fv_hdrcopy);
+		hdr = fv->fv_hdr = fv->fv_hdrcopy;
+		fv->fv_swap = B_TRUE;
+	}
+	if (hdr->fcfh_hdrsize < sizeof (fcf_hdr_t) ||
+	    hdr->fcfh_hdrsize > fv->fv_size) {
+		fcf_view_error(fv, "%s: invalid header size %u", path,
+		    hdr->fcfh_hdrsize);
+		return (-1);
+	}
+	if (hdr->fcfh_secsize < sizeof (fcf_sec_t)) {
+		fcf_view_error(fv, "%s: invalid section header size %u", path,
+		    hdr->fcfh_secsize);
+		return (-1);
+	}
+	if (!IS_P2ALIGNED(hdr->fcfh_secoff, sizeof (uint64_t)) ||
+	    !IS_P2ALIGNED(hdr->fcfh_secsize, sizeof (uint64_t))) {
+		fcf_view_error(fv, "%s: misaligned section header table", path);
+		return (-1);
+	}
+	if (hdr->fcfh_secoff > fv->fv_size || hdr->fcfh_secnum >
+	    (fv->fv_size - hdr->fcfh_secoff) / hdr->fcfh_secsize) {
+		fcf_view_error(fv, "%s: section header table extends past "
+		    "end of file", path);
+		return (-1);
+	}
+
+	fv->fv_secs = fv->fv_base + hdr->fcfh_secoff;
+	fv->fv_secsize = hdr->fcfh_secsize;
+	fv->fv_secnum = hdr->fcfh_secnum;
+
+	/*
+	 * The section table is small and every consumer reads all of it, so
+	 * it's swapped up front.  Its alignment was checked above.
+	 */
+	if (fv->fv_swap && fv->fv_secnum != 0) {
+		size_t len = fv->fv_secsize * fv->fv_secnum;
+
+		if ((fv->fv_seccopy = malloc(len)) == NULL) {
+			fcf_view_error(fv, "failed to allocate memory");
+			return (-1);
+		}
+		bcopy(fv->fv_secs, fv->fv_seccopy, len);
+		(void) fcf_swap_secs(fv->fv_seccopy, fv->fv_secnum,
+		    fv->fv_secsize);
+		fv->fv_secs = fv->fv_seccopy;
+	}
+
+	return (0);
+}
+
+void
+fcf_view_close(fcf_view_t *fv)
+{
+	/*
+	 * A view without a file descriptor is of the caller's buffer.
+	 */
+	if (fv->fv_base != NULL && fv->fv_fd >= 0)
+		(void) munmap((caddr_t)fv->fv_base, fv->fv_size);
+	if (fv->fv_fd >= 0)
+		(void) close(fv->fv_fd);
+
+	fcf_strtab_fini(&fv->fv_strtab);
+	free(fv->fv_sechash);
+	free(fv->fv_sechashed);
+	fv->fv_sechash = NULL;
+	fv->fv_sechashed = NULL;
+
+	if (fv->fv_datacopy != NULL) {
+		for (uint_t i = 0; i < fv->fv_secnum; i++)
+			free(fv->fv_datacopy[i]);
+		free(fv->fv_datacopy);
+	}
+	free(fv->fv_seccopy);
+	free(fv->fv_hdrcopy);
+	fv->fv_datacopy = NULL;
+	fv->fv_seccopy = NULL;
+	fv->fv_hdrcopy = NULL;
+
+	fv->fv_base = NULL;
+	fv->fv_fd = -1;
+}
+
+/*
+ * Return a pointer to the specified section header, or NULL if the index is
+ * out of range.  The header table itself was validated when the view was
+ * opened.
+ */
+const fcf_sec_t *
+fcf_view_sec(fcf_view_t *fv, fcf_secidx_t sid)
+{
+	if (sid >= fv->fv_secnum) {
+		fcf_view_error(fv, "section index %u out of range", sid);
+		return (NULL);
+	}
+	return ((const fcf_sec_t *)(fv->fv_secs + fv->fv_secsize * sid));
+}
+
+/*
+ * Return a host-order copy of the data of a section of a file of the other
+ * byte order, making it the first time the section is accessed.
+ */
+static const void *
+fcf_view_swapped(fcf_view_t *fv, fcf_secidx_t sid, const fcf_sec_t *sp)
+{
+	uchar_t *copy;
+	size_t size = (size_t)sp->fcfs_size;
+
+	if (fv->fv_datacopy == NULL && (fv->fv_datacopy =
+	    calloc(fv->fv_secnum, sizeof (uchar_t *))) == NULL) {
+		fcf_view_error(fv, "failed to allocate memory");
+		return (NULL);
+	}
+	if (fv->fv_datacopy[sid] != NULL)
+		return (fv->fv_datacopy[sid]);
+
+	if ((copy = malloc(size)) == NULL) {
+		fcf_view_error(fv, "failed to allocate memory");
+		return (NULL);
+	}
+	bcopy(fv->fv_base + sp->fcfs_offset, copy, size);
+	if (fcf_swap_data(sp->fcfs_type, copy, size, sp->fcfs_entsize) != 0) {
+		fcf_view_error(fv, "section %u records are misaligned for "
+		    "byte-swapping", sid);
+		free(copy);
+		return (NULL);
+	}
+
+	fv->fv_datacopy[sid] = copy;
+	return (copy);
+}
+
+/*
+ * Return a pointer to the data of the specified section, after verifying that
+ * the section is of the expected type (unless FCF_SECT_ANY is passed) and
+ * that its data lies entirely within the file and honors its alignment.
+ */
+const void *
+fcf_view_data(fcf_view_t *fv, fcf_secidx_t sid, uint_t type, size_t *sizep)
+{
+	const fcf_sec_t *sp;
+
+	if ((sp = fcf_view_sec(fv, sid)) == NULL)
+		return (NULL);
+
+	if (type != FCF_SECT_ANY && sp->fcfs_type != type) {
+		fcf_view_error(fv, "section %u is of type %u, expected %u",
+		    sid, sp->fcfs_type, type);
+		return (NULL);
+	}
+	if (sp->fcfs_align > 1 && (!ISP2(sp->fcfs_align) ||
+	    !IS_P2ALIGNED(sp->fcfs_offset, sp->fcfs_align))) {
+		fcf_view_error(fv, "section %u has invalid alignment %u", sid,
+		    sp->fcfs_align);
+		return (NULL);
+	}
+	if (sp->fcfs_offset > fv->fv_size ||
+	    sp->fcfs_size > fv->fv_size - sp->fcfs_offset) {
+		fcf_view_error(fv, "section %u extends past end of file", sid);
+		return (NULL);
+	}
+
+	*sizep = (size_t)sp->fcfs_size;
+	if (fv->fv_swap && sp->fcfs_size != 0 &&
+	    fcf_swap_needed(sp->fcfs_type))
+		return (fcf_view_swapped(fv, sid, sp));
+	return (fv->fv_base + sp->fcfs_offset);
+}
+
+/*
+ * Return the number of records of size recsz in the specified section.  For
+ * table sections, records are fcfs_entsize bytes apart, which may be larger
+ * than the record structure we know about.
+ */
+static const uchar_t *
+fcf_view_table(fcf_view_t *fv, fcf_secidx_t sid, uint_t type, size_t recsz,
+    uint_t *nrecsp, size_t *stridep)
+{
+	const fcf_sec_t *sp;
+	const uchar_t *data;
+	size_t size, stride;
+
+	if ((data = fcf_view_data(fv, sid, type, &size)) == NULL)
+		return (NULL);
+
+	sp = fcf_view_sec(fv, sid);
+	stride = sp->fcfs_entsize != 0 ? sp->fcfs_entsize : recsz;
+	if (stride < recsz) {
+		fcf_view_error(fv, "section %u has entry size %u, expected at "
+		    "least %zu", sid, sp->fcfs_entsize, recsz);
+		return (NULL);
+	}
+	if (!IS_P2ALIGNED(sp->fcfs_offset, sizeof (uint32_t)) ||
+	    !IS_P2ALIGNED(stride, sizeof (uint32_t))) {
+		fcf_view_error(fv, "section %u records are misaligned", sid);
+		return (NULL);
+	}
+
+	*nrecsp = (uint_t)(size / stride);
+	*stridep = stride;
+	return (data);
+}
+
+int
+fcf_view_nrecs(fcf_view_t *fv, fcf_secidx_t sid, uint_t type, size_t recsz,
+    uint_t *nrecsp)
+{
+	size_t stride;
+
+	return (fcf_view_table(fv, sid, type, recsz, nrecsp, &stride) ==
+	    NULL ? -1 : 0);
+}
+
+/*
+ * Return a pointer to the idx'th record of size recsz in the specified
+ * section, or NULL if the section is invalid or doesn't contain that many
+ * records.
+ */
+const void *
+fcf_view_rec(fcf_view_t *fv, fcf_secidx_t sid, uint_t type, size_t recsz,
+    uint_t idx)
+{
+	const uchar_t *data;
+	size_t stride;
+	uint_t nrecs;
+
+	if ((data = fcf_view_table(fv, sid, type, recsz, &nrecs,
+	    &stride)) == NULL)
+		return (NULL);
+
+	if (idx >= nrecs) {
+		fcf_view_error(fv, "record %u of section %u out of range", idx,
+		    sid);
+		return (NULL);
+	}
+
+	return (data + stride * idx);
+}
+
+/*
+ * Index the string table, interning its strings in the given atom table if
+ * one is supplied.  Like fmd, we use the first string table in the file to
+ * resolve string references.  Callers that want a corrupt string table to be
+ * reported up front call this right after opening the view; otherwise it's
+ * done (without interning) the first time a string is looked up, so that
+ * callers which never need a string never touch the table.  If the table is
+ * missing or corrupt, -1 is returned and every string reference resolves to
+ * "<CORRUPT>".
+ */
+int
+fcf_view_strings(fcf_view_t *fv, fcf_atomtab_t *fat)
+{
+	const char *strs;
+	size_t strsz;
+	fcf_secidx_t i;
+
+	if (fv->fv_strdone)
+		return (fv->fv_strbad ? -1 : 0);
+
+	fv->fv_strdone = B_TRUE;
+	fv->fv_strbad = B_TRUE;
+
+	for (i = 0; i < fv->fv_secnum; i++) {
+		if (fcf_view_sec(fv, i)->fcfs_type == FCF_SECT_STRTAB)
+			break;
+	}
+	if (i == fv->fv_secnum) {
+		fcf_view_error(fv, "%s: no string table", fv->fv_path);
+		return (-1);
+	}
+
+	if ((strs = fcf_view_data(fv, i, FCF_SECT_STRTAB, &strsz)) == NULL)
+		return (-1);
+
+	if (fcf_strtab_init(&fv->fv_strtab, strs, strsz, fat,
+	    fv->fv_errmsg, sizeof (fv->fv_errmsg)) != 0)
+		return (-1);
+
+	fv->fv_strbad = B_FALSE;
+	return (0);
+}
+
+const char *
+fcf_view_str(fcf_view_t *fv, fcf_stridx_t sid)
+{
+	const char *s;
+
+	if (fcf_view_strings(fv, NULL) != 0 ||
+	    (s = fcf_strtab_lookup(&fv->fv_strtab, sid)) == NULL)
+		return ("<CORRUPT>");
+
+	return (s);
+}
+
+/*
+ * Return the interned string at sid, or NULL if the reference is invalid or
+ * the string table wasn't indexed with an atom table.
+ */
+const fcf_atom_t *
+fcf_view_atom(fcf_view_t *fv, fcf_stridx_t sid)
+{
+	if (fcf_view_strings(fv, NULL) != 0)
+		return (NULL);
+
+	return (fcf_strtab_atom(&fv->fv_strtab, sid));
+}
+
+/*
+ * Return a hash of the data of the specified section, which is computed the
+ * first time it's asked for and cached for the life of the view.  The
+ * section type is mixed in, so that empty sections of different types don't
+ * compare equal.
+ */
+int
+fcf_view_sechash(fcf_view_t *fv, fcf_secidx_t sid, uint64_t *hp)
+{
+	const void *data;
+	size_t size;
+
+	if (fcf_view_sec(fv, sid) == NULL)
+		return (-1);
+
+	if (fv->fv_sechash == NULL) {
+		fv->fv_sechash = calloc(fv->fv_secnum, sizeof (uint64_t));
+		fv->fv_sechashed = calloc(fv->fv_secnum, sizeof (uchar_t));
+		if (fv->fv_sechash == NULL || fv->fv_sechashed == NULL) {
+			free(fv->fv_sechash);
+			free(fv->fv_sechashed);
+			fv->fv_sechash = NULL;
+			fv->fv_sechashed = NULL;
+			fcf_view_error(fv, "failed to allocate memory");
+			return (-1);
+		}
+	}
+
+	if (!fv->fv_sechashed[sid]) {
+		if ((data = fcf_view_data(fv, sid, FCF_SECT_ANY,
+		    &size)) == NULL)
+			return (-1);
+		fv->fv_sechash[sid] = fcf_hash(data, size,
+		    fcf_view_sec(fv, sid)->fcfs_type);
+		fv->fv_sechashed[sid] = 1;
+	}
+
+	*hp = fv->fv_sechash[sid];
+	return (0);
+}
+
+/*
+ * Step through the packed nvlists in an FCF_SECT_NVLISTS section.  Each one is
+ * an fcf_nvl_t header followed by fcfn_size bytes of packed data, padded out
+ * to the next 64-bit boundary.  *offp should be zero on the first call and is
+ * advanced past the returned nvlist.  Returns 1 if an nvlist was found, 0 at
+ * the end of the section and -1 if the section is corrupt.
+ */
+int
+fcf_view_nvl(fcf_view_t *fv, fcf_secidx_t sid, size_t *offp,
+    const char **bufp, size_t *sizep)
+{
+	const uchar_t *data;
+	fcf_nvl_t nvl;
+	size_t size, off = *offp;
+
+	if ((data = fcf_view_data(fv, sid, FCF_SECT_NVLISTS, &size)) == NULL)
+		return (-1);
+
+	if (off >= size)
+		return (0);
+
+	if (size - off < sizeof (fcf_nvl_t)) {
+		fcf_view_error(fv, "section %u: truncated nvlist header at "
+		    "offset %zu", sid, off);
+		return (-1);
+	}
+	bcopy(data + off, &nvl, sizeof (fcf_nvl_t));
+	off += sizeof (fcf_nvl_t);
+
+	if (nvl.fcfn_size > size - off) {
+		fcf_view_error(fv, "section %u: nvlist at offset %zu extends "
+		    "past end of section", sid, *offp);
+		return (-1);
+	}
+
+	*bufp = (const char *)data + off;
+	*sizep = (size_t)nvl.fcfn_size;
+	*offp = off + P2ROUNDUP((size_t)nvl.fcfn_size, sizeof (uint64_t));
+
+	return (1);
+}
@@ -0,0 +1,173 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+#ifndef _FCF_H
+#define	_FCF_H
+
+#include <sys/types.h>
+
+#include "fcf_compat.h"
+
+/*
+ * These headers aren't delivered, so we'll have to build against an ON source
+ * tree.  See the comments in the makefile.
+ */
+#include <fmd_ckpt.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/*
+ * Passed as the section type to the accessors below when the caller will
+ * accept a section of any type.
+ */
+#define	FCF_SECT_ANY	((uint_t)-1)
+
+/*
+ * An interned string.  Atoms are created by fcf_atom_intern() and live as long
+ * as the atom table that holds them, so two references to the same string are
+ * always the same atom, regardless of which file they came from.
+ */
+typedef struct fcf_atom {
+	struct fcf_atom *fa_next;	/* next atom on hash chain */
+	uint64_t fa_hash;		/* hash of fa_str */
+	uint32_t fa_id;			/* dense identifier, from zero */
+	uint32_t fa_len;		/* length of fa_str */
+	char fa_str[1];			/* string (variable length) */
+} fcf_atom_t;
+
+typedef struct fcf_atomtab fcf_atomtab_t;
+
+/*
+ * An index of an FCF string table.  See fcf_str.c.
+ */
+typedef struct fcf_strtab {
+	const char *fs_data;		/* string table data */
+	size_t fs_size;			/* size of string table */
+	uint64_t *fs_starts;		/* bitmap of string start offsets */
+	uint32_t *fs_rank;		/* strings before each bitmap word */
+	uint32_t *fs_offs;		/* start offset of each string */
+	const fcf_atom_t **fs_atoms;	/* interned string, if any */
+	uint32_t fs_nstrs;		/* number of strings */
+} fcf_strtab_t;
+
+/*
+ * A read-only view of an FCF checkpoint file.  The file is mapped rather than
+ * read, so nothing is copied and only the pages backing the header, the
+ * section table and the sections that are actually examined get faulted in.
+ *
+ * The header and section table are validated when the view is opened.  The
+ * data of each section is bounds- and alignment-checked as it's accessed, so
+ * a corrupt section only causes an error for the consumers that touch it.
+ *
+ * A file written on a system of the other byte order is presented in host
+ * order.  The header and section table are swapped into private copies when
+ * the view is opened, and the data of each section that has multi-byte
+ * fields is swapped into a private copy the first time it's accessed.
+ */
+typedef struct fcf_view {
+	const char *fv_path;		/* pathname of checkpoint file */
+	int fv_fd;			/* file descriptor, -1 if in memory */
+	const uchar_t *fv_base;		/* base address of mapping */
+	size_t fv_size;			/* size of mapping in bytes */
+	const fcf_hdr_t *fv_hdr;	/* file header */
+	const uchar_t *fv_secs;		/* section header table */
+	size_t fv_secsize;		/* size of each section header */
+	uint_t fv_secnum;		/* number of section headers */
+	boolean_t fv_strdone;		/* string table has been indexed */
+	boolean_t fv_strbad;		/* string table is unusable */
+	fcf_strtab_t fv_strtab;		/* index of string table */
+	uint64_t *fv_sechash;		/* cached section data hashes */
+	uchar_t *fv_sechashed;		/* fv_sechash[i] is valid */
+	boolean_t fv_swap;		/* file is of the other byte order */
+	fcf_hdr_t *fv_hdrcopy;		/* swapped copy of header */
+	uchar_t *fv_seccopy;		/* swapped copy of section table */
+	uchar_t **fv_datacopy;		/* swapped copies of section data */
+	char fv_errmsg[256];		/* description of last error */
+} fcf_view_t;
+
+extern int fcf_view_open(fcf_view_t *, const char *);
+extern int fcf_view_open_mem(fcf_view_t *, const char *, const void *,
+    size_t);
+extern void fcf_view_close(fcf_view_t *);
+
+extern const fcf_sec_t *fcf_view_sec(fcf_view_t *, fcf_secidx_t);
+extern const void *fcf_view_data(fcf_view_t *, fcf_secidx_t, uint_t,
+    size_t *);
+extern int fcf_view_nrecs(fcf_view_t *, fcf_secidx_t, uint_t, size_t,
+    uint_t *);
+extern const void *fcf_view_rec(fcf_view_t *, fcf_secidx_t, uint_t, size_t,
+    uint_t);
+extern int fcf_view_strings(fcf_view_t *, fcf_atomtab_t *);
+extern const char *fcf_view_str(fcf_view_t *, fcf_stridx_t);
+extern const fcf_atom_t *fcf_view_atom(fcf_view_t *, fcf_stridx_t);
+extern int fcf_view_sechash(fcf_view_t *, fcf_secidx_t, uint64_t *);
+extern int fcf_view_nvl(fcf_view_t *, fcf_secidx_t, size_t *, const char **,
+    size_t *);
+
+/*
+ * A checkpoint file under construction.  See fcf_write.c.
+ */
+typedef struct fcf_writer {
+	fcf_sec_t *fw_secs;		/* section headers */
+	uint_t fw_nsecs;		/* number of sections */
+	uint_t fw_asecs;		/* allocated entries in fw_secs */
+	uchar_t *fw_data;		/* section data */
+	size_t fw_size;			/* bytes used in fw_data */
+	size_t fw_alloc;		/* bytes allocated for fw_data */
+	fcf_atomtab_t *fw_atoms;	/* distinct strings */
+	fcf_stridx_t *fw_stroffs;	/* string table offset of each atom */
+	uint32_t fw_nstrs;		/* number of entries in fw_stroffs */
+	uint32_t fw_astrs;		/* allocated entries in fw_stroffs */
+	char *fw_strs;			/* string table */
+	size_t fw_strsz;		/* bytes used in fw_strs */
+	size_t fw_stralloc;		/* bytes allocated for fw_strs */
+	uint64_t fw_filesz;		/* size of the saved file */
+	boolean_t fw_err;		/* an allocation has failed */
+	char fw_errmsg[256];		/* description of last error */
+} fcf_writer_t;
+
+extern int fcf_writer_init(fcf_writer_t *);
+extern void fcf_writer_fini(fcf_writer_t *);
+extern fcf_stridx_t fcf_writer_str(fcf_writer_t *, const char *);
+extern fcf_secidx_t fcf_writer_sec(fcf_writer_t *, uint_t, uint_t, uint_t,
+    const void *, size_t);
+extern int fcf_writer_save(fcf_writer_t *, const char *, uint64_t);
+
+extern void fcf_swap32(uint32_t *, size_t);
+extern void fcf_swap64(uint64_t *, size_t);
+extern void fcf_swap_hdr(fcf_hdr_t *);
+extern int fcf_swap_secs(uchar_t *, size_t, size_t);
+extern int fcf_swap_data(uint_t, uchar_t *, size_t, size_t);
+extern boolean_t fcf_swap_needed(uint_t);
+
+extern uint64_t fcf_hash(const void *, size_t, uint64_t);
+
+extern fcf_atomtab_t *fcf_atomtab_create(void);
+extern void fcf_atomtab_destroy(fcf_atomtab_t *);
+extern const fcf_atom_t *fcf_atom_intern(fcf_atomtab_t *, const char *,
+    size_t);
+extern const fcf_atom_t *fcf_atom_byid(fcf_atomtab_t *, uint32_t);
+extern uint32_t fcf_atomtab_count(fcf_atomtab_t *);
+
+extern int fcf_strtab_init(fcf_strtab_t *, const char *, size_t,
+    fcf_atomtab_t *, char *, size_t);
+extern void fcf_strtab_fini(fcf_strtab_t *);
+extern int64_t fcf_strtab_ordinal(const fcf_strtab_t *, fcf_stridx_t);
+extern const char *fcf_strtab_lookup(const fcf_strtab_t *, fcf_stridx_t);
+extern const fcf_atom_t *fcf_strtab_atom(const fcf_strtab_t *, fcf_stridx_t);
+
+extern const char *fcf_sect_name(uint_t);
+extern int fcf_sect_type(const char *, uint_t *);
+extern const char *fcf_case_state_name(uint32_t);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _FCF_H */
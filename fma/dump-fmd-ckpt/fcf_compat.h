@@ -0,0 +1,71 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+#ifndef _FCF_COMPAT_H
+#define	_FCF_COMPAT_H
+
+/*
+ * The handful of illumos definitions that the tool relies on, for building it
+ * on a plain Linux box (see the makefile).  On illumos this is empty.
+ */
+#ifndef	__sun
+
+#include <byteswap.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/types.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+typedef unsigned char uchar_t;
+typedef unsigned int uint_t;
+typedef unsigned long ulong_t;
+typedef unsigned long long u_longlong_t;
+typedef enum { B_FALSE = 0, B_TRUE = 1 } boolean_t;
+
+#define	ISP2(x)			(((x) & ((x) - 1)) == 0)
+#define	IS_P2ALIGNED(v, a)	((((uintptr_t)(v)) & ((uintptr_t)(a) - 1)) == 0)
+#define	P2ROUNDUP(x, align)	(-(-(x) & -(align)))
+
+#define	MAXNAMELEN		256
+
+#define	BSWAP_32(x)		bswap_32(x)
+#define	BSWAP_64(x)		bswap_64(x)
+
+#if defined(__GLIBC__) && !__GLIBC_PREREQ(2, 38)
+static inline size_t
+strlcpy(char *dst, const char *src, size_t len)
+{
+	size_t slen = strlen(src);
+
+	if (len != 0) {
+		size_t n = slen < len ? slen : len - 1;
+
+		(void) memcpy(dst, src, n);
+		dst[n] = '\0';
+	}
+	return (slen);
+}
+
+static inline size_t
+strlcat(char *dst, const char *src, size_t len)
+{
+	size_t dlen = strnlen(dst, len);
+
+	return (dlen + strlcpy(dst + dlen, src, len - dlen));
+}
+#endif
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* !__sun */
+
+#endif	/* _FCF_COMPAT_H */
@@ -0,0 +1,395 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+/*
+ * FCF string table indexing and string interning.
+ *
+ * A string reference in an FCF file (fcf_stridx_t) is a byte offset into the
+ * string table section.  When a table is indexed we scan it once for NUL
+ * bytes, eight bytes at a time, and record where every string starts in a
+ * bitmap.  A rank array holding the number of strings that start before each
+ * 64-bit word of the bitmap then turns any offset into a string ordinal with
+ * one popcount, so a lookup is O(1) and rejects offsets that don't point at
+ * the start of a string.  fmd never generates such references, so they are
+ * treated as corruption rather than silently yielding a string suffix.
+ *
+ * If an atom table is supplied, every string in the table is interned as the
+ * index is built.  The atom table is shared by all of the files decoded in a
+ * run, and is safe for concurrent use, so each distinct module name, path or
+ * case UUID is stored once no matter how many files it appears in, atoms can
+ * be compared by address, and each atom has a small, dense identifier that
+ * can be used to refer to the string in place of repeating it.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "fcf.h"
+
+#define	FCF_ATOM_NBUCKETS	(1 << 16)
+#define	FCF_ATOM_NLOCKS		64
+
+struct fcf_atomtab {
+	pthread_mutex_t fat_locks[FCF_ATOM_NLOCKS]; /* bucket locks */
+	fcf_atom_t *fat_buckets[FCF_ATOM_NBUCKETS]; /* hash chains */
+	pthread_mutex_t fat_idlock;	/* protects members below */
+	const fcf_atom_t **fat_byid;	/* atoms indexed by fa_id */
+	uint32_t fat_natoms;		/* number of atoms */
+	uint32_t fat_alloc;		/* allocated entries in fat_byid */
+};
+
+/*
+ * MurmurHash64A, by Austin Appleby, which is in the public domain.  It's
+ * fast, consumes its input eight bytes at a time and has good distribution,
+ * and it's used both for interning strings and to fingerprint section data.
+ */
+uint64_t
+fcf_hash(const void *buf, size_t len, uint64_t seed)
+{
+	const uint64_t m = 0xc6a4a7935bd1e995ULL;
+	const int r = 47;
+	const uchar_t *p = buf, *end = p + (len & ~(size_t)7);
+	uint64_t h = seed ^ (len * m);
+	uint64_t k;
+
+	for (; p != end; p += sizeof (uint64_t)) {
+		bcopy(p, &k, sizeof (uint64_t));
+		k *= m;
+		k ^= k >> r;
+		k *= m;
+		h ^= k;
+		h *= m;
+	}
+
+	switch (len & 7) {
+	case 7:
+		h ^= (uint64_t)p[6] << 48;
+		/* FALLTHROUGH */
+	case 6:
+		h ^= (uint64_t)p[5] << 40;
+		/* FALLTHROUGH */
+	case 5:
+		h ^= (uint64_t)p[4] << 32;
+		/* FALLTHROUGH */
+	case 4:
+		h ^= (uint64_t)p[3] << 24;
+		/* FALLTHROUGH */
+	case 3:
+		h ^= (uint64_t)p[2] << 16;
+		/* FALLTHROUGH */
+	case 2:
+		h ^= (uint64_t)p[1] << 8;
+		/* FALLTHROUGH */
+	case 1:
+		h ^= (uint64_t)p[0];
+		h *= m;
+	}
+
+	h ^= h >> r;
+	h *= m;
+	h ^= h >> r;
+
+	return (h);
+}
+
+fcf_atomtab_t *
+fcf_atomtab_create(void)
+{
+	fcf_atomtab_t *fat;
+	uint_t i;
+
+	if ((fat = calloc(1, sizeof (fcf_atomtab_t))) == NULL)
+		return (NULL);
+
+	for (i = 0; i < FCF_ATOM_NLOCKS; i++)
+		(void) pthread_mutex_init(&fat->fat_locks[i], NULL);
+	(void) pthread_mutex_init(&fat->fat_idlock, NULL);
+
+	return (fat);
+}
+
+void
+fcf_atomtab_destroy(fcf_atomtab_t *fat)
+{
+	fcf_atom_t *fa, *next;
+	uint_t i;
+
+	if (fat == NULL)
+		return;
+
+	for (i = 0; i < FCF_ATOM_NBUCKETS; i++) {
+		for (fa = fat->fat_buckets[i]; fa != NULL; fa = next) {
+			next = fa->fa_next;
+			free(fa);
+		}
+	}
+	for (i = 0; i < FCF_ATOM_NLOCKS; i++)
+		(void) pthread_mutex_destroy(&fat->fat_locks[i]);
+	(void) pthread_mutex_destroy(&fat->fat_idlock);
+
+	free(fat->fat_byid);
+	free(fat);
+}
+
+/*
+ * Return the atom for the len-byte string str, creating it if this is the
+ * first time we've seen the string.  Returns NULL if memory is exhausted.
+ */
+const fcf_atom_t *
+fcf_atom_intern(fcf_atomtab_t *fat, const char *str, size_t len)
+{
+	uint64_t h = fcf_hash(str, len, 0);
+	uint_t b = h & (FCF_ATOM_NBUCKETS - 1);
+	pthread_mutex_t *lock = &fat->fat_locks[b % FCF_ATOM_NLOCKS];
+	fcf_atom_t *fa;
+
+	(void) pthread_mutex_lock(lock);
+	for (fa = fat->fat_buckets[b]; fa != NULL; fa = fa->fa_next) {
+		if (fa->fa_hash == h && fa->fa_len == len &&
+		    bcmp(fa->fa_str, str, len) == 0) {
+			(void) pthread_mutex_unlock(lock);
+			return (fa);
+		}
+	}
+
+	if ((fa = malloc(sizeof (fcf_atom_t) + len)) == NULL) {
+		(void) pthread_mutex_unlock(lock);
+		return (NULL);
+	}
+	fa->fa_hash = h;
+	fa->fa_len = (uint32_t)len;
+	bcopy(str, fa->fa_str, len);
+	fa->fa_str[len] = '\0';
+
+	(void) pthread_mutex_lock(&fat->fat_idlock);
+	if (fat->fat_natoms == fat->fat_alloc) {
+		uint32_t alloc = fat->fat_alloc == 0 ? 1024 :
+		    fat->fat_alloc * 2;
+		const fcf_atom_t **byid;
+
+		if ((byid = realloc(fat->fat_byid,
+		    alloc * sizeof (fcf_atom_t *))) == NULL) {
+			(void) pthread_mutex_unlock(&fat->fat_idlock);
+			(void) pthread_mutex_unlock(lock);
+			free(fa);
+			return (NULL);
+		}
+		fat->fat_byid = byid;
+		fat->fat_alloc = alloc;
+	}
+	fa->fa_id = fat->fat_natoms++;
+	fat->fat_byid[fa->fa_id] = fa;
+	(void) pthread_mutex_unlock(&fat->fat_idlock);
+
+	fa->fa_next = fat->fat_buckets[b];
+	fat->fat_buckets[b] = fa;
+	(void) pthread_mutex_unlock(lock);
+
+	return (fa);
+}
+
+uint32_t
+fcf_atomtab_count(fcf_atomtab_t *fat)
+{
+	uint32_t n;
+
+	(void) pthread_mutex_lock(&fat->fat_idlock);
+	n = fat->fat_natoms;
+	(void) pthread_mutex_unlock(&fat->fat_idlock);
+
+	return (n);
+}
+
+const fcf_atom_t *
+fcf_atom_byid(fcf_atomtab_t *fat, uint32_t id)
+{
+	const fcf_atom_t *fa = NULL;
+
+	(void) pthread_mutex_lock(&fat->fat_idlock);
+	if (id < fat->fat_natoms)
+		fa = fat->fat_byid[id];
+	(void) pthread_mutex_unlock(&fat->fat_idlock);
+
+	return (fa);
+}
+
+/*
+ * Exact test for zero bytes in a 64-bit word: the high bit of each byte of
+ * the result is set iff that byte of v is zero.
+ */
+#define	FCF_ZEROBYTES(v)	\
+	(~((((v) & 0x7f7f7f7f7f7f7f7fULL) + 0x7f7f7f7f7f7f7f7fULL) | (v) | \
+	0x7f7f7f7f7f7f7f7fULL))
+
+static void
+fcf_strtab_mark(fcf_strtab_t *fs, size_t off)
+{
+	fs->fs_starts[off / 64] |= 1ULL << (off % 64);
+	fs->fs_nstrs++;
+}
+
+/*
+ * Index the string table of the given size at data.  Returns 0 on success, or
+ * -1 with errmsg filled in if the table is malformed or memory is exhausted.
+ * fcf_strtab_fini() must be called in either case.
+ */
+int
+fcf_strtab_init(fcf_strtab_t *fs, const char *data, size_t size,
+    fcf_atomtab_t *fat, char *errmsg, size_t errlen)
+{
+	size_t nwords = (size + 63) / 64;
+	size_t off, i;
+	uint64_t v;
+	uint32_t n;
+
+	(void) memset(fs, 0, sizeof (fcf_strtab_t));
+	fs->fs_data = data;
+	fs->fs_size = size;
+
+	/*
+	 * Every string, including the last, must be terminated within the
+	 * table.
+	 */
+	if (size == 0 || data[size - 1] != '\0') {
+		(void) snprintf(errmsg, errlen, "string table of %zu bytes is "
+		    "empty or improperly terminated", size);
+		return (-1);
+	}
+	if (size > UINT32_MAX) {
+		(void) snprintf(errmsg, errlen, "string table of %zu bytes is "
+		    "too large", size);
+		return (-1);
+	}
+
+	if ((fs->fs_starts = calloc(nwords, sizeof (uint64_t))) == NULL ||
+	    (fs->fs_rank = calloc(nwords, sizeof (uint32_t))) == NULL) {
+		(void) snprintf(errmsg, errlen, "failed to allocate memory");
+		return (-1);
+	}
+
+	/*
+	 * A string starts at offset 0 and after every NUL other than the
+	 * last.  Most words contain no NUL at all, and are skipped with a
+	 * single test.
+	 */
+	fcf_strtab_mark(fs, 0);
+	for (off = 0; off + sizeof (uint64_t) <= size;
+	    off += sizeof (uint64_t)) {
+		bcopy(data + off, &v, sizeof (uint64_t));
+		if (FCF_ZEROBYTES(v) == 0)
+			continue;
+		for (i = off; i < off + sizeof (uint64_t); i++) {
+			if (data[i] == '\0' && i + 1 < size)
+				fcf_strtab_mark(fs, i + 1);
+		}
+	}
+	for (i = off; i < size; i++) {
+		if (data[i] == '\0' && i + 1 < size)
+			fcf_strtab_mark(fs, i + 1);
+	}
+
+	for (i = 0, n = 0; i < nwords; i++) {
+		fs->fs_rank[i] = n;
+		n += __builtin_popcountll(fs->fs_starts[i]);
+	}
+
+	if ((fs->fs_offs = malloc(fs->fs_nstrs * sizeof (uint32_t))) == NULL) {
+		(void) snprintf(errmsg, errlen, "failed to allocate memory");
+		return (-1);
+	}
+	for (i = 0, n = 0; i < nwords; i++) {
+		uint64_t w = fs->fs_starts[i];
+
+		while (w != 0) {
+			fs->fs_offs[n++] = (uint32_t)(i * 64 +
+			    __builtin_ctzll(w));
+			w &= w - 1;
+		}
+	}
+
+	if (fat == NULL)
+		return (0);
+
+	if ((fs->fs_atoms = calloc(fs->fs_nstrs,
+	    sizeof (fcf_atom_t *))) == NULL) {
+		(void) snprintf(errmsg, errlen, "failed to allocate memory");
+		return (-1);
+	}
+	for (n = 0; n < fs->fs_nstrs; n++) {
+		const char *s = data + fs->fs_offs[n];
+		size_t len = (n + 1 < fs->fs_nstrs ?
+		    fs->fs_offs[n + 1] : size) - fs->fs_offs[n] - 1;
+
+		if ((fs->fs_atoms[n] = fcf_atom_intern(fat, s, len)) == NULL) {
+			(void) snprintf(errmsg, errlen, "failed to allocate "
+			    "memory");
+			return (-1);
+		}
+	}
+
+	return (0);
+}
+
+void
+fcf_strtab_fini(fcf_strtab_t *fs)
+{
+	free(fs->fs_starts);
+	free(fs->fs_rank);
+	free(fs->fs_offs);
+	free(fs->fs_atoms);
+	(void) memset(fs, 0, sizeof (fcf_strtab_t));
+}
+
+/*
+ * Return the ordinal of the string starting at offset sid, or -1 if sid
+ * doesn't refer to the start of a string in the table.
+ */
+int64_t
+fcf_strtab_ordinal(const fcf_strtab_t *fs, fcf_stridx_t sid)
+{
+	uint64_t w, bit;
+
+	if (sid >= fs->fs_size)
+		return (-1);
+
+	w = fs->fs_starts[sid / 64];
+	bit = 1ULL << (sid % 64);
+	if ((w & bit) == 0)
+		return (-1);
+
+	return (fs->fs_rank[sid / 64] + __builtin_popcountll(w & (bit - 1)));
+}
+
+/*
+ * Return the string at offset sid, or NULL if that isn't a valid reference.
+ */
+const char *
+fcf_strtab_lookup(const fcf_strtab_t *fs, fcf_stridx_t sid)
+{
+	int64_t n = fcf_strtab_ordinal(fs, sid);
+
+	if (n < 0)
+		return (NULL);
+
+	return (fs->fs_atoms != NULL ? fs->fs_atoms[n]->fa_str :
+	    fs->fs_data + sid);
+}
+
+/*
+ * As above, but return the interned atom.  Only valid if the index was built
+ * with an atom table.
+ */
+const fcf_atom_t *
+fcf_strtab_atom(const fcf_strtab_t *fs, fcf_stridx_t sid)
+{
+	int64_t n = fcf_strtab_ordinal(fs, sid);
+
+	return (n < 0 || fs->fs_atoms == NULL ? NULL : fs->fs_atoms[n]);
+}
@@ -0,0 +1,223 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+/*
+ * Byte-swapping of FCF structures, for reading checkpoints written on a
+ * system of the other byte order.
+ *
+ * Rather than converting records a field at a time, each table is swapped
+ * with a single pass over it as an array of 32- or 64-bit words.  The loops
+ * are simple enough for the compiler to turn into vector byte shuffles.
+ * Records that mix the two widths are swapped as 64-bit words, and then each
+ * word that actually holds a pair of 32-bit fields has its halves exchanged.
+ *
+ * The record layouts don't depend on the data model: every FCF structure is
+ * made of fixed-width fields that are naturally aligned, so an ILP32 and an
+ * LP64 fmd write identical files.  Only the byte order needs handling.
+ */
+#include <stdio.h>
+#include <stddef.h>
+#include <sys/types.h>
+#ifdef	__sun
+#include <sys/byteorder.h>
+#endif
+
+#include "fcf.h"
+
+/*
+ * Layouts of the records we know how to swap.  A record is either all 32-bit
+ * fields or a sequence of 64-bit words, in which case fsw_pairs is a mask of
+ * the words that hold two 32-bit fields.
+ */
+typedef struct fcf_swapinfo {
+	size_t fsw_size;		/* size of record */
+	size_t fsw_width;		/* size of word to swap */
+	uint32_t fsw_pairs;		/* mask of words holding 32-bit pairs */
+} fcf_swapinfo_t;
+
+static const fcf_swapinfo_t fcf_swap_sec =
+	{ sizeof (fcf_sec_t), sizeof (uint64_t), 0x3 };
+static const fcf_swapinfo_t fcf_swap_module =
+	{ sizeof (fcf_module_t), sizeof (uint32_t), 0 };
+static const fcf_swapinfo_t fcf_swap_case =
+	{ sizeof (fcf_case_t), sizeof (uint32_t), 0 };
+static const fcf_swapinfo_t fcf_swap_buf =
+	{ sizeof (fcf_buf_t), sizeof (uint32_t), 0 };
+static const fcf_swapinfo_t fcf_swap_serd =
+	{ sizeof (fcf_serd_t), sizeof (uint64_t), 0x3 };
+static const fcf_swapinfo_t fcf_swap_event =
+	{ sizeof (fcf_event_t), sizeof (uint64_t), 0x4 };
+
+void
+fcf_swap32(uint32_t *p, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		p[i] = BSWAP_32(p[i]);
+}
+
+void
+fcf_swap64(uint64_t *p, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		p[i] = BSWAP_64(p[i]);
+}
+
+/*
+ * Swap n records laid out stride bytes apart.  Only the part of each record
+ * that we know about is swapped; anything beyond it is left alone.  Returns
+ * -1 if the 64-bit fields of the records wouldn't be aligned.
+ */
+static int
+fcf_swap_recs(uchar_t *buf, size_t n, size_t stride,
+    const fcf_swapinfo_t *fsw)
+{
+	size_t i, w, nwords = fsw->fsw_size / sizeof (uint64_t);
+	uint64_t *wp;
+
+	if (fsw->fsw_width == sizeof (uint32_t)) {
+		if (stride == fsw->fsw_size) {
+			fcf_swap32((uint32_t *)buf, n * stride /
+			    sizeof (uint32_t));
+		} else {
+			for (i = 0; i < n; i++) {
+				fcf_swap32((uint32_t *)(buf + i * stride),
+				    fsw->fsw_size / sizeof (uint32_t));
+			}
+		}
+		return (0);
+	}
+
+	if (!IS_P2ALIGNED(stride, sizeof (uint64_t)))
+		return (-1);
+
+	if (stride == fsw->fsw_size) {
+		fcf_swap64((uint64_t *)buf, n * nwords);
+	} else {
+		for (i = 0; i < n; i++)
+			fcf_swap64((uint64_t *)(buf + i * stride), nwords);
+	}
+
+	if (fsw->fsw_pairs != 0) {
+		for (i = 0; i < n; i++) {
+			wp = (uint64_t *)(buf + i * stride);
+			for (w = 0; w < nwords; w++) {
+				if (fsw->fsw_pairs & (1U << w))
+					wp[w] = (wp[w] << 32) | (wp[w] >> 32);
+			}
+		}
+	}
+	return (0);
+}
+
+/*
+ * Swap a copy of the file header in place.  The identification bytes are
+ * followed by four 32-bit fields and then 64-bit fields.
+ */
+void
+fcf_swap_hdr(fcf_hdr_t *hdr)
+{
+	fcf_swap32(&hdr->fcfh_flags, 4);
+	fcf_swap64(&hdr->fcfh_secoff, (sizeof (fcf_hdr_t) -
+	    offsetof(fcf_hdr_t, fcfh_secoff)) / sizeof (uint64_t));
+}
+
+/*
+ * Swap a copy of the section header table in place.  Each entry is stride
+ * bytes, which may be more than we know about.
+ */
+int
+fcf_swap_secs(uchar_t *buf, size_t n, size_t stride)
+{
+	return (fcf_swap_recs(buf, n, stride, &fcf_swap_sec));
+}
+
+/*
+ * Swap a copy of the data of a section of the given type in place.  size is
+ * the size of the section and entsize its fcfs_entsize.  Sections of types
+ * with no multi-byte fields (string tables and buffers) and of types we don't
+ * know about are left alone, as are tables whose entry size is too small or
+ * misaligned, which fcf_view_nrecs() rejects.  Returns -1 if the records
+ * can't be swapped.
+ */
+int
+fcf_swap_data(uint_t type, uchar_t *buf, size_t size, size_t entsize)
+{
+	const fcf_swapinfo_t *fsw;
+	fcf_nvl_t *nvl;
+	size_t off;
+
+	switch (type) {
+	case FCF_SECT_MODULE:
+		fsw = &fcf_swap_module;
+		break;
+	case FCF_SECT_CASE:
+		fsw = &fcf_swap_case;
+		break;
+	case FCF_SECT_BUFS:
+		fsw = &fcf_swap_buf;
+		break;
+	case FCF_SECT_SERD:
+		fsw = &fcf_swap_serd;
+		break;
+	case FCF_SECT_EVENTS:
+		fsw = &fcf_swap_event;
+		break;
+	case FCF_SECT_NVLISTS:
+		/*
+		 * Only the fcf_nvl_t headers need swapping: fmd packs the
+		 * nvlists themselves with the XDR encoding, which is the same
+		 * on every system.  A truncated header or nvlist is left for
+		 * fcf_view_nvl() to report.
+		 */
+		for (off = 0; size - off >= sizeof (fcf_nvl_t); ) {
+			nvl = (fcf_nvl_t *)(buf + off);
+			nvl->fcfn_size = BSWAP_64(nvl->fcfn_size);
+			off += sizeof (fcf_nvl_t);
+			if (nvl->fcfn_size > size - off)
+				break;
+			off += P2ROUNDUP((size_t)nvl->fcfn_size,
+			    sizeof (uint64_t));
+			if (off > size)
+				break;
+		}
+		return (0);
+	default:
+		return (0);
+	}
+
+	if (entsize == 0)
+		entsize = fsw->fsw_size;
+	if (entsize < fsw->fsw_size ||
+	    !IS_P2ALIGNED(entsize, sizeof (uint32_t)))
+		return (0);
+
+	return (fcf_swap_recs(buf, size / entsize, entsize, fsw));
+}
+
+/*
+ * Return true if a section of the given type has fields that need swapping.
+ */
+boolean_t
+fcf_swap_needed(uint_t type)
+{
+	switch (type) {
+	case FCF_SECT_MODULE:
+	case FCF_SECT_CASE:
+	case FCF_SECT_BUFS:
+	case FCF_SECT_SERD:
+	case FCF_SECT_EVENTS:
+	case FCF_SECT_NVLISTS:
+		return (B_TRUE);
+	default:
+		return (B_FALSE);
+	}
+}
@@ -0,0 +1,342 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+/*
+ * Writer side of the FCF format, for tools that produce checkpoints rather
+ * than just read them.
+ *
+ * Sections are appended one at a time and the file is laid out the way fmd
+ * lays it out (see fmd_ckpt_create() in usr/src/cmd/fm/fmd/common/fmd_ckpt.c):
+ * the header, then the section header table, then the data of each section
+ * in the order it was added, aligned as requested.  Section 0 is the
+ * reserved FCF_SECT_NONE section, so that FCF_SECIDX_NONE never refers to
+ * real data.  Strings are interned as they're added, so each distinct string
+ * is stored once, and the string table becomes the last section when the
+ * file is saved.
+ *
+ * Allocation failures are sticky: the calls that add to the writer don't
+ * report them, but the writer then refuses to save.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "fcf.h"
+
+/*
+ * Section data is laid out relative to the first 64-bit boundary after the
+ * section header table, so no section can ask for more alignment than that.
+ */
+#define	FCF_WRITER_MAXALIGN	sizeof (uint64_t)
+
+static void
+fcf_writer_error(fcf_writer_t *fw, const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	(void) vsnprintf(fw->fw_errmsg, sizeof (fw->fw_errmsg), fmt, ap);
+	va_end(ap);
+}
+
+static void
+fcf_writer_nomem(fcf_writer_t *fw)
+{
+	fw->fw_err = B_TRUE;
+	fcf_writer_error(fw, "failed to allocate memory");
+}
+
+/*
+ * Make room for len more bytes in a buffer that grows by doubling.
+ */
+static int
+fcf_writer_grow(fcf_writer_t *fw, void **bufp, size_t *allocp, size_t used,
+    size_t len)
+{
+	size_t alloc = *allocp;
+	void *buf;
+
+	if (len <= alloc - used)
+		return (0);
+
+	if (alloc == 0)
+		alloc = 4096;
+	while (len > alloc - used) {
+		if (alloc > SIZE_MAX / 2) {
+			fcf_writer_nomem(fw);
+			return (-1);
+		}
+		alloc *= 2;
+	}
+
+	if ((buf = realloc(*bufp, alloc)) == NULL) {
+		fcf_writer_nomem(fw);
+		return (-1);
+	}
+	*bufp = buf;
+	*allocp = alloc;
+	return (0);
+}
+
+int
+fcf_writer_init(fcf_writer_t *fw)
+{
+	(void) memset(fw, 0, sizeof (fcf_writer_t));
+
+	if ((fw->fw_atoms = fcf_atomtab_create()) == NULL) {
+		fcf_writer_nomem(fw);
+		return (-1);
+	}
+
+	/*
+	 * Offset 0 of the string table is the empty string, which is what
+	 * FCF_STRIDX_NONE refers to.
+	 */
+	(void) fcf_writer_str(fw, "");
+	(void) fcf_writer_sec(fw, FCF_SECT_NONE, 0, 0, NULL, 0);
+
+	return (fw->fw_err ? -1 : 0);
+}
+
+void
+fcf_writer_fini(fcf_writer_t *fw)
+{
+	fcf_atomtab_destroy(fw->fw_atoms);
+	free(fw->fw_secs);
+	free(fw->fw_data);
+	free(fw->fw_stroffs);
+	free(fw->fw_strs);
+	fw->fw_atoms = NULL;
+	fw->fw_secs = NULL;
+	fw->fw_data = NULL;
+	fw->fw_stroffs = NULL;
+	fw->fw_strs = NULL;
+}
+
+/*
+ * Return the string table offset of the given string, adding it to the table
+ * if it hasn't been seen before.
+ */
+fcf_stridx_t
+fcf_writer_str(fcf_writer_t *fw, const char *s)
+{
+	const fcf_atom_t *fa;
+	size_t len = strlen(s);
+	void *buf;
+
+	if (fw->fw_err)
+		return (FCF_STRIDX_NONE);
+
+	if ((fa = fcf_atom_intern(fw->fw_atoms, s, len)) == NULL) {
+		fcf_writer_nomem(fw);
+		return (FCF_STRIDX_NONE);
+	}
+	if (fa->fa_id < fw->fw_nstrs)
+		return (fw->fw_stroffs[fa->fa_id]);
+
+	/*
+	 * Atom ids are handed out densely in order of first use, so a new
+	 * string is always the next one.
+	 */
+	if (fw->fw_strsz + len + 1 > UINT32_MAX) {
+		fw->fw_err = B_TRUE;
+		fcf_writer_error(fw, "string table is too large");
+		return (FCF_STRIDX_NONE);
+	}
+	if (fw->fw_nstrs == fw->fw_astrs) {
+		uint32_t astrs = fw->fw_astrs == 0 ? 256 : fw->fw_astrs * 2;
+
+		if ((buf = realloc(fw->fw_stroffs,
+		    astrs * sizeof (fcf_stridx_t))) == NULL) {
+			fcf_writer_nomem(fw);
+			return (FCF_STRIDX_NONE);
+		}
+		fw->fw_stroffs = buf;
+		fw->fw_astrs = astrs;
+	}
+	buf = fw->fw_strs;
+	if (fcf_writer_grow(fw, &buf, &fw->fw_stralloc, fw->fw_strsz,
+	    len + 1) != 0)
+		return (FCF_STRIDX_NONE);
+	fw->fw_strs = buf;
+
+	fw->fw_stroffs[fw->fw_nstrs++] = (fcf_stridx_t)fw->fw_strsz;
+	bcopy(s, fw->fw_strs + fw->fw_strsz, len + 1);
+	fw->fw_strsz += len + 1;
+
+	return (fw->fw_stroffs[fa->fa_id]);
+}
+
+/*
+ * Append a section with the given type, alignment and entry size, whose data
+ * is a copy of the size bytes at data.  Returns the new section's index.
+ */
+fcf_secidx_t
+fcf_writer_sec(fcf_writer_t *fw, uint_t type, uint_t align, uint_t entsize,
+    const void *data, size_t size)
+{
+	fcf_sec_t *sp;
+	size_t off;
+	void *buf;
+
+	if (fw->fw_err)
+		return (FCF_SECIDX_NONE);
+
+	if (align > FCF_WRITER_MAXALIGN || (align != 0 && !ISP2(align))) {
+		fw->fw_err = B_TRUE;
+		fcf_writer_error(fw, "invalid section alignment %u", align);
+		return (FCF_SECIDX_NONE);
+	}
+
+	if (fw->fw_nsecs == fw->fw_asecs) {
+		uint_t asecs = fw->fw_asecs == 0 ? 64 : fw->fw_asecs * 2;
+
+		if ((buf = realloc(fw->fw_secs,
+		    asecs * sizeof (fcf_sec_t))) == NULL) {
+			fcf_writer_nomem(fw);
+			return (FCF_SECIDX_NONE);
+		}
+		fw->fw_secs = buf;
+		fw->fw_asecs = asecs;
+	}
+
+	off = align > 1 ? P2ROUNDUP(fw->fw_size, (size_t)align) : fw->fw_size;
+	buf = fw->fw_data;
+	if (fcf_writer_grow(fw, &buf, &fw->fw_alloc, fw->fw_size,
+	    off - fw->fw_size + size) != 0)
+		return (FCF_SECIDX_NONE);
+	fw->fw_data = buf;
+
+	bzero(fw->fw_data + fw->fw_size, off - fw->fw_size);
+	if (size != 0)
+		bcopy(data, fw->fw_data + off, size);
+	fw->fw_size = off + size;
+
+	/*
+	 * Offsets are relative to the start of the data until the file is
+	 * saved, since that depends on the size of the section table.
+	 */
+	sp = &fw->fw_secs[fw->fw_nsecs];
+	(void) memset(sp, 0, sizeof (fcf_sec_t));
+	sp->fcfs_type = type;
+	sp->fcfs_align = align;
+	sp->fcfs_entsize = entsize;
+	sp->fcfs_offset = off;
+	sp->fcfs_size = size;
+
+	return (fw->fw_nsecs++);
+}
+
+static int
+fcf_writer_out(int fd, const void *buf, size_t len)
+{
+	const char *p = buf;
+	ssize_t n;
+
+	while (len != 0) {
+		if ((n = write(fd, p, len)) < 0) {
+			if (errno == EINTR)
+				continue;
+			return (-1);
+		}
+		p += n;
+		len -= (size_t)n;
+	}
+	return (0);
+}
+
+/*
+ * Append the string table and write the checkpoint to path.  Like fmd, we
+ * write a temporary file in the same directory, sync it and rename it into
+ * place, so that a reader sees either the old file or the whole new one.
+ * Nothing can be added to the writer afterwards.
+ */
+int
+fcf_writer_save(fcf_writer_t *fw, const char *path, uint64_t cgen)
+{
+	static const uchar_t pad[FCF_WRITER_MAXALIGN] = { 0 };
+	char tmp[MAXPATHLEN], dir[MAXPATHLEN];
+	fcf_hdr_t hdr;
+	size_t secsz, datoff;
+	uint_t i;
+	int fd, dfd;
+
+	(void) fcf_writer_sec(fw, FCF_SECT_STRTAB, 1, 0, fw->fw_strs,
+	    fw->fw_strsz);
+	if (fw->fw_err)
+		return (-1);
+
+	secsz = fw->fw_nsecs * sizeof (fcf_sec_t);
+	datoff = P2ROUNDUP(sizeof (fcf_hdr_t) + secsz, FCF_WRITER_MAXALIGN);
+
+	(void) memset(&hdr, 0, sizeof (hdr));
+	bcopy(FCF_MAG_STRING, hdr.fcfh_ident, FCF_MAG_STRLEN);
+	hdr.fcfh_ident[FCF_ID_MODEL] = FCF_MODEL_NATIVE;
+	hdr.fcfh_ident[FCF_ID_ENCODING] = FCF_ENCODE_NATIVE;
+	hdr.fcfh_ident[FCF_ID_VERSION] = FCF_VERSION;
+	hdr.fcfh_flags = FCF_FL_VALID;
+	hdr.fcfh_hdrsize = sizeof (fcf_hdr_t);
+	hdr.fcfh_secsize = sizeof (fcf_sec_t);
+	hdr.fcfh_secnum = fw->fw_nsecs;
+	hdr.fcfh_secoff = sizeof (fcf_hdr_t);
+	hdr.fcfh_filesz = fw->fw_filesz = datoff + fw->fw_size;
+	hdr.fcfh_cgen = cgen;
+
+	for (i = 0; i < fw->fw_nsecs; i++)
+		fw->fw_secs[i].fcfs_offset += datoff;
+
+	if (snprintf(tmp, sizeof (tmp), "%s.XXXXXX", path) >= sizeof (tmp)) {
+		fcf_writer_error(fw, "path too long: %s", path);
+		return (-1);
+	}
+	if ((fd = mkstemp(tmp)) < 0) {
+		fcf_writer_error(fw, "failed to create %s (%s)", tmp,
+		    strerror(errno));
+		return (-1);
+	}
+
+	if (fcf_writer_out(fd, &hdr, sizeof (hdr)) != 0 ||
+	    fcf_writer_out(fd, fw->fw_secs, secsz) != 0 ||
+	    fcf_writer_out(fd, pad, datoff - sizeof (hdr) - secsz) != 0 ||
+	    fcf_writer_out(fd, fw->fw_data, fw->fw_size) != 0 ||
+	    fsync(fd) != 0) {
+		fcf_writer_error(fw, "failed to write %s (%s)", tmp,
+		    strerror(errno));
+		(void) close(fd);
+		(void) unlink(tmp);
+		return (-1);
+	}
+	(void) close(fd);
+
+	if (rename(tmp, path) != 0) {
+		fcf_writer_error(fw, "failed to rename %s to %s (%s)", tmp,
+		    path, strerror(errno));
+		(void) unlink(tmp);
+		return (-1);
+	}
+
+	/*
+	 * Make the rename itself durable.  dirname() may modify its argument.
+	 */
+	(void) strlcpy(dir, path, sizeof (dir));
+	if ((dfd = open(dirname(dir), O_RDONLY)) >= 0) {
+		(void) fsync(dfd);
+		(void) close(dfd);
+	}
+
+	return (0);
+}
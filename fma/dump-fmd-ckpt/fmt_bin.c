@@ -0,0 +1,222 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+/*
+ * The compact binary output format.  The stream is a sequence of records,
+ * each a one-byte tag followed by fields.  Integers are unsigned LEB128
+ * varints, and byte strings are a varint length followed by the bytes, so
+ * the stream is the same regardless of the byte order of the writer.
+ *
+ *	'F' version path		start of a checkpoint file
+ *	'S' id str			string definition
+ *	'H' model encoding version flags hdrsize secsize secnum secoff
+ *	    filesz cgen			file header
+ *	'X' sid type align flags entsize offset size
+ *					section header
+ *	'T' sid offset str		string table entry
+ *	'M' sid name path desc vers bufs
+ *					module
+ *	'C' sid uuid state bufs principal events suspects
+ *					case
+ *	'B' sid idx name data		buffer table entry
+ *	'D' sid data			buffer contents
+ *	'E' sid idx name events n t	SERD engine
+ *	'V' sid idx todsec todnsec major minor inode offset
+ *					event
+ *	'N' sid idx nvlist		packed nvlist, as checkpointed
+ *
+ * String-valued fields of module, case, buffer and SERD records are ids
+ * rather than strings.  Each distinct string is sent once, in an 'S' record
+ * that precedes its first use, and ids are numbered from one in order of
+ * first use; zero means the string couldn't be resolved.  An 'F' record
+ * resets the string dictionary, so that the output for each file stands
+ * alone.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/types.h>
+
+#include "out.h"
+
+#define	BIN_VERSION	1
+
+static uint32_t
+bin_str(dump_out_t *o, fcf_view_t *fv, fcf_stridx_t sid)
+{
+	return (out_atom(o, fcf_view_atom(fv, sid)));
+}
+
+static void
+bin_hdr(dump_out_t *o, fcf_view_t *fv)
+{
+	const fcf_hdr_t *h = fv->fv_hdr;
+
+	if (o->do_ids != NULL)
+		bzero(o->do_ids, o->do_nids * sizeof (uint32_t));
+	o->do_nextid = 1;
+
+	out_putc(o, 'F');
+	out_varint(o, BIN_VERSION);
+	out_blob(o, fv->fv_path, strlen(fv->fv_path));
+
+	out_putc(o, 'H');
+	out_varint(o, h->fcfh_ident[FCF_ID_MODEL]);
+	out_varint(o, h->fcfh_ident[FCF_ID_ENCODING]);
+	out_varint(o, h->fcfh_ident[FCF_ID_VERSION]);
+	out_varint(o, h->fcfh_flags);
+	out_varint(o, h->fcfh_hdrsize);
+	out_varint(o, h->fcfh_secsize);
+	out_varint(o, h->fcfh_secnum);
+	out_varint(o, h->fcfh_secoff);
+	out_varint(o, h->fcfh_filesz);
+	out_varint(o, h->fcfh_cgen);
+}
+
+static void
+bin_sec(dump_out_t *o, fcf_view_t *fv, fcf_secidx_t sid)
+{
+	const fcf_sec_t *s = fcf_view_sec(fv, sid);
+
+	out_putc(o, 'X');
+	out_varint(o, sid);
+	out_varint(o, s->fcfs_type);
+	out_varint(o, s->fcfs_align);
+	out_varint(o, s->fcfs_flags);
+	out_varint(o, s->fcfs_entsize);
+	out_varint(o, s->fcfs_offset);
+	out_varint(o, s->fcfs_size);
+}
+
+/*ARGSUSED*/
+static void
+bin_secend(dump_out_t *o, fcf_secidx_t sid)
+{
+}
+
+static void
+bin_str_rec(dump_out_t *o, fcf_secidx_t sid, uint32_t off, const char *s)
+{
+	out_putc(o, 'T');
+	out_varint(o, sid);
+	out_varint(o, off);
+	out_blob(o, s, strlen(s));
+}
+
+static void
+bin_module(dump_out_t *o, fcf_view_t *fv, fcf_secidx_t sid,
+    const fcf_module_t *fmmod)
+{
+	uint32_t name = bin_str(o, fv, fmmod->fcfm_name);
+	uint32_t path = bin_str(o, fv, fmmod->fcfm_path);
+	uint32_t desc = bin_str(o, fv, fmmod->fcfm_desc);
+	uint32_t vers = bin_str(o, fv, fmmod->fcfm_vers);
+
+	out_putc(o, 'M');
+	out_varint(o, sid);
+	out_varint(o, name);
+	out_varint(o, path);
+	out_varint(o, desc);
+	out_varint(o, vers);
+	out_varint(o, fmmod->fcfm_bufs);
+}
+
+static void
+bin_case(dump_out_t *o, fcf_view_t *fv, fcf_secidx_t sid,
+    const fcf_case_t *fmcase)
+{
+	uint32_t uuid = bin_str(o, fv, fmcase->fcfc_uuid);
+
+	out_putc(o, 'C');
+	out_varint(o, sid);
+	out_varint(o, uuid);
+	out_varint(o, fmcase->fcfc_state);
+	out_varint(o, fmcase->fcfc_bufs);
+	out_varint(o, fmcase->fcfc_principal);
+	out_varint(o, fmcase->fcfc_events);
+	out_varint(o, fmcase->fcfc_suspects);
+}
+
+static void
+bin_buf(dump_out_t *o, fcf_view_t *fv, fcf_secidx_t sid, uint_t i,
+    const fcf_buf_t *buf)
+{
+	uint32_t name = bin_str(o, fv, buf->fcfb_name);
+
+	out_putc(o, 'B');
+	out_varint(o, sid);
+	out_varint(o, i);
+	out_varint(o, name);
+	out_varint(o, buf->fcfb_data);
+}
+
+static void
+bin_buffer(dump_out_t *o, fcf_secidx_t sid, const uchar_t *data, size_t size)
+{
+	out_putc(o, 'D');
+	out_varint(o, sid);
+	out_blob(o, data, size);
+}
+
+static void
+bin_serd(dump_out_t *o, fcf_view_t *fv, fcf_secidx_t sid, uint_t i,
+    const fcf_serd_t *sgp)
+{
+	uint32_t name = bin_str(o, fv, sgp->fcfd_name);
+
+	out_putc(o, 'E');
+	out_varint(o, sid);
+	out_varint(o, i);
+	out_varint(o, name);
+	out_varint(o, sgp->fcfd_events);
+	out_varint(o, sgp->fcfd_n);
+	out_varint(o, sgp->fcfd_t);
+}
+
+static void
+bin_event(dump_out_t *o, fcf_secidx_t sid, uint_t i, const fcf_event_t *ep)
+{
+	out_putc(o, 'V');
+	out_varint(o, sid);
+	out_varint(o, i);
+	out_varint(o, ep->fcfe_todsec);
+	out_varint(o, ep->fcfe_todnsec);
+	out_varint(o, ep->fcfe_major);
+	out_varint(o, ep->fcfe_minor);
+	out_varint(o, ep->fcfe_inode);
+	out_varint(o, ep->fcfe_offset);
+}
+
+/*
+ * Packed nvlists are already a self-describing serialization, so they're
+ * passed through untouched rather than being unpacked.
+ */
+static void
+bin_nvl(dump_out_t *o, fcf_secidx_t sid, uint_t i, const char *buf,
+    size_t size)
+{
+	out_putc(o, 'N');
+	out_varint(o, sid);
+	out_varint(o, i);
+	out_blob(o, buf, size);
+}
+
+const dump_fmt_t dump_fmt_bin = {
+	.df_name = "binary",
+	.df_hdr = bin_hdr,
+	.df_sec = bin_sec,
+	.df_secend = bin_secend,
+	.df_str = bin_str_rec,
+	.df_module = bin_module,
+	.df_case = bin_case,
+	.df_buf = bin_buf,
+	.df_buffer = bin_buffer,
+	.df_serd = bin_serd,
+	.df_event = bin_event,
+	.df_nvl = bin_nvl
+};
@@ -0,0 +1,272 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+/*
+ * The JSON Lines output format: one JSON object per line for each header,
+ * section and record.  Every object has a "rec" member naming its kind and,
+ * apart from the file header, a "sid" member giving the section it came from.
+ * Other members are named after the corresponding fields in fmd_ckpt.h.
+ */
+#include <stdio.h>
+#include <sys/types.h>
+
+#ifndef	FCF_NO_LIBNVPAIR
+#include <libnvpair.h>
+#endif
+
+#include "out.h"
+
+static void
+json_begin(dump_out_t *o, const char *rec, fcf_secidx_t sid)
+{
+	out_puts(o, "{\"rec\":\"");
+	out_puts(o, rec);
+	out_puts(o, "\",\"sid\":");
+	out_u64(o, sid);
+}
+
+static void
+json_key(dump_out_t *o, const char *key)
+{
+	out_puts(o, ",\"");
+	out_puts(o, key);
+	out_puts(o, "\":");
+}
+
+static void
+json_u64(dump_out_t *o, const char *key, uint64_t v)
+{
+	json_key(o, key);
+	out_u64(o, v);
+}
+
+static void
+json_str(dump_out_t *o, const char *key, const char *s)
+{
+	json_key(o, key);
+	out_jstr(o, s);
+}
+
+static void
+json_end(dump_out_t *o)
+{
+	out_puts(o, "}\n");
+}
+
+static void
+json_hdr(dump_out_t *o, fcf_view_t *fv)
+{
+	const fcf_hdr_t *h = fv->fv_hdr;
+
+	out_puts(o, "{\"rec\":\"header\"");
+	json_str(o, "path", fv->fv_path);
+
+	switch (h->fcfh_ident[FCF_ID_MODEL]) {
+	case FCF_MODEL_ILP32:
+		json_str(o, "id_model", "ILP32");
+		break;
+	case FCF_MODEL_LP64:
+		json_str(o, "id_model", "LP64");
+		break;
+	default:
+		json_u64(o, "id_model", h->fcfh_ident[FCF_ID_MODEL]);
+	}
+	switch (h->fcfh_ident[FCF_ID_ENCODING]) {
+	case FCF_ENCODE_LSB:
+		json_str(o, "id_encoding", "LSB");
+		break;
+	case FCF_ENCODE_MSB:
+		json_str(o, "id_encoding", "MSB");
+		break;
+	default:
+		json_u64(o, "id_encoding", h->fcfh_ident[FCF_ID_ENCODING]);
+	}
+	json_u64(o, "id_version", h->fcfh_ident[FCF_ID_VERSION]);
+	json_u64(o, "fcfh_flags", h->fcfh_flags);
+	json_u64(o, "fcfh_hdrsize", h->fcfh_hdrsize);
+	json_u64(o, "fcfh_secsize", h->fcfh_secsize);
+	json_u64(o, "fcfh_secnum", h->fcfh_secnum);
+	json_u64(o, "fcfh_secoff", h->fcfh_secoff);
+	json_u64(o, "fcfh_filesz", h->fcfh_filesz);
+	json_u64(o, "fcfh_cgen", h->fcfh_cgen);
+	json_end(o);
+}
+
+static void
+json_sec(dump_out_t *o, fcf_view_t *fv, fcf_secidx_t sid)
+{
+	const fcf_sec_t *s = fcf_view_sec(fv, sid);
+	const char *name;
+
+	json_begin(o, "section", sid);
+	if ((name = fcf_sect_name(s->fcfs_type)) != NULL)
+		json_str(o, "fcfs_type", name);
+	else
+		json_u64(o, "fcfs_type", s->fcfs_type);
+	json_u64(o, "fcfs_align", s->fcfs_align);
+	json_u64(o, "fcfs_flags", s->fcfs_flags);
+	json_u64(o, "fcfs_entsize", s->fcfs_entsize);
+	json_u64(o, "fcfs_offset", s->fcfs_offset);
+	json_u64(o, "fcfs_size", s->fcfs_size);
+	json_end(o);
+}
+
+/*ARGSUSED*/
+static void
+json_secend(dump_out_t *o, fcf_secidx_t sid)
+{
+}
+
+static void
+json_str_rec(dump_out_t *o, fcf_secidx_t sid, uint32_t off, const char *s)
+{
+	json_begin(o, "string", sid);
+	json_u64(o, "offset", off);
+	json_str(o, "str", s);
+	json_end(o);
+}
+
+static void
+json_module(dump_out_t *o, fcf_view_t *fv, fcf_secidx_t sid,
+    const fcf_module_t *fmmod)
+{
+	json_begin(o, "module", sid);
+	json_str(o, "fcfm_name", fcf_view_str(fv, fmmod->fcfm_name));
+	json_str(o, "fcfm_path", fcf_view_str(fv, fmmod->fcfm_path));
+	json_str(o, "fcfm_desc", fcf_view_str(fv, fmmod->fcfm_desc));
+	json_str(o, "fcfm_vers", fcf_view_str(fv, fmmod->fcfm_vers));
+	json_u64(o, "fcfm_bufs", fmmod->fcfm_bufs);
+	json_end(o);
+}
+
+static void
+json_case(dump_out_t *o, fcf_view_t *fv, fcf_secidx_t sid,
+    const fcf_case_t *fmcase)
+{
+	json_begin(o, "case", sid);
+	json_str(o, "fcfc_uuid", fcf_view_str(fv, fmcase->fcfc_uuid));
+	json_str(o, "fcfc_state", fcf_case_state_name(fmcase->fcfc_state));
+	json_u64(o, "fcfc_bufs", fmcase->fcfc_bufs);
+	json_u64(o, "fcfc_principal", fmcase->fcfc_principal);
+	json_u64(o, "fcfc_events", fmcase->fcfc_events);
+	json_u64(o, "fcfc_suspects", fmcase->fcfc_suspects);
+	json_end(o);
+}
+
+static void
+json_buf(dump_out_t *o, fcf_view_t *fv, fcf_secidx_t sid, uint_t i,
+    const fcf_buf_t *buf)
+{
+	json_begin(o, "buf", sid);
+	json_u64(o, "idx", i);
+	json_str(o, "fcfb_name", fcf_view_str(fv, buf->fcfb_name));
+	json_u64(o, "fcfb_data", buf->fcfb_data);
+	json_end(o);
+}
+
+/*
+ * Opaque data is written as a hex string.
+ */
+static void
+json_hex(dump_out_t *o, const char *key, const uchar_t *data, size_t size)
+{
+	static const char hex[] = "0123456789abcdef";
+	size_t i;
+
+	json_key(o, key);
+	out_putc(o, '"');
+	for (i = 0; i < size; i++) {
+		out_putc(o, hex[data[i] >> 4]);
+		out_putc(o, hex[data[i] & 0xf]);
+	}
+	out_putc(o, '"');
+}
+
+static void
+json_buffer(dump_out_t *o, fcf_secidx_t sid, const uchar_t *data,
+    size_t size)
+{
+	json_begin(o, "buffer", sid);
+	json_u64(o, "size", size);
+	json_hex(o, "data", data, size);
+	json_end(o);
+}
+
+static void
+json_serd(dump_out_t *o, fcf_view_t *fv, fcf_secidx_t sid, uint_t i,
+    const fcf_serd_t *sgp)
+{
+	json_begin(o, "serd", sid);
+	json_u64(o, "idx", i);
+	json_str(o, "fcfd_name", fcf_view_str(fv, sgp->fcfd_name));
+	json_u64(o, "fcfd_events", sgp->fcfd_events);
+	json_u64(o, "fcfd_n", sgp->fcfd_n);
+	json_u64(o, "fcfd_t", sgp->fcfd_t);
+	json_end(o);
+}
+
+static void
+json_event(dump_out_t *o, fcf_secidx_t sid, uint_t i, const fcf_event_t *ep)
+{
+	json_begin(o, "event", sid);
+	json_u64(o, "idx", i);
+	json_u64(o, "fcfe_todsec", ep->fcfe_todsec);
+	json_u64(o, "fcfe_todnsec", ep->fcfe_todnsec);
+	json_u64(o, "fcfe_major", ep->fcfe_major);
+	json_u64(o, "fcfe_minor", ep->fcfe_minor);
+	json_u64(o, "fcfe_inode", ep->fcfe_inode);
+	json_u64(o, "fcfe_offset", ep->fcfe_offset);
+	json_end(o);
+}
+
+/*
+ * Without libnvpair, the packed nvlist is written as a hex string instead.
+ */
+static void
+json_nvl(dump_out_t *o, fcf_secidx_t sid, uint_t i, const char *buf,
+    size_t size)
+{
+#ifdef	FCF_NO_LIBNVPAIR
+	json_begin(o, "nvlist", sid);
+	json_u64(o, "idx", i);
+	json_u64(o, "fcfn_size", size);
+	json_hex(o, "data", (const uchar_t *)buf, size);
+#else
+	nvlist_t *nvl;
+
+	json_begin(o, "nvlist", sid);
+	json_u64(o, "idx", i);
+	json_u64(o, "fcfn_size", size);
+	json_key(o, "nvlist");
+
+	if (nvlist_unpack((char *)buf, size, &nvl, 0) != 0) {
+		out_puts(o, "null");
+	} else {
+		out_flush(o);
+		if (nvlist_print_json(o->do_fp, nvl) != 0)
+			o->do_err = B_TRUE;
+		nvlist_free(nvl);
+	}
+#endif
+	json_end(o);
+}
+
+const dump_fmt_t dump_fmt_json = {
+	.df_name = "json",
+	.df_hdr = json_hdr,
+	.df_sec = json_sec,
+	.df_secend = json_secend,
+	.df_str = json_str_rec,
+	.df_module = json_module,
+	.df_case = json_case,
+	.df_buf = json_buf,
+	.df_buffer = json_buffer,
+	.df_serd = json_serd,
+	.df_event = json_event,
+	.df_nvl = json_nvl
+};
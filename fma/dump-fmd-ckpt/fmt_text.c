@@ -0,0 +1,309 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+/*
+ * The human-readable output format, and the default.
+ */
+#include <stdio.h>
+#include <ctype.h>
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+#include <sys/types.h>
+
+#ifndef	FCF_NO_LIBNVPAIR
+#include <libnvpair.h>
+#endif
+
+#include "out.h"
+
+/*
+ * Begin a "name = " line, prefixed with the record index if idx isn't -1.
+ */
+static void
+text_name(dump_out_t *o, int idx, const char *name)
+{
+	if (idx >= 0) {
+		out_putc(o, '[');
+		out_u64(o, idx);
+		out_puts(o, "] ");
+	}
+	out_puts(o, name);
+	out_puts(o, " = ");
+}
+
+static void
+text_u64(dump_out_t *o, int idx, const char *name, uint64_t v,
+    const char *unit)
+{
+	text_name(o, idx, name);
+	out_u64(o, v);
+	if (unit != NULL) {
+		out_putc(o, ' ');
+		out_puts(o, unit);
+	}
+	out_putc(o, '\n');
+}
+
+static void
+text_str(dump_out_t *o, fcf_view_t *fv, int idx, const char *name,
+    fcf_stridx_t sid)
+{
+	text_name(o, idx, name);
+	out_puts(o, fcf_view_str(fv, sid));
+	out_puts(o, " (0x");
+	out_x64(o, sid);
+	out_puts(o, ")\n");
+}
+
+/*
+ * adapted from fcf_hdr() in usr/src/cmd/fm/fmd/common/fmd_mdb.c
+ */
+static void
+text_hdr(dump_out_t *o, fcf_view_t *fv)
+{
+	const fcf_hdr_t *h = fv->fv_hdr;
+
+	out_puts(o, "==========\nFCF Header\n==========\n");
+	out_printf(o, "fcfh_ident.id_magic = 0x%x, %c, %c, %c\n",
+	    h->fcfh_ident[FCF_ID_MAG0], h->fcfh_ident[FCF_ID_MAG1],
+	    h->fcfh_ident[FCF_ID_MAG2], h->fcfh_ident[FCF_ID_MAG3]);
+
+	text_name(o, -1, "fcfh_ident.id_model");
+	switch (h->fcfh_ident[FCF_ID_MODEL]) {
+	case FCF_MODEL_ILP32:
+		out_puts(o, "ILP32\n");
+		break;
+	case FCF_MODEL_LP64:
+		out_puts(o, "LP64\n");
+		break;
+	default:
+		out_puts(o, "0x");
+		out_x64(o, h->fcfh_ident[FCF_ID_MODEL]);
+		out_putc(o, '\n');
+	}
+
+	text_name(o, -1, "fcfh_ident.id_encoding");
+	switch (h->fcfh_ident[FCF_ID_ENCODING]) {
+	case FCF_ENCODE_LSB:
+		out_puts(o, "LSB\n");
+		break;
+	case FCF_ENCODE_MSB:
+		out_puts(o, "MSB\n");
+		break;
+	default:
+		out_puts(o, "0x");
+		out_x64(o, h->fcfh_ident[FCF_ID_ENCODING]);
+		out_putc(o, '\n');
+	}
+
+	text_u64(o, -1, "fcfh_ident.id_version",
+	    h->fcfh_ident[FCF_ID_VERSION], NULL);
+
+	text_name(o, -1, "fcfh_flags");
+	out_puts(o, "0x");
+	out_x64(o, h->fcfh_flags);
+	out_putc(o, '\n');
+
+	text_u64(o, -1, "fcfh_hdrsize", h->fcfh_hdrsize, "bytes");
+	text_u64(o, -1, "fcfh_secsize", h->fcfh_secsize, "bytes");
+	text_u64(o, -1, "fcfh_secnum", h->fcfh_secnum, NULL);
+	text_u64(o, -1, "fcfh_secoff", h->fcfh_secoff, "bytes");
+	text_u64(o, -1, "fcfh_filesz", h->fcfh_filesz, "bytes");
+	text_u64(o, -1, "fcfh_cgen", h->fcfh_cgen, NULL);
+	out_putc(o, '\n');
+}
+
+static void
+text_sec(dump_out_t *o, fcf_view_t *fv, fcf_secidx_t sid)
+{
+	const fcf_sec_t *s = fcf_view_sec(fv, sid);
+	const char *name;
+
+	out_puts(o, "=============\nSECTION ");
+	out_u64(o, sid);
+	out_puts(o, " (addr: ");
+	out_x64(o, (uintptr_t)s);
+	out_puts(o, ")\n=============\n");
+
+	out_printf(o, "%-10s %-5s %-5s %-5s %-6s %-5s\n",
+	    "TYPE", "ALIGN", "FLAGS", "ENTSZ", "OFF", "SIZE");
+
+	if ((name = fcf_sect_name(s->fcfs_type)) != NULL)
+		out_printf(o, "%-10s ", name);
+	else
+		out_printf(o, "%-10u ", s->fcfs_type);
+
+	out_printf(o, "%-5u %-#5x %-#5x %-6llx %-#5llx\n\n", s->fcfs_align,
+	    s->fcfs_flags, s->fcfs_entsize, (u_longlong_t)s->fcfs_offset,
+	    (u_longlong_t)s->fcfs_size);
+}
+
+/*ARGSUSED*/
+static void
+text_secend(dump_out_t *o, fcf_secidx_t sid)
+{
+	out_putc(o, '\n');
+}
+
+/*ARGSUSED*/
+static void
+text_str_rec(dump_out_t *o, fcf_secidx_t sid, uint32_t off, const char *s)
+{
+	out_puts(o, "0x");
+	out_x64(o, off);
+	out_puts(o, ": ");
+	out_puts(o, s);
+	out_putc(o, '\n');
+}
+
+/*ARGSUSED*/
+static void
+text_module(dump_out_t *o, fcf_view_t *fv, fcf_secidx_t sid,
+    const fcf_module_t *fmmod)
+{
+	text_str(o, fv, -1, "fcfm_name", fmmod->fcfm_name);
+	text_str(o, fv, -1, "fcfm_path", fmmod->fcfm_path);
+	text_str(o, fv, -1, "fcfm_desc", fmmod->fcfm_desc);
+	text_str(o, fv, -1, "fcfm_vers", fmmod->fcfm_vers);
+	text_u64(o, -1, "fcfm_bufs", fmmod->fcfm_bufs, NULL);
+}
+
+/*ARGSUSED*/
+static void
+text_case(dump_out_t *o, fcf_view_t *fv, fcf_secidx_t sid,
+    const fcf_case_t *fmcase)
+{
+	text_str(o, fv, -1, "fcfc_uuid", fmcase->fcfc_uuid);
+	text_name(o, -1, "fcfc_state");
+	out_u64(o, fmcase->fcfc_state);
+	out_puts(o, " (");
+	out_puts(o, fcf_case_state_name(fmcase->fcfc_state));
+	out_puts(o, ")\n");
+	text_u64(o, -1, "fcfc_bufs", fmcase->fcfc_bufs, NULL);
+	text_u64(o, -1, "fcfc_principal", fmcase->fcfc_principal, NULL);
+	text_u64(o, -1, "fcfc_events", fmcase->fcfc_events, NULL);
+	text_u64(o, -1, "fcfc_suspects", fmcase->fcfc_suspects, NULL);
+}
+
+/*ARGSUSED*/
+static void
+text_buf(dump_out_t *o, fcf_view_t *fv, fcf_secidx_t sid, uint_t i,
+    const fcf_buf_t *buf)
+{
+	text_str(o, fv, i, "fcfb_name", buf->fcfb_name);
+	text_u64(o, i, "fcfb_data", buf->fcfb_data, NULL);
+}
+
+/*
+ * Buffer sections hold opaque module data, so all we can do is hexdump them.
+ */
+/*ARGSUSED*/
+static void
+text_buffer(dump_out_t *o, fcf_secidx_t sid, const uchar_t *data,
+    size_t size)
+{
+	static const char hex[] = "0123456789abcdef";
+	size_t off, i;
+
+	for (off = 0; off < size; off += 16) {
+		out_printf(o, "%08zx: ", off);
+		for (i = off; i < off + 16; i++) {
+			if (i < size) {
+				out_putc(o, hex[data[i] >> 4]);
+				out_putc(o, hex[data[i] & 0xf]);
+				out_putc(o, ' ');
+			} else {
+				out_puts(o, "   ");
+			}
+		}
+		out_puts(o, " |");
+		for (i = off; i < off + 16 && i < size; i++)
+			out_putc(o, isprint(data[i]) ? data[i] : '.');
+		out_puts(o, "|\n");
+	}
+}
+
+/*ARGSUSED*/
+static void
+text_serd(dump_out_t *o, fcf_view_t *fv, fcf_secidx_t sid, uint_t i,
+    const fcf_serd_t *sgp)
+{
+	text_str(o, fv, i, "fcfd_name", sgp->fcfd_name);
+	text_u64(o, i, "fcfd_events", sgp->fcfd_events, NULL);
+	text_u64(o, i, "fcfd_n", sgp->fcfd_n, NULL);
+	text_u64(o, i, "fcfd_t", sgp->fcfd_t, "ns");
+}
+
+/*ARGSUSED*/
+static void
+text_event(dump_out_t *o, fcf_secidx_t sid, uint_t i, const fcf_event_t *ep)
+{
+	char tbuf[32];
+	struct tm tm;
+	time_t sec;
+
+	sec = (time_t)ep->fcfe_todsec;
+	if (gmtime_r(&sec, &tm) == NULL || strftime(tbuf,
+	    sizeof (tbuf), "%Y-%m-%dT%H:%M:%SZ", &tm) == 0)
+		(void) strcpy(tbuf, "?");
+
+	out_printf(o, "[%u] fcfe_tod = %" PRIu64 ".%09" PRIu64 " (%s)\n", i,
+	    ep->fcfe_todsec, ep->fcfe_todnsec, tbuf);
+	text_name(o, i, "fcfe_dev");
+	out_u64(o, ep->fcfe_major);
+	out_putc(o, ',');
+	out_u64(o, ep->fcfe_minor);
+	out_putc(o, '\n');
+	text_u64(o, i, "fcfe_inode", ep->fcfe_inode, NULL);
+	text_u64(o, i, "fcfe_offset", ep->fcfe_offset, NULL);
+}
+
+/*ARGSUSED*/
+static void
+text_nvl(dump_out_t *o, fcf_secidx_t sid, uint_t i, const char *buf,
+    size_t size)
+{
+#ifdef	FCF_NO_LIBNVPAIR
+	text_u64(o, i, "fcfn_size", size, "bytes");
+	text_buffer(o, sid, (const uchar_t *)buf, size);
+#else
+	nvlist_t *nvl;
+
+	text_u64(o, i, "fcfn_size", size, "bytes");
+	if (nvlist_unpack((char *)buf, size, &nvl, 0) != 0) {
+		out_putc(o, '[');
+		out_u64(o, i);
+		out_puts(o, "] <failed to unpack nvlist>\n");
+		return;
+	}
+
+	/*
+	 * nvlist_print() only knows how to write to a stdio stream, so get
+	 * everything we've buffered so far out ahead of it.
+	 */
+	out_flush(o);
+	nvlist_print(o->do_fp, nvl);
+	nvlist_free(nvl);
+#endif
+}
+
+const dump_fmt_t dump_fmt_text = {
+	.df_name = "text",
+	.df_hdr = text_hdr,
+	.df_sec = text_sec,
+	.df_secend = text_secend,
+	.df_str = text_str_rec,
+	.df_module = text_module,
+	.df_case = text_case,
+	.df_buf = text_buf,
+	.df_buffer = text_buffer,
+	.df_serd = text_serd,
+	.df_event = text_event,
+	.df_nvl = text_nvl
+};
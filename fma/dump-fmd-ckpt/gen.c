@@ -0,0 +1,545 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+/*
+ * "dump-fmd-ckpt gen" writes a synthetic checkpoint, for exercising the rest
+ * of the tool (and anything else that consumes checkpoints) without a live
+ * fmd.  The file has the same shape as one written by fmd_ckpt_save(): a
+ * module with a buffer, a table of SERD engines each with its own events, and
+ * a number of cases, each with a buffer, a principal event, the events that
+ * led to it and, once solved, its suspect list.
+ *
+ * The contents are drawn from a seeded generator, so the same options always
+ * produce the same file.  The suspects are packed nvlists in the XDR encoding
+ * fmd uses, which are packed by hand here so that no libnvpair is needed.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/param.h>
+#include <sys/types.h>
+
+#include "dump-fmd-ckpt.h"
+
+#define	GEN_CASEBUFSZ	64	/* size of each case's buffer */
+#define	GEN_NVLMAX	1024	/* largest packed suspect we'll generate */
+#define	GEN_TOD		1700000000ULL	/* time of the first event */
+
+/*
+ * The subset of the libnvpair XDR encoding (see nvs_xdr_* in
+ * usr/src/common/nvpair/nvpair.c) needed to pack our suspects.  The values
+ * are those of NV_ENCODE_XDR, NV_VERSION, NV_UNIQUE_NAME and data_type_t.
+ */
+#define	GEN_NV_ENCODE_XDR	1
+#define	GEN_NV_VERSION		0
+#define	GEN_NV_UNIQUE_NAME	1
+#define	GEN_DT_STRING		9
+#define	GEN_DT_NVLIST		19
+#define	GEN_DT_UINT8		23
+#define	GEN_NV_ALIGN(x)		P2ROUNDUP((size_t)(x), sizeof (uint64_t))
+#define	GEN_NV_PAIRSZ		16	/* sizeof (nvpair_t) */
+#define	GEN_NV_LISTSZ		24	/* sizeof (nvlist_t) */
+
+typedef struct gen_xdr {
+	uchar_t gx_buf[GEN_NVLMAX];	/* packed nvlist */
+	size_t gx_len;			/* bytes used in gx_buf */
+} gen_xdr_t;
+
+typedef struct gen {
+	fcf_writer_t g_fw;		/* checkpoint being built */
+	uint64_t g_rand;		/* random number generator state */
+	uint64_t g_tod;			/* time of the last event */
+	uint64_t g_off;			/* errlog offset of the last event */
+	uint_t g_nevents;		/* events per case and SERD engine */
+	uint_t g_nsuspects;		/* suspects per solved case */
+	uint_t g_ncases;		/* cases generated so far */
+} gen_t;
+
+static const char *const gen_classes[] = {
+	"fault.io.disk.predictive-failure",
+	"fault.io.disk.over-temperature",
+	"fault.fs.zfs.vdev.io",
+	"fault.fs.zfs.vdev.checksum",
+	"fault.cpu.intel.dimm_ce",
+	"fault.memory.page",
+};
+
+#define	GEN_NCLASSES	(sizeof (gen_classes) / sizeof (gen_classes[0]))
+
+/*
+ * xorshift64*, which is plenty for making up plausible looking data.
+ */
+static uint64_t
+gen_rand(gen_t *g)
+{
+	g->g_rand ^= g->g_rand >> 12;
+	g->g_rand ^= g->g_rand << 25;
+	g->g_rand ^= g->g_rand >> 27;
+	return (g->g_rand * 0x2545f4914f6cdd1dULL);
+}
+
+static void
+gen_xdr_u32(gen_xdr_t *x, uint32_t v)
+{
+	x->gx_buf[x->gx_len++] = (uchar_t)(v >> 24);
+	x->gx_buf[x->gx_len++] = (uchar_t)(v >> 16);
+	x->gx_buf[x->gx_len++] = (uchar_t)(v >> 8);
+	x->gx_buf[x->gx_len++] = (uchar_t)v;
+}
+
+/*
+ * An XDR string is its length followed by its bytes, padded out to a
+ * multiple of four.
+ */
+static void
+gen_xdr_str(gen_xdr_t *x, const char *s)
+{
+	size_t len = strlen(s);
+
+	gen_xdr_u32(x, (uint32_t)len);
+	bcopy(s, x->gx_buf + x->gx_len, len);
+	bzero(x->gx_buf + x->gx_len + len, P2ROUNDUP(len, 4) - len);
+	x->gx_len += P2ROUNDUP(len, 4);
+}
+
+/*
+ * Begin an nvpair.  Each one starts with its own encoded size, which is
+ * filled in by gen_nvp_end(), and the size of the nvpair_t that libnvpair
+ * will unpack it into, which it checks exactly.  Returns the offset of the
+ * nvpair.
+ */
+static size_t
+gen_nvp_begin(gen_xdr_t *x, const char *name, uint32_t type, size_t valsz)
+{
+	size_t off = x->gx_len;
+
+	gen_xdr_u32(x, 0);
+	gen_xdr_u32(x, (uint32_t)(GEN_NV_ALIGN(GEN_NV_PAIRSZ + strlen(name) +
+	    1) + GEN_NV_ALIGN(valsz)));
+	gen_xdr_str(x, name);
+	gen_xdr_u32(x, type);
+	gen_xdr_u32(x, 1);
+
+	return (off);
+}
+
+static void
+gen_nvp_end(gen_xdr_t *x, size_t off)
+{
+	size_t len = x->gx_len;
+
+	x->gx_len = off;
+	gen_xdr_u32(x, (uint32_t)(len - off));
+	x->gx_len = len;
+}
+
+/*
+ * An nvlist, whether packed at the top level or embedded in an nvpair, is
+ * its version and flags, its nvpairs and then a terminating pair of zeros.
+ */
+static void
+gen_nvl_begin(gen_xdr_t *x)
+{
+	gen_xdr_u32(x, GEN_NV_VERSION);
+	gen_xdr_u32(x, GEN_NV_UNIQUE_NAME);
+}
+
+static void
+gen_nvl_end(gen_xdr_t *x)
+{
+	gen_xdr_u32(x, 0);
+	gen_xdr_u32(x, 0);
+}
+
+static void
+gen_nvp_u8(gen_xdr_t *x, const char *name, uint8_t v)
+{
+	size_t off = gen_nvp_begin(x, name, GEN_DT_UINT8, sizeof (uint8_t));
+
+	gen_xdr_u32(x, v);
+	gen_nvp_end(x, off);
+}
+
+static void
+gen_nvp_str(gen_xdr_t *x, const char *name, const char *v)
+{
+	size_t off = gen_nvp_begin(x, name, GEN_DT_STRING, strlen(v) + 1);
+
+	gen_xdr_str(x, v);
+	gen_nvp_end(x, off);
+}
+
+/*
+ * Pack a fault event, as fmd would record it for a suspect, with a "dev"
+ * scheme ASRU.  The strings are bounded, so it always fits in gx_buf.
+ */
+static void
+gen_suspect(gen_t *g, gen_xdr_t *x, uint_t nsuspects)
+{
+	char path[128];
+	size_t off;
+
+	x->gx_len = 0;
+	x->gx_buf[x->gx_len++] = GEN_NV_ENCODE_XDR;
+#ifdef	_BIG_ENDIAN
+	x->gx_buf[x->gx_len++] = 0;
+#else
+	x->gx_buf[x->gx_len++] = 1;
+#endif
+	x->gx_buf[x->gx_len++] = 0;
+	x->gx_buf[x->gx_len++] = 0;
+
+	gen_nvl_begin(x);
+	gen_nvp_u8(x, "version", 0);
+	gen_nvp_str(x, "class", gen_classes[gen_rand(g) % GEN_NCLASSES]);
+	gen_nvp_u8(x, "certainty", (uint8_t)(100 / nsuspects));
+
+	(void) snprintf(path, sizeof (path), "/pci@0,0/pci8086,2f06@2,2/"
+	    "pci15d9,808@0/iport@f/disk@w5000c500%08x,0",
+	    (uint32_t)gen_rand(g));
+	off = gen_nvp_begin(x, "asru", GEN_DT_NVLIST, GEN_NV_LISTSZ);
+	gen_nvl_begin(x);
+	gen_nvp_u8(x, "version", 0);
+	gen_nvp_str(x, "scheme", "dev");
+	gen_nvp_str(x, "device-path", path);
+	gen_nvl_end(x);
+	gen_nvp_end(x, off);
+
+	gen_nvl_end(x);
+}
+
+static void
+gen_nomem(gen_t *g)
+{
+	g->g_fw.fw_err = B_TRUE;
+	(void) strlcpy(g->g_fw.fw_errmsg, "failed to allocate memory",
+	    sizeof (g->g_fw.fw_errmsg));
+}
+
+static fcf_secidx_t
+gen_buffer(gen_t *g, const char *name, size_t size)
+{
+	fcf_buf_t buf;
+	uchar_t *data;
+	size_t i;
+
+	if ((data = malloc(size)) == NULL) {
+		gen_nomem(g);
+		return (FCF_SECIDX_NONE);
+	}
+	for (i = 0; i < size; i++)
+		data[i] = (uchar_t)gen_rand(g);
+
+	buf.fcfb_name = fcf_writer_str(&g->g_fw, name);
+	buf.fcfb_data = fcf_writer_sec(&g->g_fw, FCF_SECT_BUFFER, 1, 0, data,
+	    size);
+	free(data);
+
+	return (fcf_writer_sec(&g->g_fw, FCF_SECT_BUFS, sizeof (uint32_t),
+	    sizeof (fcf_buf_t), &buf, sizeof (buf)));
+}
+
+/*
+ * Generate n events, each a little later in time and further into the
+ * error log than the last.
+ */
+static fcf_secidx_t
+gen_events(gen_t *g, uint_t n)
+{
+	fcf_event_t *evs;
+	fcf_secidx_t sid;
+	uint_t i;
+
+	if (n == 0)
+		return (FCF_SECIDX_NONE);
+
+	if ((evs = calloc(n, sizeof (fcf_event_t))) == NULL) {
+		gen_nomem(g);
+		return (FCF_SECIDX_NONE);
+	}
+	for (i = 0; i < n; i++) {
+		g->g_tod += 1 + gen_rand(g) % 60;
+		g->g_off += 512 + gen_rand(g) % 2048;
+		evs[i].fcfe_todsec = g->g_tod;
+		evs[i].fcfe_todnsec = gen_rand(g) % 1000000000;
+		evs[i].fcfe_major = 90;
+		evs[i].fcfe_minor = 2;
+		evs[i].fcfe_inode = 4242;
+		evs[i].fcfe_offset = g->g_off;
+	}
+
+	sid = fcf_writer_sec(&g->g_fw, FCF_SECT_EVENTS, sizeof (uint64_t),
+	    sizeof (fcf_event_t), evs, n * sizeof (fcf_event_t));
+	free(evs);
+	return (sid);
+}
+
+static fcf_secidx_t
+gen_suspects(gen_t *g, uint_t n)
+{
+	gen_xdr_t x;
+	fcf_nvl_t nvl;
+	uchar_t *data;
+	size_t size = 0;
+	fcf_secidx_t sid;
+	uint_t i;
+
+	if (n == 0)
+		return (FCF_SECIDX_NONE);
+
+	if ((data = malloc(n * (sizeof (fcf_nvl_t) + GEN_NVLMAX))) == NULL) {
+		gen_nomem(g);
+		return (FCF_SECIDX_NONE);
+	}
+	for (i = 0; i < n; i++) {
+		gen_suspect(g, &x, n);
+		nvl.fcfn_size = x.gx_len;
+		bcopy(&nvl, data + size, sizeof (nvl));
+		size += sizeof (nvl);
+		bcopy(x.gx_buf, data + size, x.gx_len);
+		bzero(data + size + x.gx_len,
+		    P2ROUNDUP(x.gx_len, sizeof (uint64_t)) - x.gx_len);
+		size += P2ROUNDUP(x.gx_len, sizeof (uint64_t));
+	}
+
+	sid = fcf_writer_sec(&g->g_fw, FCF_SECT_NVLISTS, sizeof (uint64_t), 0,
+	    data, size);
+	free(data);
+	return (sid);
+}
+
+static void
+gen_serd(gen_t *g, uint_t n)
+{
+	fcf_serd_t *sgs;
+	char name[32];
+	uint_t i;
+
+	if (n == 0)
+		return;
+
+	if ((sgs = calloc(n, sizeof (fcf_serd_t))) == NULL) {
+		gen_nomem(g);
+		return;
+	}
+	for (i = 0; i < n; i++) {
+		(void) snprintf(name, sizeof (name), "serd-%u", i);
+		sgs[i].fcfd_name = fcf_writer_str(&g->g_fw, name);
+		sgs[i].fcfd_events = gen_events(g, g->g_nevents);
+		sgs[i].fcfd_n = 2 + gen_rand(g) % 10;
+		sgs[i].fcfd_t = (1 + gen_rand(g) % 24) * 3600 * 1000000000ULL;
+	}
+
+	(void) fcf_writer_sec(&g->g_fw, FCF_SECT_SERD, sizeof (uint64_t),
+	    sizeof (fcf_serd_t), sgs, n * sizeof (fcf_serd_t));
+	free(sgs);
+}
+
+/*
+ * Cases are spread evenly over the three states.  Like fmd, only solved
+ * cases have a suspect list.
+ */
+static void
+gen_case(gen_t *g)
+{
+	fcf_case_t fc;
+	uint64_t r0 = gen_rand(g), r1 = gen_rand(g);
+	char uuid[40];
+
+	(void) snprintf(uuid, sizeof (uuid),
+	    "%08x-%04x-4%03x-%04x-%012llx", (uint32_t)(r0 >> 32),
+	    (uint32_t)(r0 >> 16) & 0xffff, (uint32_t)r0 & 0xfff,
+	    0x8000 | ((uint32_t)(r1 >> 48) & 0x3fff),
+	    (u_longlong_t)(r1 & 0xffffffffffffULL));
+
+	(void) memset(&fc, 0, sizeof (fc));
+	fc.fcfc_uuid = fcf_writer_str(&g->g_fw, uuid);
+	fc.fcfc_state = g->g_ncases++ % 3;
+	fc.fcfc_bufs = gen_buffer(g, "case-data", GEN_CASEBUFSZ);
+	fc.fcfc_principal = gen_events(g, 1);
+	fc.fcfc_events = gen_events(g, g->g_nevents);
+	if (fc.fcfc_state != FCF_CASE_UNSOLVED)
+		fc.fcfc_suspects = gen_suspects(g, g->g_nsuspects);
+
+	(void) fcf_writer_sec(&g->g_fw, FCF_SECT_CASE, sizeof (uint32_t), 0,
+	    &fc, sizeof (fc));
+}
+
+static void
+gen_module(gen_t *g, const char *name, size_t bufsz)
+{
+	fcf_module_t fm;
+	char path[MAXPATHLEN];
+
+	(void) snprintf(path, sizeof (path), "/usr/lib/fm/fmd/plugins/%s.so",
+	    name);
+
+	(void) memset(&fm, 0, sizeof (fm));
+	fm.fcfm_name = fcf_writer_str(&g->g_fw, name);
+	fm.fcfm_path = fcf_writer_str(&g->g_fw, path);
+	fm.fcfm_desc = fcf_writer_str(&g->g_fw, "Synthetic Diagnosis Engine");
+	fm.fcfm_vers = fcf_writer_str(&g->g_fw, "1.0");
+	if (bufsz != 0)
+		fm.fcfm_bufs = gen_buffer(g, "module-data", bufsz);
+
+	(void) fcf_writer_sec(&g->g_fw, FCF_SECT_MODULE, sizeof (uint32_t), 0,
+	    &fm, sizeof (fm));
+}
+
+static uint64_t
+gen_size(gen_t *g)
+{
+	return (sizeof (fcf_hdr_t) + (g->g_fw.fw_nsecs + 1) *
+	    sizeof (fcf_sec_t) + g->g_fw.fw_size + g->g_fw.fw_strsz);
+}
+
+/*
+ * Parse a count or size, which may have a k, m or g suffix.
+ */
+static int
+gen_num(const char *arg, uint64_t max, uint64_t *vp)
+{
+	char *end;
+	u_longlong_t v;
+	uint_t shift = 0;
+
+	errno = 0;
+	v = strtoull(arg, &end, 10);
+	if (errno != 0 || end == arg)
+		return (-1);
+
+	switch (*end) {
+	case 'k':
+	case 'K':
+		shift = 10;
+		end++;
+		break;
+	case 'm':
+	case 'M':
+		shift = 20;
+		end++;
+		break;
+	case 'g':
+	case 'G':
+		shift = 30;
+		end++;
+		break;
+	}
+	if (*end != '\0' || v > (max >> shift))
+		return (-1);
+
+	*vp = (uint64_t)v << shift;
+	return (0);
+}
+
+static void
+gen_usage(void)
+{
+	(void) fprintf(stderr, "usage: %s gen [-b bufsize] [-c cases] "
+	    "[-d serd engines] [-e events] [-g cgen]\n"
+	    "           [-m module] [-n suspects] [-r seed] [-S size] "
+	    "<ckpt file>\n\n", pname);
+}
+
+int
+do_gen(int argc, char **argv)
+{
+	gen_t g;
+	const char *modname = "synthetic";
+	uint64_t ncases = 16, nserd = 4, nevents = 4, nsuspects = 1;
+	uint64_t bufsz = 1024, cgen = 1, seed = 1, target = 0;
+	uint64_t *vp, max;
+	int c;
+
+	while ((c = getopt(argc, argv, "b:c:d:e:g:m:n:r:S:")) != -1) {
+		max = UINT32_MAX;
+		switch (c) {
+		case 'b':
+			vp = &bufsz;
+			break;
+		case 'c':
+			vp = &ncases;
+			break;
+		case 'd':
+			vp = &nserd;
+			break;
+		case 'e':
+			vp = &nevents;
+			break;
+		case 'g':
+			vp = &cgen;
+			max = UINT64_MAX;
+			break;
+		case 'm':
+			modname = optarg;
+			continue;
+		case 'n':
+			vp = &nsuspects;
+			break;
+		case 'r':
+			vp = &seed;
+			max = UINT64_MAX;
+			break;
+		case 'S':
+			vp = &target;
+			max = UINT64_MAX;
+			break;
+		default:
+			gen_usage();
+			return (2);
+		}
+		if (gen_num(optarg, max, vp) != 0) {
+			(void) fprintf(stderr, "invalid value for -%c: %s\n",
+			    c, optarg);
+			return (2);
+		}
+	}
+
+	if (argc - optind != 1) {
+		gen_usage();
+		return (2);
+	}
+
+	(void) memset(&g, 0, sizeof (g));
+	g.g_rand = seed != 0 ? seed : 1;
+	g.g_tod = GEN_TOD;
+	g.g_nevents = (uint_t)nevents;
+	g.g_nsuspects = (uint_t)nsuspects;
+
+	if (fcf_writer_init(&g.g_fw) != 0) {
+		(void) fprintf(stderr, "%s\n", g.g_fw.fw_errmsg);
+		fcf_writer_fini(&g.g_fw);
+		return (1);
+	}
+
+	gen_module(&g, modname, (size_t)bufsz);
+	gen_serd(&g, (uint_t)nserd);
+
+	/*
+	 * With -S, keep adding cases until the file would be at least that
+	 * big, counting the header, the section table (including the string
+	 * table's entry) and the string table as well as the data.
+	 */
+	while (!g.g_fw.fw_err && (g.g_ncases < ncases || gen_size(&g) < target))
+		gen_case(&g);
+
+	if (fcf_writer_save(&g.g_fw, argv[optind], cgen) != 0) {
+		(void) fprintf(stderr, "%s\n", g.g_fw.fw_errmsg);
+		fcf_writer_fini(&g.g_fw);
+		return (1);
+	}
+
+	(void) printf("%s: %u sections, %u cases, %u SERD engines, "
+	    "%llu bytes\n", argv[optind], g.g_fw.fw_nsecs, g.g_ncases,
+	    (uint_t)nserd, (u_longlong_t)g.g_fw.fw_filesz);
+
+	fcf_writer_fini(&g.g_fw);
+	return (0);
+}
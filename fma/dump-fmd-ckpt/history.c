@@ -0,0 +1,1161 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+/*
+ * "dump-fmd-ckpt history" keeps every generation of every module's
+ * checkpoint in a local store, and can rebuild any of them on demand.
+ *
+ * Successive generations of a checkpoint mostly hold the same sections: the
+ * string table and module record rarely change, and a case that hasn't been
+ * touched is written out again just as it was.  So each file is cut at its
+ * section boundaries and each piece is stored once, keyed by a 128-bit hash
+ * of its contents.  The pieces between sections (the header, the section
+ * table and any padding) are stored the same way, so that the original file
+ * can be rebuilt byte for byte without the store knowing anything about how
+ * fmd lays it out.
+ *
+ * The store is a directory holding:
+ *
+ *	pack			the distinct pieces, one after another
+ *	index			the hash, offset and size of each piece
+ *	gens/<module>/<cgen>	a manifest for each generation, listing the
+ *				index entries of its pieces in order
+ *
+ * Packing the pieces into one file rather than giving each its own keeps a
+ * 24-byte case record from costing a whole filesystem block.  The section
+ * table is cut into fixed-size chunks too, so that a few new sections only
+ * cost a few new chunks of it.  A manifest lists runs of consecutive index
+ * entries rather than every entry, so an unchanged run of sections, which
+ * were stored in order, takes up one line.  The pack and
+ * index are only ever appended to, and a manifest is only renamed into place
+ * once everything it refers to is on stable storage, so a crash can leave at
+ * most some unreferenced data at the end of the pack, which is trimmed off
+ * the next time the store is opened for writing.  The index is in host byte
+ * order, since the store is meant to live next to the fmd that it's tracking.
+ *
+ * A manifest is named after the generation number in the checkpoint header.
+ * If fmd has been restarted and reuses a generation number for different
+ * contents, the new manifest gets a ".<n>" suffix.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "dump-fmd-ckpt.h"
+
+#define	HIST_VERSION	1
+#define	HIST_SEED	0x9e3779b97f4a7c15ULL	/* seed of second hash */
+#define	HIST_MAXDUPS	100	/* manifests sharing a generation number */
+#define	HIST_TABCHUNK	4096	/* bytes of section table per piece */
+
+/*
+ * A piece of a checkpoint in the pack.  This is also the index record.
+ */
+typedef struct hist_obj {
+	uint64_t ho_hash[2];		/* hash of contents */
+	uint64_t ho_off;		/* offset in pack */
+	uint64_t ho_size;		/* size in bytes */
+} hist_obj_t;
+
+/*
+ * A generation of a checkpoint, as described by its manifest.
+ */
+typedef struct hist_gen {
+	char hg_module[MAXNAMELEN];	/* module name */
+	char hg_name[MAXNAMELEN];	/* manifest name */
+	uint64_t hg_cgen;		/* generation number */
+	uint64_t hg_size;		/* size of checkpoint */
+	uint64_t hg_hash[2];		/* hash of checkpoint */
+	uint32_t hg_npieces;		/* number of pieces */
+	uint32_t *hg_pieces;		/* index entries, in file order */
+} hist_gen_t;
+
+/*
+ * The size and mtime of a checkpoint when we last stored it, so that a
+ * file that hasn't changed isn't reread on every pass.
+ */
+typedef struct hist_seen {
+	char *hs_path;			/* pathname of checkpoint */
+	off64_t hs_size;		/* size when last stored */
+	struct timespec hs_mtime;	/* mtime when last stored */
+} hist_seen_t;
+
+typedef struct hist {
+	const char *h_store;		/* store directory */
+	int h_packfd;			/* pack, open for appending */
+	int h_idxfd;			/* index, open for appending */
+	uint64_t h_packsz;		/* size of pack */
+	hist_obj_t *h_objs;		/* pieces in the pack */
+	size_t h_nobjs;			/* number of entries in h_objs */
+	size_t h_aobjs;			/* allocated entries in h_objs */
+	uint32_t *h_slots;		/* hash table of h_objs index + 1 */
+	size_t h_nslots;		/* size of h_slots, a power of 2 */
+	boolean_t h_dirty;		/* pack has unsynced data */
+	hist_seen_t *h_seen;		/* checkpoints seen so far */
+	uint_t h_nseen;			/* number of entries in h_seen */
+	uint_t h_aseen;			/* allocated entries in h_seen */
+	uint_t h_ngens;			/* generations stored this pass */
+	uint_t h_nfailed;		/* checkpoints that failed this pass */
+	uint64_t h_added;		/* bytes added to pack this pass */
+} hist_t;
+
+static void
+hist_hash(const void *buf, size_t len, uint64_t *hash)
+{
+	hash[0] = fcf_hash(buf, len, 0);
+	hash[1] = fcf_hash(buf, len, HIST_SEED);
+}
+
+static const hist_obj_t *
+hist_find(hist_t *h, const uint64_t *hash, uint64_t size)
+{
+	size_t mask = h->h_nslots - 1;
+	size_t i = hash[0] & mask;
+	const hist_obj_t *ho;
+
+	if (h->h_nslots == 0)
+		return (NULL);
+	for (; h->h_slots[i] != 0; i = (i + 1) & mask) {
+		ho = &h->h_objs[h->h_slots[i] - 1];
+		if (ho->ho_hash[0] == hash[0] && ho->ho_hash[1] == hash[1] &&
+		    ho->ho_size == size)
+			return (ho);
+	}
+	return (NULL);
+}
+
+/*
+ * Add a piece that's already in the pack to the in-memory index, growing the
+ * hash table to keep it at most half full.
+ */
+static int
+hist_insert(hist_t *h, const hist_obj_t *ho)
+{
+	size_t i, mask, n;
+
+	if (h->h_nobjs == h->h_aobjs) {
+		size_t alloc = h->h_aobjs == 0 ? 1024 : h->h_aobjs * 2;
+		hist_obj_t *objs;
+
+		if (alloc > UINT32_MAX || (objs = realloc(h->h_objs,
+		    alloc * sizeof (hist_obj_t))) == NULL)
+			return (-1);
+		h->h_objs = objs;
+		h->h_aobjs = alloc;
+	}
+	h->h_objs[h->h_nobjs++] = *ho;
+
+	if (h->h_nobjs * 2 > h->h_nslots) {
+		size_t nslots = h->h_nslots == 0 ? 2048 : h->h_nslots * 2;
+		uint32_t *slots;
+
+		if ((slots = calloc(nslots, sizeof (uint32_t))) == NULL) {
+			h->h_nobjs--;
+			return (-1);
+		}
+		free(h->h_slots);
+		h->h_slots = slots;
+		h->h_nslots = nslots;
+		n = h->h_nobjs;
+	} else {
+		n = 1;
+	}
+
+	/*
+	 * After a resize every piece is rehashed, otherwise just the new one.
+	 */
+	mask = h->h_nslots - 1;
+	for (; n > 0; n--) {
+		ho = &h->h_objs[h->h_nobjs - n];
+		for (i = ho->ho_hash[0] & mask; h->h_slots[i] != 0;
+		    i = (i + 1) & mask)
+			continue;
+		h->h_slots[i] = (uint32_t)(h->h_nobjs - n + 1);
+	}
+	return (0);
+}
+
+/*
+ * Write all of a buffer at the given offset, or at the current offset if off
+ * is -1.
+ */
+static int
+hist_write(int fd, const void *buf, size_t len, off64_t off)
+{
+	const uchar_t *p = buf;
+	ssize_t n;
+
+	while (len > 0) {
+		if ((n = off < 0 ? write(fd, p, len) :
+		    pwrite64(fd, p, len, off)) < 0) {
+			if (errno == EINTR)
+				continue;
+			return (-1);
+		}
+		p += n;
+		len -= n;
+		if (off >= 0)
+			off += n;
+	}
+	return (0);
+}
+
+static int
+hist_read(int fd, void *buf, size_t len, off64_t off)
+{
+	uchar_t *p = buf;
+	ssize_t n;
+
+	while (len > 0) {
+		if ((n = pread64(fd, p, len, off)) <= 0) {
+			if (n < 0 && errno == EINTR)
+				continue;
+			if (n == 0)
+				errno = EIO;
+			return (-1);
+		}
+		p += n;
+		len -= n;
+		off += n;
+	}
+	return (0);
+}
+
+/*
+ * Store a piece, unless an identical one is already in the pack, and return
+ * its index entry.
+ */
+static int
+hist_put(hist_t *h, const void *buf, size_t len, uint32_t *idp)
+{
+	const hist_obj_t *old;
+	hist_obj_t ho;
+
+	hist_hash(buf, len, ho.ho_hash);
+	ho.ho_size = len;
+	if ((old = hist_find(h, ho.ho_hash, len)) != NULL) {
+		*idp = (uint32_t)(old - h->h_objs);
+		return (0);
+	}
+
+	ho.ho_off = h->h_packsz;
+	if (hist_write(h->h_packfd, buf, len, ho.ho_off) != 0 ||
+	    hist_write(h->h_idxfd, &ho, sizeof (hist_obj_t),
+	    (off64_t)h->h_nobjs * sizeof (hist_obj_t)) != 0) {
+		(void) fprintf(stderr, "failed to write to %s (%s)\n",
+		    h->h_store, strerror(errno));
+		return (-1);
+	}
+	if (hist_insert(h, &ho) != 0) {
+		(void) fprintf(stderr, "failed to allocate memory\n");
+		return (-1);
+	}
+	*idp = (uint32_t)(h->h_nobjs - 1);
+
+	h->h_packsz += len;
+	h->h_added += len;
+	h->h_dirty = B_TRUE;
+	return (0);
+}
+
+/*
+ * Open the pack and index and read the index into memory, dropping any
+ * records at the end that refer beyond the pack.  If wr is set, the store is
+ * created if need be and locked for adding to, the index is hashed for
+ * looking up pieces by content, and anything in the pack beyond the last
+ * piece that made it into the index is trimmed off.
+ */
+static int
+hist_open(hist_t *h, const char *store, boolean_t wr)
+{
+	char path[MAXPATHLEN];
+	struct stat64 st;
+	struct flock fl;
+	hist_obj_t *recs = NULL;
+	int oflags = wr ? O_RDWR | O_CREAT : O_RDONLY;
+	size_t i, n;
+	int rv = -1;
+
+	h->h_store = store;
+	h->h_packfd = h->h_idxfd = -1;
+
+	(void) snprintf(path, sizeof (path), "%s/gens", store);
+	if (wr && ((mkdir(store, 0755) != 0 && errno != EEXIST) ||
+	    (mkdir(path, 0755) != 0 && errno != EEXIST))) {
+		(void) fprintf(stderr, "failed to create %s (%s)\n", path,
+		    strerror(errno));
+		return (-1);
+	}
+
+	(void) snprintf(path, sizeof (path), "%s/index", store);
+	if ((h->h_idxfd = open(path, oflags, 0644)) < 0)
+		goto err;
+
+	(void) memset(&fl, 0, sizeof (fl));
+	fl.l_type = F_WRLCK;
+	fl.l_whence = SEEK_SET;
+	if (wr && fcntl(h->h_idxfd, F_SETLK, &fl) != 0) {
+		(void) fprintf(stderr, "%s is in use by another process\n",
+		    store);
+		return (-1);
+	}
+
+	if (fstat64(h->h_idxfd, &st) != 0)
+		goto err;
+	n = st.st_size / sizeof (hist_obj_t);
+	if (n > UINT32_MAX) {
+		errno = EFBIG;
+		goto err;
+	}
+	if (n > 0 && ((recs = malloc(n * sizeof (hist_obj_t))) == NULL ||
+	    hist_read(h->h_idxfd, recs, n * sizeof (hist_obj_t), 0) != 0))
+		goto err;
+
+	(void) snprintf(path, sizeof (path), "%s/pack", store);
+	if ((h->h_packfd = open(path, oflags, 0644)) < 0 ||
+	    fstat64(h->h_packfd, &st) != 0)
+		goto err;
+
+	for (i = 0; i < n; i++) {
+		if (recs[i].ho_off != h->h_packsz ||
+		    recs[i].ho_size > st.st_size - h->h_packsz)
+			break;
+		h->h_packsz += recs[i].ho_size;
+	}
+
+	if (!wr) {
+		h->h_objs = recs;
+		h->h_nobjs = h->h_aobjs = i;
+		return (0);
+	}
+
+	for (n = i, i = 0; i < n; i++) {
+		if (hist_insert(h, &recs[i]) != 0)
+			goto err;
+	}
+	if (ftruncate64(h->h_idxfd, (off64_t)n * sizeof (hist_obj_t)) != 0 ||
+	    ftruncate64(h->h_packfd, h->h_packsz) != 0)
+		goto err;
+
+	rv = 0;
+err:
+	if (rv != 0) {
+		(void) fprintf(stderr, "failed to open %s (%s)\n", path,
+		    strerror(errno));
+	}
+	free(recs);
+	return (rv);
+}
+
+static void
+hist_close(hist_t *h)
+{
+	uint_t i;
+
+	if (h->h_packfd >= 0)
+		(void) close(h->h_packfd);
+	if (h->h_idxfd >= 0)
+		(void) close(h->h_idxfd);
+	for (i = 0; i < h->h_nseen; i++)
+		free(h->h_seen[i].hs_path);
+	free(h->h_seen);
+	free(h->h_objs);
+	free(h->h_slots);
+}
+
+/*
+ * Read a manifest.  If pieces is false, only the header is read, otherwise
+ * the runs of index entries are expanded into hg_pieces.
+ */
+static int
+hist_gen_read(const char *path, hist_gen_t *hg, boolean_t pieces)
+{
+	u_longlong_t cgen, size, h0, h1;
+	uint32_t first, count, n = 0;
+	uint_t vers;
+	FILE *fp;
+	int rv = -1;
+
+	hg->hg_pieces = NULL;
+	if ((fp = fopen(path, "r")) == NULL) {
+		(void) fprintf(stderr, "failed to open %s (%s)\n", path,
+		    strerror(errno));
+		return (-1);
+	}
+
+	if (fscanf(fp, "fcfhist %u\n", &vers) != 1 || vers != HIST_VERSION ||
+	    fscanf(fp, "cgen %llu\n", &cgen) != 1 ||
+	    fscanf(fp, "size %llu\n", &size) != 1 ||
+	    fscanf(fp, "hash %16llx%16llx\n", &h0, &h1) != 2 ||
+	    fscanf(fp, "pieces %u\n", &hg->hg_npieces) != 1)
+		goto out;
+
+	hg->hg_cgen = cgen;
+	hg->hg_size = size;
+	hg->hg_hash[0] = h0;
+	hg->hg_hash[1] = h1;
+
+	if (!pieces) {
+		rv = 0;
+		goto out;
+	}
+
+	if (hg->hg_npieces > size + 1 || (hg->hg_pieces =
+	    calloc(hg->hg_npieces + 1, sizeof (uint32_t))) == NULL)
+		goto out;
+
+	while (fscanf(fp, "%u %u\n", &first, &count) == 2) {
+		if (count > hg->hg_npieces - n ||
+		    first > UINT32_MAX - count)
+			goto out;
+		while (count-- > 0)
+			hg->hg_pieces[n++] = first++;
+	}
+	if (n == hg->hg_npieces && feof(fp))
+		rv = 0;
+out:
+	if (rv != 0) {
+		(void) fprintf(stderr, "%s: not a valid manifest\n", path);
+		free(hg->hg_pieces);
+		hg->hg_pieces = NULL;
+	}
+	(void) fclose(fp);
+	return (rv);
+}
+
+/*
+ * Write a manifest and rename it into place, once the pieces that it refers
+ * to are safely in the pack.
+ */
+static int
+hist_gen_write(hist_t *h, const char *path, const hist_gen_t *hg)
+{
+	char tmp[MAXPATHLEN], dir[MAXPATHLEN];
+	FILE *fp;
+	uint32_t i, j;
+	int fd;
+
+	if (h->h_dirty) {
+		if (fsync(h->h_packfd) != 0 || fsync(h->h_idxfd) != 0) {
+			(void) fprintf(stderr, "failed to sync %s (%s)\n",
+			    h->h_store, strerror(errno));
+			return (-1);
+		}
+		h->h_dirty = B_FALSE;
+	}
+
+	if (snprintf(tmp, sizeof (tmp), "%s.XXXXXX", path) >= sizeof (tmp)) {
+		(void) fprintf(stderr, "%s: path too long\n", path);
+		return (-1);
+	}
+	if ((fd = mkstemp(tmp)) < 0 || (fp = fdopen(fd, "w")) == NULL) {
+		(void) fprintf(stderr, "failed to create %s (%s)\n", tmp,
+		    strerror(errno));
+		if (fd >= 0) {
+			(void) close(fd);
+			(void) unlink(tmp);
+		}
+		return (-1);
+	}
+
+	(void) fprintf(fp, "fcfhist %u\ncgen %llu\nsize %llu\n"
+	    "hash %016llx%016llx\npieces %u\n", HIST_VERSION,
+	    (u_longlong_t)hg->hg_cgen, (u_longlong_t)hg->hg_size,
+	    (u_longlong_t)hg->hg_hash[0], (u_longlong_t)hg->hg_hash[1],
+	    hg->hg_npieces);
+	for (i = 0; i < hg->hg_npieces; i = j) {
+		for (j = i + 1; j < hg->hg_npieces &&
+		    hg->hg_pieces[j] == hg->hg_pieces[j - 1] + 1; j++)
+			continue;
+		(void) fprintf(fp, "%u %u\n", hg->hg_pieces[i], j - i);
+	}
+
+	if (fflush(fp) != 0 || fsync(fd) != 0) {
+		(void) fprintf(stderr, "failed to write %s (%s)\n", tmp,
+		    strerror(errno));
+		(void) fclose(fp);
+		(void) unlink(tmp);
+		return (-1);
+	}
+	(void) fclose(fp);
+
+	if (rename(tmp, path) != 0) {
+		(void) fprintf(stderr, "failed to rename %s to %s (%s)\n",
+		    tmp, path, strerror(errno));
+		(void) unlink(tmp);
+		return (-1);
+	}
+
+	(void) strlcpy(dir, path, sizeof (dir));
+	if ((fd = open(dirname(dir), O_RDONLY)) >= 0) {
+		(void) fsync(fd);
+		(void) close(fd);
+	}
+	return (0);
+}
+
+static int
+hist_cut_cmp(const void *l, const void *r)
+{
+	uint64_t a = *(const uint64_t *)l, b = *(const uint64_t *)r;
+
+	return (a < b ? -1 : a > b);
+}
+
+/*
+ * Store one generation of a checkpoint: cut the file at the start and end of
+ * every section and every HIST_TABCHUNK bytes through the section table, and
+ * store each piece.  A section whose bounds are bad just doesn't contribute
+ * any cuts, since its bytes are stored either way.
+ */
+static int
+hist_store(hist_t *h, fcf_view_t *fv, const char *module)
+{
+	char path[MAXPATHLEN];
+	const fcf_sec_t *sp;
+	hist_gen_t hg, old;
+	uint64_t *cuts, off, size = fv->fv_size;
+	uint64_t tab = fv->fv_hdr->fcfh_secoff;
+	uint64_t tabsz = (uint64_t)fv->fv_secnum * fv->fv_secsize;
+	uint64_t base = h->h_packsz;
+	size_t nobjs = h->h_nobjs;
+	uint_t i, n = 0, nnew = 0;
+	int rv = -1;
+
+	(void) memset(&hg, 0, sizeof (hg));
+	n = fv->fv_secnum * 2 + tabsz / HIST_TABCHUNK + 4;
+	if ((cuts = malloc(n * sizeof (uint64_t))) == NULL ||
+	    (hg.hg_pieces = malloc(n * sizeof (uint32_t))) == NULL) {
+		(void) fprintf(stderr, "failed to allocate memory\n");
+		goto out;
+	}
+
+	n = 0;
+	cuts[n++] = 0;
+	cuts[n++] = size;
+	for (off = 0; off <= tabsz; off += HIST_TABCHUNK)
+		cuts[n++] = tab + off;
+	cuts[n++] = tab + tabsz;
+	for (i = 0; i < fv->fv_secnum; i++) {
+		sp = fcf_view_sec(fv, i);
+		if (sp->fcfs_offset > size ||
+		    sp->fcfs_size > size - sp->fcfs_offset)
+			continue;
+		cuts[n++] = sp->fcfs_offset;
+		cuts[n++] = sp->fcfs_offset + sp->fcfs_size;
+	}
+	qsort(cuts, n, sizeof (uint64_t), hist_cut_cmp);
+
+	for (i = 1; i < n; i++) {
+		if (cuts[i] == cuts[i - 1])
+			continue;
+		if (hist_put(h, fv->fv_base + cuts[i - 1],
+		    cuts[i] - cuts[i - 1], &hg.hg_pieces[hg.hg_npieces]) != 0)
+			goto out;
+		if (hg.hg_pieces[hg.hg_npieces++] >= nobjs)
+			nnew++;
+	}
+
+	hg.hg_cgen = fv->fv_hdr->fcfh_cgen;
+	hg.hg_size = size;
+	hist_hash(fv->fv_base, size, hg.hg_hash);
+
+	(void) snprintf(path, sizeof (path), "%s/gens/%s", h->h_store,
+	    module);
+	if (mkdir(path, 0755) != 0 && errno != EEXIST) {
+		(void) fprintf(stderr, "failed to create %s (%s)\n", path,
+		    strerror(errno));
+		goto out;
+	}
+
+	/*
+	 * Find a free name for the manifest, unless this generation is
+	 * already stored.
+	 */
+	for (i = 0; i < HIST_MAXDUPS; i++) {
+		if (i == 0) {
+			(void) snprintf(path, sizeof (path), "%s/gens/%s/%llu",
+			    h->h_store, module, (u_longlong_t)hg.hg_cgen);
+		} else {
+			(void) snprintf(path, sizeof (path),
+			    "%s/gens/%s/%llu.%u", h->h_store, module,
+			    (u_longlong_t)hg.hg_cgen, i);
+		}
+		if (access(path, F_OK) != 0)
+			break;
+		if (hist_gen_read(path, &old, B_FALSE) == 0 &&
+		    old.hg_size == hg.hg_size &&
+		    old.hg_hash[0] == hg.hg_hash[0] &&
+		    old.hg_hash[1] == hg.hg_hash[1]) {
+			rv = 0;
+			goto out;
+		}
+	}
+	if (i == HIST_MAXDUPS) {
+		(void) fprintf(stderr, "%s: too many versions of generation "
+		    "%llu\n", module, (u_longlong_t)hg.hg_cgen);
+		goto out;
+	}
+
+	if (hist_gen_write(h, path, &hg) != 0)
+		goto out;
+
+	(void) printf("%s: generation %s, %llu bytes in %u pieces, "
+	    "%u new (%llu bytes)\n", module, strrchr(path, '/') + 1,
+	    (u_longlong_t)size, hg.hg_npieces, nnew,
+	    (u_longlong_t)(h->h_packsz - base));
+	h->h_ngens++;
+	rv = 0;
+out:
+	free(cuts);
+	free(hg.hg_pieces);
+	return (rv);
+}
+
+static hist_seen_t *
+hist_seen(hist_t *h, const char *path)
+{
+	hist_seen_t *hs;
+	uint_t i;
+
+	for (i = 0; i < h->h_nseen; i++) {
+		if (strcmp(h->h_seen[i].hs_path, path) == 0)
+			return (&h->h_seen[i]);
+	}
+
+	if (h->h_nseen == h->h_aseen) {
+		uint_t alloc = h->h_aseen == 0 ? 16 : h->h_aseen * 2;
+
+		if ((hs = realloc(h->h_seen,
+		    alloc * sizeof (hist_seen_t))) == NULL)
+			return (NULL);
+		h->h_seen = hs;
+		h->h_aseen = alloc;
+	}
+
+	hs = &h->h_seen[h->h_nseen];
+	(void) memset(hs, 0, sizeof (hist_seen_t));
+	hs->hs_size = -1;
+	if ((hs->hs_path = strdup(path)) == NULL)
+		return (NULL);
+	h->h_nseen++;
+	return (hs);
+}
+
+/*
+ * Called by ckpt_walk() for each checkpoint.  fmd names a checkpoint after
+ * its module, so that's what the store calls it too.
+ */
+static int
+hist_snap_cb(const char *dir, const char *name, void *arg)
+{
+	hist_t *h = arg;
+	hist_seen_t *hs;
+	char path[MAXPATHLEN];
+	struct stat64 st;
+	fcf_view_t fv;
+	int rv;
+
+	(void) snprintf(path, sizeof (path), "%s/%s", dir, name);
+	if (stat64(path, &st) != 0)
+		return (0);
+
+	if ((hs = hist_seen(h, path)) == NULL) {
+		(void) fprintf(stderr, "failed to allocate memory\n");
+		return (-1);
+	}
+	if (hs->hs_size == st.st_size &&
+	    hs->hs_mtime.tv_sec == st.st_mtim.tv_sec &&
+	    hs->hs_mtime.tv_nsec == st.st_mtim.tv_nsec)
+		return (0);
+
+	if (fcf_view_open(&fv, path) != 0) {
+		(void) fprintf(stderr, "%s\n", fv.fv_errmsg);
+		fcf_view_close(&fv);
+		h->h_nfailed++;
+		return (0);
+	}
+
+	rv = hist_store(h, &fv, name);
+	fcf_view_close(&fv);
+
+	/*
+	 * A failure to write to the store isn't going to get any better by
+	 * carrying on.
+	 */
+	if (rv != 0)
+		return (-1);
+
+	hs->hs_size = st.st_size;
+	hs->hs_mtime = st.st_mtim;
+	return (0);
+}
+
+static int
+hist_gen_cmp(const void *l, const void *r)
+{
+	const hist_gen_t *lg = l, *rg = r;
+	int c;
+
+	if ((c = strcmp(lg->hg_module, rg->hg_module)) != 0)
+		return (c);
+	if (lg->hg_cgen != rg->hg_cgen)
+		return (lg->hg_cgen < rg->hg_cgen ? -1 : 1);
+	return (strcmp(lg->hg_name, rg->hg_name));
+}
+
+/*
+ * Returns B_TRUE if a name is safe to use as a module or manifest name.
+ */
+static boolean_t
+hist_name_ok(const char *name, boolean_t gen)
+{
+	const char *p;
+
+	if (name[0] == '\0' || name[0] == '.' ||
+	    strlen(name) >= MAXNAMELEN)
+		return (B_FALSE);
+	for (p = name; *p != '\0'; p++) {
+		if (*p == '/' || (gen && (*p < '0' || *p > '9') && *p != '.'))
+			return (B_FALSE);
+	}
+	return (B_TRUE);
+}
+
+/*
+ * Read the headers of the manifests of every generation in the store, or
+ * just those of one module, sorted by module and generation.
+ */
+static int
+hist_gens(const char *store, const char *module, hist_gen_t **gensp,
+    uint_t *ngensp, uint64_t *mbytesp)
+{
+	DIR *sdp, *mdp = NULL;
+	struct dirent *sdep, *mdep;
+	char path[MAXPATHLEN];
+	struct stat64 st;
+	hist_gen_t *gens = NULL, *hg;
+	uint_t ngens = 0, alloc = 0;
+	int rv = -1;
+
+	*mbytesp = 0;
+	(void) snprintf(path, sizeof (path), "%s/gens", store);
+	if ((sdp = opendir(path)) == NULL) {
+		(void) fprintf(stderr, "failed to open %s (%s)\n", path,
+		    strerror(errno));
+		return (-1);
+	}
+
+	while ((sdep = readdir(sdp)) != NULL) {
+		if (!hist_name_ok(sdep->d_name, B_FALSE) ||
+		    (module != NULL && strcmp(sdep->d_name, module) != 0))
+			continue;
+		(void) snprintf(path, sizeof (path), "%s/gens/%s", store,
+		    sdep->d_name);
+		if (stat64(path, &st) != 0 || !S_ISDIR(st.st_mode) ||
+		    (mdp = opendir(path)) == NULL)
+			continue;
+
+		while ((mdep = readdir(mdp)) != NULL) {
+			if (!hist_name_ok(mdep->d_name, B_TRUE))
+				continue;
+			if (ngens == alloc) {
+				alloc = alloc == 0 ? 64 : alloc * 2;
+				if ((hg = realloc(gens,
+				    alloc * sizeof (hist_gen_t))) == NULL) {
+					(void) fprintf(stderr, "failed to "
+					    "allocate memory\n");
+					goto out;
+				}
+				gens = hg;
+			}
+			hg = &gens[ngens];
+			(void) snprintf(path, sizeof (path), "%s/gens/%s/%s",
+			    store, sdep->d_name, mdep->d_name);
+			if (stat64(path, &st) != 0 ||
+			    hist_gen_read(path, hg, B_FALSE) != 0)
+				continue;
+			(void) strlcpy(hg->hg_module, sdep->d_name,
+			    sizeof (hg->hg_module));
+			(void) strlcpy(hg->hg_name, mdep->d_name,
+			    sizeof (hg->hg_name));
+			*mbytesp += st.st_size;
+			ngens++;
+		}
+		(void) closedir(mdp);
+		mdp = NULL;
+	}
+
+	qsort(gens, ngens, sizeof (hist_gen_t), hist_gen_cmp);
+	*gensp = gens;
+	*ngensp = ngens;
+	gens = NULL;
+	rv = 0;
+out:
+	if (mdp != NULL)
+		(void) closedir(mdp);
+	(void) closedir(sdp);
+	free(gens);
+	return (rv);
+}
+
+static int
+hist_list(const char *store, const char *module)
+{
+	hist_gen_t *gens = NULL;
+	uint_t i, ngens, nmods = 0;
+	uint64_t total = 0, stored, mbytes;
+	char path[MAXPATHLEN];
+	struct stat64 st;
+
+	if (hist_gens(store, module, &gens, &ngens, &mbytes) != 0)
+		return (1);
+
+	(void) printf("%-24s %-12s %12s %8s\n", "MODULE", "GENERATION",
+	    "SIZE", "PIECES");
+	for (i = 0; i < ngens; i++) {
+		(void) printf("%-24s %-12s %12llu %8u\n", gens[i].hg_module,
+		    gens[i].hg_name, (u_longlong_t)gens[i].hg_size,
+		    gens[i].hg_npieces);
+		total += gens[i].hg_size;
+		if (i == 0 || strcmp(gens[i].hg_module,
+		    gens[i - 1].hg_module) != 0)
+			nmods++;
+	}
+
+	/*
+	 * The pack and index are shared by every module, so they're only
+	 * counted when listing the whole store.
+	 */
+	stored = mbytes;
+	if (module == NULL) {
+		(void) snprintf(path, sizeof (path), "%s/pack", store);
+		if (stat64(path, &st) == 0)
+			stored += st.st_size;
+		(void) snprintf(path, sizeof (path), "%s/index", store);
+		if (stat64(path, &st) == 0)
+			stored += st.st_size;
+		(void) printf("\n%u generations of %u modules: %llu bytes of "
+		    "checkpoints stored in %llu bytes (%.1f%%)\n", ngens,
+		    nmods, (u_longlong_t)total, (u_longlong_t)stored,
+		    total == 0 ? 0.0 : 100.0 * stored / total);
+	}
+
+	free(gens);
+	return (0);
+}
+
+/*
+ * Rebuild the generation whose manifest is at path into a new buffer,
+ * checking each piece and then the whole file against the hashes in the
+ * manifest.
+ */
+static uchar_t *
+hist_gen_load(hist_t *h, const char *path, uint64_t *sizep)
+{
+	hist_gen_t hg;
+	const hist_obj_t *ho;
+	uint64_t hash[2], off;
+	uchar_t *buf;
+	uint32_t i;
+
+	if (hist_gen_read(path, &hg, B_TRUE) != 0)
+		return (NULL);
+	if ((buf = malloc(hg.hg_size == 0 ? 1 : hg.hg_size)) == NULL) {
+		(void) fprintf(stderr, "failed to allocate memory\n");
+		goto err;
+	}
+
+	for (i = 0, off = 0; i < hg.hg_npieces; i++) {
+		if (hg.hg_pieces[i] >= h->h_nobjs ||
+		    (ho = &h->h_objs[hg.hg_pieces[i]])->ho_size >
+		    hg.hg_size - off) {
+			(void) fprintf(stderr, "%s: piece %u is missing from "
+			    "the index\n", path, hg.hg_pieces[i]);
+			goto err;
+		}
+		if (hist_read(h->h_packfd, buf + off, ho->ho_size,
+		    ho->ho_off) != 0) {
+			(void) fprintf(stderr, "failed to read %s/pack (%s)\n",
+			    h->h_store, strerror(errno));
+			goto err;
+		}
+		hist_hash(buf + off, ho->ho_size, hash);
+		if (hash[0] != ho->ho_hash[0] || hash[1] != ho->ho_hash[1]) {
+			(void) fprintf(stderr, "%s/pack: piece %u is "
+			    "corrupt\n", h->h_store, hg.hg_pieces[i]);
+			goto err;
+		}
+		off += ho->ho_size;
+	}
+
+	hist_hash(buf, hg.hg_size, hash);
+	if (hash[0] != hg.hg_hash[0] || hash[1] != hg.hg_hash[1]) {
+		(void) fprintf(stderr, "%s: rebuilt checkpoint doesn't "
+		    "match\n", path);
+		goto err;
+	}
+
+	free(hg.hg_pieces);
+	*sizep = hg.hg_size;
+	return (buf);
+
+err:
+	free(hg.hg_pieces);
+	free(buf);
+	return (NULL);
+}
+
+/*
+ * Rebuild a generation of a checkpoint into a file, or standard output if
+ * opath is "-".  If gen is NULL, the latest generation is rebuilt.
+ */
+static int
+hist_rebuild(const char *store, const char *module, const char *gen,
+    const char *opath)
+{
+	char path[MAXPATHLEN], tmp[MAXPATHLEN];
+	hist_gen_t *gens = NULL;
+	hist_t h;
+	uint64_t mbytes, size;
+	uchar_t *buf = NULL;
+	uint_t ngens;
+	int fd = -1, rv = 1;
+	boolean_t out = strcmp(opath, "-") == 0;
+
+	(void) memset(&h, 0, sizeof (h));
+	h.h_packfd = h.h_idxfd = -1;
+	if (!hist_name_ok(module, B_FALSE) ||
+	    (gen != NULL && !hist_name_ok(gen, B_TRUE))) {
+		(void) fprintf(stderr, "invalid module or generation\n");
+		return (2);
+	}
+
+	if (gen == NULL) {
+		if (hist_gens(store, module, &gens, &ngens, &mbytes) != 0)
+			return (1);
+		if (ngens == 0) {
+			(void) fprintf(stderr, "no generations of %s in %s\n",
+			    module, store);
+			free(gens);
+			return (1);
+		}
+		(void) snprintf(path, sizeof (path), "%s/gens/%s/%s", store,
+		    module, gens[ngens - 1].hg_name);
+		free(gens);
+	} else {
+		(void) snprintf(path, sizeof (path), "%s/gens/%s/%s", store,
+		    module, gen);
+	}
+
+	if (hist_open(&h, store, B_FALSE) != 0 ||
+	    (buf = hist_gen_load(&h, path, &size)) == NULL)
+		goto out;
+
+	if (out) {
+		fd = STDOUT_FILENO;
+		(void) strlcpy(tmp, "standard output", sizeof (tmp));
+	} else {
+		if (snprintf(tmp, sizeof (tmp), "%s.XXXXXX", opath) >=
+		    sizeof (tmp)) {
+			(void) fprintf(stderr, "%s: path too long\n", opath);
+			goto out;
+		}
+		if ((fd = mkstemp(tmp)) < 0) {
+			(void) fprintf(stderr, "failed to create %s (%s)\n",
+			    tmp, strerror(errno));
+			goto out;
+		}
+	}
+
+	if (hist_write(fd, buf, size, -1) != 0) {
+		(void) fprintf(stderr, "failed to write %s (%s)\n", tmp,
+		    strerror(errno));
+		if (!out)
+			(void) unlink(tmp);
+		goto out;
+	}
+
+	if (!out) {
+		(void) fchmod(fd, 0644);
+		if (rename(tmp, opath) != 0) {
+			(void) fprintf(stderr, "failed to rename %s to %s "
+			    "(%s)\n", tmp, opath, strerror(errno));
+			(void) unlink(tmp);
+			goto out;
+		}
+	}
+	rv = 0;
+out:
+	if (fd >= 0 && !out)
+		(void) close(fd);
+	hist_close(&h);
+	free(buf);
+	return (rv);
+}
+
+/*
+ * Returns B_TRUE if a directory looks like a history store.
+ */
+boolean_t
+hist_is_store(const char *dir)
+{
+	char path[MAXPATHLEN];
+	struct stat64 st;
+
+	(void) snprintf(path, sizeof (path), "%s/pack", dir);
+	if (stat64(path, &st) != 0 || !S_ISREG(st.st_mode))
+		return (B_FALSE);
+	(void) snprintf(path, sizeof (path), "%s/gens", dir);
+	return (stat64(path, &st) == 0 && S_ISDIR(st.st_mode));
+}
+
+/*
+ * Call func with the contents of every generation in a store, in order of
+ * module and generation, rebuilding one at a time.  The name passed to func
+ * is the path of the generation's manifest.  A generation that can't be
+ * rebuilt is reported and skipped, and makes the return value -1; otherwise
+ * the walk stops if func returns nonzero, and that value is returned.
+ */
+int
+hist_walk(const char *store, ckpt_func_t *func, void *arg)
+{
+	char path[MAXPATHLEN];
+	hist_gen_t *gens = NULL;
+	hist_t h;
+	uint64_t mbytes, size;
+	uchar_t *buf;
+	uint_t i, ngens = 0;
+	int err = 0, rv = 0;
+
+	(void) memset(&h, 0, sizeof (h));
+	h.h_packfd = h.h_idxfd = -1;
+	if (hist_open(&h, store, B_FALSE) != 0 ||
+	    hist_gens(store, NULL, &gens, &ngens, &mbytes) != 0) {
+		hist_close(&h);
+		return (-1);
+	}
+
+	for (i = 0; i < ngens && rv == 0; i++) {
+		(void) snprintf(path, sizeof (path), "%s/gens/%s/%s", store,
+		    gens[i].hg_module, gens[i].hg_name);
+		if ((buf = hist_gen_load(&h, path, &size)) == NULL) {
+			err = -1;
+			continue;
+		}
+		rv = func(path, buf, size, arg);
+		free(buf);
+	}
+
+	free(gens);
+	hist_close(&h);
+	return (rv != 0 ? rv : err);
+}
+
+static void
+hist_usage(void)
+{
+	(void) fprintf(stderr, "usage: %s history [-i interval] -d store "
+	    "[root]\n"
+	    "       %s history -l -d store [module]\n"
+	    "       %s history -d store [-g generation] -o output module\n\n"
+	    "root defaults to %s\n\n", pname, pname, pname, CKPT_DEFROOT);
+}
+
+int
+do_history(int argc, char **argv)
+{
+	hist_t h;
+	const char *store = NULL, *root = CKPT_DEFROOT;
+	const char *gen = NULL, *opath = NULL;
+	boolean_t list = B_FALSE;
+	long interval = 0;
+	char *end;
+	int c, rv;
+
+	while ((c = getopt(argc, argv, "d:g:i:lo:")) != -1) {
+		switch (c) {
+		case 'd':
+			store = optarg;
+			break;
+		case 'g':
+			gen = optarg;
+			break;
+		case 'i':
+			errno = 0;
+			interval = strtol(optarg, &end, 10);
+			if (errno != 0 || *end != '\0' || interval < 1 ||
+			    interval > UINT_MAX) {
+				(void) fprintf(stderr, "invalid interval: "
+				    "%s\n", optarg);
+				return (2);
+			}
+			break;
+		case 'l':
+			list = B_TRUE;
+			break;
+		case 'o':
+			opath = optarg;
+			break;
+		default:
+			hist_usage();
+			return (2);
+		}
+	}
+
+	if (store == NULL || argc - optind > 1 ||
+	    (list && (opath != NULL || gen != NULL || interval != 0)) ||
+	    (opath != NULL && (interval != 0 || argc - optind != 1)) ||
+	    (gen != NULL && opath == NULL)) {
+		hist_usage();
+		return (2);
+	}
+
+	if (list)
+		return (hist_list(store, argc > optind ? argv[optind] : NULL));
+	if (opath != NULL)
+		return (hist_rebuild(store, argv[optind], gen, opath));
+
+	if (argc - optind == 1)
+		root = argv[optind];
+
+	(void) memset(&h, 0, sizeof (h));
+	if (hist_open(&h, store, B_TRUE) != 0) {
+		hist_close(&h);
+		return (1);
+	}
+
+	for (;;) {
+		h.h_ngens = h.h_nfailed = 0;
+		h.h_added = 0;
+		if ((rv = ckpt_walk(root, hist_snap_cb, &h)) != 0)
+			break;
+		if (interval == 0 || h.h_ngens != 0 || h.h_nfailed != 0) {
+			(void) printf("%u new generations stored, %u "
+			    "checkpoints failed, %llu bytes added to %s\n",
+			    h.h_ngens, h.h_nfailed, (u_longlong_t)h.h_added,
+			    store);
+		}
+		(void) fflush(stdout);
+		if (interval == 0)
+			break;
+		(void) sleep((uint_t)interval);
+	}
+
+	hist_close(&h);
+	return (rv != 0 || h.h_nfailed != 0 ? 1 : 0);
+}
@@ -0,0 +1,263 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+/*
+ * The buffered writer used by all of the output formats.  See out.h.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/param.h>
+#include <sys/types.h>
+
+#include "out.h"
+
+static const dump_fmt_t *const dump_fmts[] = {
+	&dump_fmt_text,
+	&dump_fmt_json,
+	&dump_fmt_bin,
+	NULL
+};
+
+static const char out_hexdigits[] = "0123456789abcdef";
+
+const dump_fmt_t *
+dump_fmt_lookup(const char *name)
+{
+	uint_t i;
+
+	for (i = 0; dump_fmts[i] != NULL; i++) {
+		if (strcmp(dump_fmts[i]->df_name, name) == 0)
+			return (dump_fmts[i]);
+	}
+	return (NULL);
+}
+
+void
+out_init(dump_out_t *o, FILE *fp, const dump_fmt_t *fmt)
+{
+	o->do_fp = fp;
+	o->do_fmt = fmt;
+	o->do_err = B_FALSE;
+	o->do_ids = NULL;
+	o->do_nids = 0;
+	o->do_nextid = 1;
+	o->do_len = 0;
+}
+
+/*
+ * Flush any pending output and release the writer's resources.  Returns -1
+ * if any of the output couldn't be written.
+ */
+int
+out_fini(dump_out_t *o)
+{
+	out_flush(o);
+	free(o->do_ids);
+	o->do_ids = NULL;
+	o->do_nids = 0;
+
+	return (o->do_err ? -1 : 0);
+}
+
+void
+out_flush(dump_out_t *o)
+{
+	if (o->do_len != 0 &&
+	    fwrite(o->do_buf, 1, o->do_len, o->do_fp) != o->do_len)
+		o->do_err = B_TRUE;
+	o->do_len = 0;
+}
+
+void
+out_write(dump_out_t *o, const void *buf, size_t len)
+{
+	const char *p = buf;
+	size_t n;
+
+	while (len != 0) {
+		if (o->do_len == OUT_BUFSZ)
+			out_flush(o);
+
+		n = MIN(len, OUT_BUFSZ - o->do_len);
+		bcopy(p, o->do_buf + o->do_len, n);
+		o->do_len += n;
+		p += n;
+		len -= n;
+	}
+}
+
+void
+out_puts(dump_out_t *o, const char *s)
+{
+	out_write(o, s, strlen(s));
+}
+
+void
+out_u64(dump_out_t *o, uint64_t v)
+{
+	char buf[20];
+	int i = sizeof (buf);
+
+	do {
+		buf[--i] = '0' + v % 10;
+		v /= 10;
+	} while (v != 0);
+
+	out_write(o, buf + i, sizeof (buf) - i);
+}
+
+void
+out_x64(dump_out_t *o, uint64_t v)
+{
+	char buf[16];
+	int i = sizeof (buf);
+
+	do {
+		buf[--i] = out_hexdigits[v & 0xf];
+		v >>= 4;
+	} while (v != 0);
+
+	out_write(o, buf + i, sizeof (buf) - i);
+}
+
+/*
+ * For the odd bit of output that really wants printf-style formatting.  The
+ * result is formatted directly into the buffer when it fits.
+ */
+void
+out_printf(dump_out_t *o, const char *fmt, ...)
+{
+	va_list ap;
+	int n;
+
+	va_start(ap, fmt);
+	n = vsnprintf(o->do_buf + o->do_len, OUT_BUFSZ - o->do_len, fmt, ap);
+	va_end(ap);
+
+	if (n < 0)
+		return;
+	if ((size_t)n < OUT_BUFSZ - o->do_len) {
+		o->do_len += n;
+		return;
+	}
+
+	out_flush(o);
+	va_start(ap, fmt);
+	if ((size_t)n < OUT_BUFSZ) {
+		o->do_len = vsnprintf(o->do_buf, OUT_BUFSZ, fmt, ap);
+	} else if (vfprintf(o->do_fp, fmt, ap) < 0) {
+		o->do_err = B_TRUE;
+	}
+	va_end(ap);
+}
+
+/*
+ * Write a string as a quoted JSON string.
+ */
+void
+out_jstr(dump_out_t *o, const char *s)
+{
+	const char *run = s;
+	uchar_t c;
+
+	out_putc(o, '"');
+	for (; (c = *s) != '\0'; s++) {
+		if (c >= 0x20 && c != '"' && c != '\\')
+			continue;
+
+		out_write(o, run, s - run);
+		run = s + 1;
+
+		out_putc(o, '\\');
+		switch (c) {
+		case '"':
+		case '\\':
+			out_putc(o, c);
+			break;
+		case '\n':
+			out_putc(o, 'n');
+			break;
+		case '\t':
+			out_putc(o, 't');
+			break;
+		default:
+			out_puts(o, "u00");
+			out_putc(o, out_hexdigits[c >> 4]);
+			out_putc(o, out_hexdigits[c & 0xf]);
+			break;
+		}
+	}
+	out_write(o, run, s - run);
+	out_putc(o, '"');
+}
+
+/*
+ * Write an unsigned LEB128 varint, as used throughout the binary format.
+ */
+void
+out_varint(dump_out_t *o, uint64_t v)
+{
+	while (v >= 0x80) {
+		out_putc(o, (char)(v | 0x80));
+		v >>= 7;
+	}
+	out_putc(o, (char)v);
+}
+
+/*
+ * Write a length-prefixed byte string for the binary format.
+ */
+void
+out_blob(dump_out_t *o, const void *buf, size_t len)
+{
+	out_varint(o, len);
+	out_write(o, buf, len);
+}
+
+/*
+ * Return the binary format's identifier for an atom, emitting a string
+ * definition record the first time the atom is seen.  Identifiers are local
+ * to the writer and assigned in order of first use from one, so the output
+ * doesn't depend on the order in which a shared atom table happened to be
+ * filled.  Zero stands for a string that couldn't be resolved.
+ *
+ * Since this may emit a record, it must be called for every string in a
+ * record before any of the record itself is written.
+ */
+uint32_t
+out_atom(dump_out_t *o, const fcf_atom_t *fa)
+{
+	uint32_t *ids, n;
+
+	if (fa == NULL)
+		return (0);
+
+	if (fa->fa_id >= o->do_nids) {
+		n = MAX(o->do_nids * 2, fa->fa_id + 1);
+		n = MAX(n, 1024);
+		if ((ids = realloc(o->do_ids, n * sizeof (uint32_t))) == NULL) {
+			o->do_err = B_TRUE;
+			return (0);
+		}
+		bzero(ids + o->do_nids, (n - o->do_nids) * sizeof (uint32_t));
+		o->do_ids = ids;
+		o->do_nids = n;
+	}
+
+	if (o->do_ids[fa->fa_id] == 0) {
+		o->do_ids[fa->fa_id] = o->do_nextid++;
+		out_putc(o, 'S');
+		out_varint(o, o->do_ids[fa->fa_id]);
+		out_blob(o, fa->fa_str, fa->fa_len);
+	}
+
+	return (o->do_ids[fa->fa_id]);
+}
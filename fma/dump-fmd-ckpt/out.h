@@ -0,0 +1,104 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+#ifndef _OUT_H
+#define	_OUT_H
+
+#include <stdio.h>
+#include <sys/types.h>
+
+#include "fcf.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define	OUT_BUFSZ	(32 * 1024)
+
+struct dump_fmt;
+
+/*
+ * A buffered writer.  Output accumulates in do_buf and is handed to the
+ * underlying stream in OUT_BUFSZ chunks, so emitting a field costs a few
+ * stores rather than a trip through stdio.  Nothing is allocated per field;
+ * the only allocation is the atom id map used by the binary format, which
+ * grows with the number of distinct strings written.
+ */
+typedef struct dump_out {
+	FILE *do_fp;			/* underlying stream */
+	const struct dump_fmt *do_fmt;	/* output format */
+	boolean_t do_err;		/* a write to do_fp failed */
+	uint32_t *do_ids;		/* binary: local id of each atom */
+	uint32_t do_nids;		/* number of entries in do_ids */
+	uint32_t do_nextid;		/* binary: next local id to assign */
+	size_t do_len;			/* bytes used in do_buf */
+	char do_buf[OUT_BUFSZ];		/* pending output */
+} dump_out_t;
+
+/*
+ * An output format.  The decoders in dump-fmd-ckpt.c validate each record and
+ * hand it to these entry points, which decide how it's rendered.  Records
+ * within a section are numbered from zero.
+ */
+typedef struct dump_fmt {
+	const char *df_name;
+	void (*df_hdr)(dump_out_t *, fcf_view_t *);
+	void (*df_sec)(dump_out_t *, fcf_view_t *, fcf_secidx_t);
+	void (*df_secend)(dump_out_t *, fcf_secidx_t);
+	void (*df_str)(dump_out_t *, fcf_secidx_t, uint32_t, const char *);
+	void (*df_module)(dump_out_t *, fcf_view_t *, fcf_secidx_t,
+	    const fcf_module_t *);
+	void (*df_case)(dump_out_t *, fcf_view_t *, fcf_secidx_t,
+	    const fcf_case_t *);
+	void (*df_buf)(dump_out_t *, fcf_view_t *, fcf_secidx_t, uint_t,
+	    const fcf_buf_t *);
+	void (*df_buffer)(dump_out_t *, fcf_secidx_t, const uchar_t *, size_t);
+	void (*df_serd)(dump_out_t *, fcf_view_t *, fcf_secidx_t, uint_t,
+	    const fcf_serd_t *);
+	void (*df_event)(dump_out_t *, fcf_secidx_t, uint_t,
+	    const fcf_event_t *);
+	void (*df_nvl)(dump_out_t *, fcf_secidx_t, uint_t, const char *,
+	    size_t);
+} dump_fmt_t;
+
+extern const dump_fmt_t dump_fmt_text;
+extern const dump_fmt_t dump_fmt_json;
+extern const dump_fmt_t dump_fmt_bin;
+
+extern const dump_fmt_t *dump_fmt_lookup(const char *);
+
+extern void out_init(dump_out_t *, FILE *, const dump_fmt_t *);
+extern int out_fini(dump_out_t *);
+extern void out_flush(dump_out_t *);
+
+extern void out_write(dump_out_t *, const void *, size_t);
+extern void out_puts(dump_out_t *, const char *);
+extern void out_u64(dump_out_t *, uint64_t);
+extern void out_x64(dump_out_t *, uint64_t);
+extern void out_printf(dump_out_t *, const char *, ...);
+extern void out_jstr(dump_out_t *, const char *);
+extern void out_varint(dump_out_t *, uint64_t);
+extern void out_blob(dump_out_t *, const void *, size_t);
+extern uint32_t out_atom(dump_out_t *, const fcf_atom_t *);
+
+/*
+ * Append a single character.  This is the hot path for all of the formats,
+ * so it's inlined.
+ */
+static inline void
+out_putc(dump_out_t *o, char c)
+{
+	if (o->do_len == OUT_BUFSZ)
+		out_flush(o);
+	o->do_buf[o->do_len++] = c;
+}
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _OUT_H */
@@ -0,0 +1,487 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+/*
+ * "dump-fmd-ckpt scan" walks a checkpoint directory hierarchy, which fmd lays
+ * out as <root>/<module>/<module>, and decodes every checkpoint in it on a
+ * pool of worker threads.
+ *
+ * Each worker dumps into a private in-memory stream.  The main thread prints
+ * those buffers strictly in pathname order as they complete, so the report is
+ * identical regardless of the number of threads.  To bound memory use, the
+ * workers are never allowed to get more than SCAN_WINDOW files ahead of the
+ * file currently being printed.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <strings.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "dump-fmd-ckpt.h"
+
+#define	SCAN_MAXTHREADS	64
+#define	SCAN_WINDOW(nthr)	((nthr) * 4)
+
+typedef struct scan_file {
+	char *sf_path;			/* pathname of checkpoint */
+	char *sf_buf;			/* dumped output */
+	size_t sf_len;			/* length of sf_buf */
+	int sf_status;			/* result of dump_ckpt() */
+	boolean_t sf_done;		/* sf_buf is ready to be printed */
+} scan_file_t;
+
+typedef struct scan {
+	pthread_mutex_t sc_lock;
+	pthread_cond_t sc_cv;		/* signalled on any progress */
+	scan_file_t *sc_files;		/* files, sorted by pathname */
+	uint_t sc_nfiles;		/* number of files */
+	uint_t sc_alloc;		/* allocated entries in sc_files */
+	uint_t sc_next;			/* next file to hand out */
+	uint_t sc_printed;		/* number of files printed so far */
+	uint_t sc_window;		/* max files decoded ahead */
+	const dump_sel_t *sc_sel;	/* sections to dump */
+	const dump_fmt_t *sc_fmt;	/* output format */
+	fcf_atomtab_t *sc_atoms;	/* strings shared by all files */
+} scan_t;
+
+static int
+scan_add(scan_t *sc, const char *dir, const char *name)
+{
+	scan_file_t *sf;
+
+	if (sc->sc_nfiles == sc->sc_alloc) {
+		uint_t alloc = sc->sc_alloc == 0 ? 64 : sc->sc_alloc * 2;
+
+		if ((sf = realloc(sc->sc_files,
+		    alloc * sizeof (scan_file_t))) == NULL)
+			return (-1);
+		sc->sc_files = sf;
+		sc->sc_alloc = alloc;
+	}
+
+	sf = &sc->sc_files[sc->sc_nfiles];
+	(void) memset(sf, 0, sizeof (scan_file_t));
+	if (asprintf(&sf->sf_path, "%s/%s", dir, name) < 0)
+		return (-1);
+
+	sc->sc_nfiles++;
+	return (0);
+}
+
+/*
+ * Call the callback with the directory and name of every regular file one
+ * level below each module directory under the root.  If the callback returns
+ * nonzero, the walk stops and that value is returned.  The watch subcommand
+ * walks the hierarchy this way too.
+ */
+int
+ckpt_walk(const char *root, int (*func)(const char *, const char *, void *),
+    void *arg)
+{
+	DIR *rdp, *mdp;
+	struct dirent *rdep, *mdep;
+	char mpath[MAXPATHLEN], fpath[MAXPATHLEN];
+	struct stat64 st;
+	int rv = 0;
+
+	if ((rdp = opendir(root)) == NULL) {
+		(void) fprintf(stderr, "failed to open %s (%s)\n", root,
+		    strerror(errno));
+		return (-1);
+	}
+
+	while (rv == 0 && (rdep = readdir(rdp)) != NULL) {
+		if (rdep->d_name[0] == '.')
+			continue;
+
+		if (snprintf(mpath, sizeof (mpath), "%s/%s", root,
+		    rdep->d_name) >= sizeof (mpath)) {
+			(void) fprintf(stderr, "%s/%s: path too long\n", root,
+			    rdep->d_name);
+			continue;
+		}
+		if (stat64(mpath, &st) != 0 || !S_ISDIR(st.st_mode))
+			continue;
+
+		if ((mdp = opendir(mpath)) == NULL) {
+			(void) fprintf(stderr, "failed to open %s (%s)\n",
+			    mpath, strerror(errno));
+			continue;
+		}
+		while (rv == 0 && (mdep = readdir(mdp)) != NULL) {
+			size_t len = strlen(mdep->d_name);
+
+			/*
+			 * fmd writes a new checkpoint to "<module>+" and
+			 * renames it into place once it's complete, so skip
+			 * any such file that we happen to catch in flight.
+			 */
+			if (mdep->d_name[0] == '.' ||
+			    mdep->d_name[len - 1] == '+')
+				continue;
+
+			if (snprintf(fpath, sizeof (fpath), "%s/%s", mpath,
+			    mdep->d_name) >= sizeof (fpath)) {
+				(void) fprintf(stderr, "%s/%s: path too "
+				    "long\n", mpath, mdep->d_name);
+				continue;
+			}
+			if (stat64(fpath, &st) != 0 || !S_ISREG(st.st_mode))
+				continue;
+
+			rv = func(mpath, mdep->d_name, arg);
+		}
+		(void) closedir(mdp);
+	}
+	(void) closedir(rdp);
+
+	return (rv);
+}
+
+typedef struct ckpt_input {
+	ckpt_func_t *ci_func;		/* called for each checkpoint */
+	void *ci_arg;			/* argument to ci_func */
+	int ci_err;			/* a file couldn't be read */
+} ckpt_input_t;
+
+/*
+ * Map a checkpoint file and pass its contents to the callback.  An empty
+ * file is passed as such, for the callback to reject.
+ */
+static int
+ckpt_input_file(ckpt_input_t *ci, const char *path)
+{
+	static const uint64_t empty = 0;
+	struct stat64 st;
+	void *buf;
+	int fd, rv;
+
+	if ((fd = open(path, O_RDONLY)) < 0 || fstat64(fd, &st) != 0) {
+		(void) fprintf(stderr, "failed to open %s (%s)\n", path,
+		    strerror(errno));
+		if (fd >= 0)
+			(void) close(fd);
+		ci->ci_err = -1;
+		return (0);
+	}
+
+	if (st.st_size == 0) {
+		(void) close(fd);
+		return (ci->ci_func(path, &empty, 0, ci->ci_arg));
+	}
+
+	buf = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	(void) close(fd);
+	if (buf == MAP_FAILED) {
+		(void) fprintf(stderr, "failed to map %s (%s)\n", path,
+		    strerror(errno));
+		ci->ci_err = -1;
+		return (0);
+	}
+
+	rv = ci->ci_func(path, buf, st.st_size, ci->ci_arg);
+	(void) munmap(buf, st.st_size);
+	return (rv);
+}
+
+static int
+ckpt_input_cb(const char *dir, const char *name, void *arg)
+{
+	char path[MAXPATHLEN];
+
+	(void) snprintf(path, sizeof (path), "%s/%s", dir, name);
+	return (ckpt_input_file(arg, path));
+}
+
+/*
+ * Call the callback with the contents of every checkpoint that path names:
+ * a checkpoint directory hierarchy, a history store (see history.c), a
+ * single checkpoint or a tar archive, which is read from standard input if
+ * path is "-".  This is how the subcommands that take any mix of these find
+ * their input.  If the callback returns nonzero, the walk stops and that
+ * value is returned; otherwise -1 is returned if anything couldn't be read.
+ */
+int
+ckpt_input(const char *path, ckpt_func_t *func, void *arg)
+{
+	ckpt_input_t ci;
+	struct stat64 st;
+	char magic[FCF_MAG_STRLEN];
+	ssize_t n = 0;
+	int fd, rv;
+
+	if (strcmp(path, "-") == 0)
+		return (tar_walk(path, func, arg));
+
+	if (stat64(path, &st) != 0) {
+		(void) fprintf(stderr, "failed to stat %s (%s)\n", path,
+		    strerror(errno));
+		return (-1);
+	}
+
+	ci.ci_func = func;
+	ci.ci_arg = arg;
+	ci.ci_err = 0;
+
+	if (S_ISDIR(st.st_mode)) {
+		if (hist_is_store(path))
+			return (hist_walk(path, func, arg));
+		rv = ckpt_walk(path, ckpt_input_cb, &ci);
+		return (rv != 0 ? rv : ci.ci_err);
+	}
+
+	if ((fd = open(path, O_RDONLY)) >= 0) {
+		n = read(fd, magic, sizeof (magic));
+		(void) close(fd);
+	}
+	if (n == sizeof (magic) &&
+	    bcmp(magic, FCF_MAG_STRING, FCF_MAG_STRLEN) == 0) {
+		rv = ckpt_input_file(&ci, path);
+		return (rv != 0 ? rv : ci.ci_err);
+	}
+
+	return (tar_walk(path, func, arg));
+}
+
+static int
+scan_collect_cb(const char *dir, const char *name, void *arg)
+{
+	if (scan_add(arg, dir, name) != 0) {
+		(void) fprintf(stderr, "failed to allocate memory\n");
+		return (-1);
+	}
+	return (0);
+}
+
+static int
+scan_file_cmp(const void *l, const void *r)
+{
+	const scan_file_t *lf = l, *rf = r;
+
+	return (strcmp(lf->sf_path, rf->sf_path));
+}
+
+/*
+ * In text mode, errors are reported inline with the file they relate to.  The
+ * structured formats must stay parseable, so errors go to stderr instead.
+ */
+static void
+scan_one(scan_t *sc, scan_file_t *sf)
+{
+	boolean_t text = sc->sc_fmt == &dump_fmt_text;
+	dump_out_t *o;
+	dump_ctx_t dc;
+	FILE *fp;
+
+	if ((o = malloc(sizeof (dump_out_t))) == NULL) {
+		sf->sf_status = -1;
+		return;
+	}
+	if ((fp = open_memstream(&sf->sf_buf, &sf->sf_len)) == NULL) {
+		free(o);
+		sf->sf_status = -1;
+		return;
+	}
+
+	out_init(o, fp, sc->sc_fmt);
+	dc.dc_out = o;
+	dc.dc_err = text ? fp : stderr;
+	dc.dc_sel = sc->sc_sel;
+	dc.dc_atoms = sc->sc_atoms;
+
+	if (text) {
+		out_puts(o, "##########\n");
+		out_puts(o, sf->sf_path);
+		out_puts(o, "\n##########\n");
+	}
+	sf->sf_status = dump_ckpt(&dc, sf->sf_path);
+	if (text)
+		out_putc(o, '\n');
+	if (out_fini(o) != 0)
+		sf->sf_status = -1;
+	(void) fclose(fp);
+	free(o);
+}
+
+static void *
+scan_worker(void *arg)
+{
+	scan_t *sc = arg;
+	scan_file_t *sf;
+
+	(void) pthread_mutex_lock(&sc->sc_lock);
+	for (;;) {
+		while (sc->sc_next < sc->sc_nfiles &&
+		    sc->sc_next >= sc->sc_printed + sc->sc_window)
+			(void) pthread_cond_wait(&sc->sc_cv, &sc->sc_lock);
+
+		if (sc->sc_next == sc->sc_nfiles)
+			break;
+
+		sf = &sc->sc_files[sc->sc_next++];
+		(void) pthread_mutex_unlock(&sc->sc_lock);
+
+		scan_one(sc, sf);
+
+		(void) pthread_mutex_lock(&sc->sc_lock);
+		sf->sf_done = B_TRUE;
+		(void) pthread_cond_broadcast(&sc->sc_cv);
+	}
+	(void) pthread_mutex_unlock(&sc->sc_lock);
+
+	return (NULL);
+}
+
+static void
+scan_usage(void)
+{
+	(void) fprintf(stderr, "usage: %s scan [-j nthreads] [-o format] "
+	    "[-s secidx[,...]] [-t type[,...]] [root]\n\n"
+	    "root defaults to %s\n\n", pname, CKPT_DEFROOT);
+}
+
+int
+do_scan(int argc, char **argv)
+{
+	scan_t sc = { 0 };
+	dump_sel_t sel = { 0 };
+	pthread_t *tids = NULL;
+	const char *root = CKPT_DEFROOT;
+	long nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+	uint_t i, nfailed = 0;
+	char *end;
+	int c, err, status = 1;
+
+	sc.sc_fmt = &dump_fmt_text;
+
+	while ((c = getopt(argc, argv, "j:o:s:t:")) != -1) {
+		switch (c) {
+		case 'j':
+			errno = 0;
+			nthreads = strtol(optarg, &end, 10);
+			if (errno != 0 || *end != '\0' || nthreads < 1) {
+				(void) fprintf(stderr, "invalid thread count: "
+				    "%s\n", optarg);
+				return (2);
+			}
+			break;
+		case 'o':
+			if ((sc.sc_fmt = parse_fmt(optarg)) == NULL)
+				return (2);
+			break;
+		case 's':
+			if (parse_secs(optarg, &sel) != 0)
+				return (2);
+			break;
+		case 't':
+			if (parse_types(optarg, &sel) != 0)
+				return (2);
+			break;
+		default:
+			scan_usage();
+			return (2);
+		}
+	}
+
+	if (argc - optind > 1) {
+		scan_usage();
+		return (2);
+	}
+	if (argc - optind == 1)
+		root = argv[optind];
+
+	if (ckpt_walk(root, scan_collect_cb, &sc) != 0)
+		goto out;
+	qsort(sc.sc_files, sc.sc_nfiles, sizeof (scan_file_t), scan_file_cmp);
+
+	if (nthreads < 1)
+		nthreads = 1;
+	if (nthreads > SCAN_MAXTHREADS)
+		nthreads = SCAN_MAXTHREADS;
+	if (nthreads > sc.sc_nfiles)
+		nthreads = sc.sc_nfiles == 0 ? 1 : sc.sc_nfiles;
+
+	(void) pthread_mutex_init(&sc.sc_lock, NULL);
+	(void) pthread_cond_init(&sc.sc_cv, NULL);
+	sc.sc_window = SCAN_WINDOW(nthreads);
+	sc.sc_sel = &sel;
+
+	if ((sc.sc_atoms = fcf_atomtab_create()) == NULL ||
+	    (tids = calloc(nthreads, sizeof (pthread_t))) == NULL) {
+		(void) fprintf(stderr, "failed to allocate memory\n");
+		goto out;
+	}
+	for (i = 0; i < nthreads; i++) {
+		if ((err = pthread_create(&tids[i], NULL, scan_worker,
+		    &sc)) != 0) {
+			(void) fprintf(stderr, "failed to create worker "
+			    "thread (%s)\n", strerror(err));
+			nthreads = i;
+			break;
+		}
+	}
+
+	/*
+	 * Print each file's output as soon as it and everything before it
+	 * has been decoded.  If we couldn't create a single worker, the main
+	 * thread does the decoding itself.
+	 */
+	for (i = 0; i < sc.sc_nfiles; i++) {
+		scan_file_t *sf = &sc.sc_files[i];
+
+		if (nthreads == 0) {
+			sc.sc_next++;
+			scan_one(&sc, sf);
+		} else {
+			(void) pthread_mutex_lock(&sc.sc_lock);
+			while (!sf->sf_done)
+				(void) pthread_cond_wait(&sc.sc_cv,
+				    &sc.sc_lock);
+			(void) pthread_mutex_unlock(&sc.sc_lock);
+		}
+
+		if (sf->sf_buf != NULL)
+			(void) fwrite(sf->sf_buf, 1, sf->sf_len, stdout);
+		if (sf->sf_status != 0)
+			nfailed++;
+		free(sf->sf_buf);
+		sf->sf_buf = NULL;
+
+		(void) pthread_mutex_lock(&sc.sc_lock);
+		sc.sc_printed++;
+		(void) pthread_cond_broadcast(&sc.sc_cv);
+		(void) pthread_mutex_unlock(&sc.sc_lock);
+	}
+
+	for (i = 0; i < nthreads; i++)
+		(void) pthread_join(tids[i], NULL);
+
+	(void) fprintf(sc.sc_fmt == &dump_fmt_text ? stdout : stderr,
+	    "%u checkpoint files scanned under %s, %u failed, "
+	    "%u distinct strings\n", sc.sc_nfiles, root, nfailed,
+	    fcf_atomtab_count(sc.sc_atoms));
+	status = nfailed == 0 ? 0 : 1;
+
+out:
+	for (i = 0; i < sc.sc_nfiles; i++)
+		free(sc.sc_files[i].sf_path);
+	free(sc.sc_files);
+	free(tids);
+	fcf_atomtab_destroy(sc.sc_atoms);
+
+	return (status);
+}
@@ -0,0 +1,682 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+/*
+ * "dump-fmd-ckpt serd" replays the events recorded by SERD engines through
+ * an evaluator that behaves like fmd's, once for each of a grid of N and T
+ * values, to show how often each engine would have fired had it been tuned
+ * differently.
+ *
+ * A checkpoint only holds the events that an engine has seen since it last
+ * fired, so the events of each engine are collected from every checkpoint
+ * given, keyed by module and engine name, and the same event seen in several
+ * checkpoints is only counted once.  The best input is a history store (see
+ * history.c), which holds every generation of every checkpoint and so every
+ * event that any engine has held.
+ *
+ * fmd's engine fires when it has seen more than N events and the oldest of
+ * the last N + 1 is at most T before the newest.  The evaluator assumes that
+ * the module resets the engine as soon as it fires, as the diagnosis engines
+ * do, so the count of firings is the number of diagnoses that would have
+ * been made.  With the events sorted by time, this is a single pass over
+ * them with no state but the index of the first event since the last reset.
+ * The variants are spread over a pool of threads.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/param.h>
+#include <sys/types.h>
+
+#include "dump-fmd-ckpt.h"
+
+#define	SERD_MAXTHREADS	64
+#define	SERD_MAXVALS	256	/* values of N or T in a sweep */
+#define	SERD_NSEC	1000000000ULL
+
+/*
+ * A recorded event.  fmd doesn't give events an identity, so two events are
+ * taken to be the same if they agree on every field.
+ */
+typedef struct serd_ev {
+	uint64_t sv_tod;		/* time of day in ns */
+	uint64_t sv_inode;		/* inode of log */
+	uint64_t sv_offset;		/* offset in log */
+	uint32_t sv_major;		/* major of log device */
+	uint32_t sv_minor;		/* minor of log device */
+} serd_ev_t;
+
+typedef struct serd_eng {
+	const fcf_atom_t *se_module;	/* module name */
+	const fcf_atom_t *se_name;	/* engine name */
+	uint32_t se_n;			/* N as last recorded */
+	uint64_t se_t;			/* T as last recorded */
+	uint_t se_nrecs;		/* records of the engine seen */
+	boolean_t se_varied;		/* N or T changed between files */
+	serd_ev_t *se_evs;		/* events */
+	size_t se_nevs;			/* number of entries in se_evs */
+	size_t se_aevs;			/* allocated entries in se_evs */
+	uint64_t *se_tods;		/* sorted distinct event times */
+	size_t se_ntods;		/* number of entries in se_tods */
+	uint_t se_job;			/* index of first variant in s_res */
+} serd_eng_t;
+
+/*
+ * The outcome of replaying one engine's events with one N and T.
+ */
+typedef struct serd_res {
+	serd_eng_t *sr_eng;		/* engine */
+	uint32_t sr_n;			/* N */
+	uint64_t sr_t;			/* T in ns */
+	uint64_t sr_fires;		/* number of times it fired */
+	uint64_t sr_first;		/* time of first firing */
+} serd_res_t;
+
+typedef struct serd {
+	fcf_atomtab_t *s_atoms;		/* module and engine names */
+	serd_eng_t *s_engs;		/* engines */
+	uint_t s_nengs;			/* number of engines */
+	uint_t s_aengs;			/* allocated entries in s_engs */
+	uint_t s_nfiles;		/* checkpoints read */
+	uint_t s_nfailed;		/* checkpoints with errors */
+	boolean_t s_nomem;		/* an allocation failed */
+	uint32_t s_ns[SERD_MAXVALS];	/* values of N to try */
+	uint_t s_nns;			/* number of entries in s_ns */
+	uint64_t s_ts[SERD_MAXVALS];	/* values of T to try */
+	uint_t s_nts;			/* number of entries in s_ts */
+	serd_res_t *s_res;		/* results */
+	uint_t s_nres;			/* number of entries in s_res */
+	pthread_mutex_t s_lock;
+	uint_t s_next;			/* next result to compute */
+} serd_t;
+
+/*
+ * Units of time, largest first.  A bare number is in nanoseconds, as fmd's
+ * own time properties are.
+ */
+static const struct {
+	const char *su_name;
+	uint64_t su_mul;
+} serd_units[] = {
+	{ "d", 86400 * SERD_NSEC },
+	{ "h", 3600 * SERD_NSEC },
+	{ "m", 60 * SERD_NSEC },
+	{ "s", SERD_NSEC },
+	{ "ms", 1000000 },
+	{ "us", 1000 },
+	{ "ns", 1 },
+	{ "", 1 },
+	{ NULL, 0 }
+};
+
+static serd_eng_t *
+serd_eng(serd_t *s, const fcf_atom_t *module, const fcf_atom_t *name)
+{
+	serd_eng_t *se;
+	uint_t i;
+
+	for (i = 0; i < s->s_nengs; i++) {
+		se = &s->s_engs[i];
+		if (se->se_module == module && se->se_name == name)
+			return (se);
+	}
+
+	if (s->s_nengs == s->s_aengs) {
+		uint_t alloc = s->s_aengs == 0 ? 16 : s->s_aengs * 2;
+
+		if ((se = realloc(s->s_engs,
+		    alloc * sizeof (serd_eng_t))) == NULL)
+			return (NULL);
+		s->s_engs = se;
+		s->s_aengs = alloc;
+	}
+
+	se = &s->s_engs[s->s_nengs++];
+	(void) memset(se, 0, sizeof (serd_eng_t));
+	se->se_module = module;
+	se->se_name = name;
+	return (se);
+}
+
+static const fcf_atom_t *
+serd_atom(serd_t *s, fcf_view_t *fv, fcf_stridx_t idx)
+{
+	const fcf_atom_t *fa;
+
+	if ((fa = fcf_view_atom(fv, idx)) == NULL)
+		fa = fcf_atom_intern(s->s_atoms, "?", 1);
+	return (fa);
+}
+
+/*
+ * Add the events of one SERD engine record to those of the engine.
+ */
+static int
+serd_rec(serd_t *s, fcf_view_t *fv, const fcf_atom_t *module,
+    const fcf_serd_t *sgp)
+{
+	const fcf_event_t *fe;
+	const fcf_atom_t *name;
+	serd_eng_t *se;
+	serd_ev_t *sv;
+	uint_t i, n = 0;
+
+	if (sgp->fcfd_events != FCF_SECIDX_NONE &&
+	    fcf_view_nrecs(fv, sgp->fcfd_events, FCF_SECT_EVENTS,
+	    sizeof (fcf_event_t), &n) != 0)
+		return (-1);
+
+	if (module == NULL || (name = serd_atom(s, fv,
+	    sgp->fcfd_name)) == NULL || (se = serd_eng(s, module,
+	    name)) == NULL) {
+		s->s_nomem = B_TRUE;
+		return (-1);
+	}
+	if (se->se_nrecs++ != 0 &&
+	    (se->se_n != sgp->fcfd_n || se->se_t != sgp->fcfd_t))
+		se->se_varied = B_TRUE;
+	se->se_n = sgp->fcfd_n;
+	se->se_t = sgp->fcfd_t;
+
+	if (se->se_nevs + n > se->se_aevs) {
+		size_t alloc = se->se_aevs == 0 ? 64 : se->se_aevs * 2;
+
+		while (alloc < se->se_nevs + n)
+			alloc *= 2;
+		if ((sv = realloc(se->se_evs,
+		    alloc * sizeof (serd_ev_t))) == NULL) {
+			s->s_nomem = B_TRUE;
+			return (-1);
+		}
+		se->se_evs = sv;
+		se->se_aevs = alloc;
+	}
+
+	for (i = 0; i < n; i++) {
+		fe = fcf_view_rec(fv, sgp->fcfd_events, FCF_SECT_EVENTS,
+		    sizeof (fcf_event_t), i);
+		sv = &se->se_evs[se->se_nevs++];
+		sv->sv_tod = fe->fcfe_todsec * SERD_NSEC + fe->fcfe_todnsec;
+		sv->sv_inode = fe->fcfe_inode;
+		sv->sv_offset = fe->fcfe_offset;
+		sv->sv_major = fe->fcfe_major;
+		sv->sv_minor = fe->fcfe_minor;
+	}
+	return (0);
+}
+
+static int
+serd_view(serd_t *s, fcf_view_t *fv)
+{
+	const fcf_module_t *mp;
+	const fcf_atom_t *module = NULL;
+	const fcf_serd_t *sgp;
+	fcf_secidx_t i;
+	uint_t j, n;
+	int rv = 0;
+
+	if (fcf_view_strings(fv, s->s_atoms) != 0)
+		return (-1);
+
+	for (i = 0; i < fv->fv_secnum && module == NULL; i++) {
+		if (fcf_view_sec(fv, i)->fcfs_type != FCF_SECT_MODULE)
+			continue;
+		if ((mp = fcf_view_rec(fv, i, FCF_SECT_MODULE,
+		    sizeof (fcf_module_t), 0)) == NULL)
+			return (-1);
+		module = serd_atom(s, fv, mp->fcfm_name);
+	}
+	if (module == NULL)
+		module = fcf_atom_intern(s->s_atoms, "?", 1);
+
+	for (i = 0; i < fv->fv_secnum && !s->s_nomem; i++) {
+		if (fcf_view_sec(fv, i)->fcfs_type != FCF_SECT_SERD)
+			continue;
+		if (fcf_view_nrecs(fv, i, FCF_SECT_SERD, sizeof (fcf_serd_t),
+		    &n) != 0) {
+			rv = -1;
+			continue;
+		}
+		for (j = 0; j < n; j++) {
+			sgp = fcf_view_rec(fv, i, FCF_SECT_SERD,
+			    sizeof (fcf_serd_t), j);
+			if (serd_rec(s, fv, module, sgp) != 0)
+				rv = -1;
+		}
+	}
+	return (rv);
+}
+
+static int
+serd_ckpt_cb(const char *path, const void *buf, size_t size, void *arg)
+{
+	serd_t *s = arg;
+	fcf_view_t fv;
+	int rv;
+
+	if ((rv = fcf_view_open_mem(&fv, path, buf, size)) == 0)
+		rv = serd_view(s, &fv);
+	s->s_nfiles++;
+	if (rv != 0 && !s->s_nomem) {
+		(void) fprintf(stderr, "%s\n", fv.fv_errmsg);
+		s->s_nfailed++;
+	}
+	fcf_view_close(&fv);
+	return (s->s_nomem ? -1 : 0);
+}
+
+static int
+serd_ev_cmp(const void *l, const void *r)
+{
+	const serd_ev_t *lv = l, *rv = r;
+
+	if (lv->sv_tod != rv->sv_tod)
+		return (lv->sv_tod < rv->sv_tod ? -1 : 1);
+	if (lv->sv_inode != rv->sv_inode)
+		return (lv->sv_inode < rv->sv_inode ? -1 : 1);
+	if (lv->sv_offset != rv->sv_offset)
+		return (lv->sv_offset < rv->sv_offset ? -1 : 1);
+	if (lv->sv_major != rv->sv_major)
+		return (lv->sv_major < rv->sv_major ? -1 : 1);
+	if (lv->sv_minor != rv->sv_minor)
+		return (lv->sv_minor < rv->sv_minor ? -1 : 1);
+	return (0);
+}
+
+static int
+serd_eng_cmp(const void *l, const void *r)
+{
+	const serd_eng_t *le = l, *re = r;
+	int c;
+
+	if ((c = strcmp(le->se_module->fa_str, re->se_module->fa_str)) != 0)
+		return (c);
+	return (strcmp(le->se_name->fa_str, re->se_name->fa_str));
+}
+
+/*
+ * Sort each engine's events by time and boil them down to the times of the
+ * distinct ones, which is all that the evaluator needs.
+ */
+static int
+serd_prepare(serd_t *s)
+{
+	serd_eng_t *se;
+	uint_t i;
+	size_t j;
+
+	for (i = 0; i < s->s_nengs; i++) {
+		se = &s->s_engs[i];
+		qsort(se->se_evs, se->se_nevs, sizeof (serd_ev_t),
+		    serd_ev_cmp);
+		if ((se->se_tods = malloc((se->se_nevs + 1) *
+		    sizeof (uint64_t))) == NULL)
+			return (-1);
+		for (j = 0; j < se->se_nevs; j++) {
+			if (j > 0 && serd_ev_cmp(&se->se_evs[j - 1],
+			    &se->se_evs[j]) == 0)
+				continue;
+			se->se_tods[se->se_ntods++] = se->se_evs[j].sv_tod;
+		}
+		free(se->se_evs);
+		se->se_evs = NULL;
+	}
+	qsort(s->s_engs, s->s_nengs, sizeof (serd_eng_t), serd_eng_cmp);
+	return (0);
+}
+
+/*
+ * Replay sorted event times through an engine with the given N and T,
+ * resetting it each time it fires.
+ */
+static void
+serd_eval(serd_res_t *sr)
+{
+	const uint64_t *tod = sr->sr_eng->se_tods;
+	size_t i, base = 0, n = sr->sr_eng->se_ntods;
+	uint64_t fires = 0;
+
+	sr->sr_first = 0;
+	for (i = 0; i < n; i++) {
+		if (i - base >= sr->sr_n &&
+		    tod[i] - tod[i - sr->sr_n] <= sr->sr_t) {
+			if (fires++ == 0)
+				sr->sr_first = tod[i];
+			base = i + 1;
+		}
+	}
+	sr->sr_fires = fires;
+}
+
+#define	SERD_CHUNK	64	/* variants handed to a worker at a time */
+
+static void *
+serd_worker(void *arg)
+{
+	serd_t *s = arg;
+	uint_t i, end;
+
+	for (;;) {
+		(void) pthread_mutex_lock(&s->s_lock);
+		i = s->s_next;
+		end = s->s_next = MIN(s->s_nres, i + SERD_CHUNK);
+		(void) pthread_mutex_unlock(&s->s_lock);
+
+		if (i == end)
+			break;
+		for (; i < end; i++)
+			serd_eval(&s->s_res[i]);
+	}
+	return (NULL);
+}
+
+/*
+ * Lay out a result for every engine and every combination of N and T.  An
+ * engine's recorded N or T is used where no values were given to try.
+ */
+static int
+serd_jobs(serd_t *s)
+{
+	serd_eng_t *se;
+	serd_res_t *sr;
+	uint_t i, j, k, nn, nt, n = 0;
+
+	for (i = 0; i < s->s_nengs; i++) {
+		nn = s->s_nns == 0 ? 1 : s->s_nns;
+		nt = s->s_nts == 0 ? 1 : s->s_nts;
+		n += nn * nt;
+	}
+	if (n != 0 && (s->s_res = calloc(n, sizeof (serd_res_t))) == NULL)
+		return (-1);
+
+	for (i = 0, sr = s->s_res; i < s->s_nengs; i++) {
+		se = &s->s_engs[i];
+		se->se_job = (uint_t)(sr - s->s_res);
+		nn = s->s_nns == 0 ? 1 : s->s_nns;
+		nt = s->s_nts == 0 ? 1 : s->s_nts;
+		for (j = 0; j < nn; j++) {
+			for (k = 0; k < nt; k++, sr++) {
+				sr->sr_eng = se;
+				sr->sr_n = s->s_nns == 0 ? se->se_n :
+				    s->s_ns[j];
+				sr->sr_t = s->s_nts == 0 ? se->se_t :
+				    s->s_ts[k];
+			}
+		}
+	}
+	s->s_nres = n;
+	return (0);
+}
+
+static void
+serd_fmt_time(char *buf, size_t len, uint64_t ns)
+{
+	uint_t i;
+
+	for (i = 0; serd_units[i + 1].su_name[0] != '\0'; i++) {
+		if (ns != 0 && ns % serd_units[i].su_mul == 0)
+			break;
+	}
+	(void) snprintf(buf, len, "%llu%s",
+	    (u_longlong_t)(ns / serd_units[i].su_mul), serd_units[i].su_name);
+}
+
+static void
+serd_fmt_tod(char *buf, size_t len, uint64_t ns)
+{
+	struct tm tm;
+	time_t t = (time_t)(ns / SERD_NSEC);
+
+	if (gmtime_r(&t, &tm) == NULL ||
+	    strftime(buf, len, "%Y-%m-%dT%H:%M:%SZ", &tm) == 0)
+		(void) strlcpy(buf, "?", len);
+}
+
+static void
+serd_report(serd_t *s)
+{
+	char first[32], last[32], t[32];
+	serd_eng_t *se;
+	serd_res_t *sr, *end;
+	uint_t i;
+
+	for (i = 0; i < s->s_nengs; i++) {
+		se = &s->s_engs[i];
+		serd_fmt_time(t, sizeof (t), se->se_t);
+		(void) printf("%s%s/%s: N=%u T=%s%s, %llu events",
+		    i == 0 ? "" : "\n", se->se_module->fa_str,
+		    se->se_name->fa_str, se->se_n, t,
+		    se->se_varied ? " (varied)" : "",
+		    (u_longlong_t)se->se_ntods);
+		if (se->se_ntods != 0) {
+			serd_fmt_tod(first, sizeof (first), se->se_tods[0]);
+			serd_fmt_tod(last, sizeof (last),
+			    se->se_tods[se->se_ntods - 1]);
+			(void) printf(" from %s to %s", first, last);
+		}
+		(void) printf("\n  %10s %10s %8s  %s\n", "N", "T", "FIRES",
+		    "FIRST");
+
+		end = i + 1 < s->s_nengs ? &s->s_res[s->s_engs[i + 1].se_job] :
+		    &s->s_res[s->s_nres];
+		for (sr = &s->s_res[se->se_job]; sr < end; sr++) {
+			serd_fmt_time(t, sizeof (t), sr->sr_t);
+			if (sr->sr_fires != 0)
+				serd_fmt_tod(first, sizeof (first),
+				    sr->sr_first);
+			else
+				(void) strlcpy(first, "-", sizeof (first));
+			(void) printf("%c %10u %10s %8llu  %s\n",
+			    sr->sr_n == se->se_n && sr->sr_t == se->se_t ?
+			    '*' : ' ', sr->sr_n, t,
+			    (u_longlong_t)sr->sr_fires, first);
+		}
+	}
+}
+
+/*
+ * Parse a comma-separated list of counts, each of which may be a range.
+ */
+static int
+serd_parse_ns(serd_t *s, char *arg)
+{
+	char *p, *q, *end;
+	unsigned long lo, hi;
+
+	for (p = strtok_r(arg, ",", &q); p != NULL;
+	    p = strtok_r(NULL, ",", &q)) {
+		errno = 0;
+		lo = hi = strtoul(p, &end, 10);
+		if (errno == 0 && end != p && *end == '-')
+			hi = strtoul(end + 1, &end, 10);
+		if (errno != 0 || end == p || *end != '\0' || hi < lo ||
+		    hi > UINT32_MAX) {
+			(void) fprintf(stderr, "invalid count: %s\n", p);
+			return (-1);
+		}
+		for (; lo <= hi; lo++) {
+			if (s->s_nns == SERD_MAXVALS) {
+				(void) fprintf(stderr, "too many values of "
+				    "N (max %u)\n", SERD_MAXVALS);
+				return (-1);
+			}
+			s->s_ns[s->s_nns++] = (uint32_t)lo;
+		}
+	}
+	return (0);
+}
+
+/*
+ * Parse a comma-separated list of times, each a number followed by one of
+ * the units in serd_units.
+ */
+static int
+serd_parse_ts(serd_t *s, char *arg)
+{
+	char *p, *q, *end;
+	u_longlong_t v;
+	uint_t i;
+
+	for (p = strtok_r(arg, ",", &q); p != NULL;
+	    p = strtok_r(NULL, ",", &q)) {
+		errno = 0;
+		v = strtoull(p, &end, 10);
+		for (i = 0; serd_units[i].su_name != NULL; i++) {
+			if (strcmp(end, serd_units[i].su_name) == 0)
+				break;
+		}
+		if (errno != 0 || end == p || serd_units[i].su_name == NULL ||
+		    v > UINT64_MAX / serd_units[i].su_mul) {
+			(void) fprintf(stderr, "invalid time: %s\n", p);
+			return (-1);
+		}
+		if (s->s_nts == SERD_MAXVALS) {
+			(void) fprintf(stderr, "too many values of T (max "
+			    "%u)\n", SERD_MAXVALS);
+			return (-1);
+		}
+		s->s_ts[s->s_nts++] = v * serd_units[i].su_mul;
+	}
+	return (0);
+}
+
+static void
+serd_usage(void)
+{
+	(void) fprintf(stderr, "usage: %s serd [-j nthreads] [-n N[,...]] "
+	    "[-t T[,...]]\n"
+	    "           [root | store | archive | ckpt file] ...\n\n"
+	    "N may be a range (lo-hi); T takes a d, h, m, s, ms, us or ns "
+	    "suffix\n"
+	    "root defaults to %s\n\n", pname, CKPT_DEFROOT);
+}
+
+static double
+serd_now(void)
+{
+	struct timespec ts;
+
+	(void) clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((double)ts.tv_sec + (double)ts.tv_nsec / 1e9);
+}
+
+int
+do_serd(int argc, char **argv)
+{
+	static char *defroot[] = { CKPT_DEFROOT };
+	serd_t s;
+	pthread_t *tids = NULL;
+	long nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+	char **args, *end;
+	double start, ms;
+	uint64_t nevs = 0;
+	uint_t j;
+	int c, i, err, nargs, rv = 0;
+
+	(void) memset(&s, 0, sizeof (s));
+	while ((c = getopt(argc, argv, "j:n:t:")) != -1) {
+		switch (c) {
+		case 'j':
+			errno = 0;
+			nthreads = strtol(optarg, &end, 10);
+			if (errno != 0 || *end != '\0' || nthreads < 1) {
+				(void) fprintf(stderr, "invalid thread count: "
+				    "%s\n", optarg);
+				return (2);
+			}
+			break;
+		case 'n':
+			if (serd_parse_ns(&s, optarg) != 0)
+				return (2);
+			break;
+		case 't':
+			if (serd_parse_ts(&s, optarg) != 0)
+				return (2);
+			break;
+		default:
+			serd_usage();
+			return (2);
+		}
+	}
+
+	args = argv + optind;
+	nargs = argc - optind;
+	if (nargs == 0) {
+		args = defroot;
+		nargs = 1;
+	}
+
+	if ((s.s_atoms = fcf_atomtab_create()) == NULL) {
+		(void) fprintf(stderr, "failed to allocate memory\n");
+		return (1);
+	}
+
+	for (i = 0; i < nargs && !s.s_nomem; i++) {
+		if (ckpt_input(args[i], serd_ckpt_cb, &s) != 0)
+			rv = 1;
+	}
+	if (s.s_nomem || serd_prepare(&s) != 0 || serd_jobs(&s) != 0) {
+		(void) fprintf(stderr, "failed to allocate memory\n");
+		rv = 1;
+		goto out;
+	}
+
+	if (nthreads > SERD_MAXTHREADS)
+		nthreads = SERD_MAXTHREADS;
+	if (nthreads > s.s_nres / SERD_CHUNK + 1)
+		nthreads = s.s_nres / SERD_CHUNK + 1;
+	if ((tids = calloc(nthreads, sizeof (pthread_t))) == NULL) {
+		(void) fprintf(stderr, "failed to allocate memory\n");
+		rv = 1;
+		goto out;
+	}
+	(void) pthread_mutex_init(&s.s_lock, NULL);
+
+	/*
+	 * If no worker can be created, the main thread does all the work.
+	 */
+	start = serd_now();
+	for (i = 0; i < nthreads; i++) {
+		if ((err = pthread_create(&tids[i], NULL, serd_worker,
+		    &s)) != 0) {
+			(void) fprintf(stderr, "failed to create worker "
+			    "thread (%s)\n", strerror(err));
+			break;
+		}
+	}
+	if (i == 0)
+		(void) serd_worker(&s);
+	while (--i >= 0)
+		(void) pthread_join(tids[i], NULL);
+	ms = (serd_now() - start) * 1000;
+
+	serd_report(&s);
+	for (j = 0; j < s.s_nengs; j++)
+		nevs += s.s_engs[j].se_ntods;
+	(void) printf("%s%u checkpoints read, %u failed: %u SERD engines, "
+	    "%llu events, %u variants evaluated in %.3f ms\n",
+	    s.s_nengs == 0 ? "" : "\n", s.s_nfiles, s.s_nfailed, s.s_nengs,
+	    (u_longlong_t)nevs, s.s_nres, ms);
+	if (s.s_nfailed != 0)
+		rv = 1;
+
+out:
+	for (j = 0; j < s.s_nengs; j++) {
+		free(s.s_engs[j].se_evs);
+		free(s.s_engs[j].se_tods);
+	}
+	free(s.s_engs);
+	free(s.s_res);
+	free(tids);
+	fcf_atomtab_destroy(s.s_atoms);
+	return (rv);
+}
@@ -0,0 +1,582 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+/*
+ * "dump-fmd-ckpt tar" decodes the checkpoints in tar archives, such as the
+ * support bundles that carry a copy of /var/fm/fmd/ckpt, without extracting
+ * anything.
+ *
+ * The archive is read as a stream through zlib, which passes uncompressed
+ * input through as-is, so plain and gzip'd archives (and pipes) are handled
+ * alike.  Each member is identified by its first block: one that starts with
+ * the FCF magic number is read into memory and decoded from there, and any
+ * other member is skipped over as it goes by.  Only one member is held in
+ * memory at a time.
+ *
+ * ustar archives are understood, along with the GNU long name and POSIX pax
+ * extensions that tar(1) uses for long pathnames and large files.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <zlib.h>
+
+#include "dump-fmd-ckpt.h"
+
+#define	TAR_BLOCKSZ	512
+#define	TAR_CHUNK	(1024 * 1024)		/* most to gzread() at once */
+#define	TAR_MAXMETA	(1024 * 1024)		/* largest long name or pax */
+
+/*
+ * A ustar header block.  All of the numeric fields are octal strings, except
+ * that GNU tar uses a base-256 encoding for sizes too large for size[].
+ */
+typedef struct tar_hdr {
+	char th_name[100];
+	char th_mode[8];
+	char th_uid[8];
+	char th_gid[8];
+	char th_size[12];
+	char th_mtime[12];
+	char th_chksum[8];
+	char th_typeflag;
+	char th_linkname[100];
+	char th_magic[6];
+	char th_version[2];
+	char th_uname[32];
+	char th_gname[32];
+	char th_devmajor[8];
+	char th_devminor[8];
+	char th_prefix[155];
+	char th_pad[12];
+} tar_hdr_t;
+
+typedef struct tar {
+	gzFile t_gz;			/* archive being read */
+	const char *t_archive;		/* name of archive */
+	uint64_t t_off;			/* offset of next byte in archive */
+	uint64_t *t_buf;		/* current member's data */
+	size_t t_alloc;			/* bytes allocated for t_buf */
+	char *t_name;			/* long name for next member, if any */
+	uint64_t t_size;		/* pax size for next member */
+	boolean_t t_havesize;		/* t_size is valid */
+	ckpt_func_t *t_func;		/* called for each checkpoint */
+	void *t_arg;			/* argument to t_func */
+} tar_t;
+
+/*
+ * State of the tar subcommand.
+ */
+typedef struct tar_dump {
+	dump_ctx_t *td_dc;		/* where decoded output goes */
+	boolean_t td_text;		/* output is text */
+	uint_t td_nckpts;		/* checkpoints decoded */
+	uint_t td_nfailed;		/* checkpoints that failed to decode */
+} tar_dump_t;
+
+static void
+tar_error(tar_t *t, const char *msg)
+{
+	int err;
+	const char *zmsg = gzerror(t->t_gz, &err);
+
+	if (err == Z_ERRNO)
+		zmsg = strerror(errno);
+	else if (err == Z_OK)
+		zmsg = "unexpected end of archive";
+
+	(void) fprintf(stderr, "%s: %s at offset %llu (%s)\n", t->t_archive,
+	    msg, (u_longlong_t)t->t_off, zmsg);
+}
+
+/*
+ * Read exactly len bytes, or fail.
+ */
+static int
+tar_read(tar_t *t, void *buf, size_t len)
+{
+	char *p = buf;
+	size_t n;
+	int rv;
+
+	while (len != 0) {
+		n = len < TAR_CHUNK ? len : TAR_CHUNK;
+		if ((rv = gzread(t->t_gz, p, (unsigned)n)) <= 0)
+			return (-1);
+		p += rv;
+		len -= (size_t)rv;
+		t->t_off += (uint64_t)rv;
+	}
+	return (0);
+}
+
+static int
+tar_skip(tar_t *t, uint64_t len)
+{
+	char buf[64 * 1024];
+	size_t n;
+
+	while (len != 0) {
+		n = len < sizeof (buf) ? (size_t)len : sizeof (buf);
+		if (tar_read(t, buf, n) != 0)
+			return (-1);
+		len -= n;
+	}
+	return (0);
+}
+
+/*
+ * Make room for a member of len bytes.  The buffer is 64-bit aligned, which
+ * is what fcf_view_open_mem() needs.
+ */
+static int
+tar_grow(tar_t *t, size_t len)
+{
+	void *buf;
+
+	if (len <= t->t_alloc)
+		return (0);
+	if ((buf = realloc(t->t_buf, P2ROUNDUP(len, TAR_BLOCKSZ))) == NULL) {
+		(void) fprintf(stderr, "failed to allocate memory\n");
+		return (-1);
+	}
+	t->t_buf = buf;
+	t->t_alloc = P2ROUNDUP(len, TAR_BLOCKSZ);
+	return (0);
+}
+
+static boolean_t
+tar_zero(const tar_hdr_t *th)
+{
+	const uchar_t *p = (const uchar_t *)th;
+	size_t i;
+
+	for (i = 0; i < sizeof (tar_hdr_t); i++) {
+		if (p[i] != 0)
+			return (B_FALSE);
+	}
+	return (B_TRUE);
+}
+
+static int
+tar_num(const char *field, size_t len, uint64_t *vp)
+{
+	const uchar_t *p = (const uchar_t *)field;
+	uint64_t v = 0;
+	size_t i = 0;
+
+	/*
+	 * Base-256: the first byte has its high bit set and the rest of the
+	 * field is a big-endian number.
+	 */
+	if (p[0] & 0x80) {
+		v = p[0] & 0x7f;
+		for (i = 1; i < len; i++) {
+			if (v > (UINT64_MAX >> 8))
+				return (-1);
+			v = (v << 8) | p[i];
+		}
+		*vp = v;
+		return (0);
+	}
+
+	while (i < len && (p[i] == ' ' || p[i] == '\0'))
+		i++;
+	for (; i < len && p[i] >= '0' && p[i] <= '7'; i++) {
+		if (v > (UINT64_MAX >> 3))
+			return (-1);
+		v = (v << 3) | (p[i] - '0');
+	}
+	if (i < len && p[i] != ' ' && p[i] != '\0')
+		return (-1);
+
+	*vp = v;
+	return (0);
+}
+
+/*
+ * The checksum is the sum of the header's bytes with the checksum field
+ * taken to be spaces.  Some old tars summed signed chars, so accept either.
+ */
+static boolean_t
+tar_cksum_ok(const tar_hdr_t *th)
+{
+	const uchar_t *p = (const uchar_t *)th;
+	uint64_t want;
+	uint32_t usum = 0;
+	int32_t ssum = 0;
+	size_t i, off = offsetof(tar_hdr_t, th_chksum);
+
+	if (tar_num(th->th_chksum, sizeof (th->th_chksum), &want) != 0)
+		return (B_FALSE);
+
+	for (i = 0; i < sizeof (tar_hdr_t); i++) {
+		uchar_t c = (i >= off && i < off + sizeof (th->th_chksum)) ?
+		    ' ' : p[i];
+
+		usum += c;
+		ssum += (signed char)c;
+	}
+	return (want == usum || want == (uint64_t)(uint32_t)ssum);
+}
+
+/*
+ * Read the data of a GNU long name or pax extended header, which applies to
+ * the member that follows it.
+ */
+static int
+tar_meta(tar_t *t, char type, uint64_t size)
+{
+	char *data, *p, *end, *eq;
+	unsigned long len;
+
+	if (size > TAR_MAXMETA) {
+		tar_error(t, "oversized extended header");
+		return (-1);
+	}
+	if ((data = malloc((size_t)size + 1)) == NULL) {
+		(void) fprintf(stderr, "failed to allocate memory\n");
+		return (-1);
+	}
+	if (tar_read(t, data, (size_t)size) != 0 ||
+	    tar_skip(t, P2ROUNDUP(size, TAR_BLOCKSZ) - size) != 0) {
+		tar_error(t, "truncated extended header");
+		free(data);
+		return (-1);
+	}
+	data[size] = '\0';
+
+	if (type == 'L') {
+		free(t->t_name);
+		t->t_name = data;
+		return (0);
+	}
+
+	/*
+	 * pax records are "<length> <keyword>=<value>\n", where the length
+	 * covers the whole record.  Only the path and size matter here.
+	 */
+	for (p = data; p < data + size; p += len) {
+		len = strtoul(p, &end, 10);
+		if (*end != ' ' || len == 0 ||
+		    len > (size_t)(data + size - p) || p[len - 1] != '\n')
+			break;
+		p[len - 1] = '\0';
+		if ((eq = strchr(end + 1, '=')) == NULL)
+			continue;
+		*eq++ = '\0';
+		if (strcmp(end + 1, "path") == 0) {
+			free(t->t_name);
+			if ((t->t_name = strdup(eq)) == NULL) {
+				(void) fprintf(stderr, "failed to allocate "
+				    "memory\n");
+				free(data);
+				return (-1);
+			}
+		} else if (strcmp(end + 1, "size") == 0) {
+			t->t_size = strtoull(eq, NULL, 10);
+			t->t_havesize = B_TRUE;
+		}
+	}
+
+	free(data);
+	return (0);
+}
+
+/*
+ * Read the rest of the checkpoint whose first block has been read into t_buf
+ * and hand it to the caller.
+ */
+static int
+tar_ckpt(tar_t *t, const char *name, uint64_t size, size_t have)
+{
+	char *path;
+	int rv;
+
+	if (size > SIZE_MAX || tar_grow(t, (size_t)size) != 0)
+		return (-1);
+	if (tar_read(t, (uchar_t *)t->t_buf + have, (size_t)size - have) != 0 ||
+	    tar_skip(t, P2ROUNDUP(size, TAR_BLOCKSZ) - size) != 0) {
+		tar_error(t, "truncated member");
+		return (-1);
+	}
+
+	if (asprintf(&path, "%s:%s", t->t_archive, name) < 0) {
+		(void) fprintf(stderr, "failed to allocate memory\n");
+		return (-1);
+	}
+
+	rv = t->t_func(path, t->t_buf, (size_t)size, t->t_arg);
+	free(path);
+	return (rv);
+}
+
+/*
+ * Walk the members of one archive.  Returns -1 if the archive couldn't be
+ * read to the end, or the first nonzero value returned by the callback.
+ */
+static int
+tar_members(tar_t *t)
+{
+	tar_hdr_t th;
+	char name[sizeof (th.th_prefix) + sizeof (th.th_name) + 2];
+	const char *mname;
+	uint64_t size;
+	size_t have;
+	int rv = 0;
+
+	for (;;) {
+		if (tar_read(t, &th, sizeof (th)) != 0) {
+			tar_error(t, "failed to read header");
+			rv = -1;
+			break;
+		}
+		if (tar_zero(&th))
+			break;
+		if (!tar_cksum_ok(&th) ||
+		    tar_num(th.th_size, sizeof (th.th_size), &size) != 0) {
+			t->t_off -= sizeof (th);
+			tar_error(t, "invalid header");
+			rv = -1;
+			break;
+		}
+		if (t->t_havesize) {
+			size = t->t_size;
+			t->t_havesize = B_FALSE;
+		}
+
+		switch (th.th_typeflag) {
+		case 'L':
+		case 'x':
+			if (tar_meta(t, th.th_typeflag, size) != 0) {
+				rv = -1;
+				goto out;
+			}
+			continue;
+		case '0':
+		case '7':
+		case '\0':
+			break;
+		default:
+			/*
+			 * Directories, links, devices, pax global headers and
+			 * the like have no checkpoint data.
+			 */
+			free(t->t_name);
+			t->t_name = NULL;
+			if (tar_skip(t, P2ROUNDUP(size, TAR_BLOCKSZ)) != 0) {
+				tar_error(t, "truncated member");
+				rv = -1;
+				goto out;
+			}
+			continue;
+		}
+
+		if (t->t_name != NULL) {
+			mname = t->t_name;
+		} else if (strncmp(th.th_magic, "ustar", 5) == 0 &&
+		    th.th_prefix[0] != '\0') {
+			(void) snprintf(name, sizeof (name), "%.*s/%.*s",
+			    (int)sizeof (th.th_prefix), th.th_prefix,
+			    (int)sizeof (th.th_name), th.th_name);
+			mname = name;
+		} else {
+			(void) snprintf(name, sizeof (name), "%.*s",
+			    (int)sizeof (th.th_name), th.th_name);
+			mname = name;
+		}
+
+		/*
+		 * Read the first block and only carry on with the member if
+		 * it's a checkpoint.
+		 */
+		have = size < TAR_BLOCKSZ ? (size_t)size : TAR_BLOCKSZ;
+		if (tar_grow(t, TAR_BLOCKSZ) != 0 ||
+		    tar_read(t, t->t_buf, have) != 0) {
+			tar_error(t, "truncated member");
+			rv = -1;
+			break;
+		}
+		if (have >= FCF_MAG_STRLEN &&
+		    bcmp(t->t_buf, FCF_MAG_STRING, FCF_MAG_STRLEN) == 0) {
+			if ((rv = tar_ckpt(t, mname, size, have)) != 0)
+				break;
+		} else if (tar_skip(t, P2ROUNDUP(size, TAR_BLOCKSZ) -
+		    have) != 0) {
+			tar_error(t, "truncated member");
+			rv = -1;
+			break;
+		}
+
+		free(t->t_name);
+		t->t_name = NULL;
+	}
+
+out:
+	free(t->t_name);
+	t->t_name = NULL;
+	t->t_havesize = B_FALSE;
+	return (rv);
+}
+
+/*
+ * Call func with the pathname ("<archive>:<member>") and contents of every
+ * checkpoint in the given tar archive, which may be gzip'd; "-" is stdin.
+ * The contents are 64-bit aligned, as fcf_view_open_mem() needs, and are only
+ * valid for the duration of the call.  Returns -1 if the archive couldn't be
+ * read to the end, or the first nonzero value returned by func.
+ */
+int
+tar_walk(const char *archive, ckpt_func_t *func, void *arg)
+{
+	tar_t t;
+	int fd, rv;
+
+	(void) memset(&t, 0, sizeof (t));
+	t.t_func = func;
+	t.t_arg = arg;
+
+	if (strcmp(archive, "-") == 0) {
+		t.t_archive = "<stdin>";
+		fd = dup(STDIN_FILENO);
+	} else {
+		t.t_archive = archive;
+		fd = open(archive, O_RDONLY);
+	}
+	if (fd < 0 || (t.t_gz = gzdopen(fd, "rb")) == NULL) {
+		(void) fprintf(stderr, "failed to open %s (%s)\n", t.t_archive,
+		    strerror(errno));
+		if (fd >= 0)
+			(void) close(fd);
+		return (-1);
+	}
+	(void) gzbuffer(t.t_gz, 128 * 1024);
+
+	rv = tar_members(&t);
+
+	(void) gzclose(t.t_gz);
+	free(t.t_buf);
+	return (rv);
+}
+
+static int
+tar_dump_cb(const char *path, const void *buf, size_t size, void *arg)
+{
+	tar_dump_t *td = arg;
+	dump_ctx_t *dc = td->td_dc;
+	fcf_view_t fv;
+
+	if (td->td_text) {
+		out_puts(dc->dc_out, "##########\n");
+		out_puts(dc->dc_out, path);
+		out_puts(dc->dc_out, "\n##########\n");
+	}
+	if (fcf_view_open_mem(&fv, path, buf, size) != 0) {
+		dump_abort(dc, &fv);
+		td->td_nfailed++;
+	} else {
+		dump_view(dc, &fv);
+	}
+	if (td->td_text)
+		out_putc(dc->dc_out, '\n');
+	fcf_view_close(&fv);
+	out_flush(dc->dc_out);
+
+	td->td_nckpts++;
+	return (0);
+}
+
+static void
+tar_usage(void)
+{
+	(void) fprintf(stderr, "usage: %s tar [-o format] [-s secidx[,...]] "
+	    "[-t type[,...]] [archive ...]\n\n"
+	    "archives may be gzip'd; with none, or \"-\", stdin is read\n\n",
+	    pname);
+}
+
+int
+do_tar(int argc, char **argv)
+{
+	static char *stdin_args[] = { "-" };
+	const dump_fmt_t *fmt = &dump_fmt_text;
+	dump_sel_t sel = { 0 };
+	dump_out_t *out;
+	dump_ctx_t dc;
+	tar_dump_t td;
+	char **args;
+	int c, i, nargs, nbad = 0;
+
+	while ((c = getopt(argc, argv, "o:s:t:")) != -1) {
+		switch (c) {
+		case 'o':
+			if ((fmt = parse_fmt(optarg)) == NULL)
+				return (2);
+			break;
+		case 's':
+			if (parse_secs(optarg, &sel) != 0)
+				return (2);
+			break;
+		case 't':
+			if (parse_types(optarg, &sel) != 0)
+				return (2);
+			break;
+		default:
+			tar_usage();
+			return (2);
+		}
+	}
+
+	args = argv + optind;
+	nargs = argc - optind;
+	if (nargs == 0) {
+		args = stdin_args;
+		nargs = 1;
+	}
+
+	/*
+	 * The output buffer is large, so don't put it on the stack.  As with
+	 * scan, the strings of every checkpoint go in one atom table.
+	 */
+	(void) memset(&td, 0, sizeof (td));
+	if ((out = malloc(sizeof (dump_out_t))) == NULL ||
+	    (dc.dc_atoms = fcf_atomtab_create()) == NULL) {
+		(void) fprintf(stderr, "failed to allocate memory\n");
+		free(out);
+		return (1);
+	}
+	out_init(out, stdout, fmt);
+	dc.dc_out = out;
+	dc.dc_err = fmt == &dump_fmt_text ? stdout : stderr;
+	dc.dc_sel = &sel;
+	td.td_dc = &dc;
+	td.td_text = fmt == &dump_fmt_text;
+
+	for (i = 0; i < nargs; i++) {
+		if (tar_walk(args[i], tar_dump_cb, &td) != 0)
+			nbad++;
+	}
+
+	if (out_fini(out) != 0) {
+		(void) fprintf(stderr, "failed to write output\n");
+		nbad++;
+	}
+	(void) fprintf(td.td_text ? stdout : stderr,
+	    "%u checkpoint files read from %d archives, %u failed, "
+	    "%u distinct strings\n", td.td_nckpts, nargs, td.td_nfailed,
+	    fcf_atomtab_count(dc.dc_atoms));
+
+	free(out);
+	fcf_atomtab_destroy(dc.dc_atoms);
+	return (nbad == 0 && td.td_nfailed == 0 ? 0 : 1);
+}
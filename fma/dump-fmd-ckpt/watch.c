@@ -0,0 +1,344 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+/*
+ * "dump-fmd-ckpt watch" stays resident, watching a checkpoint directory
+ * hierarchy, and reports how each checkpoint changes over time.
+ *
+ * Each pass over the hierarchy only stats the files.  A checkpoint is only
+ * reopened when its size or mtime has changed.  fmd bumps fcfh_cgen each time
+ * it writes a module's checkpoint, so if the header's cgen is the same as the
+ * previous version's, the file was only touched or copied back into place and
+ * nothing more is done.  Otherwise it's compared with the previous version
+ * using the diff engine, which itself skips everything whose hash hasn't
+ * changed.  The previous version stays mapped between passes.
+ * That's safe because fmd never rewrites a checkpoint in place: it writes a
+ * new file and renames it over the old one, so our mapping keeps the old file
+ * alive until we let go of it.
+ *
+ * Passes are triggered by inotify events on the root and module directories.
+ * A pass is also made every interval regardless, which covers anything the
+ * events miss.  Where inotify isn't available, or with -p, we simply poll.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "dump-fmd-ckpt.h"
+
+#define	WATCH_INTERVAL	1	/* default seconds between passes */
+#define	WATCH_SETTLE	100	/* ms to wait for a burst of events to end */
+
+#define	WATCH_DIRMASK	(IN_CREATE | IN_DELETE | IN_MOVED_FROM | \
+	IN_MOVED_TO | IN_CLOSE_WRITE)
+
+typedef struct watch_file {
+	char *wf_path;			/* pathname of checkpoint */
+	fcf_view_t wf_view;		/* last version seen */
+	boolean_t wf_mapped;		/* wf_view is open */
+	boolean_t wf_tried;		/* wf_size and wf_mtime are set */
+	boolean_t wf_seen;		/* found during this pass */
+	off64_t wf_size;		/* size of last version seen */
+	struct timespec wf_mtime;	/* mtime of last version seen */
+	off64_t wf_nsize;		/* size found during this pass */
+	struct timespec wf_nmtime;	/* mtime found during this pass */
+} watch_file_t;
+
+typedef struct watch {
+	const char *w_root;		/* root of checkpoint hierarchy */
+	watch_file_t *w_files;		/* files, sorted by pathname */
+	uint_t w_nfiles;		/* number of files */
+	uint_t w_nsorted;		/* number of files known to be sorted */
+	uint_t w_alloc;			/* allocated entries in w_files */
+	fcf_atomtab_t *w_atoms;		/* strings shared by all versions */
+	int w_ifd;			/* inotify descriptor, or -1 */
+	char w_lastdir[MAXPATHLEN];	/* last directory added to w_ifd */
+} watch_t;
+
+static int
+watch_file_cmp(const void *l, const void *r)
+{
+	const watch_file_t *lf = l, *rf = r;
+
+	return (strcmp(lf->wf_path, rf->wf_path));
+}
+
+static void
+watch_banner(char *buf, size_t len)
+{
+	struct tm tm;
+	time_t now = time(NULL);
+
+	(void) strlcpy(buf, "=== ", len);
+	if (gmtime_r(&now, &tm) == NULL || strftime(buf + 4, len - 4,
+	    "%Y-%m-%dT%H:%M:%SZ", &tm) == 0)
+		(void) strlcat(buf, "?", len);
+}
+
+/*
+ * Note the current size and mtime of a file found by the walk, adding it if
+ * it's new.  New files are appended and sorted into place after the walk.
+ */
+static int
+watch_found(const char *dir, const char *name, void *arg)
+{
+	watch_t *w = arg;
+	watch_file_t key, *wf;
+	char path[MAXPATHLEN];
+	struct stat64 st;
+
+	if (w->w_ifd >= 0 && strcmp(dir, w->w_lastdir) != 0) {
+		(void) inotify_add_watch(w->w_ifd, dir, WATCH_DIRMASK);
+		(void) strlcpy(w->w_lastdir, dir, sizeof (w->w_lastdir));
+	}
+
+	(void) snprintf(path, sizeof (path), "%s/%s", dir, name);
+	if (stat64(path, &st) != 0)
+		return (0);
+
+	key.wf_path = path;
+	if ((wf = bsearch(&key, w->w_files, w->w_nsorted,
+	    sizeof (watch_file_t), watch_file_cmp)) == NULL) {
+		if (w->w_nfiles == w->w_alloc) {
+			uint_t alloc = w->w_alloc == 0 ? 64 : w->w_alloc * 2;
+
+			if ((wf = realloc(w->w_files,
+			    alloc * sizeof (watch_file_t))) == NULL)
+				goto nomem;
+			w->w_files = wf;
+			w->w_alloc = alloc;
+		}
+		wf = &w->w_files[w->w_nfiles];
+		(void) memset(wf, 0, sizeof (watch_file_t));
+		if ((wf->wf_path = strdup(path)) == NULL)
+			goto nomem;
+		w->w_nfiles++;
+	}
+
+	wf->wf_seen = B_TRUE;
+	wf->wf_nsize = st.st_size;
+	wf->wf_nmtime = st.st_mtim;
+	return (0);
+
+nomem:
+	(void) fprintf(stderr, "failed to allocate memory\n");
+	return (-1);
+}
+
+/*
+ * Reopen a checkpoint whose size or mtime has changed and report how it
+ * differs from the last version we saw, or everything in it if it's new.
+ */
+static void
+watch_update(watch_t *w, watch_file_t *wf, boolean_t report)
+{
+	char banner[64];
+	fcf_view_t nfv;
+
+	wf->wf_size = wf->wf_nsize;
+	wf->wf_mtime = wf->wf_nmtime;
+	wf->wf_tried = B_TRUE;
+
+	/*
+	 * On failure, keep the last good version, if there is one.  The
+	 * error is only reported once, since we've already noted the new
+	 * size and mtime, and the file isn't tried again until they change.
+	 */
+	if (fcf_view_open(&nfv, wf->wf_path) != 0) {
+		(void) fprintf(stderr, "%s\n", nfv.fv_errmsg);
+		fcf_view_close(&nfv);
+		return;
+	}
+	if (wf->wf_mapped &&
+	    nfv.fv_hdr->fcfh_cgen == wf->wf_view.fv_hdr->fcfh_cgen) {
+		fcf_view_close(&nfv);
+		return;
+	}
+	if (fcf_view_strings(&nfv, w->w_atoms) != 0) {
+		(void) fprintf(stderr, "%s\n", nfv.fv_errmsg);
+		fcf_view_close(&nfv);
+		return;
+	}
+
+	if (report) {
+		watch_banner(banner, sizeof (banner));
+		if (wf->wf_mapped)
+			(void) diff_views(&wf->wf_view, &nfv, banner);
+		else
+			(void) diff_view_items(&nfv, banner);
+	}
+
+	if (wf->wf_mapped)
+		fcf_view_close(&wf->wf_view);
+	wf->wf_view = nfv;
+	wf->wf_mapped = B_TRUE;
+}
+
+/*
+ * Make a pass over the hierarchy, reporting changes if report is set.
+ */
+static int
+watch_pass(watch_t *w, boolean_t report)
+{
+	char banner[64];
+	watch_file_t *wf;
+	uint_t i, j;
+
+	for (i = 0; i < w->w_nfiles; i++)
+		w->w_files[i].wf_seen = B_FALSE;
+	w->w_lastdir[0] = '\0';
+
+	if (ckpt_walk(w->w_root, watch_found, w) != 0)
+		return (-1);
+
+	qsort(w->w_files, w->w_nfiles, sizeof (watch_file_t), watch_file_cmp);
+
+	for (i = 0, j = 0; i < w->w_nfiles; i++) {
+		wf = &w->w_files[i];
+
+		if (!wf->wf_seen) {
+			if (report) {
+				watch_banner(banner, sizeof (banner));
+				(void) printf("%s\n- %s\n", banner,
+				    wf->wf_path);
+			}
+			if (wf->wf_mapped)
+				fcf_view_close(&wf->wf_view);
+			free(wf->wf_path);
+			continue;
+		}
+
+		if (!wf->wf_tried || wf->wf_nsize != wf->wf_size ||
+		    wf->wf_nmtime.tv_sec != wf->wf_mtime.tv_sec ||
+		    wf->wf_nmtime.tv_nsec != wf->wf_mtime.tv_nsec)
+			watch_update(w, wf, report);
+
+		w->w_files[j++] = *wf;
+	}
+	w->w_nfiles = w->w_nsorted = j;
+
+	(void) fflush(stdout);
+	return (0);
+}
+
+/*
+ * Wait for something to change.  With inotify, wait for an event and then
+ * for the burst it's part of to end, since fmd touches several files when it
+ * checkpoints.  Returns when there's been an event or the interval expires.
+ */
+static void
+watch_wait(watch_t *w, int interval)
+{
+	struct pollfd pfd;
+	char buf[4096];
+
+	if (w->w_ifd < 0) {
+		(void) sleep(interval);
+		return;
+	}
+
+	pfd.fd = w->w_ifd;
+	pfd.events = POLLIN;
+	if (poll(&pfd, 1, interval * 1000) <= 0)
+		return;
+
+	do {
+		while (read(w->w_ifd, buf, sizeof (buf)) > 0)
+			continue;
+	} while (poll(&pfd, 1, WATCH_SETTLE) > 0);
+}
+
+static void
+watch_usage(void)
+{
+	(void) fprintf(stderr, "usage: %s watch [-p] [-i interval] [root]\n\n"
+	    "root defaults to %s\n\n", pname, CKPT_DEFROOT);
+}
+
+int
+do_watch(int argc, char **argv)
+{
+	watch_t w = { 0 };
+	boolean_t dopoll = B_FALSE;
+	long interval = WATCH_INTERVAL;
+	char *end;
+	int c;
+
+	w.w_root = CKPT_DEFROOT;
+	w.w_ifd = -1;
+
+	while ((c = getopt(argc, argv, "i:p")) != -1) {
+		switch (c) {
+		case 'i':
+			errno = 0;
+			interval = strtol(optarg, &end, 10);
+			if (errno != 0 || *end != '\0' || interval < 1 ||
+			    interval > INT_MAX / 1000) {
+				(void) fprintf(stderr, "invalid interval: "
+				    "%s\n", optarg);
+				return (2);
+			}
+			break;
+		case 'p':
+			dopoll = B_TRUE;
+			break;
+		default:
+			watch_usage();
+			return (2);
+		}
+	}
+
+	if (argc - optind > 1) {
+		watch_usage();
+		return (2);
+	}
+	if (argc - optind == 1)
+		w.w_root = argv[optind];
+
+	if ((w.w_atoms = fcf_atomtab_create()) == NULL) {
+		(void) fprintf(stderr, "failed to allocate memory\n");
+		return (1);
+	}
+
+	if (!dopoll) {
+		if ((w.w_ifd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) < 0 ||
+		    inotify_add_watch(w.w_ifd, w.w_root, WATCH_DIRMASK) < 0) {
+			(void) fprintf(stderr, "inotify unavailable (%s), "
+			    "polling every %lds instead\n", strerror(errno),
+			    interval);
+			if (w.w_ifd >= 0)
+				(void) close(w.w_ifd);
+			w.w_ifd = -1;
+		}
+	}
+
+	/*
+	 * The first pass just records the current state of every checkpoint,
+	 * which subsequent changes are reported against.
+	 */
+	if (watch_pass(&w, B_FALSE) != 0)
+		return (1);
+	(void) fprintf(stderr, "watching %u checkpoint files under %s\n",
+	    w.w_nfiles, w.w_root);
+
+	for (;;) {
+		watch_wait(&w, (int)interval);
+		if (watch_pass(&w, B_TRUE) != 0)
+			return (1);
+	}
+	/* NOTREACHED */
+}
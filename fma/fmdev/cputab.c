@@ -0,0 +1,605 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+/*
+ * Build, write, load and print the CPU table described in cputab.h from the
+ * nvlist returned by FM_IOC_PHYSCPU_INFO.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#ifdef	__sun
+#include <sys/devfm.h>
+#endif
+#ifndef	FMDEV_NO_LIBNVPAIR
+#include <libnvpair.h>
+#endif
+
+#include "cputab.h"
+#include "mfile.h"
+#include "fmdev_compat.h"
+
+/*
+ * Not every version of sys/devfm.h names these.
+ */
+#ifndef	FM_PHYSCPU_INFO_STRAND_APICID
+#define	FM_PHYSCPU_INFO_STRAND_APICID	"strand-initial-apicid"
+#endif
+#ifndef	FM_PHYSCPU_INFO_SMBIOS_ID
+#define	FM_PHYSCPU_INFO_SMBIOS_ID	"smbios-id"
+#endif
+#ifndef	FM_PHYSCPU_INFO_CHIP_IDENTSTR
+#define	FM_PHYSCPU_INFO_CHIP_IDENTSTR	"chip-identstr"
+#endif
+#ifndef	FM_PHYSCPU_INFO_NPROCNODES
+#define	FM_PHYSCPU_INFO_NPROCNODES	"nprocnodes"
+#endif
+#ifndef	FM_PHYSCPU_INFO_PROCNODE_ID
+#define	FM_PHYSCPU_INFO_PROCNODE_ID	"procnodeid"
+#endif
+
+#define	CPUTAB_ALIGN(x)	(((x) + 7) & ~(uint64_t)7)
+
+/*
+ * One CPU as read from the nvlist, before it's sorted into place.
+ */
+typedef struct cputab_ent {
+	uint32_t ce_cpuid;
+	uint32_t ce_chipid;
+	uint32_t ce_coreid;
+	uint32_t ce_strandid;
+	uint32_t ce_apicid;
+	uint32_t ce_smbiosid;
+	uint32_t ce_procnode;
+	uint32_t ce_nprocnodes;
+	uint32_t ce_family;
+	uint32_t ce_model;
+	uint32_t ce_stepping;
+	uint32_t ce_socket;
+	const char *ce_vendor;
+	const char *ce_rev;
+	const char *ce_ident;
+} cputab_ent_t;
+
+/*
+ * The string table under construction.  There are only a handful of distinct
+ * strings (one vendor, revision and identity per chip at most), so they're
+ * simply searched linearly.
+ */
+typedef struct cputab_strtab {
+	char *cst_buf;
+	size_t cst_size;
+	size_t cst_alloc;
+} cputab_strtab_t;
+
+/*
+ * Without libnvpair (see the makefile), a table can be read and printed but
+ * not built.
+ */
+#ifndef	FMDEV_NO_LIBNVPAIR
+/*
+ * Look up an integer of any width and signedness, returning CPUTAB_NONE if
+ * it's absent or isn't an integer.
+ */
+static uint32_t
+cputab_int(nvlist_t *nvl, const char *name)
+{
+	nvpair_t *nvp;
+	int64_t v;
+
+	if (nvlist_lookup_nvpair(nvl, name, &nvp) != 0)
+		return (CPUTAB_NONE);
+
+	switch (nvpair_type(nvp)) {
+	case DATA_TYPE_INT8: {
+		int8_t x;
+		(void) nvpair_value_int8(nvp, &x);
+		v = x;
+		break;
+	}
+	case DATA_TYPE_UINT8: {
+		uint8_t x;
+		(void) nvpair_value_uint8(nvp, &x);
+		v = x;
+		break;
+	}
+	case DATA_TYPE_INT16: {
+		int16_t x;
+		(void) nvpair_value_int16(nvp, &x);
+		v = x;
+		break;
+	}
+	case DATA_TYPE_UINT16: {
+		uint16_t x;
+		(void) nvpair_value_uint16(nvp, &x);
+		v = x;
+		break;
+	}
+	case DATA_TYPE_INT32: {
+		int32_t x;
+		(void) nvpair_value_int32(nvp, &x);
+		v = x;
+		break;
+	}
+	case DATA_TYPE_UINT32: {
+		uint32_t x;
+		(void) nvpair_value_uint32(nvp, &x);
+		v = x;
+		break;
+	}
+	case DATA_TYPE_INT64: {
+		int64_t x;
+		(void) nvpair_value_int64(nvp, &x);
+		v = x;
+		break;
+	}
+	case DATA_TYPE_UINT64: {
+		uint64_t x;
+		(void) nvpair_value_uint64(nvp, &x);
+		if (x >= CPUTAB_NONE)
+			return (CPUTAB_NONE);
+		v = (int64_t)x;
+		break;
+	}
+	default:
+		return (CPUTAB_NONE);
+	}
+
+	if (v < 0 || v >= CPUTAB_NONE)
+		return (CPUTAB_NONE);
+	return ((uint32_t)v);
+}
+
+static const char *
+cputab_string(nvlist_t *nvl, const char *name)
+{
+	char *s;
+
+	if (nvlist_lookup_string(nvl, name, &s) != 0)
+		return (NULL);
+	return (s);
+}
+
+static int
+cputab_ent_cmp(const void *l, const void *r)
+{
+	const cputab_ent_t *a = l, *b = r;
+
+	if (a->ce_chipid != b->ce_chipid)
+		return (a->ce_chipid < b->ce_chipid ? -1 : 1);
+	if (a->ce_coreid != b->ce_coreid)
+		return (a->ce_coreid < b->ce_coreid ? -1 : 1);
+	if (a->ce_strandid != b->ce_strandid)
+		return (a->ce_strandid < b->ce_strandid ? -1 : 1);
+	if (a->ce_cpuid != b->ce_cpuid)
+		return (a->ce_cpuid < b->ce_cpuid ? -1 : 1);
+	return (0);
+}
+
+static uint32_t
+cputab_intern(cputab_strtab_t *st, const char *s)
+{
+	size_t off, len;
+
+	if (s == NULL || *s == '\0')
+		return (0);
+	for (off = 1; off < st->cst_size; off += len + 1) {
+		len = strlen(st->cst_buf + off);
+		if (strcmp(st->cst_buf + off, s) == 0)
+			return ((uint32_t)off);
+	}
+
+	len = strlen(s) + 1;
+	if (st->cst_size + len > st->cst_alloc) {
+		size_t n = st->cst_alloc * 2 + len;
+		char *buf;
+
+		if ((buf = realloc(st->cst_buf, n)) == NULL)
+			return (CPUTAB_NONE);
+		st->cst_buf = buf;
+		st->cst_alloc = n;
+	}
+	off = st->cst_size;
+	(void) memcpy(st->cst_buf + off, s, len);
+	st->cst_size += len;
+	return ((uint32_t)off);
+}
+
+/*
+ * Turn the FM_IOC_PHYSCPU_INFO nvlist into a table, in a single allocation
+ * that's laid out exactly as the file is.
+ */
+int
+cputab_build(nvlist_t *nvl, cputab_hdr_t **ctp)
+{
+	nvlist_t **cpus;
+	uint_t ncpus, i, j;
+	cputab_ent_t *ents = NULL;
+	cputab_strtab_t st = { 0 };
+	cputab_hdr_t *ct = NULL;
+	cputab_chip_t *chips;
+	cputab_core_t *cores;
+	cputab_strand_t *strands;
+	uint32_t *idx, nchips = 0, ncores = 0, nidx = 0;
+	uint64_t off;
+	int err;
+
+	if ((err = nvlist_lookup_nvlist_array(nvl, FM_PHYSCPU_INFO_CPUS,
+	    &cpus, &ncpus)) != 0) {
+		(void) fprintf(stderr, "no %s array in physcpu_info output "
+		    "(%s)\n", FM_PHYSCPU_INFO_CPUS, strerror(err));
+		return (-1);
+	}
+	if (ncpus == 0) {
+		(void) fprintf(stderr, "physcpu_info output has no CPUs\n");
+		return (-1);
+	}
+	if ((ents = calloc(ncpus, sizeof (cputab_ent_t))) == NULL ||
+	    (st.cst_buf = malloc(st.cst_alloc = 256)) == NULL) {
+		(void) fprintf(stderr, "malloc failed\n");
+		goto err;
+	}
+	st.cst_buf[0] = '\0';
+	st.cst_size = 1;
+
+	for (i = 0; i < ncpus; i++) {
+		cputab_ent_t *ce = &ents[i];
+		nvlist_t *cpu = cpus[i];
+
+		ce->ce_cpuid = cputab_int(cpu, FM_PHYSCPU_INFO_CPU_ID);
+		ce->ce_chipid = cputab_int(cpu, FM_PHYSCPU_INFO_CHIP_ID);
+		ce->ce_coreid = cputab_int(cpu, FM_PHYSCPU_INFO_CORE_ID);
+		ce->ce_strandid = cputab_int(cpu, FM_PHYSCPU_INFO_STRAND_ID);
+		ce->ce_apicid = cputab_int(cpu, FM_PHYSCPU_INFO_STRAND_APICID);
+		ce->ce_smbiosid = cputab_int(cpu, FM_PHYSCPU_INFO_SMBIOS_ID);
+		ce->ce_procnode = cputab_int(cpu, FM_PHYSCPU_INFO_PROCNODE_ID);
+		ce->ce_nprocnodes = cputab_int(cpu,
+		    FM_PHYSCPU_INFO_NPROCNODES);
+		ce->ce_family = cputab_int(cpu, FM_PHYSCPU_INFO_FAMILY);
+		ce->ce_model = cputab_int(cpu, FM_PHYSCPU_INFO_MODEL);
+		ce->ce_stepping = cputab_int(cpu, FM_PHYSCPU_INFO_STEPPING);
+		ce->ce_socket = cputab_int(cpu, FM_PHYSCPU_INFO_SOCKET_TYPE);
+		ce->ce_vendor = cputab_string(cpu, FM_PHYSCPU_INFO_VENDOR_ID);
+		ce->ce_rev = cputab_string(cpu, FM_PHYSCPU_INFO_CHIP_REV);
+		ce->ce_ident = cputab_string(cpu,
+		    FM_PHYSCPU_INFO_CHIP_IDENTSTR);
+
+		if (ce->ce_cpuid == CPUTAB_NONE ||
+		    ce->ce_chipid == CPUTAB_NONE ||
+		    ce->ce_coreid == CPUTAB_NONE) {
+			(void) fprintf(stderr, "CPU %u in physcpu_info output "
+			    "lacks a cpu, chip or core id\n", i);
+			goto err;
+		}
+		if (ce->ce_cpuid >= nidx)
+			nidx = ce->ce_cpuid + 1;
+	}
+
+	qsort(ents, ncpus, sizeof (cputab_ent_t), cputab_ent_cmp);
+	for (i = 0; i < ncpus; i++) {
+		if (i == 0 || ents[i].ce_chipid != ents[i - 1].ce_chipid) {
+			nchips++;
+			ncores++;
+		} else if (ents[i].ce_coreid != ents[i - 1].ce_coreid) {
+			ncores++;
+		}
+	}
+
+	off = CPUTAB_ALIGN(sizeof (cputab_hdr_t));
+	off += CPUTAB_ALIGN((uint64_t)nchips * sizeof (cputab_chip_t));
+	off += CPUTAB_ALIGN((uint64_t)ncores * sizeof (cputab_core_t));
+	off += CPUTAB_ALIGN((uint64_t)ncpus * sizeof (cputab_strand_t));
+	off += CPUTAB_ALIGN((uint64_t)nidx * sizeof (uint32_t));
+	if ((ct = calloc(1, off)) == NULL) {
+		(void) fprintf(stderr, "malloc failed\n");
+		goto err;
+	}
+
+	ct->ct_magic = CPUTAB_MAGIC;
+	ct->ct_version = CPUTAB_VERSION;
+	ct->ct_hdrsize = sizeof (cputab_hdr_t);
+	ct->ct_nchips = nchips;
+	ct->ct_ncores = ncores;
+	ct->ct_nstrands = ncpus;
+	ct->ct_nidx = nidx;
+	ct->ct_chipoff = CPUTAB_ALIGN(sizeof (cputab_hdr_t));
+	ct->ct_coreoff = ct->ct_chipoff +
+	    CPUTAB_ALIGN((uint64_t)nchips * sizeof (cputab_chip_t));
+	ct->ct_strandoff = ct->ct_coreoff +
+	    CPUTAB_ALIGN((uint64_t)ncores * sizeof (cputab_core_t));
+	ct->ct_idxoff = ct->ct_strandoff +
+	    CPUTAB_ALIGN((uint64_t)ncpus * sizeof (cputab_strand_t));
+	ct->ct_stroff = off;
+
+	chips = (cputab_chip_t *)((char *)ct + ct->ct_chipoff);
+	cores = (cputab_core_t *)((char *)ct + ct->ct_coreoff);
+	strands = (cputab_strand_t *)((char *)ct + ct->ct_strandoff);
+	idx = (uint32_t *)((char *)ct + ct->ct_idxoff);
+	for (i = 0; i < nidx; i++)
+		idx[i] = CPUTAB_NONE;
+
+	/*
+	 * The entries are sorted, so each new chip or core id starts the next
+	 * chip or core, and the strands are simply laid down in order.  The
+	 * chip's attributes are taken from its first strand.
+	 */
+	for (i = 0, nchips = 0, ncores = 0; i < ncpus; i++) {
+		const cputab_ent_t *ce = &ents[i];
+		cputab_chip_t *cc;
+		cputab_core_t *co;
+		cputab_strand_t *cs = &strands[i];
+
+		if (i == 0 || ce->ce_chipid != ents[i - 1].ce_chipid) {
+			cc = &chips[nchips++];
+			cc->cc_chipid = ce->ce_chipid;
+			cc->cc_family = ce->ce_family;
+			cc->cc_model = ce->ce_model;
+			cc->cc_stepping = ce->ce_stepping;
+			cc->cc_socket = ce->ce_socket;
+			cc->cc_nprocnodes = ce->ce_nprocnodes;
+			cc->cc_core = ncores;
+			cc->cc_strand = i;
+			if ((cc->cc_vendor = cputab_intern(&st,
+			    ce->ce_vendor)) == CPUTAB_NONE ||
+			    (cc->cc_rev = cputab_intern(&st,
+			    ce->ce_rev)) == CPUTAB_NONE ||
+			    (cc->cc_ident = cputab_intern(&st,
+			    ce->ce_ident)) == CPUTAB_NONE) {
+				(void) fprintf(stderr, "malloc failed\n");
+				goto err;
+			}
+			co = NULL;
+		} else {
+			cc = &chips[nchips - 1];
+			co = &cores[ncores - 1];
+		}
+		if (co == NULL || ce->ce_coreid != co->co_coreid) {
+			co = &cores[ncores++];
+			co->co_coreid = ce->ce_coreid;
+			co->co_chip = nchips - 1;
+			co->co_procnode = ce->ce_procnode;
+			co->co_strand = i;
+			cc->cc_ncores++;
+		}
+		co->co_nstrands++;
+		cc->cc_nstrands++;
+
+		cs->cs_cpuid = ce->ce_cpuid;
+		cs->cs_strandid = ce->ce_strandid;
+		cs->cs_apicid = ce->ce_apicid;
+		cs->cs_smbiosid = ce->ce_smbiosid;
+		cs->cs_core = ncores - 1;
+		cs->cs_chip = nchips - 1;
+		if (idx[ce->ce_cpuid] != CPUTAB_NONE) {
+			(void) fprintf(stderr, "CPU %u appears twice in "
+			    "physcpu_info output\n", ce->ce_cpuid);
+			goto err;
+		}
+		idx[ce->ce_cpuid] = i;
+	}
+
+	/*
+	 * Strands without a strand id are numbered by their place in the core.
+	 */
+	for (i = 0; i < ncores; i++) {
+		for (j = 0; j < cores[i].co_nstrands; j++) {
+			cputab_strand_t *cs = &strands[cores[i].co_strand + j];
+
+			if (cs->cs_strandid == CPUTAB_NONE)
+				cs->cs_strandid = j;
+		}
+	}
+
+	ct->ct_strsize = st.cst_size;
+	ct->ct_filesz = ct->ct_stroff + CPUTAB_ALIGN(st.cst_size);
+	{
+		cputab_hdr_t *nct;
+
+		if ((nct = realloc(ct, ct->ct_filesz)) == NULL) {
+			(void) fprintf(stderr, "malloc failed\n");
+			goto err;
+		}
+		ct = nct;
+	}
+	(void) memset((char *)ct + ct->ct_stroff, 0,
+	    ct->ct_filesz - ct->ct_stroff);
+	(void) memcpy((char *)ct + ct->ct_stroff, st.cst_buf, st.cst_size);
+
+	free(ents);
+	free(st.cst_buf);
+	*ctp = ct;
+	return (0);
+err:
+	free(ents);
+	free(st.cst_buf);
+	free(ct);
+	return (-1);
+}
+#endif
+
+void
+cputab_free(cputab_hdr_t *ct)
+{
+	free(ct);
+}
+
+/*
+ * Write the table out, replacing any at that path atomically.
+ */
+int
+cputab_write(const cputab_hdr_t *ct, const char *path)
+{
+	return (mfile_write(ct, ct->ct_filesz, path));
+}
+
+/*
+ * Check that a table is self-consistent, so that the accessors in cputab.h
+ * can be used on it without further checks.
+ */
+static int
+cputab_check(const void *addr, size_t size)
+{
+	const cputab_hdr_t *ct = addr;
+	const cputab_chip_t *cc;
+	const cputab_core_t *co;
+	const cputab_strand_t *cs;
+	const uint32_t *idx;
+	uint32_t i;
+
+	if (size < sizeof (cputab_hdr_t) || ct->ct_magic != CPUTAB_MAGIC)
+		return (-1);
+	if (ct->ct_version != CPUTAB_VERSION ||
+	    ct->ct_hdrsize != sizeof (cputab_hdr_t) || ct->ct_filesz != size)
+		return (-1);
+
+	if (!MFILE_FITS(ct->ct_chipoff, ct->ct_nchips,
+	    sizeof (cputab_chip_t), size) ||
+	    !MFILE_FITS(ct->ct_coreoff, ct->ct_ncores,
+	    sizeof (cputab_core_t), size) ||
+	    !MFILE_FITS(ct->ct_strandoff, ct->ct_nstrands,
+	    sizeof (cputab_strand_t), size) ||
+	    !MFILE_FITS(ct->ct_idxoff, ct->ct_nidx, sizeof (uint32_t), size) ||
+	    !MFILE_FITS(ct->ct_stroff, ct->ct_strsize, 1, size))
+		return (-1);
+
+	if (ct->ct_strsize == 0 ||
+	    *cputab_str(ct, ct->ct_strsize - 1) != '\0')
+		return (-1);
+
+	for (i = 0; i < ct->ct_nchips; i++) {
+		cc = cputab_chip(ct, i);
+		if (cc->cc_vendor >= ct->ct_strsize ||
+		    cc->cc_rev >= ct->ct_strsize ||
+		    cc->cc_ident >= ct->ct_strsize ||
+		    cc->cc_core > ct->ct_ncores ||
+		    cc->cc_ncores > ct->ct_ncores - cc->cc_core ||
+		    cc->cc_strand > ct->ct_nstrands ||
+		    cc->cc_nstrands > ct->ct_nstrands - cc->cc_strand)
+			return (-1);
+	}
+	for (i = 0; i < ct->ct_ncores; i++) {
+		co = cputab_core(ct, i);
+		if (co->co_chip >= ct->ct_nchips ||
+		    co->co_strand > ct->ct_nstrands ||
+		    co->co_nstrands > ct->ct_nstrands - co->co_strand)
+			return (-1);
+	}
+	for (i = 0; i < ct->ct_nstrands; i++) {
+		cs = (const cputab_strand_t *)((const char *)ct +
+		    ct->ct_strandoff) + i;
+		if (cs->cs_core >= ct->ct_ncores ||
+		    cs->cs_chip >= ct->ct_nchips)
+			return (-1);
+	}
+	idx = (const uint32_t *)((const char *)ct + ct->ct_idxoff);
+	for (i = 0; i < ct->ct_nidx; i++) {
+		if (idx[i] != CPUTAB_NONE && idx[i] >= ct->ct_nstrands)
+			return (-1);
+	}
+	return (0);
+}
+
+/*
+ * Map a table written by cputab_write().
+ */
+int
+cputab_open(const char *path, cputab_hdr_t **ctp)
+{
+	return (mfile_open(path, "CPU table", sizeof (cputab_hdr_t),
+	    cputab_check, (void **)ctp));
+}
+
+void
+cputab_close(cputab_hdr_t *ct)
+{
+	mfile_close(ct, ct->ct_filesz);
+}
+
+static void
+cputab_fmt(char *buf, size_t len, uint32_t v, const char *fmt)
+{
+	if (v == CPUTAB_NONE)
+		(void) strlcpy(buf, "-", len);
+	else
+		(void) snprintf(buf, len, fmt, v);
+}
+
+static void
+cputab_print_chip(const cputab_hdr_t *ct, const cputab_chip_t *cc)
+{
+	char fam[16], mod[16], step[16], sock[16];
+
+	cputab_fmt(fam, sizeof (fam), cc->cc_family, "%x");
+	cputab_fmt(mod, sizeof (mod), cc->cc_model, "%x");
+	cputab_fmt(step, sizeof (step), cc->cc_stepping, "%x");
+	cputab_fmt(sock, sizeof (sock), cc->cc_socket, "0x%x");
+	(void) printf("chip %u: %s family %s model %s stepping %s, "
+	    "rev %s, socket %s, %u cores, %u strands\n", cc->cc_chipid,
+	    *cputab_str(ct, cc->cc_vendor) == '\0' ? "-" :
+	    cputab_str(ct, cc->cc_vendor), fam, mod, step,
+	    *cputab_str(ct, cc->cc_rev) == '\0' ? "-" :
+	    cputab_str(ct, cc->cc_rev), sock, cc->cc_ncores, cc->cc_nstrands);
+	if (*cputab_str(ct, cc->cc_ident) != '\0')
+		(void) printf("    %s\n", cputab_str(ct, cc->cc_ident));
+}
+
+static void
+cputab_print_strand(const cputab_hdr_t *ct, const cputab_strand_t *cs)
+{
+	const cputab_core_t *co = cputab_core(ct, cs->cs_core);
+	char apic[16], smb[16], node[16];
+
+	cputab_fmt(apic, sizeof (apic), cs->cs_apicid, "%u");
+	cputab_fmt(smb, sizeof (smb), cs->cs_smbiosid, "%u");
+	cputab_fmt(node, sizeof (node), co->co_procnode, "%u");
+	(void) printf("%5u %5u %5u %7u %7s %9s %7s\n", cs->cs_cpuid,
+	    cputab_chip(ct, cs->cs_chip)->cc_chipid, co->co_coreid,
+	    cs->cs_strandid, apic, node, smb);
+}
+
+static void
+cputab_print_hdr(void)
+{
+	(void) printf("%5s %5s %5s %7s %7s %9s %7s\n", "CPU", "CHIP", "CORE",
+	    "STRAND", "APICID", "PROCNODE", "SMBIOS");
+}
+
+/*
+ * Print the chips, then every strand in chip, core and strand order.
+ */
+void
+cputab_print(const cputab_hdr_t *ct)
+{
+	const cputab_strand_t *strands = (const cputab_strand_t *)
+	    ((const char *)ct + ct->ct_strandoff);
+	uint32_t i;
+
+	for (i = 0; i < ct->ct_nchips; i++)
+		cputab_print_chip(ct, cputab_chip(ct, i));
+	(void) printf("\n");
+	cputab_print_hdr();
+	for (i = 0; i < ct->ct_nstrands; i++)
+		cputab_print_strand(ct, &strands[i]);
+}
+
+int
+cputab_print_cpu(const cputab_hdr_t *ct, uint32_t cpuid)
+{
+	const cputab_strand_t *cs;
+
+	if ((cs = cputab_strand(ct, cpuid)) == NULL) {
+		(void) fprintf(stderr, "no such CPU: %u\n", cpuid);
+		return (-1);
+	}
+	cputab_print_chip(ct, cputab_chip(ct, cs->cs_chip));
+	(void) printf("\n");
+	cputab_print_hdr();
+	cputab_print_strand(ct, cs);
+	return (0);
+}
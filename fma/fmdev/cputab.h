@@ -0,0 +1,139 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+#ifndef _CPUTAB_H
+#define	_CPUTAB_H
+
+/*
+ * A compact, indexed form of the FM_IOC_PHYSCPU_INFO output, laid out so that
+ * it can be mmap'd and used as-is.  The file is a header followed by arrays
+ * of chips, cores and strands, an index from logical CPU id to strand, and a
+ * string table.  Chips are sorted by chip id, each chip's cores are contiguous
+ * and sorted by core id, and each core's strands are contiguous and sorted by
+ * strand id, so a chip or core is described by a range of the next array.
+ *
+ * Every field is in the byte order of the host that wrote the file; a reader
+ * on the other byte order sees CPUTAB_MAGIC swapped and must reject the file.
+ * Every array starts on an 8-byte boundary.  Strings are referred to by their
+ * offset in the string table, which starts with an empty string, and are
+ * NUL-terminated.  Fields that the driver didn't provide are CPUTAB_NONE.
+ */
+
+#include <sys/types.h>
+#include <stdint.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define	CPUTAB_MAGIC	0x43505554	/* "CPUT" */
+#define	CPUTAB_VERSION	1
+#define	CPUTAB_NONE	UINT32_MAX
+
+typedef struct cputab_hdr {
+	uint32_t ct_magic;		/* CPUTAB_MAGIC */
+	uint16_t ct_version;		/* CPUTAB_VERSION */
+	uint16_t ct_hdrsize;		/* sizeof (cputab_hdr_t) */
+	uint32_t ct_nchips;		/* number of chips */
+	uint32_t ct_ncores;		/* number of cores */
+	uint32_t ct_nstrands;		/* number of strands */
+	uint32_t ct_nidx;		/* entries in index (max cpu id + 1) */
+	uint64_t ct_chipoff;		/* offset of cputab_chip_t array */
+	uint64_t ct_coreoff;		/* offset of cputab_core_t array */
+	uint64_t ct_strandoff;		/* offset of cputab_strand_t array */
+	uint64_t ct_idxoff;		/* offset of uint32_t index by cpu id */
+	uint64_t ct_stroff;		/* offset of string table */
+	uint64_t ct_strsize;		/* size of string table */
+	uint64_t ct_filesz;		/* size of the whole file */
+} cputab_hdr_t;
+
+typedef struct cputab_chip {
+	uint32_t cc_chipid;		/* chip (socket) id */
+	uint32_t cc_vendor;		/* vendor id string */
+	uint32_t cc_family;		/* cpuid family */
+	uint32_t cc_model;		/* cpuid model */
+	uint32_t cc_stepping;		/* cpuid stepping */
+	uint32_t cc_rev;		/* chip revision string */
+	uint32_t cc_ident;		/* chip identity string */
+	uint32_t cc_socket;		/* socket type (X86_SOCKET_*) */
+	uint32_t cc_nprocnodes;		/* processor nodes in this chip */
+	uint32_t cc_core;		/* index of first core */
+	uint32_t cc_ncores;		/* number of cores */
+	uint32_t cc_strand;		/* index of first strand */
+	uint32_t cc_nstrands;		/* number of strands */
+	uint32_t cc_pad;
+} cputab_chip_t;
+
+typedef struct cputab_core {
+	uint32_t co_coreid;		/* core id */
+	uint32_t co_chip;		/* index of chip */
+	uint32_t co_procnode;		/* processor node id */
+	uint32_t co_strand;		/* index of first strand */
+	uint32_t co_nstrands;		/* number of strands */
+	uint32_t co_pad;
+} cputab_core_t;
+
+typedef struct cputab_strand {
+	uint32_t cs_cpuid;		/* logical cpu id */
+	uint32_t cs_strandid;		/* strand id within core */
+	uint32_t cs_apicid;		/* initial APIC id */
+	uint32_t cs_smbiosid;		/* SMBIOS processor id */
+	uint32_t cs_core;		/* index of core */
+	uint32_t cs_chip;		/* index of chip */
+} cputab_strand_t;
+
+/*
+ * Return the strand for a logical CPU id, or NULL if there's no such CPU.
+ */
+static inline const cputab_strand_t *
+cputab_strand(const cputab_hdr_t *ct, uint32_t cpuid)
+{
+	const char *base = (const char *)ct;
+	const uint32_t *idx = (const uint32_t *)(base + ct->ct_idxoff);
+
+	if (cpuid >= ct->ct_nidx || idx[cpuid] == CPUTAB_NONE)
+		return (NULL);
+	return ((const cputab_strand_t *)(base + ct->ct_strandoff) +
+	    idx[cpuid]);
+}
+
+static inline const cputab_core_t *
+cputab_core(const cputab_hdr_t *ct, uint32_t i)
+{
+	return ((const cputab_core_t *)((const char *)ct + ct->ct_coreoff) +
+	    i);
+}
+
+static inline const cputab_chip_t *
+cputab_chip(const cputab_hdr_t *ct, uint32_t i)
+{
+	return ((const cputab_chip_t *)((const char *)ct + ct->ct_chipoff) +
+	    i);
+}
+
+static inline const char *
+cputab_str(const cputab_hdr_t *ct, uint32_t off)
+{
+	return ((const char *)ct + ct->ct_stroff + off);
+}
+
+struct nvlist;
+
+extern int cputab_build(struct nvlist *, cputab_hdr_t **);
+extern int cputab_open(const char *, cputab_hdr_t **);
+extern void cputab_close(cputab_hdr_t *);
+extern void cputab_free(cputab_hdr_t *);
+extern int cputab_write(const cputab_hdr_t *, const char *);
+extern void cputab_print(const cputab_hdr_t *);
+extern int cputab_print_cpu(const cputab_hdr_t *, uint32_t);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _CPUTAB_H */
@@ -9,42 +9,692 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <fcntl.h>
-#include <libnvpair.h>
+#include <inttypes.h>
+#include <pthread.h>
 #include <string.h>
-#include <stropts.h>
+#include <strings.h>
 #include <unistd.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#ifdef	__sun
+#include <atomic.h>
 #include <fm/fmd_agent.h>
 #include <sys/devfm.h>
-#include <sys/types.h>
+#endif
+#ifndef	FMDEV_NO_LIBNVPAIR
+#include <libnvpair.h>
+#endif
+
+#include "cputab.h"
+#include "fmdev_compat.h"
+#include "iocap.h"
+#ifndef	FMDEV_NO_LIBNVPAIR
+#include "nvdiff.h"
+#endif
+#include "pnvl.h"
 
 #define	FMDEV	"/dev/fm"
 
+#define	FMDEV_MAXTHREADS	256
+
+/*
+ * Latencies are kept in a log-linear histogram: each power of two is split
+ * into FMDEV_SUBBKTS buckets, so a percentile read from it is within about
+ * 6% of the real value without having to keep every sample.
+ */
+#define	FMDEV_SUBSHIFT	4
+#define	FMDEV_SUBBKTS	(1 << FMDEV_SUBSHIFT)
+#define	FMDEV_NBKTS	(64 * FMDEV_SUBBKTS)
+
+typedef struct fmdev_hist {
+	uint64_t fh_bkts[FMDEV_NBKTS];	/* counts by log-linear bucket */
+	uint64_t fh_count;		/* number of samples */
+	uint64_t fh_total;		/* sum of samples */
+	uint64_t fh_max;		/* largest sample */
+} fmdev_hist_t;
+
+/*
+ * The state of one thread of a repeat run.  Each thread has its own output
+ * buffer, which it reuses for every call.
+ */
+typedef struct fmdev_thr {
+	struct fmdev_run *ft_run;	/* run this thread is part of */
+	pthread_t ft_tid;		/* thread id */
+	char *ft_buf;			/* output buffer */
+	fmdev_hist_t ft_ioc;		/* ioctl latencies */
+	fmdev_hist_t ft_unpack;		/* unpack latencies */
+	uint64_t ft_errors;		/* failed ioctls and unpacks */
+	uint64_t ft_outsz;		/* size of last reply */
+	int ft_errno;			/* errno of last failure */
+} fmdev_thr_t;
+
+typedef struct fmdev_run {
+	iocap_t *fr_ic;			/* /dev/fm, or a capture of it */
+	int fr_cmd;			/* ioctl to issue */
+	uint64_t fr_count;		/* calls to make, if nonzero */
+	volatile uint64_t fr_issued;	/* number of calls made so far */
+	hrtime_t fr_end;		/* time to stop, if fr_count is zero */
+	fmdev_thr_t *fr_thrs;		/* threads */
+	uint_t fr_nthrs;		/* number of threads */
+} fmdev_run_t;
+
 static const char *pname;
-static const char optstr[] = "i:";
+static const char optstr[] = "C:d:i:n:o:P:q:r:t:Tw:";
 
 static void
 usage()
 {
-	(void) fprintf(stderr, "usage: %s -i <ioctl>\n\n"
+	(void) fprintf(stderr, "usage: %s [-C file | -P file] -i <ioctl>\n"
+	    "       %s [-C file | -P file] -i <ioctl> -n count | -d seconds "
+	    "[-t nthreads]\n"
+	    "       %s [-C file | -P file] -i <ioctl> -w interval "
+	    "[-n samples]\n"
+	    "       %s [-C file | -P file] -i physcpu_info [-T] [-o file] "
+	    "[-q cpuid]\n"
+	    "       %s -r file [-q cpuid]\n\n"
 	    "where \'ioctl\' can be:\n"
-	    "versions, physcpu_info, gentopo_legacy\n\n", pname);
+	    "versions, physcpu_info, gentopo_legacy\n\n"
+	    "With -n or -d, the ioctl is issued repeatedly (from -t threads) "
+	    "and its\nlatency is reported instead of its output.\n\n"
+	    "With -w, the ioctl is issued every interval seconds and only "
+	    "the changes to\nits output are printed.\n\n"
+	    "With -T, -o or -q, the physcpu_info output is turned into a chip, "
+	    "core and\nstrand table, which is printed (-T), written to a file "
+	    "(-o) or queried for\none CPU (-q).  -r reads a table written with "
+	    "-o.\n\n"
+	    "-C records every ioctl issued, and its output, to a capture file, "
+	    "and -P\nplays one back in place of %s.\n\n",
+	    pname, pname, pname, pname, pname, FMDEV);
+}
+
+static uint_t
+fmdev_bkt(uint64_t v)
+{
+	uint_t log2;
+
+	if (v < FMDEV_SUBBKTS)
+		return ((uint_t)v);
+	log2 = 63 - __builtin_clzll(v);
+	return (((log2 - FMDEV_SUBSHIFT + 1) << FMDEV_SUBSHIFT) +
+	    (uint_t)((v >> (log2 - FMDEV_SUBSHIFT)) & (FMDEV_SUBBKTS - 1)));
+}
+
+/*
+ * Return the largest value that falls into a bucket.
+ */
+static uint64_t
+fmdev_bkt_max(uint_t b)
+{
+	uint_t log2;
+
+	if (b < FMDEV_SUBBKTS)
+		return (b);
+	log2 = (b >> FMDEV_SUBSHIFT) + FMDEV_SUBSHIFT - 1;
+	return ((((uint64_t)(b & (FMDEV_SUBBKTS - 1)) + FMDEV_SUBBKTS + 1) <<
+	    (log2 - FMDEV_SUBSHIFT)) - 1);
+}
+
+static void
+fmdev_hist_add(fmdev_hist_t *fh, uint64_t v)
+{
+	fh->fh_bkts[fmdev_bkt(v)]++;
+	fh->fh_count++;
+	fh->fh_total += v;
+	if (v > fh->fh_max)
+		fh->fh_max = v;
+}
+
+static void
+fmdev_hist_merge(fmdev_hist_t *to, const fmdev_hist_t *from)
+{
+	uint_t i;
+
+	for (i = 0; i < FMDEV_NBKTS; i++)
+		to->fh_bkts[i] += from->fh_bkts[i];
+	to->fh_count += from->fh_count;
+	to->fh_total += from->fh_total;
+	if (from->fh_max > to->fh_max)
+		to->fh_max = from->fh_max;
+}
+
+/*
+ * Return the value below which the given fraction of samples fall.
+ */
+static uint64_t
+fmdev_hist_pct(const fmdev_hist_t *fh, double pct)
+{
+	uint64_t n = 0, want = (uint64_t)(pct * fh->fh_count);
+	uint_t i;
+
+	if (want == 0)
+		want = 1;
+	for (i = 0; i < FMDEV_NBKTS; i++) {
+		if ((n += fh->fh_bkts[i]) >= want)
+			break;
+	}
+	if (i == FMDEV_NBKTS || fmdev_bkt_max(i) > fh->fh_max)
+		return (fh->fh_max);
+	return (fmdev_bkt_max(i));
+}
+
+static void
+fmdev_fmt_ns(char *buf, size_t len, uint64_t ns)
+{
+	if (ns < 10000)
+		(void) snprintf(buf, len, "%lluns", (u_longlong_t)ns);
+	else if (ns < 10000000)
+		(void) snprintf(buf, len, "%lluus", (u_longlong_t)ns / 1000);
+	else
+		(void) snprintf(buf, len, "%llums",
+		    (u_longlong_t)ns / 1000000);
+}
+
+/*
+ * Print a summary line for a histogram, followed by its distribution by
+ * power of two in the style of DTrace's quantize().
+ */
+static void
+fmdev_hist_print(const char *what, const fmdev_hist_t *fh)
+{
+	char p50[24], p99[24], p999[24], max[24], mean[24];
+	uint64_t pow2[64] = { 0 };
+	uint_t i, lo = 64, hi = 0, bar;
+
+	if (fh->fh_count == 0) {
+		(void) printf("%s: no samples\n", what);
+		return;
+	}
+
+	fmdev_fmt_ns(p50, sizeof (p50), fmdev_hist_pct(fh, 0.50));
+	fmdev_fmt_ns(p99, sizeof (p99), fmdev_hist_pct(fh, 0.99));
+	fmdev_fmt_ns(p999, sizeof (p999), fmdev_hist_pct(fh, 0.999));
+	fmdev_fmt_ns(max, sizeof (max), fh->fh_max);
+	fmdev_fmt_ns(mean, sizeof (mean), fh->fh_total / fh->fh_count);
+	(void) printf("%s: p50 %s, p99 %s, p99.9 %s, max %s, mean %s\n\n",
+	    what, p50, p99, p999, max, mean);
+
+	for (i = 0; i < FMDEV_NBKTS; i++) {
+		uint64_t v = fmdev_bkt_max(i);
+		uint_t p = v == 0 ? 0 : 63 - __builtin_clzll(v);
+
+		if (fh->fh_bkts[i] == 0)
+			continue;
+		pow2[p] += fh->fh_bkts[i];
+		if (p < lo)
+			lo = p;
+		if (p > hi)
+			hi = p;
+	}
+
+	(void) printf("%16s  %s %s\n", "ns", "------------- Distribution "
+	    "-------------", "count");
+	if (lo > 0)
+		lo--;
+	for (i = lo; i <= hi + 1 && i < 64; i++) {
+		bar = (uint_t)((pow2[i] * 40 + fh->fh_count / 2) /
+		    fh->fh_count);
+		(void) printf("%16llu |%-40.*s %llu\n",
+		    i == 0 ? 0ULL : 1ULL << i, bar,
+		    "@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@",
+		    (u_longlong_t)pow2[i]);
+	}
+	(void) printf("\n");
+}
+
+/*
+ * Claim the next call, returning false once the run is over.
+ */
+static boolean_t
+fmdev_next(fmdev_run_t *fr)
+{
+	if (fr->fr_count != 0)
+		return (atomic_inc_64_nv(&fr->fr_issued) <= fr->fr_count);
+	if (gethrtime() >= fr->fr_end)
+		return (B_FALSE);
+	atomic_inc_64(&fr->fr_issued);
+	return (B_TRUE);
+}
+
+#ifdef	FMDEV_NO_LIBNVPAIR
+/*
+ * Without libnvpair, the output is decoded where it lies instead of unpacked:
+ * every pair, including those in embedded nvlists, is visited.
+ */
+static int
+fmdev_walk(const pnvl_t *nvl)
+{
+	pnvl_pair_t pp;
+	pnvl_t child;
+	uint_t i;
+	int err;
+
+	for (err = pnvl_first(nvl, &pp); err == 0; err = pnvl_next(&pp)) {
+		if (pp.pp_type != DATA_TYPE_NVLIST &&
+		    pp.pp_type != DATA_TYPE_NVLIST_ARRAY)
+			continue;
+		for (i = 0; i < pp.pp_nelem; i++) {
+			if (i == 0)
+				err = pnvl_value_nvlist(&pp, 0, &child);
+			else
+				err = pnvl_nvlist_next(&child);
+			if (err != 0 || (err = fmdev_walk(&child)) != 0)
+				return (err);
+		}
+	}
+	return (err == ENOENT ? 0 : err);
+}
+#endif
+
+/*
+ * Issue the ioctl until the run is over, timing the ioctl itself and the
+ * unpacking (and freeing) of its output separately.
+ */
+static void *
+fmdev_worker(void *arg)
+{
+	fmdev_thr_t *ft = arg;
+	fmdev_run_t *fr = ft->ft_run;
+	fm_ioc_data_t iocdata = { 0 };
+#ifdef	FMDEV_NO_LIBNVPAIR
+	pnvl_t nvl;
+	int err;
+#else
+	nvlist_t *nvl;
+#endif
+	hrtime_t start, mid, end;
+
+	iocdata.fid_version = 1;
+	iocdata.fid_outbuf = ft->ft_buf;
+
+	while (fmdev_next(fr)) {
+		iocdata.fid_outsz = FM_IOC_OUT_MAXBUFSZ;
+
+		start = gethrtime();
+		if (iocap_ioctl(fr->fr_ic, fr->fr_cmd, &iocdata,
+		    sizeof (iocdata), IOCAP_BUF(iocdata.fid_outbuf,
+		    iocdata.fid_outsz)) < 0) {
+			ft->ft_errors++;
+			ft->ft_errno = errno;
+			continue;
+		}
+		mid = gethrtime();
+#ifdef	FMDEV_NO_LIBNVPAIR
+		if ((err = pnvl_init(&nvl, iocdata.fid_outbuf,
+		    iocdata.fid_outsz)) != 0 || (err = fmdev_walk(&nvl)) != 0) {
+			ft->ft_errors++;
+			ft->ft_errno = err;
+			continue;
+		}
+#else
+		if (nvlist_unpack(iocdata.fid_outbuf, iocdata.fid_outsz,
+		    &nvl, NV_UNIQUE_NAME) != 0) {
+			ft->ft_errors++;
+			ft->ft_errno = errno;
+			continue;
+		}
+		nvlist_free(nvl);
+#endif
+		end = gethrtime();
+
+		fmdev_hist_add(&ft->ft_ioc, mid - start);
+		fmdev_hist_add(&ft->ft_unpack, end - mid);
+		ft->ft_outsz = iocdata.fid_outsz;
+	}
+	return (NULL);
+}
+
+static int
+fmdev_repeat(iocap_t *ic, int cmd, const char *ioc, uint64_t count,
+    uint64_t secs, uint_t nthrs)
+{
+	fmdev_run_t fr = { 0 };
+	fmdev_hist_t *ioch = NULL, *unpackh = NULL;
+	fmdev_thr_t *ft;
+	hrtime_t start, elapsed;
+	uint64_t calls, errors = 0, outsz = 0;
+	uint_t i, started;
+	int err, lasterr = 0, status = 1;
+
+	fr.fr_ic = ic;
+	fr.fr_cmd = cmd;
+	fr.fr_count = count;
+	fr.fr_nthrs = nthrs;
+	if ((fr.fr_thrs = calloc(nthrs, sizeof (fmdev_thr_t))) == NULL ||
+	    (ioch = calloc(1, sizeof (fmdev_hist_t))) == NULL ||
+	    (unpackh = calloc(1, sizeof (fmdev_hist_t))) == NULL) {
+		(void) fprintf(stderr, "malloc failed\n");
+		goto out;
+	}
+	for (i = 0; i < nthrs; i++) {
+		ft = &fr.fr_thrs[i];
+		ft->ft_run = &fr;
+		if ((ft->ft_buf = malloc(FM_IOC_OUT_MAXBUFSZ)) == NULL) {
+			(void) fprintf(stderr, "malloc failed\n");
+			goto out;
+		}
+	}
+
+	start = gethrtime();
+	fr.fr_end = start + (hrtime_t)secs * NANOSEC;
+	for (started = 0; started < nthrs; started++) {
+		ft = &fr.fr_thrs[started];
+		if ((err = pthread_create(&ft->ft_tid, NULL, fmdev_worker,
+		    ft)) != 0) {
+			(void) fprintf(stderr, "failed to create thread (%s)\n",
+			    strerror(err));
+			break;
+		}
+	}
+	if (started == 0)
+		(void) fmdev_worker(&fr.fr_thrs[0]);
+	for (i = 0; i < started; i++)
+		(void) pthread_join(fr.fr_thrs[i].ft_tid, NULL);
+	elapsed = gethrtime() - start;
+
+	for (i = 0; i < nthrs; i++) {
+		ft = &fr.fr_thrs[i];
+		fmdev_hist_merge(ioch, &ft->ft_ioc);
+		fmdev_hist_merge(unpackh, &ft->ft_unpack);
+		errors += ft->ft_errors;
+		if (ft->ft_errors != 0)
+			lasterr = ft->ft_errno;
+		if (ft->ft_outsz > outsz)
+			outsz = ft->ft_outsz;
+	}
+
+	calls = ioch->fh_count + errors;
+	(void) printf("%s: %llu calls on %u threads in %.3f s (%.0f calls/s), "
+	    "%llu failed, replies of up to %llu bytes\n\n", ioc,
+	    (u_longlong_t)calls, started == 0 ? 1 : started,
+	    (double)elapsed / NANOSEC,
+	    (double)calls * NANOSEC / (elapsed == 0 ? 1 : elapsed),
+	    (u_longlong_t)errors, (u_longlong_t)outsz);
+	if (errors != 0) {
+		(void) fprintf(stderr, "last failure: %s\n",
+		    strerror(lasterr));
+	}
+	fmdev_hist_print("ioctl", ioch);
+#ifdef	FMDEV_NO_LIBNVPAIR
+	fmdev_hist_print("walk", unpackh);
+#else
+	fmdev_hist_print("unpack", unpackh);
+#endif
+	status = errors == 0 ? 0 : 1;
+out:
+	if (fr.fr_thrs != NULL) {
+		for (i = 0; i < nthrs; i++)
+			free(fr.fr_thrs[i].ft_buf);
+	}
+	free(fr.fr_thrs);
+	free(ioch);
+	free(unpackh);
+	return (status);
+}
+
+#ifndef	FMDEV_NO_LIBNVPAIR
+/*
+ * A hash of the packed output, taken a word at a time.  It only has to tell
+ * one sample from the next, so a multiply-xorshift mix will do.
+ */
+static uint64_t
+fmdev_hash(const char *buf, size_t len)
+{
+	uint64_t h = len * 0x9e3779b97f4a7c15ULL, w;
+
+	for (; len >= sizeof (w); buf += sizeof (w), len -= sizeof (w)) {
+		(void) memcpy(&w, buf, sizeof (w));
+		h = (h ^ w) * 0xff51afd7ed558ccdULL;
+		h ^= h >> 32;
+	}
+	if (len > 0) {
+		w = 0;
+		(void) memcpy(&w, buf, len);
+		h = (h ^ w) * 0xff51afd7ed558ccdULL;
+	}
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return (h);
+}
+
+static void
+fmdev_banner(const char *ioc, const char *what, size_t size, uint64_t hash)
+{
+	char tbuf[32];
+	struct tm tm;
+	time_t now = time(NULL);
+
+	if (gmtime_r(&now, &tm) == NULL || strftime(tbuf, sizeof (tbuf),
+	    "%Y-%m-%dT%H:%M:%SZ", &tm) == 0)
+		(void) strlcpy(tbuf, "?", sizeof (tbuf));
+	(void) printf("=== %s %s: %s (%zu bytes, hash %016" PRIx64 ")\n",
+	    tbuf, ioc, what, size, hash);
+}
+
+/*
+ * Issue the ioctl every interval and print what changed since the last
+ * sample.  The packed output is hashed first, and only unpacked and compared
+ * when the hash (or size) changed, so an idle sample costs just the ioctl and
+ * a pass over its output.
+ */
+static int
+fmdev_sample(iocap_t *ic, int cmd, const char *ioc, hrtime_t interval,
+    uint64_t count)
+{
+	fm_ioc_data_t iocdata = { 0 };
+	nvlist_t *prev = NULL, *cur;
+	uint64_t hash, lasthash = 0, samples = 0, changes = 0, errors = 0;
+	size_t lastsz = 0;
+	hrtime_t next, now;
+	struct timespec ts;
+	char *outbuf;
+	uint_t ndiffs;
+	int lasterr = 0;
+
+	if ((outbuf = malloc(FM_IOC_OUT_MAXBUFSZ)) == NULL) {
+		(void) fprintf(stderr, "malloc failed\n");
+		return (1);
+	}
+	iocdata.fid_version = 1;
+	iocdata.fid_outbuf = outbuf;
+
+	for (next = gethrtime(); count == 0 || samples < count;
+	    next += interval) {
+		if (samples++ > 0) {
+			if ((now = gethrtime()) < next) {
+				ts.tv_sec = (next - now) / NANOSEC;
+				ts.tv_nsec = (next - now) % NANOSEC;
+				(void) nanosleep(&ts, NULL);
+			} else {
+				next = now;
+			}
+		}
+
+		iocdata.fid_outsz = FM_IOC_OUT_MAXBUFSZ;
+		if (iocap_ioctl(ic, cmd, &iocdata, sizeof (iocdata),
+		    IOCAP_BUF(iocdata.fid_outbuf, iocdata.fid_outsz)) < 0) {
+			/*
+			 * Only report the first of a run of identical
+			 * failures.
+			 */
+			if (errno != lasterr) {
+				(void) fprintf(stderr, "ioctl failed (%s)\n",
+				    strerror(errno));
+			}
+			lasterr = errno;
+			errors++;
+			continue;
+		}
+		lasterr = 0;
+
+		hash = fmdev_hash(outbuf, iocdata.fid_outsz);
+		if (prev != NULL && hash == lasthash &&
+		    iocdata.fid_outsz == lastsz)
+			continue;
+
+		if (nvlist_unpack(outbuf, iocdata.fid_outsz, &cur,
+		    NV_UNIQUE_NAME) != 0) {
+			(void) fprintf(stderr, "failed to unpack nvlist (%s)\n",
+			    strerror(errno));
+			errors++;
+			continue;
+		}
+		if (prev == NULL) {
+			fmdev_banner(ioc, "initial state", iocdata.fid_outsz,
+			    hash);
+			nvlist_print(stdout, cur);
+		} else {
+			fmdev_banner(ioc, "changed", iocdata.fid_outsz, hash);
+			if ((ndiffs = nvdiff(stdout, prev, cur)) == 0)
+				(void) printf("no changes to the nvpairs\n");
+			else
+				changes++;
+			nvlist_free(prev);
+		}
+		(void) fflush(stdout);
+		prev = cur;
+		lasthash = hash;
+		lastsz = iocdata.fid_outsz;
+	}
+
+	(void) printf("%" PRIu64 " samples, %" PRIu64 " with changes, %"
+	    PRIu64 " failed\n", samples, changes, errors);
+	nvlist_free(prev);
+	free(outbuf);
+	return (errors == 0 ? 0 : 1);
+}
+#endif
+
+/*
+ * Parse an interval in seconds, which may be fractional.
+ */
+static int
+fmdev_interval(const char *arg, hrtime_t *ivp)
+{
+	char *end;
+	double v;
+
+	errno = 0;
+	v = strtod(arg, &end);
+	if (errno != 0 || end == arg || *end != '\0' || v < 0.001 ||
+	    v > INT32_MAX) {
+		(void) fprintf(stderr, "invalid interval: %s\n", arg);
+		return (-1);
+	}
+	*ivp = (hrtime_t)(v * NANOSEC);
+	return (0);
+}
+
+static int
+fmdev_num(const char *arg, const char *what, uint64_t min, uint64_t max,
+    uint64_t *vp)
+{
+	char *end;
+	u_longlong_t v;
+
+	errno = 0;
+	v = strtoull(arg, &end, 10);
+	if (errno != 0 || end == arg || *end != '\0' || v < min || v > max) {
+		(void) fprintf(stderr, "invalid %s: %s\n", what, arg);
+		return (-1);
+	}
+	*vp = v;
+	return (0);
+}
+
+#ifndef	FMDEV_NO_LIBNVPAIR
+/*
+ * Turn the physcpu_info output into a CPU table and print, write and/or
+ * query it.
+ */
+static int
+fmdev_cputab(nvlist_t *nvl, boolean_t print, const char *file,
+    int64_t cpuid)
+{
+	cputab_hdr_t *ct;
+	int status = 0;
+
+	if (cputab_build(nvl, &ct) != 0)
+		return (1);
+	if (file != NULL && cputab_write(ct, file) != 0)
+		status = 1;
+	if (print)
+		cputab_print(ct);
+	if (cpuid >= 0) {
+		if (print)
+			(void) printf("\n");
+		if (cputab_print_cpu(ct, (uint32_t)cpuid) != 0)
+			status = 1;
+	}
+	cputab_free(ct);
+	return (status);
 }
+#endif
 
 int
 main(int argc, char **argv)
 {
-	char c, *ioc = NULL, *outbuf = NULL;
+	char c, *ioc = NULL, *outbuf = NULL, *tabout = NULL, *tabin = NULL;
+	char *capout = NULL, *capin = NULL;
 	fm_ioc_data_t iocdata = { 0 };
+#ifndef	FMDEV_NO_LIBNVPAIR
 	nvlist_t *outnv = NULL;
-	int cmd, fd, status = 1;
+#endif
+	uint64_t count = 0, secs = 0, nthrs = 1, cpuid;
+	int64_t query = -1;
+	hrtime_t interval = 0;
+	boolean_t table = B_FALSE;
+	iocap_t *ic;
+	int cmd, err, status = 1;
 
 	pname = argv[0];
 	while (optind < argc) {
 		while ((c = getopt(argc, argv, optstr)) != -1) {
 			switch (c) {
+			case 'C':
+				capout = optarg;
+				break;
+			case 'd':
+				if (fmdev_num(optarg, "duration", 1, INT32_MAX,
+				    &secs) != 0)
+					return (2);
+				break;
 			case 'i':
 				ioc = optarg;
 				break;
+			case 'o':
+				tabout = optarg;
+				break;
+			case 'P':
+				capin = optarg;
+				break;
+			case 'q':
+				if (fmdev_num(optarg, "cpu id", 0,
+				    UINT32_MAX - 1, &cpuid) != 0)
+					return (2);
+				query = (int64_t)cpuid;
+				break;
+			case 'r':
+				tabin = optarg;
+				break;
+			case 'T':
+				table = B_TRUE;
+				break;
+			case 'w':
+				if (fmdev_interval(optarg, &interval) != 0)
+					return (2);
+				break;
+			case 'n':
+				if (fmdev_num(optarg, "count", 1,
+				    UINT64_MAX, &count) != 0)
+					return (2);
+				break;
+			case 't':
+				if (fmdev_num(optarg, "thread count", 1,
+				    FMDEV_MAXTHREADS, &nthrs) != 0)
+					return (2);
+				break;
 			default:
 				usage();
 				return (2);
@@ -52,11 +702,48 @@ main(int argc, char **argv)
 		}
 	}
 
+	if (tabin != NULL) {
+		cputab_hdr_t *ct;
+
+		if (ioc != NULL || tabout != NULL || table || capout != NULL ||
+		    capin != NULL) {
+			(void) fprintf(stderr, "-r can only be combined with "
+			    "-q\n");
+			usage();
+			return (2);
+		}
+		if (cputab_open(tabin, &ct) != 0)
+			return (1);
+		status = 0;
+		if (query < 0)
+			cputab_print(ct);
+		else if (cputab_print_cpu(ct, (uint32_t)query) != 0)
+			status = 1;
+		cputab_close(ct);
+		return (status);
+	}
+
 	if (ioc == NULL) {
 		(void) fprintf(stderr, "-i option is required\n");
 		usage();
 		return (2);
 	}
+	if (interval != 0 && (secs != 0 || nthrs != 1 || table ||
+	    tabout != NULL || query >= 0)) {
+		(void) fprintf(stderr, "-w can only be combined with -n\n");
+		usage();
+		return (2);
+	}
+	if (count != 0 && secs != 0) {
+		(void) fprintf(stderr, "-n and -d are mutually exclusive\n");
+		usage();
+		return (2);
+	}
+	if (capout != NULL && capin != NULL) {
+		(void) fprintf(stderr, "-C and -P are mutually exclusive\n");
+		usage();
+		return (2);
+	}
 	if (strcasecmp(ioc, "versions") == 0) {
 		cmd = FM_IOC_VERSIONS;
 	} else if (strcmp(ioc, "physcpu_info") == 0) {
@@ -68,11 +755,52 @@ main(int argc, char **argv)
 		usage();
 		return (2);
 	}
-	if ((fd = open(FMDEV, O_RDWR)) < 0) {
-		(void) fprintf(stderr, "failed to open %s (%s)\n", FMDEV,
-		    strerror(errno));
+	if ((table || tabout != NULL || query >= 0) &&
+	    cmd != FM_IOC_PHYSCPU_INFO) {
+		(void) fprintf(stderr, "-T, -o and -q only apply to "
+		    "physcpu_info\n");
+		usage();
+		return (2);
+	}
+	if ((table || tabout != NULL || query >= 0) &&
+	    (count != 0 || secs != 0)) {
+		(void) fprintf(stderr, "-T, -o and -q can't be combined with "
+		    "-n or -d\n");
+		usage();
+		return (2);
+	}
+#ifdef	FMDEV_NO_LIBNVPAIR
+	if (interval != 0 || table || tabout != NULL || query >= 0) {
+		(void) fprintf(stderr, "-w, -T, -o and -q need libnvpair, "
+		    "which this build doesn't have\n");
+		return (2);
+	}
+#endif
+#ifdef	IOCAP_PLAYBACK_ONLY
+	if (capin == NULL) {
+		(void) fprintf(stderr, "this build can only play captures "
+		    "back, with -P\n");
+		usage();
+		return (2);
+	}
+#endif
+	if ((ic = iocap_open(FMDEV, O_RDWR, capout, capin)) == NULL) {
+		(void) fprintf(stderr, "failed to open %s (%s)\n",
+		    capin != NULL ? capin : FMDEV, strerror(errno));
 		return (1);
 	}
+
+#ifndef	FMDEV_NO_LIBNVPAIR
+	if (interval != 0) {
+		status = fmdev_sample(ic, cmd, ioc, interval, count);
+		goto out;
+	}
+#endif
+	if (count != 0 || secs != 0) {
+		status = fmdev_repeat(ic, cmd, ioc, count, secs, (uint_t)nthrs);
+		goto out;
+	}
+
 	if ((outbuf = malloc(FM_IOC_OUT_MAXBUFSZ)) == 0) {
 		(void) fprintf(stderr, "malloc failed\n");
 		goto out;
@@ -81,23 +809,47 @@ main(int argc, char **argv)
 	iocdata.fid_version = 1;
 	iocdata.fid_outbuf = outbuf;
 	iocdata.fid_outsz = FM_IOC_OUT_MAXBUFSZ;
-	if (ioctl(fd, cmd, &iocdata) < 0) {
+	if (iocap_ioctl(ic, cmd, &iocdata, sizeof (iocdata),
+	    IOCAP_BUF(iocdata.fid_outbuf, iocdata.fid_outsz)) < 0) {
 		(void) fprintf(stderr, "ioctl failed (%s)\n", strerror(errno));
 		goto out;
 	}
 
+	/*
+	 * Plain output is printed straight from the packed buffer; only the
+	 * CPU table needs the nvlist unpacked.
+	 */
+	if (!table && tabout == NULL && query < 0) {
+		pnvl_t pnvl;
+
+		if ((err = pnvl_init(&pnvl, iocdata.fid_outbuf,
+		    iocdata.fid_outsz)) != 0 ||
+		    (err = pnvl_print(stdout, &pnvl)) != 0) {
+			(void) fprintf(stderr, "failed to decode nvlist (%s)\n",
+			    strerror(err));
+			goto out;
+		}
+		status = 0;
+		goto out;
+	}
+
+#ifndef	FMDEV_NO_LIBNVPAIR
 	if (nvlist_unpack(iocdata.fid_outbuf, iocdata.fid_outsz, &outnv,
 	    NV_UNIQUE_NAME) < 0) {
 		(void) fprintf(stderr, "failed to unpack nvlist (%s)",
 		    strerror(errno));
 		goto out;
 	}
-	nvlist_print(stdout, outnv);
+	status = fmdev_cputab(outnv, table, tabout, query);
 	nvlist_free(outnv);
-	status = 0;
+#endif
 out:
 	free(outbuf);
-	(void) close(fd);
+	if (iocap_close(ic) != 0) {
+		(void) fprintf(stderr, "failed to write %s (%s)\n", capout,
+		    strerror(errno));
+		status = 1;
+	}
 
 	return (status);
 }
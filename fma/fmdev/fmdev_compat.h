@@ -0,0 +1,49 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+#ifndef _FMDEV_COMPAT_H
+#define	_FMDEV_COMPAT_H
+
+/*
+ * The parts of sys/devfm.h that fmdev uses, for building it on Linux to play
+ * captures back (see the makefile).  A capture records each ioctl's command
+ * and argument structure as they were on illumos, so these have to match the
+ * amd64 definitions exactly.  On illumos this is empty.
+ */
+#ifndef	__sun
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "compat.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define	FM_IOC_OUT_MAXBUFSZ	524288
+
+typedef struct fm_ioc_data {
+	uint32_t fid_version;		/* interface version */
+	size_t fid_insz;		/* size of packed input nvlist */
+	caddr_t fid_inbuf;		/* buf containing packed input nvl */
+	size_t fid_outsz;		/* size of packed output nvlist */
+	caddr_t fid_outbuf;		/* buf containing packed output nvl */
+} fm_ioc_data_t;
+
+#define	FM_IOC			(0xFA << 16)
+#define	FM_IOC_VERSIONS		(FM_IOC | 1)
+#define	FM_IOC_PHYSCPU_INFO	(FM_IOC | 5)
+#define	FM_IOC_GENTOPO_LEGACY	(FM_IOC | 9)
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* !__sun */
+
+#endif	/* _FMDEV_COMPAT_H */
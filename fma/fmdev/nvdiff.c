@@ -0,0 +1,298 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+/*
+ * Report the differences between two nvlists, one line per leaf nvpair that
+ * was added (+), removed (-) or changed (~), named by its path from the top,
+ * e.g. "cpus[3].core-id".  Embedded nvlists are descended into and nvlist
+ * arrays are compared element by element, so a change deep inside a large
+ * nvlist is reported as just that change.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <libnvpair.h>
+#include <string.h>
+
+#include "nvdiff.h"
+
+#define	NVDIFF_MAXPATH	1024
+
+static void
+nvdiff_str(FILE *fp, const char *s)
+{
+	(void) fputc('"', fp);
+	for (; *s != '\0'; s++) {
+		if (*s == '"' || *s == '\\')
+			(void) fputc('\\', fp);
+		(void) fputc(*s, fp);
+	}
+	(void) fputc('"', fp);
+}
+
+#define	NVDIFF_SCALAR(T, t, ctype, fmt, cast)				\
+	case DATA_TYPE_##T: {						\
+		ctype v;						\
+		(void) nvpair_value_##t(nvp, &v);			\
+		(void) fprintf(fp, fmt, (cast)v);			\
+		break;							\
+	}
+
+#define	NVDIFF_ARRAY(T, t, ctype, fmt, cast)				\
+	case DATA_TYPE_##T##_ARRAY: {					\
+		ctype *v;						\
+		(void) nvpair_value_##t##_array(nvp, &v, &n);		\
+		(void) fputc('[', fp);					\
+		for (i = 0; i < n; i++) {				\
+			(void) fprintf(fp, i == 0 ? fmt : ", " fmt,	\
+			    (cast)v[i]);				\
+		}							\
+		(void) fputc(']', fp);					\
+		break;							\
+	}
+
+/*
+ * Write the value of a leaf nvpair.
+ */
+static void
+nvdiff_val(FILE *fp, nvpair_t *nvp)
+{
+	uint_t i, n;
+
+	switch (nvpair_type(nvp)) {
+	case DATA_TYPE_BOOLEAN:
+		(void) fputs("true", fp);
+		break;
+	case DATA_TYPE_BOOLEAN_VALUE: {
+		boolean_t b;
+
+		(void) nvpair_value_boolean_value(nvp, &b);
+		(void) fputs(b ? "true" : "false", fp);
+		break;
+	}
+	NVDIFF_SCALAR(BYTE, byte, uchar_t, "0x%x", uint_t)
+	NVDIFF_SCALAR(INT8, int8, int8_t, "%d", int)
+	NVDIFF_SCALAR(UINT8, uint8, uint8_t, "0x%x", uint_t)
+	NVDIFF_SCALAR(INT16, int16, int16_t, "%d", int)
+	NVDIFF_SCALAR(UINT16, uint16, uint16_t, "0x%x", uint_t)
+	NVDIFF_SCALAR(INT32, int32, int32_t, "%d", int)
+	NVDIFF_SCALAR(UINT32, uint32, uint32_t, "0x%x", uint_t)
+	NVDIFF_SCALAR(INT64, int64, int64_t, "%lld", longlong_t)
+	NVDIFF_SCALAR(UINT64, uint64, uint64_t, "0x%llx", u_longlong_t)
+	NVDIFF_SCALAR(HRTIME, hrtime, hrtime_t, "%lld", longlong_t)
+	NVDIFF_SCALAR(DOUBLE, double, double, "%.17g", double)
+	case DATA_TYPE_STRING: {
+		char *s;
+
+		(void) nvpair_value_string(nvp, &s);
+		nvdiff_str(fp, s);
+		break;
+	}
+	NVDIFF_ARRAY(BOOLEAN, boolean, boolean_t, "%d", int)
+	NVDIFF_ARRAY(BYTE, byte, uchar_t, "0x%x", uint_t)
+	NVDIFF_ARRAY(INT8, int8, int8_t, "%d", int)
+	NVDIFF_ARRAY(UINT8, uint8, uint8_t, "0x%x", uint_t)
+	NVDIFF_ARRAY(INT16, int16, int16_t, "%d", int)
+	NVDIFF_ARRAY(UINT16, uint16, uint16_t, "0x%x", uint_t)
+	NVDIFF_ARRAY(INT32, int32, int32_t, "%d", int)
+	NVDIFF_ARRAY(UINT32, uint32, uint32_t, "0x%x", uint_t)
+	NVDIFF_ARRAY(INT64, int64, int64_t, "%lld", longlong_t)
+	NVDIFF_ARRAY(UINT64, uint64, uint64_t, "0x%llx", u_longlong_t)
+	case DATA_TYPE_STRING_ARRAY: {
+		char **v;
+
+		(void) nvpair_value_string_array(nvp, &v, &n);
+		(void) fputc('[', fp);
+		for (i = 0; i < n; i++) {
+			if (i > 0)
+				(void) fputs(", ", fp);
+			nvdiff_str(fp, v[i]);
+		}
+		(void) fputc(']', fp);
+		break;
+	}
+	default:
+		(void) fprintf(fp, "<type %d>", nvpair_type(nvp));
+		break;
+	}
+}
+
+#undef	NVDIFF_SCALAR
+#undef	NVDIFF_ARRAY
+
+/*
+ * Return the value of a leaf nvpair as an allocated string, which is what
+ * values are compared by.
+ */
+static char *
+nvdiff_fmt(nvpair_t *nvp)
+{
+	char *buf = NULL;
+	size_t len = 0;
+	FILE *fp;
+
+	if ((fp = open_memstream(&buf, &len)) == NULL)
+		return (NULL);
+	nvdiff_val(fp, nvp);
+	if (fclose(fp) != 0) {
+		free(buf);
+		return (NULL);
+	}
+	return (buf);
+}
+
+static void
+nvdiff_path(char *buf, const char *path, const char *name)
+{
+	if (*path == '\0')
+		(void) snprintf(buf, NVDIFF_MAXPATH, "%s", name);
+	else
+		(void) snprintf(buf, NVDIFF_MAXPATH, "%s.%s", path, name);
+}
+
+static uint_t nvdiff_all(FILE *, char, nvlist_t *, const char *);
+
+/*
+ * Report every leaf under an nvpair that's only on one side.
+ */
+static uint_t
+nvdiff_one(FILE *fp, char mark, nvpair_t *nvp, const char *path)
+{
+	char child[NVDIFF_MAXPATH], elem[NVDIFF_MAXPATH];
+	nvlist_t *nv, **nva;
+	uint_t i, n, ndiffs = 0;
+	char *val;
+
+	nvdiff_path(child, path, nvpair_name(nvp));
+	switch (nvpair_type(nvp)) {
+	case DATA_TYPE_NVLIST:
+		(void) nvpair_value_nvlist(nvp, &nv);
+		return (nvdiff_all(fp, mark, nv, child));
+	case DATA_TYPE_NVLIST_ARRAY:
+		(void) nvpair_value_nvlist_array(nvp, &nva, &n);
+		for (i = 0; i < n; i++) {
+			(void) snprintf(elem, sizeof (elem), "%s[%u]", child,
+			    i);
+			ndiffs += nvdiff_all(fp, mark, nva[i], elem);
+		}
+		return (ndiffs);
+	default:
+		val = nvdiff_fmt(nvp);
+		(void) fprintf(fp, "%c %s = %s\n", mark, child,
+		    val != NULL ? val : "?");
+		free(val);
+		return (1);
+	}
+}
+
+static uint_t
+nvdiff_all(FILE *fp, char mark, nvlist_t *nvl, const char *path)
+{
+	nvpair_t *nvp;
+	uint_t ndiffs = 0;
+
+	for (nvp = nvlist_next_nvpair(nvl, NULL); nvp != NULL;
+	    nvp = nvlist_next_nvpair(nvl, nvp))
+		ndiffs += nvdiff_one(fp, mark, nvp, path);
+	return (ndiffs);
+}
+
+static uint_t nvdiff_nvl(FILE *, nvlist_t *, nvlist_t *, const char *);
+
+static boolean_t
+nvdiff_isnvl(data_type_t type)
+{
+	return (type == DATA_TYPE_NVLIST || type == DATA_TYPE_NVLIST_ARRAY);
+}
+
+/*
+ * Compare two nvpairs of the same name, found under the given path.
+ */
+static uint_t
+nvdiff_pair(FILE *fp, nvpair_t *onvp, nvpair_t *nnvp, const char *path)
+{
+	char child[NVDIFF_MAXPATH], elem[NVDIFF_MAXPATH];
+	nvlist_t *onv, *nnv, **onva, **nnva;
+	uint_t i, on, nn, ndiffs = 0;
+	data_type_t type = nvpair_type(onvp);
+	char *oval, *nval;
+
+	nvdiff_path(child, path, nvpair_name(onvp));
+	if (type != nvpair_type(nnvp) &&
+	    (nvdiff_isnvl(type) || nvdiff_isnvl(nvpair_type(nnvp)))) {
+		/*
+		 * A pair that became or stopped being an nvlist is reported
+		 * as a removal and an addition.
+		 */
+		ndiffs += nvdiff_one(fp, '-', onvp, path);
+		ndiffs += nvdiff_one(fp, '+', nnvp, path);
+		return (ndiffs);
+	}
+	if (type == DATA_TYPE_NVLIST) {
+		(void) nvpair_value_nvlist(onvp, &onv);
+		(void) nvpair_value_nvlist(nnvp, &nnv);
+		return (nvdiff_nvl(fp, onv, nnv, child));
+	}
+	if (type == DATA_TYPE_NVLIST_ARRAY) {
+		(void) nvpair_value_nvlist_array(onvp, &onva, &on);
+		(void) nvpair_value_nvlist_array(nnvp, &nnva, &nn);
+		for (i = 0; i < on || i < nn; i++) {
+			(void) snprintf(elem, sizeof (elem), "%s[%u]", child,
+			    i);
+			if (i >= nn)
+				ndiffs += nvdiff_all(fp, '-', onva[i], elem);
+			else if (i >= on)
+				ndiffs += nvdiff_all(fp, '+', nnva[i], elem);
+			else
+				ndiffs += nvdiff_nvl(fp, onva[i], nnva[i],
+				    elem);
+		}
+		return (ndiffs);
+	}
+
+	oval = nvdiff_fmt(onvp);
+	nval = nvdiff_fmt(nnvp);
+	if (type != nvpair_type(nnvp) || oval == NULL || nval == NULL ||
+	    strcmp(oval, nval) != 0) {
+		(void) fprintf(fp, "~ %s: %s -> %s\n", child,
+		    oval != NULL ? oval : "?", nval != NULL ? nval : "?");
+		ndiffs++;
+	}
+	free(oval);
+	free(nval);
+	return (ndiffs);
+}
+
+static uint_t
+nvdiff_nvl(FILE *fp, nvlist_t *onvl, nvlist_t *nnvl, const char *path)
+{
+	nvpair_t *nvp, *other;
+	uint_t ndiffs = 0;
+
+	for (nvp = nvlist_next_nvpair(onvl, NULL); nvp != NULL;
+	    nvp = nvlist_next_nvpair(onvl, nvp)) {
+		if (nvlist_lookup_nvpair(nnvl, nvpair_name(nvp), &other) == 0)
+			ndiffs += nvdiff_pair(fp, nvp, other, path);
+		else
+			ndiffs += nvdiff_one(fp, '-', nvp, path);
+	}
+	for (nvp = nvlist_next_nvpair(nnvl, NULL); nvp != NULL;
+	    nvp = nvlist_next_nvpair(nnvl, nvp)) {
+		if (nvlist_lookup_nvpair(onvl, nvpair_name(nvp), &other) != 0)
+			ndiffs += nvdiff_one(fp, '+', nvp, path);
+	}
+	return (ndiffs);
+}
+
+/*
+ * Report the differences between two nvlists, returning how many there were.
+ */
+uint_t
+nvdiff(FILE *fp, nvlist_t *onvl, nvlist_t *nnvl)
+{
+	return (nvdiff_nvl(fp, onvl, nnvl, ""));
+}
@@ -0,0 +1,505 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+/*
+ * Generate a C source file and header holding every code in one dictionary,
+ * in a minimal perfect hash table, along with functions to look them up.  A
+ * program built with them computes its codes without libdiagcode, and without
+ * opening or reading the dictionary.
+ *
+ * The table is built by hashing and displacing: each key is first hashed
+ * (with seed 0) into one of n groups, where n is the number of keys.  Groups
+ * are then placed from the largest down.  For a group of two or more keys, the
+ * smallest seed that hashes each of them to a different slot that's still
+ * free is found and kept as the group's displacement; a group of one is put
+ * in any free slot, and the displacement records that slot directly, as
+ * -(slot + 1).  A lookup is thus two hashes, at most, and one strcmp().  The
+ * hash function here and the one that's generated must agree.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "dcgen.h"
+
+#define	DCGEN_MAXSEED	(1U << 24)	/* give up on a group after this */
+#define	DCGEN_PREFIXLEN	64
+
+typedef struct dcgen_ent {
+	const char *ge_key;
+	const char *ge_code;
+	uint32_t ge_group;		/* dictionary order, then group */
+	uint32_t ge_gsize;		/* number of keys in the group */
+} dcgen_ent_t;
+
+typedef struct dcgen_file {
+	FILE *gf_fp;
+	char gf_path[MAXPATHLEN];
+	char gf_tmp[MAXPATHLEN];
+} dcgen_file_t;
+
+static uint32_t
+dcgen_hash(uint32_t seed, const char *s)
+{
+	uint32_t h = 2166136261U ^ (seed * 2654435761U);
+
+	for (; *s != '\0'; s++) {
+		h ^= (uchar_t)*s;
+		h *= 16777619U;
+	}
+	return (h);
+}
+
+static int
+dcgen_keycmp(const void *l, const void *r)
+{
+	const dcgen_ent_t *gl = l, *gr = r;
+	int rv;
+
+	if ((rv = strcmp(gl->ge_key, gr->ge_key)) != 0)
+		return (rv);
+	if (gl->ge_group != gr->ge_group)
+		return (gl->ge_group < gr->ge_group ? -1 : 1);
+	return (0);
+}
+
+/*
+ * Largest groups first, and the keys in each group together.
+ */
+static int
+dcgen_groupcmp(const void *l, const void *r)
+{
+	const dcgen_ent_t *gl = l, *gr = r;
+
+	if (gl->ge_gsize != gr->ge_gsize)
+		return (gl->ge_gsize > gr->ge_gsize ? -1 : 1);
+	if (gl->ge_group != gr->ge_group)
+		return (gl->ge_group < gr->ge_group ? -1 : 1);
+	return (0);
+}
+
+/*
+ * Place every key.  On success, slots[] holds the index in ents[] of the key
+ * in each slot, and disp[] each group's displacement.
+ */
+static int
+dcgen_place(dcgen_ent_t *ents, uint32_t n, int32_t *disp, uint32_t *slots)
+{
+	uint32_t *gsize, *tmp, i, j, k, g, seed, next = 0;
+	uchar_t *used;
+	int status = -1;
+
+	gsize = calloc(n, sizeof (uint32_t));
+	tmp = calloc(n, sizeof (uint32_t));
+	used = calloc(n, sizeof (uchar_t));
+	if (gsize == NULL || tmp == NULL || used == NULL) {
+		(void) fprintf(stderr, "malloc failed\n");
+		goto out;
+	}
+
+	for (i = 0; i < n; i++) {
+		ents[i].ge_group = dcgen_hash(0, ents[i].ge_key) % n;
+		gsize[ents[i].ge_group]++;
+	}
+	for (i = 0; i < n; i++)
+		ents[i].ge_gsize = gsize[ents[i].ge_group];
+	qsort(ents, n, sizeof (dcgen_ent_t), dcgen_groupcmp);
+
+	for (i = 0; i < n; i += ents[i].ge_gsize) {
+		g = ents[i].ge_group;
+		if (ents[i].ge_gsize == 1) {
+			while (used[next])
+				next++;
+			used[next] = 1;
+			slots[next] = i;
+			disp[g] = -(int32_t)next - 1;
+			continue;
+		}
+
+		for (seed = 1; seed < DCGEN_MAXSEED; seed++) {
+			for (j = 0; j < ents[i].ge_gsize; j++) {
+				tmp[j] = dcgen_hash(seed,
+				    ents[i + j].ge_key) % n;
+				if (used[tmp[j]])
+					break;
+				for (k = 0; k < j && tmp[k] != tmp[j]; k++)
+					continue;
+				if (k < j)
+					break;
+			}
+			if (j == ents[i].ge_gsize)
+				break;
+		}
+		if (seed == DCGEN_MAXSEED) {
+			(void) fprintf(stderr, "no perfect hash found for the "
+			    "%u keys with group %u\n", ents[i].ge_gsize, g);
+			goto out;
+		}
+		for (j = 0; j < ents[i].ge_gsize; j++) {
+			used[tmp[j]] = 1;
+			slots[tmp[j]] = i + j;
+		}
+		disp[g] = (int32_t)seed;
+	}
+	status = 0;
+out:
+	free(gsize);
+	free(tmp);
+	free(used);
+	return (status);
+}
+
+static void
+dcgen_putstr(FILE *fp, const char *s)
+{
+	(void) putc('"', fp);
+	for (; *s != '\0'; s++) {
+		if (*s == '"' || *s == '\\')
+			(void) fprintf(fp, "\\%c", *s);
+		else if (isprint((uchar_t)*s))
+			(void) putc(*s, fp);
+		else
+			(void) fprintf(fp, "\\%03o", (uchar_t)*s);
+	}
+	(void) putc('"', fp);
+}
+
+/*
+ * Output goes to a temporary file that's renamed into place once it's all
+ * been written, so that a failed run never leaves a partial file for make to
+ * think is up to date.
+ */
+static int
+dcgen_open(dcgen_file_t *gf, const char *base, const char *suffix)
+{
+	int fd;
+
+	if (snprintf(gf->gf_path, sizeof (gf->gf_path), "%s%s", base,
+	    suffix) >= sizeof (gf->gf_path) ||
+	    snprintf(gf->gf_tmp, sizeof (gf->gf_tmp), "%s.XXXXXX",
+	    gf->gf_path) >= sizeof (gf->gf_tmp)) {
+		(void) fprintf(stderr, "%s: path too long\n", base);
+		return (-1);
+	}
+	if ((fd = mkstemp(gf->gf_tmp)) < 0 || fchmod(fd, 0644) != 0 ||
+	    (gf->gf_fp = fdopen(fd, "w")) == NULL) {
+		(void) fprintf(stderr, "failed to create %s (%s)\n",
+		    gf->gf_tmp, strerror(errno));
+		if (fd >= 0) {
+			(void) close(fd);
+			(void) unlink(gf->gf_tmp);
+		}
+		return (-1);
+	}
+	return (0);
+}
+
+static int
+dcgen_close(dcgen_file_t *gf, int status)
+{
+	if (gf->gf_fp == NULL)
+		return (status);
+	if (status == 0 && (ferror(gf->gf_fp) || fflush(gf->gf_fp) != 0 ||
+	    fsync(fileno(gf->gf_fp)) != 0)) {
+		(void) fprintf(stderr, "failed to write %s (%s)\n",
+		    gf->gf_tmp, strerror(errno));
+		status = -1;
+	}
+	(void) fclose(gf->gf_fp);
+	gf->gf_fp = NULL;
+	if (status == 0 && rename(gf->gf_tmp, gf->gf_path) != 0) {
+		(void) fprintf(stderr, "failed to rename %s to %s (%s)\n",
+		    gf->gf_tmp, gf->gf_path, strerror(errno));
+		status = -1;
+	}
+	if (status != 0)
+		(void) unlink(gf->gf_tmp);
+	return (status);
+}
+
+static void
+dcgen_header(FILE *fp, const char *dict, const char *prefix,
+    const char *uprefix, uint32_t n)
+{
+	(void) fprintf(fp,
+	    "/*\n"
+	    " * Generated by gen-diagcode from the %2$s dictionary.  "
+	    "Do not edit.\n"
+	    " */\n"
+	    "\n"
+	    "#ifndef _%3$s_H\n"
+	    "#define\t_%3$s_H\n"
+	    "\n"
+	    "#include <sys/types.h>\n"
+	    "\n"
+	    "#ifdef\t__cplusplus\n"
+	    "extern \"C\" {\n"
+	    "#endif\n"
+	    "\n"
+	    "#define\t%3$s_DICT\t\"%2$s\"\n"
+	    "#define\t%3$s_NCODES\t%4$u\n"
+	    "\n"
+	    "/*\n"
+	    " * %1$s_lookup() returns the code for a key written as it is "
+	    "in the\n"
+	    " * dictionary (one class, or several sorted and separated by "
+	    "single spaces),\n"
+	    " * or NULL.  %1$s_key2code() takes the same arguments as "
+	    "fm_dc_key2code(),\n"
+	    " * less the handle, and fails with ENOMSG or ERANGE as it "
+	    "does.\n"
+	    " */\n"
+	    "extern const char *%1$s_lookup(const char *);\n"
+	    "extern int %1$s_key2code(const char *[], char *, size_t);\n"
+	    "\n"
+	    "#ifdef\t__cplusplus\n"
+	    "}\n"
+	    "#endif\n"
+	    "\n"
+	    "#endif\t/* _%3$s_H */\n",
+	    prefix, dict, uprefix, n);
+}
+
+static void
+dcgen_source(FILE *fp, const char *dict, const char *prefix,
+    const char *hdr, const dcgen_ent_t *ents, const int32_t *disp,
+    const uint32_t *slots, uint32_t n)
+{
+	uint32_t i, maxkey = 1, keylen = 1, nclasses;
+	const char *p;
+
+	for (i = 0; i < n; i++) {
+		for (nclasses = 1, p = ents[i].ge_key; *p != '\0'; p++) {
+			if (*p == ' ')
+				nclasses++;
+		}
+		maxkey = MAX(maxkey, nclasses);
+		keylen = MAX(keylen, (uint32_t)strlen(ents[i].ge_key) + 1);
+	}
+
+	(void) fprintf(fp,
+	    "/*\n"
+	    " * Generated by gen-diagcode from the %s dictionary.  "
+	    "Do not edit.\n"
+	    " */\n"
+	    "\n"
+	    "#include <errno.h>\n"
+	    "#include <stdint.h>\n"
+	    "#include <string.h>\n"
+	    "#include <sys/types.h>\n"
+	    "\n"
+	    "#include \"%s\"\n"
+	    "\n"
+	    "#define\tDC_NSLOTS\t%u\n"
+	    "#define\tDC_MAXKEY\t%u\t/* most classes in a key */\n"
+	    "#define\tDC_KEYLEN\t%u\t/* longest key, and its NUL */\n"
+	    "\n"
+	    "/*\n"
+	    " * A key's slot is found by hashing it with seed 0 to pick a "
+	    "displacement.\n"
+	    " * A negative displacement d is the slot itself, as -(slot + "
+	    "1); any other is\n"
+	    " * the seed to hash the key again with to find it.\n"
+	    " */\n"
+	    "static const int32_t %s_disp[DC_NSLOTS] = {",
+	    dict, hdr, n, maxkey, keylen, prefix);
+	for (i = 0; i < n; i++) {
+		(void) fprintf(fp, "%s%d,", i % 8 == 0 ? "\n\t" : " ",
+		    disp[i]);
+	}
+	(void) fprintf(fp,
+	    "\n};\n"
+	    "\n"
+	    "static const struct {\n"
+	    "\tconst char *e_key;\n"
+	    "\tconst char *e_code;\n"
+	    "} %s_ents[DC_NSLOTS] = {\n", prefix);
+	for (i = 0; i < n; i++) {
+		(void) fprintf(fp, "\t{ ");
+		dcgen_putstr(fp, ents[slots[i]].ge_key);
+		(void) fprintf(fp, ", ");
+		dcgen_putstr(fp, ents[slots[i]].ge_code);
+		(void) fprintf(fp, " },\n");
+	}
+	(void) fprintf(fp,
+	    "};\n"
+	    "\n"
+	    "static uint32_t\n"
+	    "%1$s_hash(uint32_t seed, const char *s)\n"
+	    "{\n"
+	    "\tuint32_t h = 2166136261U ^ (seed * 2654435761U);\n"
+	    "\n"
+	    "\tfor (; *s != '\\0'; s++) {\n"
+	    "\t\th ^= (unsigned char)*s;\n"
+	    "\t\th *= 16777619U;\n"
+	    "\t}\n"
+	    "\treturn (h);\n"
+	    "}\n"
+	    "\n"
+	    "const char *\n"
+	    "%1$s_lookup(const char *key)\n"
+	    "{\n"
+	    "\tint32_t d = %1$s_disp[%1$s_hash(0, key) %% DC_NSLOTS];\n"
+	    "\tuint32_t i = d < 0 ? (uint32_t)(-(d + 1)) :\n"
+	    "\t    %1$s_hash((uint32_t)d, key) %% DC_NSLOTS;\n"
+	    "\n"
+	    "\treturn (strcmp(%1$s_ents[i].e_key, key) == 0 ?\n"
+	    "\t    %1$s_ents[i].e_code : NULL);\n"
+	    "}\n"
+	    "\n"
+	    "int\n"
+	    "%1$s_key2code(const char *key[], char *code, size_t maxcode)\n"
+	    "{\n"
+	    "\tconst char *sorted[DC_MAXKEY], *c;\n"
+	    "\tchar buf[DC_KEYLEN];\n"
+	    "\tsize_t off = 0, len;\n"
+	    "\tint i, j, n;\n"
+	    "\n"
+	    "\tif (key[0] != NULL && key[1] == NULL) {\n"
+	    "\t\tc = %1$s_lookup(key[0]);\n"
+	    "\t} else {\n"
+	    "\t\tfor (n = 0; key[n] != NULL; n++) {\n"
+	    "\t\t\tif (n == DC_MAXKEY)\n"
+	    "\t\t\t\tgoto nomsg;\n"
+	    "\t\t\tfor (j = n; j > 0 &&\n"
+	    "\t\t\t    strcmp(sorted[j - 1], key[n]) > 0; j--)\n"
+	    "\t\t\t\tsorted[j] = sorted[j - 1];\n"
+	    "\t\t\tsorted[j] = key[n];\n"
+	    "\t\t}\n"
+	    "\t\tfor (i = 0; i < n; i++) {\n"
+	    "\t\t\tlen = strlen(sorted[i]);\n"
+	    "\t\t\tif (off + (i > 0) + len >= sizeof (buf))\n"
+	    "\t\t\t\tgoto nomsg;\n"
+	    "\t\t\tif (i > 0)\n"
+	    "\t\t\t\tbuf[off++] = ' ';\n"
+	    "\t\t\t(void) memcpy(buf + off, sorted[i], len);\n"
+	    "\t\t\toff += len;\n"
+	    "\t\t}\n"
+	    "\t\tbuf[off] = '\\0';\n"
+	    "\t\tc = %1$s_lookup(buf);\n"
+	    "\t}\n"
+	    "\tif (c == NULL)\n"
+	    "\t\tgoto nomsg;\n"
+	    "\tif ((len = strlen(c)) >= maxcode) {\n"
+	    "\t\terrno = ERANGE;\n"
+	    "\t\treturn (-1);\n"
+	    "\t}\n"
+	    "\t(void) memcpy(code, c, len + 1);\n"
+	    "\treturn (0);\n"
+	    "nomsg:\n"
+	    "\terrno = ENOMSG;\n"
+	    "\treturn (-1);\n"
+	    "}\n",
+	    prefix);
+}
+
+/*
+ * Write base.c and base.h for the named dictionary in an index.  The
+ * functions and table are named after the last component of base, which
+ * therefore has to be a valid C identifier.
+ */
+int
+dcgen_write(const dcidx_hdr_t *dx, const char *dict, const char *base)
+{
+	char prefix[DCGEN_PREFIXLEN], uprefix[DCGEN_PREFIXLEN];
+	char hdr[DCGEN_PREFIXLEN + 2];
+	dcgen_file_t src = { 0 }, inc = { 0 };
+	const dcidx_dict_t *dd = NULL;
+	const dcidx_ent_t *de;
+	dcgen_ent_t *ents = NULL;
+	int32_t *disp = NULL;
+	uint32_t *slots = NULL, i, n;
+	const char *p;
+	int status = -1;
+
+	p = (p = strrchr(base, '/')) != NULL ? p + 1 : base;
+	if (strlcpy(prefix, p, sizeof (prefix)) >= sizeof (prefix) ||
+	    prefix[0] == '\0' || isdigit((uchar_t)prefix[0])) {
+		(void) fprintf(stderr, "%s: not a valid C identifier\n", p);
+		return (-1);
+	}
+	for (i = 0; prefix[i] != '\0'; i++) {
+		if (!isalnum((uchar_t)prefix[i]) && prefix[i] != '_') {
+			(void) fprintf(stderr, "%s: not a valid C "
+			    "identifier\n", prefix);
+			return (-1);
+		}
+		uprefix[i] = toupper((uchar_t)prefix[i]);
+	}
+	uprefix[i] = '\0';
+	(void) snprintf(hdr, sizeof (hdr), "%s.h", prefix);
+
+	for (i = 0; i < dx->dx_ndicts; i++) {
+		dd = dcidx_dict(dx, i);
+		if (strcmp(dcidx_str(dx, dd->dd_name), dict) == 0)
+			break;
+	}
+	if (i == dx->dx_ndicts || dd->dd_nents == 0) {
+		(void) fprintf(stderr, "no codes in %s\n", dict);
+		return (-1);
+	}
+
+	if ((ents = calloc(dd->dd_nents, sizeof (dcgen_ent_t))) == NULL) {
+		(void) fprintf(stderr, "malloc failed\n");
+		return (-1);
+	}
+	for (i = 0; i < dd->dd_nents; i++) {
+		de = dcidx_ent(dx, dd->dd_ent + i);
+		ents[i].ge_key = dcidx_str(dx, de->de_key);
+		ents[i].ge_code = dcidx_str(dx, de->de_code);
+		ents[i].ge_group = i;
+	}
+
+	/*
+	 * Two entries with the same key would always land in the same group
+	 * and collide whatever the seed, so keep only the first, which is the
+	 * one libdiagcode would find.
+	 */
+	qsort(ents, dd->dd_nents, sizeof (dcgen_ent_t), dcgen_keycmp);
+	for (i = n = 0; i < dd->dd_nents; i++) {
+		if (n > 0 && strcmp(ents[n - 1].ge_key, ents[i].ge_key) == 0) {
+			(void) fprintf(stderr, "%s: duplicate key %s, "
+			    "skipped\n", dict, ents[i].ge_key);
+			continue;
+		}
+		ents[n++] = ents[i];
+	}
+
+	if ((disp = calloc(n, sizeof (int32_t))) == NULL ||
+	    (slots = calloc(n, sizeof (uint32_t))) == NULL) {
+		(void) fprintf(stderr, "malloc failed\n");
+		goto out;
+	}
+	if (dcgen_place(ents, n, disp, slots) != 0)
+		goto out;
+
+	if (dcgen_open(&inc, base, ".h") != 0)
+		goto out;
+	dcgen_header(inc.gf_fp, dict, prefix, uprefix, n);
+	if (dcgen_close(&inc, 0) != 0)
+		goto out;
+	if (dcgen_open(&src, base, ".c") != 0)
+		goto out;
+	dcgen_source(src.gf_fp, dict, prefix, hdr, ents, disp, slots, n);
+	if (dcgen_close(&src, 0) != 0)
+		goto out;
+	(void) printf("%u codes from %s written to %s and %s\n", n, dict,
+	    src.gf_path, inc.gf_path);
+	status = 0;
+out:
+	free(ents);
+	free(disp);
+	free(slots);
+	return (status);
+}
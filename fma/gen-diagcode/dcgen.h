@@ -0,0 +1,29 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+#ifndef _DCGEN_H
+#define	_DCGEN_H
+
+/*
+ * Generate C source for a static table of one dictionary's codes, so that a
+ * program can compute them without reading the dictionary.  See dcgen.c.
+ */
+
+#include "dcidx.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+extern int dcgen_write(const dcidx_hdr_t *, const char *, const char *);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _DCGEN_H */
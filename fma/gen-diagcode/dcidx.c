@@ -0,0 +1,541 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+/*
+ * Build, write, map and search the diagcode index described in dcidx.h.
+ *
+ * The index is built by reading the keys out of each dictionary's text and
+ * asking libdiagcode for the code of each, so the codes are exactly what
+ * fm_dc_key2code() would return and nothing here needs to know how they're
+ * computed.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <dirent.h>
+#include <errno.h>
+#include <string.h>
+#include <fm/diagcode.h>
+#include <sys/param.h>
+#include <sys/types.h>
+
+#include "dcidx.h"
+#include "mfile.h"
+
+#define	DCIDX_ALIGN(x)	(((x) + 7) & ~(uint64_t)7)
+#define	DCIDX_MAXKEY	32		/* most classes in one key */
+#define	DCIDX_KEYLEN	4096
+#define	DCIDX_CODELEN	64
+#define	DCIDX_SUFFIX	".dict"
+
+typedef struct dcidx_strtab {
+	char *ds_buf;
+	size_t ds_size;
+	size_t ds_alloc;
+} dcidx_strtab_t;
+
+typedef struct dcidx_bent {
+	size_t be_key;			/* offset of key in string table */
+	size_t be_code;			/* offset of code in string table */
+	uint32_t be_dict;		/* index of dictionary */
+} dcidx_bent_t;
+
+typedef struct dcidx_bld {
+	const char *db_dir;		/* dictionary directory */
+	dcidx_strtab_t db_strs;		/* strings */
+	dcidx_bent_t *db_ents;		/* entries */
+	size_t db_nents;		/* number of entries */
+	size_t db_alloc;		/* entries allocated */
+	size_t *db_names;		/* offset of each dictionary's name */
+	size_t *db_first;		/* index of each one's first entry */
+} dcidx_bld_t;
+
+static size_t
+dcidx_addstr(dcidx_strtab_t *ds, const char *s)
+{
+	size_t off, len = strlen(s) + 1;
+
+	if (ds->ds_size + len > ds->ds_alloc) {
+		size_t n = ds->ds_alloc * 2 + len + 4096;
+		char *buf;
+
+		if ((buf = realloc(ds->ds_buf, n)) == NULL)
+			return (SIZE_MAX);
+		ds->ds_buf = buf;
+		ds->ds_alloc = n;
+	}
+	off = ds->ds_size;
+	(void) memcpy(ds->ds_buf + off, s, len);
+	ds->ds_size += len;
+	return (off);
+}
+
+static int
+dcidx_strcmp(const void *l, const void *r)
+{
+	return (strcmp(*(char *const *)l, *(char *const *)r));
+}
+
+/*
+ * Split a key into its classes, in place, and sort them.  Returns the number
+ * of classes, or -1 if there are too many.
+ */
+static int
+dcidx_split(char *key, char **classes)
+{
+	char *c, *last;
+	int n = 0;
+
+	for (c = strtok_r(key, " \t\n", &last); c != NULL;
+	    c = strtok_r(NULL, " \t\n", &last)) {
+		if (n == DCIDX_MAXKEY)
+			return (-1);
+		classes[n++] = c;
+	}
+	classes[n] = NULL;
+	qsort(classes, n, sizeof (char *), dcidx_strcmp);
+	return (n);
+}
+
+/*
+ * Put a key in the form it's indexed in: its classes sorted and separated by
+ * single spaces.
+ */
+int
+dcidx_normkey(const char *key, char *buf, size_t len)
+{
+	char tmp[DCIDX_KEYLEN], *classes[DCIDX_MAXKEY + 1];
+	size_t off = 0;
+	int i, n;
+
+	if (strlcpy(tmp, key, sizeof (tmp)) >= sizeof (tmp) ||
+	    (n = dcidx_split(tmp, classes)) <= 0)
+		return (-1);
+	for (i = 0; i < n; i++) {
+		off += snprintf(buf + off, off < len ? len - off : 0, "%s%s",
+		    i == 0 ? "" : " ", classes[i]);
+	}
+	return (off < len ? 0 : -1);
+}
+
+static int
+dcidx_addent(dcidx_bld_t *db, uint32_t dict, const char *key,
+    const char *code)
+{
+	dcidx_bent_t *be;
+
+	if (db->db_nents == db->db_alloc) {
+		size_t n = db->db_alloc == 0 ? 1024 : db->db_alloc * 2;
+
+		if ((be = realloc(db->db_ents, n * sizeof (dcidx_bent_t))) ==
+		    NULL)
+			return (-1);
+		db->db_ents = be;
+		db->db_alloc = n;
+	}
+	be = &db->db_ents[db->db_nents];
+	if ((be->be_key = dcidx_addstr(&db->db_strs, key)) == SIZE_MAX ||
+	    (be->be_code = dcidx_addstr(&db->db_strs, code)) == SIZE_MAX)
+		return (-1);
+	be->be_dict = dict;
+	db->db_nents++;
+	return (0);
+}
+
+/*
+ * Add every key in one dictionary.  Lines that can't be made sense of, and
+ * keys that libdiagcode has no code for, are reported and skipped; only a
+ * dictionary that can't be read at all, or running out of memory, is an
+ * error.
+ */
+static int
+dcidx_read(dcidx_bld_t *db, uint32_t dict, const char *name)
+{
+	char path[MAXPATHLEN], key[DCIDX_KEYLEN], code[DCIDX_CODELEN];
+	char *classes[DCIDX_MAXKEY + 1], *line = NULL, *p, *eq;
+	size_t linesz = 0;
+	fm_dc_handle_t *dhp;
+	uint_t lineno = 0;
+	FILE *fp;
+	int status = 0;
+
+	(void) snprintf(path, sizeof (path), "%s/%s%s", db->db_dir, name,
+	    DCIDX_SUFFIX);
+	if ((fp = fopen(path, "r")) == NULL) {
+		(void) fprintf(stderr, "failed to open %s (%s)\n", path,
+		    strerror(errno));
+		return (-1);
+	}
+	if ((dhp = fm_dc_opendict(FM_DC_VERSION, db->db_dir, name)) == NULL) {
+		(void) fprintf(stderr, "fm_dc_opendict failed for %s\n", path);
+		(void) fclose(fp);
+		return (-1);
+	}
+
+	while (getline(&line, &linesz, fp) >= 0) {
+		lineno++;
+		for (p = line; *p == ' ' || *p == '\t'; p++)
+			continue;
+		if (*p == '\0' || *p == '\n' || *p == '#' ||
+		    strncmp(p, "FMDICT:", 7) == 0)
+			continue;
+		if ((eq = strchr(p, '=')) == NULL) {
+			(void) fprintf(stderr, "%s: line %u: no '=', "
+			    "skipped\n", path, lineno);
+			continue;
+		}
+		*eq = '\0';
+		if (dcidx_normkey(p, key, sizeof (key)) != 0 ||
+		    dcidx_split(p, classes) <= 0) {
+			(void) fprintf(stderr, "%s: line %u: bad key, "
+			    "skipped\n", path, lineno);
+			continue;
+		}
+		if (fm_dc_key2code(dhp, (const char **)classes, code,
+		    sizeof (code)) < 0) {
+			(void) fprintf(stderr, "%s: line %u: "
+			    "fm_dc_key2code failed for %s, skipped\n", path,
+			    lineno, key);
+			continue;
+		}
+		if (dcidx_addent(db, dict, key, code) != 0) {
+			(void) fprintf(stderr, "malloc failed\n");
+			status = -1;
+			break;
+		}
+	}
+	if (status == 0 && ferror(fp)) {
+		(void) fprintf(stderr, "failed to read %s (%s)\n", path,
+		    strerror(errno));
+		status = -1;
+	}
+	free(line);
+	fm_dc_closedict(dhp);
+	(void) fclose(fp);
+	return (status);
+}
+
+static void
+dcidx_insert(uint32_t *tab, uint32_t nbuckets, uint32_t h, uint32_t ent)
+{
+	uint32_t i;
+
+	for (i = h & (nbuckets - 1); tab[i] != DCIDX_NONE;
+	    i = (i + 1) & (nbuckets - 1))
+		continue;
+	tab[i] = ent;
+}
+
+/*
+ * Index every dictionary in a directory, or just the named one, in a single
+ * allocation that's laid out exactly as the file is.
+ */
+int
+dcidx_build(const char *dictdir, const char *only, dcidx_hdr_t **dxp)
+{
+	dcidx_bld_t db = { 0 };
+	dcidx_hdr_t *dx = NULL;
+	dcidx_dict_t *dd;
+	dcidx_ent_t *de;
+	uint32_t *keytab, *codetab;
+	char **names = NULL, **nnames;
+	struct dirent *dp;
+	DIR *dir;
+	size_t len, nnames_alloc = 0, ndicts = 0, i, j, end;
+	uint64_t off;
+	uint32_t nbuckets;
+	int status = -1;
+
+	db.db_dir = dictdir;
+	if ((dir = opendir(dictdir)) == NULL) {
+		(void) fprintf(stderr, "failed to open %s (%s)\n", dictdir,
+		    strerror(errno));
+		return (-1);
+	}
+	while ((dp = readdir(dir)) != NULL) {
+		len = strlen(dp->d_name);
+		if (len <= strlen(DCIDX_SUFFIX) || strcmp(dp->d_name + len -
+		    strlen(DCIDX_SUFFIX), DCIDX_SUFFIX) != 0)
+			continue;
+		if (only != NULL && (len - strlen(DCIDX_SUFFIX) !=
+		    strlen(only) || strncmp(dp->d_name, only, len -
+		    strlen(DCIDX_SUFFIX)) != 0))
+			continue;
+		if (ndicts == nnames_alloc) {
+			nnames_alloc = nnames_alloc == 0 ? 64 :
+			    nnames_alloc * 2;
+			if ((nnames = realloc(names,
+			    nnames_alloc * sizeof (char *))) == NULL)
+				goto nomem;
+			names = nnames;
+		}
+		if ((names[ndicts] = strndup(dp->d_name,
+		    len - strlen(DCIDX_SUFFIX))) == NULL)
+			goto nomem;
+		ndicts++;
+	}
+	(void) closedir(dir);
+	dir = NULL;
+	if (ndicts == 0) {
+		if (only != NULL) {
+			(void) fprintf(stderr, "no %s%s in %s\n", only,
+			    DCIDX_SUFFIX, dictdir);
+		} else {
+			(void) fprintf(stderr, "no dictionaries in %s\n",
+			    dictdir);
+		}
+		goto out;
+	}
+	qsort(names, ndicts, sizeof (char *), dcidx_strcmp);
+
+	if (dcidx_addstr(&db.db_strs, "") == SIZE_MAX ||
+	    (db.db_names = calloc(ndicts, sizeof (size_t))) == NULL ||
+	    (db.db_first = calloc(ndicts, sizeof (size_t))) == NULL)
+		goto nomem;
+	for (i = 0; i < ndicts; i++) {
+		db.db_first[i] = db.db_nents;
+		if ((db.db_names[i] = dcidx_addstr(&db.db_strs, names[i])) ==
+		    SIZE_MAX)
+			goto nomem;
+		if (dcidx_read(&db, (uint32_t)i, names[i]) != 0)
+			goto out;
+	}
+	if (db.db_nents >= UINT32_MAX / 4 || db.db_strs.ds_size >= UINT32_MAX) {
+		(void) fprintf(stderr, "too many dictionary entries\n");
+		goto out;
+	}
+
+	for (nbuckets = 8; nbuckets < 2 * db.db_nents; nbuckets <<= 1)
+		continue;
+
+	off = DCIDX_ALIGN(sizeof (dcidx_hdr_t));
+	if ((dx = calloc(1, off)) == NULL)
+		goto nomem;
+	dx->dx_magic = DCIDX_MAGIC;
+	dx->dx_version = DCIDX_VERSION;
+	dx->dx_hdrsize = sizeof (dcidx_hdr_t);
+	dx->dx_ndicts = (uint32_t)ndicts;
+	dx->dx_nents = (uint32_t)db.db_nents;
+	dx->dx_nbuckets = nbuckets;
+	dx->dx_dictoff = off;
+	off += DCIDX_ALIGN(ndicts * sizeof (dcidx_dict_t));
+	dx->dx_entoff = off;
+	off += DCIDX_ALIGN(db.db_nents * sizeof (dcidx_ent_t));
+	dx->dx_keytaboff = off;
+	off += DCIDX_ALIGN((uint64_t)nbuckets * sizeof (uint32_t));
+	dx->dx_codetaboff = off;
+	off += DCIDX_ALIGN((uint64_t)nbuckets * sizeof (uint32_t));
+	dx->dx_stroff = off;
+	dx->dx_strsize = db.db_strs.ds_size;
+	dx->dx_filesz = off + DCIDX_ALIGN(db.db_strs.ds_size);
+	{
+		dcidx_hdr_t *ndx;
+
+		if ((ndx = realloc(dx, dx->dx_filesz)) == NULL)
+			goto nomem;
+		dx = ndx;
+	}
+	(void) memset((char *)dx + dx->dx_dictoff, 0,
+	    dx->dx_filesz - dx->dx_dictoff);
+
+	for (i = 0; i < ndicts; i++) {
+		dd = (dcidx_dict_t *)dcidx_dict(dx, (uint32_t)i);
+		end = i + 1 < ndicts ? db.db_first[i + 1] : db.db_nents;
+		dd->dd_name = (uint32_t)db.db_names[i];
+		dd->dd_ent = (uint32_t)db.db_first[i];
+		dd->dd_nents = (uint32_t)(end - db.db_first[i]);
+	}
+
+	keytab = (uint32_t *)((char *)dx + dx->dx_keytaboff);
+	codetab = (uint32_t *)((char *)dx + dx->dx_codetaboff);
+	for (j = 0; j < nbuckets; j++)
+		keytab[j] = codetab[j] = DCIDX_NONE;
+	for (i = 0; i < db.db_nents; i++) {
+		de = (dcidx_ent_t *)dcidx_ent(dx, (uint32_t)i);
+		de->de_key = (uint32_t)db.db_ents[i].be_key;
+		de->de_code = (uint32_t)db.db_ents[i].be_code;
+		de->de_dict = db.db_ents[i].be_dict;
+		de->de_keyhash = dcidx_hash(db.db_strs.ds_buf + de->de_key);
+		de->de_codehash = dcidx_hash(db.db_strs.ds_buf + de->de_code);
+		dcidx_insert(keytab, nbuckets, de->de_keyhash, (uint32_t)i);
+		dcidx_insert(codetab, nbuckets, de->de_codehash, (uint32_t)i);
+	}
+	(void) memcpy((char *)dx + dx->dx_stroff, db.db_strs.ds_buf,
+	    db.db_strs.ds_size);
+
+	*dxp = dx;
+	dx = NULL;
+	status = 0;
+	goto out;
+
+nomem:
+	(void) fprintf(stderr, "malloc failed\n");
+out:
+	if (dir != NULL)
+		(void) closedir(dir);
+	for (i = 0; i < ndicts; i++)
+		free(names[i]);
+	free(names);
+	free(db.db_names);
+	free(db.db_first);
+	free(db.db_ents);
+	free(db.db_strs.ds_buf);
+	free(dx);
+	return (status);
+}
+
+void
+dcidx_free(dcidx_hdr_t *dx)
+{
+	free(dx);
+}
+
+/*
+ * Write the index out, replacing any at that path atomically.
+ */
+int
+dcidx_write(const dcidx_hdr_t *dx, const char *path)
+{
+	return (mfile_write(dx, dx->dx_filesz, path));
+}
+
+/*
+ * Check that a hash table only refers to entries that exist and has at least
+ * one empty slot, so that probing it always ends.
+ */
+static int
+dcidx_check_tab(const dcidx_hdr_t *dx, uint64_t off)
+{
+	const uint32_t *tab = (const uint32_t *)((const char *)dx + off);
+	uint32_t i, n = 0;
+
+	for (i = 0; i < dx->dx_nbuckets; i++) {
+		if (tab[i] == DCIDX_NONE)
+			continue;
+		if (tab[i] >= dx->dx_nents)
+			return (-1);
+		n++;
+	}
+	return (n < dx->dx_nbuckets ? 0 : -1);
+}
+
+/*
+ * Check that an index is self-consistent, so that the accessors in dcidx.h
+ * and the lookups below can be used on it without further checks.
+ */
+static int
+dcidx_check(const void *addr, size_t size)
+{
+	const dcidx_hdr_t *dx = addr;
+	const dcidx_dict_t *dd;
+	const dcidx_ent_t *de;
+	uint32_t i;
+
+	if (size < sizeof (dcidx_hdr_t) || dx->dx_magic != DCIDX_MAGIC)
+		return (-1);
+	if (dx->dx_version != DCIDX_VERSION ||
+	    dx->dx_hdrsize != sizeof (dcidx_hdr_t) || dx->dx_filesz != size)
+		return (-1);
+	if (dx->dx_nbuckets == 0 ||
+	    (dx->dx_nbuckets & (dx->dx_nbuckets - 1)) != 0)
+		return (-1);
+
+	if (!MFILE_FITS(dx->dx_dictoff, dx->dx_ndicts,
+	    sizeof (dcidx_dict_t), size) ||
+	    !MFILE_FITS(dx->dx_entoff, dx->dx_nents,
+	    sizeof (dcidx_ent_t), size) ||
+	    !MFILE_FITS(dx->dx_keytaboff, dx->dx_nbuckets,
+	    sizeof (uint32_t), size) ||
+	    !MFILE_FITS(dx->dx_codetaboff, dx->dx_nbuckets,
+	    sizeof (uint32_t), size) ||
+	    !MFILE_FITS(dx->dx_stroff, dx->dx_strsize, 1, size))
+		return (-1);
+
+	if (dx->dx_strsize == 0 ||
+	    *dcidx_str(dx, dx->dx_strsize - 1) != '\0')
+		return (-1);
+
+	for (i = 0; i < dx->dx_ndicts; i++) {
+		dd = dcidx_dict(dx, i);
+		if (dd->dd_name >= dx->dx_strsize ||
+		    dd->dd_ent > dx->dx_nents ||
+		    dd->dd_nents > dx->dx_nents - dd->dd_ent)
+			return (-1);
+	}
+	for (i = 0; i < dx->dx_nents; i++) {
+		de = dcidx_ent(dx, i);
+		if (de->de_key >= dx->dx_strsize ||
+		    de->de_code >= dx->dx_strsize ||
+		    de->de_dict >= dx->dx_ndicts)
+			return (-1);
+	}
+	if (dcidx_check_tab(dx, dx->dx_keytaboff) != 0 ||
+	    dcidx_check_tab(dx, dx->dx_codetaboff) != 0)
+		return (-1);
+	return (0);
+}
+
+/*
+ * Map an index written by dcidx_write().
+ */
+int
+dcidx_open(const char *path, dcidx_hdr_t **dxp)
+{
+	return (mfile_open(path, "diagcode index", sizeof (dcidx_hdr_t),
+	    dcidx_check, (void **)dxp));
+}
+
+void
+dcidx_close(dcidx_hdr_t *dx)
+{
+	mfile_close(dx, dx->dx_filesz);
+}
+
+/*
+ * Return the entry for a key, which must already be in the form given by
+ * dcidx_normkey(), in the named dictionary, or in any dictionary if dict is
+ * NULL.
+ */
+const dcidx_ent_t *
+dcidx_lookup_key(const dcidx_hdr_t *dx, const char *dict, const char *key)
+{
+	const uint32_t *tab = (const uint32_t *)((const char *)dx +
+	    dx->dx_keytaboff);
+	uint32_t h = dcidx_hash(key), mask = dx->dx_nbuckets - 1, i;
+	const dcidx_ent_t *de;
+
+	for (i = h & mask; tab[i] != DCIDX_NONE; i = (i + 1) & mask) {
+		de = dcidx_ent(dx, tab[i]);
+		if (de->de_keyhash != h ||
+		    strcmp(dcidx_str(dx, de->de_key), key) != 0)
+			continue;
+		if (dict == NULL || strcmp(dcidx_str(dx,
+		    dcidx_dict(dx, de->de_dict)->dd_name), dict) == 0)
+			return (de);
+	}
+	return (NULL);
+}
+
+/*
+ * Return the entry for a code.
+ */
+const dcidx_ent_t *
+dcidx_lookup_code(const dcidx_hdr_t *dx, const char *code)
+{
+	const uint32_t *tab = (const uint32_t *)((const char *)dx +
+	    dx->dx_codetaboff);
+	uint32_t h = dcidx_hash(code), mask = dx->dx_nbuckets - 1, i;
+	const dcidx_ent_t *de;
+
+	for (i = h & mask; tab[i] != DCIDX_NONE; i = (i + 1) & mask) {
+		de = dcidx_ent(dx, tab[i]);
+		if (de->de_codehash == h &&
+		    strcmp(dcidx_str(dx, de->de_code), code) == 0)
+			return (de);
+	}
+	return (NULL);
+}
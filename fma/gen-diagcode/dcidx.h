@@ -0,0 +1,124 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+#ifndef _DCIDX_H
+#define	_DCIDX_H
+
+/*
+ * A precompiled index of every code in a set of FM dictionaries, laid out so
+ * that it can be mmap'd and used as-is, for looking up the code for a key
+ * (one or more event classes) and the key and dictionary for a code without
+ * reading any dictionary.  The file is a header followed by arrays of
+ * dictionaries and entries, two hash tables and a string table.  Each
+ * dictionary's entries are contiguous.  The hash tables each have
+ * dx_nbuckets slots, a power of two at least twice the number of entries, and
+ * hold the index of an entry or DCIDX_NONE; an entry is found by hashing its
+ * key (or code) with dcidx_hash() and probing linearly from that slot.  Keys
+ * with several classes are stored with the classes sorted and separated by
+ * single spaces (see dcidx_normkey()).
+ *
+ * As with fmdev's CPU table, every field is in the byte order of the host that
+ * wrote the file, every array starts on an 8-byte boundary and strings are
+ * referred to by their offset in the string table, which starts with an empty
+ * string.
+ */
+
+#include <sys/types.h>
+#include <stdint.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define	DCIDX_MAGIC	0x44434958	/* "DCIX" */
+#define	DCIDX_VERSION	1
+#define	DCIDX_NONE	UINT32_MAX
+
+typedef struct dcidx_hdr {
+	uint32_t dx_magic;		/* DCIDX_MAGIC */
+	uint16_t dx_version;		/* DCIDX_VERSION */
+	uint16_t dx_hdrsize;		/* sizeof (dcidx_hdr_t) */
+	uint32_t dx_ndicts;		/* number of dictionaries */
+	uint32_t dx_nents;		/* number of entries */
+	uint32_t dx_nbuckets;		/* slots in each hash table */
+	uint32_t dx_pad;
+	uint64_t dx_dictoff;		/* offset of dcidx_dict_t array */
+	uint64_t dx_entoff;		/* offset of dcidx_ent_t array */
+	uint64_t dx_keytaboff;		/* offset of hash table by key */
+	uint64_t dx_codetaboff;		/* offset of hash table by code */
+	uint64_t dx_stroff;		/* offset of string table */
+	uint64_t dx_strsize;		/* size of string table */
+	uint64_t dx_filesz;		/* size of the whole file */
+} dcidx_hdr_t;
+
+typedef struct dcidx_dict {
+	uint32_t dd_name;		/* dictionary name string */
+	uint32_t dd_ent;		/* index of first entry */
+	uint32_t dd_nents;		/* number of entries */
+	uint32_t dd_pad;
+} dcidx_dict_t;
+
+typedef struct dcidx_ent {
+	uint32_t de_key;		/* key string */
+	uint32_t de_code;		/* code string */
+	uint32_t de_dict;		/* index of dictionary */
+	uint32_t de_keyhash;		/* dcidx_hash() of key */
+	uint32_t de_codehash;		/* dcidx_hash() of code */
+	uint32_t de_pad;
+} dcidx_ent_t;
+
+/*
+ * 32-bit FNV-1a.
+ */
+static inline uint32_t
+dcidx_hash(const char *s)
+{
+	uint32_t h = 2166136261U;
+
+	for (; *s != '\0'; s++) {
+		h ^= (uchar_t)*s;
+		h *= 16777619U;
+	}
+	return (h);
+}
+
+static inline const dcidx_dict_t *
+dcidx_dict(const dcidx_hdr_t *dx, uint32_t i)
+{
+	return ((const dcidx_dict_t *)((const char *)dx + dx->dx_dictoff) +
+	    i);
+}
+
+static inline const dcidx_ent_t *
+dcidx_ent(const dcidx_hdr_t *dx, uint32_t i)
+{
+	return ((const dcidx_ent_t *)((const char *)dx + dx->dx_entoff) + i);
+}
+
+static inline const char *
+dcidx_str(const dcidx_hdr_t *dx, uint32_t off)
+{
+	return ((const char *)dx + dx->dx_stroff + off);
+}
+
+extern int dcidx_build(const char *, const char *, dcidx_hdr_t **);
+extern int dcidx_open(const char *, dcidx_hdr_t **);
+extern void dcidx_close(dcidx_hdr_t *);
+extern void dcidx_free(dcidx_hdr_t *);
+extern int dcidx_write(const dcidx_hdr_t *, const char *);
+extern int dcidx_normkey(const char *, char *, size_t);
+extern const dcidx_ent_t *dcidx_lookup_key(const dcidx_hdr_t *, const char *,
+    const char *);
+extern const dcidx_ent_t *dcidx_lookup_code(const dcidx_hdr_t *,
+    const char *);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _DCIDX_H */
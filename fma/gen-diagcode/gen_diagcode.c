@@ -9,46 +9,653 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <string.h>
 #include <stropts.h>
 #include <unistd.h>
 #include <fm/diagcode.h>
+#include <sys/param.h>
 #include <sys/types.h>
 
+#include "dcgen.h"
+#include "dcidx.h"
+
 #define	DICTDIR	"usr/lib/fm/dict"
 
+#define	GD_MAXTHREADS	256
+#define	GD_CHUNK	64		/* lines handed to a thread at a time */
+#define	GD_CODELEN	64
+#define	GD_KEYLEN	4096
+
+typedef enum {
+	GD_OK,
+	GD_ENODICT,			/* dictionary couldn't be opened */
+	GD_ENOCODE			/* no code for the class */
+} gd_err_t;
+
+typedef struct gd_line {
+	char *gl_dict;			/* dictionary name */
+	char *gl_class;			/* event class */
+	uint_t gl_lineno;		/* line number in input */
+	gd_err_t gl_err;		/* outcome */
+	char gl_code[GD_CODELEN];	/* code, if gl_err is GD_OK */
+} gd_line_t;
+
+typedef struct gd_chunk {
+	gd_line_t gc_lines[GD_CHUNK];	/* input */
+	uint_t gc_nlines;		/* number of lines in gc_lines */
+	uchar_t gc_done;		/* lookups are finished */
+} gd_chunk_t;
+
+typedef struct gd_dict {
+	const char *gdd_name;		/* dictionary name */
+	fm_dc_handle_t *gdd_dhp;	/* handle, or NULL if open failed */
+} gd_dict_t;
+
+typedef struct gd_batch {
+	const char *gb_file;		/* name of the input */
+	int gb_fd;			/* input */
+	int gb_rstatus;			/* reader's exit status */
+	const char *gb_dictpath;	/* directory holding dictionaries */
+	const dcidx_hdr_t *gb_idx;	/* index to use instead, if any */
+	gd_chunk_t **gb_chunks;		/* input read so far */
+	size_t gb_nchunks;		/* number of chunks read */
+	size_t gb_nalloc;		/* size of gb_chunks */
+	size_t gb_next;			/* next chunk to hand out */
+	boolean_t gb_eof;		/* no more chunks are coming */
+	pthread_mutex_t gb_lock;	/* protects the above, and gc_done */
+	pthread_cond_t gb_cv;		/* signalled as chunks come and go */
+} gd_batch_t;
+
 static const char *pname;
-static const char optstr[] = "d:f:R:";
+static const char optstr[] = "b:c:d:f:g:j:o:R:x:";
 
 static void
 usage()
 {
 	(void) fprintf(stderr, "usage: %s [-R rootdir] -d <dict> "
-	    "-f <FM class>\n\n", pname);
+	    "-f <FM class>\n"
+	    "       %s [-R rootdir] -b <file> [-j nthreads]\n"
+	    "       %s [-R rootdir] -o <index>\n"
+	    "       %s [-R rootdir] -d <dict> -g <base>\n"
+	    "       %s -x <index> [-d <dict>] -f <FM class>\n"
+	    "       %s -x <index> -b <file> [-j nthreads]\n"
+	    "       %s -x <index> -c <code>\n\n"
+	    "With -b, each line of file (or stdin, if it's -) holds a "
+	    "dictionary name and\nan FM class, and \"<dict> <class> <code>\" "
+	    "is printed for each, in the same\norder, with \"-\" for the "
+	    "code if there isn't one.  The input is divided among\n-j "
+	    "threads, each of which keeps every dictionary it uses open.\n\n"
+	    "-o writes an index of every code in every dictionary, which -x "
+	    "then looks codes\nup in instead of the dictionaries.  -c prints "
+	    "the dictionary and class for a\ncode, or, given -, reads codes "
+	    "from stdin and prints \"<code> <dict> <class>\"\nfor each.\n\n"
+	    "-g writes base.c and base.h, which define base_lookup() and "
+	    "base_key2code()\nto compute the dictionary's codes from a "
+	    "table compiled into the program.\n\n",
+	    pname, pname, pname, pname, pname, pname, pname);
+}
+
+/*
+ * Parse one <dict> <class> line of a batch into gl.  Returns 1 for blank lines
+ * and comments, which are skipped, and -1 if the line is malformed.
+ */
+static int
+gd_parse(const char *name, const char *line, uint_t lineno, gd_line_t *gl)
+{
+	char *buf, *dict, *class, *extra, *last;
+
+	/*
+	 * Each line's copy starts with its dictionary name, so that's what's
+	 * freed when the batch is done.
+	 */
+	while (*line == ' ' || *line == '\t')
+		line++;
+	if ((buf = strdup(line)) == NULL) {
+		(void) fprintf(stderr, "malloc failed\n");
+		return (-1);
+	}
+	dict = strtok_r(buf, " \t\n", &last);
+	if (dict == NULL || *dict == '#') {
+		free(buf);
+		return (1);
+	}
+	class = strtok_r(NULL, " \t\n", &last);
+	extra = strtok_r(NULL, " \t\n", &last);
+	if (class == NULL || extra != NULL) {
+		(void) fprintf(stderr, "%s: line %u: expected <dict> <class>\n",
+		    name, lineno);
+		free(buf);
+		return (-1);
+	}
+	gl->gl_dict = dict;
+	gl->gl_class = class;
+	gl->gl_lineno = lineno;
+	gl->gl_err = GD_OK;
+	return (0);
+}
+
+/*
+ * Hand a chunk of input to the workers.
+ */
+static int
+gd_publish(gd_batch_t *gb, gd_chunk_t *gc)
+{
+	gd_chunk_t **chunks;
+	size_t nalloc;
+	int status = 0;
+
+	(void) pthread_mutex_lock(&gb->gb_lock);
+	if (gb->gb_nchunks == gb->gb_nalloc) {
+		nalloc = gb->gb_nalloc == 0 ? 64 : gb->gb_nalloc * 2;
+		if ((chunks = realloc(gb->gb_chunks,
+		    nalloc * sizeof (gd_chunk_t *))) == NULL) {
+			status = -1;
+			goto out;
+		}
+		gb->gb_chunks = chunks;
+		gb->gb_nalloc = nalloc;
+	}
+	gb->gb_chunks[gb->gb_nchunks++] = gc;
+	(void) pthread_cond_broadcast(&gb->gb_cv);
+out:
+	(void) pthread_mutex_unlock(&gb->gb_lock);
+	return (status);
+}
+
+/*
+ * Read the <dict> <class> pairs of a batch, skipping blank lines and comments.
+ * Lines are handed to the workers GD_CHUNK at a time, and whatever has been
+ * read when the input runs dry is handed over without waiting for more, so a
+ * pipe's lines are looked up (and printed) as they arrive rather than once it
+ * has been closed.  That's why this reads the descriptor itself: stdio
+ * doesn't say when its buffer is empty.
+ */
+static void *
+gd_reader(void *arg)
+{
+	gd_batch_t *gb = arg;
+	gd_chunk_t *gc = NULL;
+	char *buf = NULL, *nbuf, *p, *nl;
+	size_t bufsz = 0, len = 0;
+	ssize_t n;
+	uint_t lineno = 0;
+	boolean_t eof = B_FALSE;
+	int status = 0;
+
+	while (!eof) {
+		if (len + 1 >= bufsz) {
+			bufsz = bufsz == 0 ? 65536 : bufsz * 2;
+			if ((nbuf = realloc(buf, bufsz)) == NULL) {
+				(void) fprintf(stderr, "malloc failed\n");
+				status = 1;
+				goto out;
+			}
+			buf = nbuf;
+		}
+		if ((n = read(gb->gb_fd, buf + len, bufsz - len - 1)) < 0) {
+			if (errno == EINTR)
+				continue;
+			(void) fprintf(stderr, "failed to read %s (%s)\n",
+			    gb->gb_file, strerror(errno));
+			status = 1;
+			goto out;
+		}
+		len += n;
+
+		/*
+		 * At the end of the input, a last line without a newline is
+		 * still a line.
+		 */
+		if (n == 0) {
+			eof = B_TRUE;
+			if (len > 0)
+				buf[len++] = '\n';
+		}
+
+		for (p = buf; (nl = memchr(p, '\n', len - (p - buf))) != NULL;
+		    p = nl + 1) {
+			*nl = '\0';
+			lineno++;
+			if (gc == NULL &&
+			    (gc = calloc(1, sizeof (gd_chunk_t))) == NULL) {
+				(void) fprintf(stderr, "malloc failed\n");
+				status = 1;
+				goto out;
+			}
+			switch (gd_parse(gb->gb_file, p, lineno,
+			    &gc->gc_lines[gc->gc_nlines])) {
+			case 0:
+				gc->gc_nlines++;
+				break;
+			case -1:
+				status = 1;
+				break;
+			}
+			if (gc->gc_nlines < GD_CHUNK)
+				continue;
+			if (gd_publish(gb, gc) != 0) {
+				(void) fprintf(stderr, "malloc failed\n");
+				status = 1;
+				goto out;
+			}
+			gc = NULL;
+		}
+		len -= p - buf;
+		(void) memmove(buf, p, len);
+
+		if (gc != NULL && gc->gc_nlines > 0) {
+			if (gd_publish(gb, gc) != 0) {
+				(void) fprintf(stderr, "malloc failed\n");
+				status = 1;
+				goto out;
+			}
+			gc = NULL;
+		}
+	}
+
+out:
+	if (gc != NULL) {
+		while (gc->gc_nlines > 0)
+			free(gc->gc_lines[--gc->gc_nlines].gl_dict);
+		free(gc);
+	}
+	free(buf);
+
+	(void) pthread_mutex_lock(&gb->gb_lock);
+	gb->gb_rstatus = status;
+	gb->gb_eof = B_TRUE;
+	(void) pthread_cond_broadcast(&gb->gb_cv);
+	(void) pthread_mutex_unlock(&gb->gb_lock);
+	return (NULL);
+}
+
+/*
+ * Return this thread's handle for a dictionary, opening it the first time
+ * it's asked for.
+ */
+static fm_dc_handle_t *
+gd_dict(const gd_batch_t *gb, gd_dict_t **dictsp, uint_t *ndictsp,
+    const char *name)
+{
+	gd_dict_t *dicts = *dictsp;
+	uint_t i;
+
+	for (i = 0; i < *ndictsp; i++) {
+		if (strcmp(dicts[i].gdd_name, name) == 0)
+			return (dicts[i].gdd_dhp);
+	}
+	if ((dicts = realloc(dicts, (i + 1) * sizeof (gd_dict_t))) == NULL)
+		return (NULL);
+	dicts[i].gdd_name = name;
+	dicts[i].gdd_dhp = fm_dc_opendict(FM_DC_VERSION, gb->gb_dictpath,
+	    name);
+	*dictsp = dicts;
+	*ndictsp = i + 1;
+	return (dicts[i].gdd_dhp);
+}
+
+/*
+ * A dictionary handle reads the dictionary through a stdio stream of its own,
+ * so handles aren't shared between threads: each worker opens the ones it
+ * needs and keeps them until the batch is done.
+ */
+static void *
+gd_worker(void *arg)
+{
+	gd_batch_t *gb = arg;
+	gd_dict_t *dicts = NULL;
+	fm_dc_handle_t *dhp;
+	gd_chunk_t *gc;
+	gd_line_t *gl;
+	const char *key[2];
+	uint_t i, l, ndicts = 0;
+
+	for (;;) {
+		(void) pthread_mutex_lock(&gb->gb_lock);
+		while (gb->gb_next == gb->gb_nchunks && !gb->gb_eof)
+			(void) pthread_cond_wait(&gb->gb_cv, &gb->gb_lock);
+		gc = gb->gb_next < gb->gb_nchunks ?
+		    gb->gb_chunks[gb->gb_next++] : NULL;
+		(void) pthread_mutex_unlock(&gb->gb_lock);
+		if (gc == NULL)
+			break;
+
+		for (l = 0; l < gc->gc_nlines; l++) {
+			gl = &gc->gc_lines[l];
+			if (gb->gb_idx != NULL) {
+				const dcidx_ent_t *de;
+
+				if ((de = dcidx_lookup_key(gb->gb_idx,
+				    gl->gl_dict, gl->gl_class)) == NULL) {
+					gl->gl_err = GD_ENOCODE;
+				} else {
+					(void) strlcpy(gl->gl_code,
+					    dcidx_str(gb->gb_idx, de->de_code),
+					    sizeof (gl->gl_code));
+				}
+				continue;
+			}
+			if ((dhp = gd_dict(gb, &dicts, &ndicts,
+			    gl->gl_dict)) == NULL) {
+				gl->gl_err = GD_ENODICT;
+				continue;
+			}
+			key[0] = gl->gl_class;
+			key[1] = NULL;
+			if (fm_dc_key2code(dhp, key, gl->gl_code,
+			    sizeof (gl->gl_code)) < 0)
+				gl->gl_err = GD_ENOCODE;
+		}
+
+		(void) pthread_mutex_lock(&gb->gb_lock);
+		gc->gc_done = 1;
+		(void) pthread_cond_broadcast(&gb->gb_cv);
+		(void) pthread_mutex_unlock(&gb->gb_lock);
+	}
+
+	for (i = 0; i < ndicts; i++) {
+		if (dicts[i].gdd_dhp != NULL)
+			fm_dc_closedict(dicts[i].gdd_dhp);
+	}
+	free(dicts);
+	return (NULL);
+}
+
+/*
+ * Whether chunk c has yet to be read or looked up.  Called with gb_lock held.
+ */
+static boolean_t
+gd_pending(const gd_batch_t *gb, size_t c)
+{
+	if (c == gb->gb_nchunks)
+		return (!gb->gb_eof);
+	return (!gb->gb_chunks[c]->gc_done);
+}
+
+/*
+ * Look up the code for every line of a batch on nthrs threads, in the index if
+ * one is given and in the dictionaries otherwise.  A thread of its own reads
+ * the input while the workers look up what it has read so far, and results
+ * are printed in input order as soon as each chunk of them, and every chunk
+ * before it, is finished.  Output is flushed whenever we'd otherwise wait for
+ * more, so that a pipe sees results while its input is still being written.
+ */
+static int
+gd_batch(const char *file, const char *dictpath, const dcidx_hdr_t *dx,
+    uint_t nthrs)
+{
+	gd_batch_t gb = { 0 };
+	pthread_t *tids = NULL, rtid;
+	gd_chunk_t *gc;
+	gd_line_t *gl;
+	size_t c;
+	uint_t l, started = 0;
+	boolean_t reader = B_FALSE;
+	int err, status = 0;
+
+	if (strcmp(file, "-") == 0) {
+		gb.gb_fd = STDIN_FILENO;
+		gb.gb_file = "stdin";
+	} else if ((gb.gb_fd = open(file, O_RDONLY)) < 0) {
+		(void) fprintf(stderr, "failed to open %s (%s)\n", file,
+		    strerror(errno));
+		return (1);
+	} else {
+		gb.gb_file = file;
+	}
+	gb.gb_dictpath = dictpath;
+	gb.gb_idx = dx;
+	(void) pthread_mutex_init(&gb.gb_lock, NULL);
+	(void) pthread_cond_init(&gb.gb_cv, NULL);
+
+	if ((tids = calloc(nthrs, sizeof (pthread_t))) == NULL) {
+		(void) fprintf(stderr, "malloc failed\n");
+		status = 1;
+		goto out;
+	}
+	for (started = 0; started < nthrs; started++) {
+		if ((err = pthread_create(&tids[started], NULL, gd_worker,
+		    &gb)) != 0) {
+			(void) fprintf(stderr, "failed to create thread (%s)\n",
+			    strerror(err));
+			break;
+		}
+	}
+
+	/*
+	 * Without threads to spare, fall back to reading everything, then
+	 * looking it all up, then printing it.
+	 */
+	if ((err = pthread_create(&rtid, NULL, gd_reader, &gb)) == 0) {
+		reader = B_TRUE;
+	} else {
+		(void) fprintf(stderr, "failed to create thread (%s)\n",
+		    strerror(err));
+		(void) gd_reader(&gb);
+	}
+	if (started == 0)
+		(void) gd_worker(&gb);
+
+	for (c = 0; ; c++) {
+		(void) pthread_mutex_lock(&gb.gb_lock);
+		if (gd_pending(&gb, c)) {
+			(void) pthread_mutex_unlock(&gb.gb_lock);
+			(void) fflush(stdout);
+			(void) pthread_mutex_lock(&gb.gb_lock);
+		}
+		while (gd_pending(&gb, c))
+			(void) pthread_cond_wait(&gb.gb_cv, &gb.gb_lock);
+		gc = c < gb.gb_nchunks ? gb.gb_chunks[c] : NULL;
+		(void) pthread_mutex_unlock(&gb.gb_lock);
+		if (gc == NULL)
+			break;
+
+		for (l = 0; l < gc->gc_nlines; l++) {
+			gl = &gc->gc_lines[l];
+			(void) printf("%s %s %s\n", gl->gl_dict, gl->gl_class,
+			    gl->gl_err == GD_OK ? gl->gl_code : "-");
+			if (gl->gl_err == GD_ENODICT) {
+				(void) fprintf(stderr, "%s: line %u: "
+				    "fm_dc_opendict failed for %s in %s\n",
+				    gb.gb_file, gl->gl_lineno, gl->gl_dict,
+				    dictpath);
+				status = 1;
+			} else if (gl->gl_err == GD_ENOCODE) {
+				(void) fprintf(stderr, "%s: line %u: "
+				    "no code for %s in %s\n", gb.gb_file,
+				    gl->gl_lineno, gl->gl_class, gl->gl_dict);
+				status = 1;
+			}
+		}
+	}
+	if (reader)
+		(void) pthread_join(rtid, NULL);
+	while (started > 0)
+		(void) pthread_join(tids[--started], NULL);
+	if (gb.gb_rstatus != 0)
+		status = 1;
+
+	if (fflush(stdout) != 0) {
+		(void) fprintf(stderr, "failed to write output (%s)\n",
+		    strerror(errno));
+		status = 1;
+	}
+out:
+	for (c = 0; c < gb.gb_nchunks; c++) {
+		gc = gb.gb_chunks[c];
+		for (l = 0; l < gc->gc_nlines; l++)
+			free(gc->gc_lines[l].gl_dict);
+		free(gc);
+	}
+	free(gb.gb_chunks);
+	free(tids);
+	if (gb.gb_fd != STDIN_FILENO)
+		(void) close(gb.gb_fd);
+	return (status);
+}
+
+/*
+ * Print the dictionary and key for a code, or, if code is "-", for each code
+ * read from stdin.  When reading stdin, codes that aren't in the index are
+ * printed with "-" for the dictionary and key, and aren't treated as errors.
+ */
+static int
+gd_codes(const dcidx_hdr_t *dx, const char *code)
+{
+	const dcidx_ent_t *de;
+	char *line = NULL, *p, *last;
+	size_t linesz = 0;
+	int status = 0;
+
+	if (strcmp(code, "-") != 0) {
+		if ((de = dcidx_lookup_code(dx, code)) == NULL) {
+			(void) fprintf(stderr, "no such code: %s\n", code);
+			return (1);
+		}
+		(void) printf("%s %s\n",
+		    dcidx_str(dx, dcidx_dict(dx, de->de_dict)->dd_name),
+		    dcidx_str(dx, de->de_key));
+		return (0);
+	}
+
+	while (getline(&line, &linesz, stdin) >= 0) {
+		if ((p = strtok_r(line, " \t\n", &last)) == NULL)
+			continue;
+		if ((de = dcidx_lookup_code(dx, p)) == NULL) {
+			(void) printf("%s - -\n", p);
+			continue;
+		}
+		(void) printf("%s %s %s\n", p,
+		    dcidx_str(dx, dcidx_dict(dx, de->de_dict)->dd_name),
+		    dcidx_str(dx, de->de_key));
+	}
+	if (ferror(stdin)) {
+		(void) fprintf(stderr, "failed to read stdin (%s)\n",
+		    strerror(errno));
+		status = 1;
+	}
+	if (fflush(stdout) != 0) {
+		(void) fprintf(stderr, "failed to write output (%s)\n",
+		    strerror(errno));
+		status = 1;
+	}
+	free(line);
+	return (status);
+}
+
+/*
+ * Handle the index options: build one (-o), or look codes up in one (-x).
+ */
+static int
+gd_index(const char *out, const char *in, const char *dictpath,
+    const char *dict, const char *fm_class, const char *batch,
+    const char *code, uint_t nthrs)
+{
+	char key[GD_KEYLEN];
+	const dcidx_ent_t *de;
+	dcidx_hdr_t *dx;
+	int status = 1;
+
+	if (out != NULL) {
+		if (dcidx_build(dictpath, NULL, &dx) != 0)
+			return (1);
+		if (dcidx_write(dx, out) == 0) {
+			(void) printf("%u codes from %u dictionaries written "
+			    "to %s\n", dx->dx_nents, dx->dx_ndicts, out);
+			status = 0;
+		}
+		dcidx_free(dx);
+		return (status);
+	}
+
+	if (dcidx_open(in, &dx) != 0)
+		return (1);
+	if (code != NULL) {
+		status = gd_codes(dx, code);
+	} else if (batch != NULL) {
+		status = gd_batch(batch, dictpath, dx, nthrs);
+	} else if (dcidx_normkey(fm_class, key, sizeof (key)) != 0) {
+		(void) fprintf(stderr, "invalid FM class: %s\n", fm_class);
+	} else if ((de = dcidx_lookup_key(dx, dict, key)) == NULL) {
+		(void) fprintf(stderr, "no code for %s in %s\n", key,
+		    dict != NULL ? dict : in);
+	} else {
+		(void) printf("%s\n", dcidx_str(dx, de->de_code));
+		status = 0;
+	}
+	dcidx_close(dx);
+	return (status);
+}
+
+/*
+ * Generate C source for a table of one dictionary's codes (-g).
+ */
+static int
+gd_gen(const char *base, const char *dictpath, const char *dict)
+{
+	dcidx_hdr_t *dx;
+	int status;
+
+	if (dcidx_build(dictpath, dict, &dx) != 0)
+		return (1);
+	status = dcgen_write(dx, dict, base) == 0 ? 0 : 1;
+	dcidx_free(dx);
+	return (status);
 }
 
 int
 main(int argc, char **argv)
 {
-	char c, *dict = NULL, *fm_class = NULL, *root = "/", code[64];
+	char c, *dict = NULL, *fm_class = NULL, *root = "/", code[GD_CODELEN];
+	char *batch = NULL, *end, *idxout = NULL, *idxin = NULL, *dcode = NULL;
+	char *gen = NULL;
 	char dictpath[MAXPATHLEN + 1];
 	int status = 1;
 	fm_dc_handle_t *dhp = NULL;
 	const char *key[2];
+	ulong_t nthrs = 1;
 
 	pname = argv[0];
 	while (optind < argc) {
 		while ((c = getopt(argc, argv, optstr)) != -1) {
 			switch (c) {
+			case 'b':
+				batch = optarg;
+				break;
+			case 'c':
+				dcode = optarg;
+				break;
 			case 'd':
 				dict = optarg;
 				break;
 			case 'f':
 				fm_class = optarg;
 				break;
+			case 'g':
+				gen = optarg;
+				break;
+			case 'j':
+				errno = 0;
+				nthrs = strtoul(optarg, &end, 10);
+				if (errno != 0 || *end != '\0' ||
+				    end == optarg || nthrs == 0 ||
+				    nthrs > GD_MAXTHREADS) {
+					(void) fprintf(stderr, "invalid thread "
+					    "count: %s\n", optarg);
+					return (2);
+				}
+				break;
+			case 'o':
+				idxout = optarg;
+				break;
 			case 'R':
 				root = optarg;
 				break;
+			case 'x':
+				idxin = optarg;
+				break;
 			default:
 				usage();
 				return (2);
@@ -56,12 +663,55 @@ main(int argc, char **argv)
 		}
 	}
 
+	(void) snprintf(dictpath, MAXPATHLEN, "%s/%s", root, DICTDIR);
+	if (gen != NULL) {
+		if (dict == NULL || idxout != NULL || idxin != NULL ||
+		    batch != NULL || dcode != NULL || fm_class != NULL) {
+			(void) fprintf(stderr, "-g requires -d and can only be "
+			    "combined with -R\n");
+			usage();
+			return (2);
+		}
+		return (gd_gen(gen, dictpath, dict));
+	}
+	if (idxout != NULL && (idxin != NULL || batch != NULL ||
+	    dcode != NULL || dict != NULL || fm_class != NULL)) {
+		(void) fprintf(stderr, "-o can only be combined with -R\n");
+		usage();
+		return (2);
+	}
+	if (dcode != NULL && (idxin == NULL || batch != NULL ||
+	    dict != NULL || fm_class != NULL)) {
+		(void) fprintf(stderr, "-c requires -x and can't be combined "
+		    "with -b/-d/-f\n");
+		usage();
+		return (2);
+	}
+	if (batch != NULL) {
+		if (dict != NULL || fm_class != NULL) {
+			(void) fprintf(stderr, "-b can't be combined with "
+			    "-d/-f\n");
+			usage();
+			return (2);
+		}
+		if (idxin == NULL)
+			return (gd_batch(batch, dictpath, NULL, (uint_t)nthrs));
+	}
+	if (idxin != NULL && batch == NULL && dcode == NULL &&
+	    fm_class == NULL) {
+		(void) fprintf(stderr, "-x requires -f, -b or -c\n");
+		usage();
+		return (2);
+	}
+	if (idxout != NULL || idxin != NULL) {
+		return (gd_index(idxout, idxin, dictpath, dict, fm_class, batch,
+		    dcode, (uint_t)nthrs));
+	}
 	if (dict == NULL || fm_class == NULL) {
 		(void) fprintf(stderr, "-d/-f options are required\n");
 		usage();
 		return (2);
 	}
-	(void) snprintf(dictpath, MAXPATHLEN, "%s/%s", root, DICTDIR);
 	if ((dhp = fm_dc_opendict(FM_DC_VERSION, dictpath, dict)) == NULL) {
 		(void) fprintf(stderr, "fm_dc_opendict failed for %s\n",
 		    dictpath);
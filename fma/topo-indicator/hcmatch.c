@@ -0,0 +1,305 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+/*
+ * Each pattern is compiled, when it's added, into a list of globs, one per
+ * "name=instance" pair of an hc path, so that a node can be matched by
+ * running fnmatch() on its own pair and those of its ancestors, rather than
+ * by asking libtopo for its resource and turning that into a string.
+ * Patterns come in three kinds:
+ *
+ *   hc://<authority>/<pair>/.../<pair>
+ *	Anchored: a node matches if its path has exactly as many pairs as the
+ *	pattern and each matches the corresponding glob.  If the authority
+ *	isn't "*", a node that matches that far is only a candidate, and the
+ *	whole FMRI string has to be compared with the pattern (HCM_CHECK).
+ *
+ *   *<pair>/.../<pair>
+ *	Unanchored: the leading '*' stands for the scheme, the authority and
+ *	any number of leading pairs, so a node matches if the last pairs of
+ *	its path match the globs.  The first glob keeps the '*', so that
+ *	"*bay=1" matches "bay=1" and "*enclosure=0/bay=1" matches
+ *	"ses-enclosure=0/bay=1".  A pattern whose first pair has a ':' in it
+ *	is taken to be about the authority, and is of the third kind.
+ *
+ *   anything else
+ *	Every node is a candidate, to be compared as a string (HCM_CHECK).
+ *
+ * In the first two, '*', '?' and brackets match within a pair, and never
+ * across a '/'.
+ *
+ * While the walk goes on, the current node's path is kept as a stack that's
+ * popped back to each new node's parent, along with which anchored patterns
+ * still match each prefix of it.  Once no anchored pattern can match below a
+ * node, and every pattern is anchored, nothing below it can match.  libtopo's
+ * walker has no way for a callback to skip a node's children and still visit
+ * its siblings, but when a callback returns TOPO_WALK_TERMINATE the walker
+ * treats it as the end of that list of siblings and carries on from the
+ * parent's next sibling.  So hcm_node() returns HCM_PRUNE for the first child
+ * of such a node, and that child, its siblings and all their descendants are
+ * never visited.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <fnmatch.h>
+#include <string.h>
+
+#include "hcmatch.h"
+
+#define	HCM_SCHEME	"hc://"
+
+typedef enum {
+	HCP_STRING,			/* compare the FMRI string */
+	HCP_SUFFIX,			/* match the last pairs */
+	HCP_ANCHORED			/* match every pair */
+} hcp_kind_t;
+
+typedef struct hcm_pat {
+	hcp_kind_t hp_kind;
+	char *hp_pattern;		/* pattern as given */
+	char *hp_buf;			/* hp_comps point into this */
+	char **hp_comps;		/* glob for each pair */
+	uint_t hp_ncomps;
+	boolean_t hp_authchk;		/* check the authority afterwards */
+} hcm_pat_t;
+
+typedef struct hcm_level {
+	tnode_t *hl_node;
+	char *hl_comp;			/* "name=instance" */
+	size_t hl_compsz;		/* allocated size of hl_comp */
+	boolean_t hl_prune;		/* nothing below can match */
+} hcm_level_t;
+
+struct hcm {
+	hcm_pat_t *hm_pats;
+	uint_t hm_npats;
+	boolean_t hm_anchored;		/* every pattern is anchored */
+	hcm_level_t *hm_path;		/* current node and its ancestors */
+	uint_t hm_depth;		/* number of levels in use */
+	uint_t hm_maxdepth;		/* number of levels allocated */
+	uchar_t *hm_alive;		/* anchored patterns matching so far, */
+					/* hm_maxdepth rows of hm_npats + 1 */
+};
+
+hcm_t *
+hcm_create(void)
+{
+	hcm_t *hm;
+
+	if ((hm = calloc(1, sizeof (hcm_t))) == NULL)
+		return (NULL);
+	hm->hm_anchored = B_TRUE;
+	return (hm);
+}
+
+void
+hcm_destroy(hcm_t *hm)
+{
+	uint_t i;
+
+	if (hm == NULL)
+		return;
+	for (i = 0; i < hm->hm_npats; i++) {
+		free(hm->hm_pats[i].hp_pattern);
+		free(hm->hm_pats[i].hp_buf);
+		free(hm->hm_pats[i].hp_comps);
+	}
+	for (i = 0; i < hm->hm_maxdepth; i++)
+		free(hm->hm_path[i].hl_comp);
+	free(hm->hm_pats);
+	free(hm->hm_path);
+	free(hm->hm_alive);
+	free(hm);
+}
+
+/*
+ * Split a copy of s into its '/' separated globs.
+ */
+static int
+hcm_split(hcm_pat_t *hp, const char *s)
+{
+	char *p;
+	uint_t n;
+
+	if ((hp->hp_buf = strdup(s)) == NULL)
+		return (-1);
+	for (n = 1, p = hp->hp_buf; *p != '\0'; p++) {
+		if (*p == '/')
+			n++;
+	}
+	if ((hp->hp_comps = calloc(n, sizeof (char *))) == NULL)
+		return (-1);
+	hp->hp_comps[0] = hp->hp_buf;
+	for (n = 1, p = hp->hp_buf; *p != '\0'; p++) {
+		if (*p == '/') {
+			*p = '\0';
+			hp->hp_comps[n++] = p + 1;
+		}
+	}
+	hp->hp_ncomps = n;
+	return (0);
+}
+
+/*
+ * Compile and add a pattern, and return its index, which is also its index
+ * in the results hcm_node() fills in.  Patterns can't be added once the walk
+ * has begun.
+ */
+int
+hcm_add(hcm_t *hm, const char *pattern)
+{
+	hcm_pat_t *hp;
+	const char *auth, *path;
+	size_t len, first;
+
+	if (hm->hm_maxdepth != 0)
+		return (-1);
+	if ((hp = realloc(hm->hm_pats, (hm->hm_npats + 1) *
+	    sizeof (hcm_pat_t))) == NULL)
+		return (-1);
+	hm->hm_pats = hp;
+	hp += hm->hm_npats;
+	(void) memset(hp, 0, sizeof (hcm_pat_t));
+	if ((hp->hp_pattern = strdup(pattern)) == NULL)
+		return (-1);
+
+	len = strlen(HCM_SCHEME);
+	first = strcspn(pattern, "/");
+	if (strncmp(pattern, HCM_SCHEME, len) == 0 &&
+	    (path = strchr(pattern + len, '/')) != NULL) {
+		auth = pattern + len;
+		hp->hp_kind = HCP_ANCHORED;
+		hp->hp_authchk = path - auth != 1 || *auth != '*';
+		if (hcm_split(hp, path + 1) != 0)
+			goto nomem;
+	} else if (pattern[0] == '*' &&
+	    memchr(pattern, ':', first) == NULL) {
+		hp->hp_kind = HCP_SUFFIX;
+		if (hcm_split(hp, pattern[1] == '/' ? pattern + 2 : pattern) !=
+		    0)
+			goto nomem;
+	} else {
+		hp->hp_kind = HCP_STRING;
+	}
+	if (hp->hp_kind != HCP_ANCHORED)
+		hm->hm_anchored = B_FALSE;
+	return (hm->hm_npats++);
+
+nomem:
+	free(hp->hp_pattern);
+	free(hp->hp_buf);
+	free(hp->hp_comps);
+	return (-1);
+}
+
+static int
+hcm_grow(hcm_t *hm)
+{
+	uint_t n = hm->hm_maxdepth == 0 ? 16 : hm->hm_maxdepth * 2;
+	hcm_level_t *hl;
+	uchar_t *alive;
+
+	if ((hl = realloc(hm->hm_path, n * sizeof (hcm_level_t))) == NULL)
+		return (-1);
+	(void) memset(hl + hm->hm_maxdepth, 0,
+	    (n - hm->hm_maxdepth) * sizeof (hcm_level_t));
+	hm->hm_path = hl;
+	if ((alive = realloc(hm->hm_alive, n * (hm->hm_npats + 1))) == NULL)
+		return (-1);
+	hm->hm_alive = alive;
+	hm->hm_maxdepth = n;
+	return (0);
+}
+
+/*
+ * Called for each node of the walk, in the order it visits them: fill in
+ * res[] with the result for each pattern.  Returns HCM_PRUNE if the walk
+ * should skip this node and the rest of its siblings, 0 otherwise, or -1 if
+ * memory runs out.
+ */
+int
+hcm_node(hcm_t *hm, tnode_t *node, uchar_t *res)
+{
+	tnode_t *parent = topo_node_parent(node);
+	boolean_t prune = hm->hm_anchored;
+	hcm_level_t *hl;
+	hcm_pat_t *hp;
+	uchar_t *alive, *palive;
+	uint_t d, i, j, n;
+	int len;
+
+	while (hm->hm_depth > 0 &&
+	    hm->hm_path[hm->hm_depth - 1].hl_node != parent)
+		hm->hm_depth--;
+	if (hm->hm_depth > 0 && hm->hm_path[hm->hm_depth - 1].hl_prune)
+		return (HCM_PRUNE);
+	if (hm->hm_depth == hm->hm_maxdepth && hcm_grow(hm) != 0)
+		return (-1);
+
+	d = hm->hm_depth++;
+	hl = &hm->hm_path[d];
+	hl->hl_node = node;
+	for (;;) {
+		len = snprintf(hl->hl_comp, hl->hl_compsz, "%s=%d",
+		    topo_node_name(node), topo_node_instance(node));
+		if (len < hl->hl_compsz)
+			break;
+		free(hl->hl_comp);
+		hl->hl_compsz = len + 1;
+		if ((hl->hl_comp = malloc(hl->hl_compsz)) == NULL) {
+			hl->hl_compsz = 0;
+			hm->hm_depth--;
+			return (-1);
+		}
+	}
+
+	alive = &hm->hm_alive[d * (hm->hm_npats + 1)];
+	palive = d > 0 ? alive - (hm->hm_npats + 1) : NULL;
+	for (i = 0; i < hm->hm_npats; i++) {
+		hp = &hm->hm_pats[i];
+		n = hp->hp_ncomps;
+		res[i] = HCM_NOMATCH;
+		switch (hp->hp_kind) {
+		case HCP_STRING:
+			res[i] = HCM_CHECK;
+			break;
+		case HCP_SUFFIX:
+			if (d + 1 < n)
+				break;
+			for (j = n; j > 0; j--) {
+				if (fnmatch(hp->hp_comps[j - 1],
+				    hm->hm_path[d + 1 - n + j - 1].hl_comp,
+				    0) != 0)
+					break;
+			}
+			if (j == 0)
+				res[i] = HCM_MATCH;
+			break;
+		case HCP_ANCHORED:
+			alive[i] = (palive == NULL || palive[i]) && d < n &&
+			    fnmatch(hp->hp_comps[d], hl->hl_comp, 0) == 0;
+			if (alive[i] && d + 1 == n)
+				res[i] = hp->hp_authchk ? HCM_CHECK : HCM_MATCH;
+			if (alive[i] && d + 1 < n)
+				prune = B_FALSE;
+			break;
+		}
+	}
+	hl->hl_prune = prune;
+	return (0);
+}
+
+/*
+ * Compare a node's FMRI string with a pattern that hcm_node() said
+ * HCM_CHECK for.
+ */
+boolean_t
+hcm_check(const hcm_t *hm, uint_t i, const char *fmri)
+{
+	return (fnmatch(hm->hm_pats[i].hp_pattern, fmri, 0) == 0);
+}
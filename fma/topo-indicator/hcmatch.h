@@ -0,0 +1,50 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+#ifndef _HCMATCH_H
+#define	_HCMATCH_H
+
+/*
+ * Match FMRI glob patterns against the nodes of an hc topology walk, one
+ * "name=instance" pair at a time, without building each node's FMRI string,
+ * and tell the walk when a whole subtree can be skipped.  See hcmatch.c.
+ */
+
+#include <sys/types.h>
+#include <fm/libtopo.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/*
+ * Per-pattern results from hcm_node().
+ */
+#define	HCM_NOMATCH	0
+#define	HCM_MATCH	1
+#define	HCM_CHECK	2	/* compare the FMRI string with hcm_check() */
+
+/*
+ * hcm_node() return value for a node that the walk callback should answer
+ * with TOPO_WALK_TERMINATE.
+ */
+#define	HCM_PRUNE	1
+
+typedef struct hcm hcm_t;
+
+extern hcm_t *hcm_create(void);
+extern void hcm_destroy(hcm_t *);
+extern int hcm_add(hcm_t *, const char *);
+extern int hcm_node(hcm_t *, tnode_t *, uchar_t *);
+extern boolean_t hcm_check(const hcm_t *, uint_t, const char *);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _HCMATCH_H */
@@ -0,0 +1,478 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+/*
+ * topo-indicator -D holds a topology snapshot, and carries out operations
+ * sent to it over a Unix socket by topo-indicator -S, so that only the first
+ * of them pays for topo_snap_hold() enumerating every SES enclosure and
+ * IPMI sensor.
+ *
+ * A client writes its request, one line each:
+ *
+ *	refresh
+ *	led <FMRI> <type> <mode>
+ *	query <FMRI>
+ *
+ * and shuts down its side of the connection.  The reply is each line of the
+ * output, prefixed with "1 " if it would have gone to stdout and "2 " if it
+ * would have gone to stderr, then "exit <status>".  Requests are handled one
+ * at a time, and the operations in each are carried out during a single walk,
+ * as they would be by topo-indicator itself.
+ *
+ * The snapshot is taken again when a client asks for it, and after devices
+ * are added or removed, or attachment points change state (the sysevents
+ * that hotplugging a disk, or an enclosure, gives rise to).  Those come in
+ * bursts, so the snapshot is only taken once things have been quiet for
+ * SNAPD_SETTLE, or when a request comes in before then.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <libsysevent.h>
+#include <sys/sysevent/eventdefs.h>
+#include <fm/libtopo.h>
+
+#include "topo-indicator.h"
+
+#define	SNAPD_SETTLE	(2LL * NANOSEC)	/* quiet time before a refresh */
+#define	SNAPD_TIMEOUT	10		/* seconds to send a request in */
+#define	SNAPD_BACKLOG	16
+
+typedef struct snapd {
+	topo_hdl_t *sd_thp;
+	boolean_t sd_held;		/* there's a snapshot to use */
+	boolean_t sd_stale;		/* there have been sysevents since */
+	hrtime_t sd_event;		/* when the last one came */
+} snapd_t;
+
+/*
+ * The sysevent handler and the signal handlers write to this, and the main
+ * loop polls it along with the socket.
+ */
+static int snapd_pipe[2] = { -1, -1 };
+static volatile sig_atomic_t snapd_quit;
+
+static const char *snapd_classes[] = { EC_DEV_ADD, EC_DEV_REMOVE, EC_DR };
+
+/*ARGSUSED*/
+static void
+snapd_event(sysevent_t *ev)
+{
+	char c = 'e';
+
+	(void) write(snapd_pipe[1], &c, 1);
+}
+
+/*ARGSUSED*/
+static void
+snapd_signal(int sig)
+{
+	char c = 'q';
+
+	snapd_quit = 1;
+	(void) write(snapd_pipe[1], &c, 1);
+}
+
+/*
+ * Take a new snapshot, reporting any failure to the client whose request
+ * asked for it, if any.  Until one can be taken, requests fail.
+ */
+static int
+snapd_refresh(snapd_t *sd, struct led_cb_arg *cbarg)
+{
+	hrtime_t start = gethrtime();
+	int err;
+
+	if (sd->sd_held)
+		topo_snap_release(sd->sd_thp);
+	sd->sd_stale = B_FALSE;
+	sd->sd_held = topo_snap_hold(sd->sd_thp, NULL, &err) != NULL;
+	if (!sd->sd_held) {
+		(void) fprintf(stderr, "failed to take topo snapshot: %s\n",
+		    topo_strerror(err));
+		if (cbarg != NULL) {
+			ti_err(cbarg, "failed to take topo snapshot: %s\n",
+			    topo_strerror(err));
+		}
+		return (-1);
+	}
+	(void) fprintf(stderr, "took topo snapshot in %lld ms\n",
+	    (long long)((gethrtime() - start) / (NANOSEC / MILLISEC)));
+	return (0);
+}
+
+static sysevent_handle_t *
+snapd_subscribe(void)
+{
+	const char *subclasses[] = { EC_SUB_ALL };
+	sysevent_handle_t *shp;
+	uint_t i;
+
+	if ((shp = sysevent_bind_handle(snapd_event)) == NULL) {
+		(void) fprintf(stderr, "failed to bind sysevent handle (%s)\n",
+		    strerror(errno));
+		return (NULL);
+	}
+	for (i = 0; i < sizeof (snapd_classes) / sizeof (snapd_classes[0]);
+	    i++) {
+		if (sysevent_subscribe_event(shp, snapd_classes[i],
+		    subclasses, 1) != 0) {
+			(void) fprintf(stderr, "failed to subscribe to %s "
+			    "sysevents (%s)\n", snapd_classes[i],
+			    strerror(errno));
+			sysevent_unbind_handle(shp);
+			return (NULL);
+		}
+	}
+	return (shp);
+}
+
+/*
+ * Read a client's request, carry it out and send the reply.
+ */
+static void
+snapd_request(snapd_t *sd, int fd)
+{
+	struct led_cb_arg cbarg = { 0 };
+	struct timeval tv = { SNAPD_TIMEOUT, 0 };
+	char *line = NULL, *fields[5], *p, *last;
+	size_t linesz = 0;
+	boolean_t refresh = B_FALSE;
+	FILE *in, *out = NULL;
+	uint_t n;
+	int wfd, status = 2;
+
+	(void) setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof (tv));
+	(void) setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof (tv));
+	if ((in = fdopen(fd, "r")) == NULL) {
+		(void) close(fd);
+		return;
+	}
+	if ((wfd = dup(fd)) < 0 || (out = fdopen(wfd, "w")) == NULL) {
+		(void) fprintf(stderr, "failed to reply to request (%s)\n",
+		    strerror(errno));
+		if (wfd >= 0)
+			(void) close(wfd);
+		goto done;
+	}
+	cbarg.lcb_reply = out;
+
+	while (getline(&line, &linesz, in) >= 0) {
+		n = 0;
+		for (p = strtok_r(line, " \t\n", &last); p != NULL && n < 5;
+		    p = strtok_r(NULL, " \t\n", &last))
+			fields[n++] = p;
+		if (n == 0)
+			continue;
+		if (n == 1 && strcmp(fields[0], "refresh") == 0) {
+			refresh = B_TRUE;
+		} else if (n == 2 && strcmp(fields[0], "query") == 0) {
+			if (add_query(&cbarg, fields[1]) != 0)
+				goto reply;
+		} else if (n == 4 && strcmp(fields[0], "led") == 0) {
+			if (add_op(&cbarg, fields[1], fields[2],
+			    fields[3]) != 0)
+				goto reply;
+		} else {
+			ti_err(&cbarg, "invalid request: %s\n", fields[0]);
+			goto reply;
+		}
+	}
+	if (ferror(in)) {
+		(void) fprintf(stderr, "failed to read request (%s)\n",
+		    strerror(errno));
+		goto done;
+	}
+
+	status = 1;
+	if ((refresh || sd->sd_stale || !sd->sd_held) &&
+	    snapd_refresh(sd, &cbarg) != 0)
+		goto reply;
+	status = cbarg.lcb_nops == 0 ? 0 : run_ops(sd->sd_thp, &cbarg);
+reply:
+	(void) fprintf(out, "exit %d\n", status);
+done:
+	if (out != NULL)
+		(void) fclose(out);
+	(void) fclose(in);
+	free(line);
+	free_ops(&cbarg);
+}
+
+/*
+ * Bind the socket at path, unless another topo-indicator -D is already
+ * listening there.
+ */
+static int
+snapd_listen(const char *path)
+{
+	struct sockaddr_un sun;
+	struct stat st;
+	mode_t omask;
+	int fd, err;
+
+	(void) memset(&sun, 0, sizeof (sun));
+	sun.sun_family = AF_UNIX;
+	if (strlcpy(sun.sun_path, path, sizeof (sun.sun_path)) >=
+	    sizeof (sun.sun_path)) {
+		(void) fprintf(stderr, "socket path too long: %s\n", path);
+		return (-1);
+	}
+	/*
+	 * A socket that nothing is listening on is left over from one that
+	 * went away, and is replaced.  Anything else that's there is kept,
+	 * since connect() fails the same way for a plain file.
+	 */
+	if (lstat(path, &st) == 0) {
+		if (!S_ISSOCK(st.st_mode)) {
+			(void) fprintf(stderr, "%s exists and is not a "
+			    "socket\n", path);
+			return (-1);
+		}
+		if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+			(void) fprintf(stderr, "failed to create socket "
+			    "(%s)\n", strerror(errno));
+			return (-1);
+		}
+		if (connect(fd, (struct sockaddr *)&sun, sizeof (sun)) == 0) {
+			(void) fprintf(stderr, "%s is already being served\n",
+			    path);
+			(void) close(fd);
+			return (-1);
+		}
+		err = errno;
+		(void) close(fd);
+		if (err == ECONNREFUSED)
+			(void) unlink(path);
+	}
+
+	if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+		(void) fprintf(stderr, "failed to create socket (%s)\n",
+		    strerror(errno));
+		return (-1);
+	}
+	/*
+	 * Setting indicators is for root only, as it is without -D.
+	 */
+	omask = umask(077);
+	if (bind(fd, (struct sockaddr *)&sun, sizeof (sun)) != 0 ||
+	    listen(fd, SNAPD_BACKLOG) != 0) {
+		(void) fprintf(stderr, "failed to listen on %s (%s)\n", path,
+		    strerror(errno));
+		(void) umask(omask);
+		(void) close(fd);
+		return (-1);
+	}
+	(void) umask(omask);
+	(void) fcntl(fd, F_SETFD, FD_CLOEXEC);
+	return (fd);
+}
+
+int
+snapd_serve(const char *root, const char *path)
+{
+	snapd_t sd = { 0 };
+	sysevent_handle_t *shp = NULL;
+	struct sigaction act;
+	struct pollfd pfd[2];
+	hrtime_t now;
+	char buf[64];
+	ssize_t len;
+	int err, fd = -1, timeout, status = 1;
+
+	if (pipe(snapd_pipe) != 0) {
+		(void) fprintf(stderr, "failed to create pipe (%s)\n",
+		    strerror(errno));
+		return (1);
+	}
+	(void) fcntl(snapd_pipe[0], F_SETFL, O_NONBLOCK);
+	(void) fcntl(snapd_pipe[1], F_SETFL, O_NONBLOCK);
+
+	(void) memset(&act, 0, sizeof (act));
+	(void) sigemptyset(&act.sa_mask);
+	act.sa_handler = snapd_signal;
+	(void) sigaction(SIGINT, &act, NULL);
+	(void) sigaction(SIGTERM, &act, NULL);
+	act.sa_handler = SIG_IGN;
+	(void) sigaction(SIGPIPE, &act, NULL);
+
+	if ((sd.sd_thp = topo_open(TOPO_VERSION, root, &err)) == NULL) {
+		(void) fprintf(stderr, "failed to get topo handle: %s\n",
+		    topo_strerror(err));
+		goto out;
+	}
+	/*
+	 * Subscribe before taking the first snapshot, so that nothing that
+	 * changes while it's being taken is missed.  Clients that connect
+	 * in the meantime wait for it.
+	 */
+	if ((fd = snapd_listen(path)) < 0 ||
+	    (shp = snapd_subscribe()) == NULL ||
+	    snapd_refresh(&sd, NULL) != 0)
+		goto out;
+
+	pfd[0].fd = fd;
+	pfd[0].events = POLLIN;
+	pfd[1].fd = snapd_pipe[0];
+	pfd[1].events = POLLIN;
+	while (!snapd_quit) {
+		timeout = -1;
+		if (sd.sd_stale) {
+			now = gethrtime();
+			timeout = now - sd.sd_event >= SNAPD_SETTLE ? 0 :
+			    (SNAPD_SETTLE - (now - sd.sd_event)) /
+			    (NANOSEC / MILLISEC) + 1;
+		}
+		if (poll(pfd, 2, timeout) < 0) {
+			if (errno == EINTR)
+				continue;
+			(void) fprintf(stderr, "failed to poll (%s)\n",
+			    strerror(errno));
+			goto out;
+		}
+		if (pfd[1].revents & POLLIN) {
+			while ((len = read(snapd_pipe[0], buf,
+			    sizeof (buf))) > 0) {
+				if (memchr(buf, 'e', len) != NULL) {
+					sd.sd_stale = B_TRUE;
+					sd.sd_event = gethrtime();
+				}
+			}
+		}
+		if (snapd_quit)
+			break;
+		if (sd.sd_stale && gethrtime() - sd.sd_event >= SNAPD_SETTLE)
+			(void) snapd_refresh(&sd, NULL);
+		if (pfd[0].revents & POLLIN) {
+			int cfd;
+
+			if ((cfd = accept(fd, NULL, NULL)) >= 0)
+				snapd_request(&sd, cfd);
+		}
+	}
+	status = 0;
+out:
+	if (fd >= 0) {
+		(void) close(fd);
+		(void) unlink(path);
+	}
+	if (shp != NULL)
+		sysevent_unbind_handle(shp);
+	if (sd.sd_thp != NULL) {
+		if (sd.sd_held)
+			topo_snap_release(sd.sd_thp);
+		topo_close(sd.sd_thp);
+	}
+	(void) close(snapd_pipe[0]);
+	(void) close(snapd_pipe[1]);
+	return (status);
+}
+
+/*
+ * Send the operations to the topo-indicator -D listening at path, and print
+ * its reply as if they had been carried out here.  Returns the exit status.
+ */
+int
+snapd_send(const char *path, const struct led_cb_arg *cbarg,
+    boolean_t refresh)
+{
+	struct sockaddr_un sun;
+	struct led_op *op;
+	char *line = NULL;
+	size_t linesz = 0;
+	FILE *in = NULL, *out = NULL;
+	uint_t i;
+	int fd, wfd = -1, status = -1;
+
+	(void) memset(&sun, 0, sizeof (sun));
+	sun.sun_family = AF_UNIX;
+	if (strlcpy(sun.sun_path, path, sizeof (sun.sun_path)) >=
+	    sizeof (sun.sun_path)) {
+		(void) fprintf(stderr, "socket path too long: %s\n", path);
+		return (1);
+	}
+	for (i = 0; i < cbarg->lcb_nops; i++) {
+		if (strpbrk(cbarg->lcb_ops[i].lo_fmri, " \t\n") != NULL) {
+			(void) fprintf(stderr, "patterns sent with -S can't "
+			    "contain white space: %s\n",
+			    cbarg->lcb_ops[i].lo_fmri);
+			return (2);
+		}
+	}
+
+	if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+		(void) fprintf(stderr, "failed to create socket (%s)\n",
+		    strerror(errno));
+		return (1);
+	}
+	if (connect(fd, (struct sockaddr *)&sun, sizeof (sun)) != 0) {
+		(void) fprintf(stderr, "failed to connect to %s (%s)\n", path,
+		    strerror(errno));
+		(void) close(fd);
+		return (1);
+	}
+	if ((in = fdopen(fd, "r")) == NULL ||
+	    (wfd = dup(fd)) < 0 || (out = fdopen(wfd, "w")) == NULL) {
+		(void) fprintf(stderr, "failed to allocate memory\n");
+		if (wfd >= 0)
+			(void) close(wfd);
+		goto out;
+	}
+
+	if (refresh)
+		(void) fprintf(out, "refresh\n");
+	for (i = 0; i < cbarg->lcb_nops; i++) {
+		op = &cbarg->lcb_ops[i];
+		if (op->lo_ledmode == LO_QUERY) {
+			(void) fprintf(out, "query %s\n", op->lo_fmri);
+		} else {
+			(void) fprintf(out, "led %s %s %s\n", op->lo_fmri,
+			    op->lo_ledtypestr, op->lo_ledmodestr);
+		}
+	}
+	if (fflush(out) != 0 || shutdown(fd, SHUT_WR) != 0) {
+		(void) fprintf(stderr, "failed to send request to %s (%s)\n",
+		    path, strerror(errno));
+		goto out;
+	}
+
+	while (getline(&line, &linesz, in) >= 0) {
+		if (strncmp(line, "1 ", 2) == 0) {
+			(void) fputs(line + 2, stdout);
+		} else if (strncmp(line, "2 ", 2) == 0) {
+			(void) fputs(line + 2, stderr);
+		} else if (sscanf(line, "exit %d", &status) == 1) {
+			break;
+		}
+	}
+	if (status < 0) {
+		(void) fprintf(stderr, "no reply from %s\n", path);
+		status = 1;
+	}
+out:
+	if (status < 0)
+		status = 1;
+	if (out != NULL)
+		(void) fclose(out);
+	if (in != NULL)
+		(void) fclose(in);
+	else
+		(void) close(fd);
+	free(line);
+	return (status);
+}
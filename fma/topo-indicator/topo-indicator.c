@@ -7,167 +7,524 @@
  */
 #include <stdio.h>
 #include <stdlib.h>
-#include <fnmatch.h>
+#include <stdarg.h>
+#include <errno.h>
 #include <string.h>
+#include <unistd.h>
 #include <fm/libtopo.h>
 #include <fm/topo_list.h>
 
+#include "topo-indicator.h"
+
 static const char *pname;
-static const char optstr[] = "m:R:t:";
+static const char optstr[] = "D:f:m:Q:rR:S:t:";
 
 static void
 usage()
 {
-	(void) fprintf(stderr, "usage: %s [-R root] -m <get|on|off> "
-	    "-t <locate|service|ok2rm> <FMRI>\n\n", pname);
+	(void) fprintf(stderr, "usage: %s [-R root | -S socket] "
+	    "-m <get|on|off> -t <locate|service|ok2rm> <FMRI>\n"
+	    "       %s [-R root | -S socket [-r]] [-f file] [-Q FMRI]...\n"
+	    "           [<FMRI> <type> <mode>]...\n"
+	    "       %s [-R root] -D socket\n\n"
+	    "Each operation is applied to the indicators of every node whose "
+	    "FMRI matches\nthe pattern given for it.  With -f, operations "
+	    "are also read from file (or\nstdin, if it's -), one per line.  "
+	    "All of them are carried out during a single\nwalk of a single "
+	    "topology snapshot, in the order they're given for each node.\n"
+	    "-Q prints the FMRIs of the nodes that match a pattern.\n\n"
+	    "Patterns are matched one \"name=instance\" pair at a time.  "
+	    "\"*<pair>/<pair>\"\nmatches nodes whose path ends with those "
+	    "pairs, and \"hc://*/<pair>/<pair>\"\nonly nodes whose whole "
+	    "path matches.  If every pattern is of the second form,\nparts "
+	    "of the tree that can't match are skipped.\n\n"
+	    "With -D, a snapshot is held and operations sent with -S are "
+	    "carried out on it.\nIt's taken again after a device is added or "
+	    "removed, or when -r asks for it.\n\n",
+	    pname, pname, pname);
 }
 
-struct led_cb_arg {
-	char *lcb_fmri;
-	topo_led_type_t lcb_ledtype;
-	char *lcb_ledtypestr;
-	int lcb_ledmode;
+static const struct {
+	const char *lt_name;
+	topo_led_type_t lt_type;
+} ledtypes[] = {
+	{ "locate", TOPO_LED_TYPE_LOCATE },
+	{ "service", TOPO_LED_TYPE_SERVICE },
+	{ "ok2rm", TOPO_LED_TYPE_OK2RM }
 };
 
+static void
+ti_vprintf(struct led_cb_arg *cbarg, int fd, const char *fmt, va_list ap)
+{
+	if (cbarg != NULL && cbarg->lcb_reply != NULL) {
+		(void) fprintf(cbarg->lcb_reply, "%d ", fd);
+		(void) vfprintf(cbarg->lcb_reply, fmt, ap);
+	} else {
+		(void) vfprintf(fd == STDOUT_FILENO ? stdout : stderr, fmt, ap);
+	}
+}
+
+/*
+ * Print a line of output, or an error message, for an operation.  When the
+ * operation was sent with -S, it goes back to the client instead.
+ */
+void
+ti_out(struct led_cb_arg *cbarg, const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	ti_vprintf(cbarg, STDOUT_FILENO, fmt, ap);
+	va_end(ap);
+}
+
+void
+ti_err(struct led_cb_arg *cbarg, const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	ti_vprintf(cbarg, STDERR_FILENO, fmt, ap);
+	va_end(ap);
+}
+
+static struct led_op *
+new_op(struct led_cb_arg *cbarg, const char *fmri)
+{
+	struct led_op *op;
+
+	if ((op = realloc(cbarg->lcb_ops, (cbarg->lcb_nops + 1) *
+	    sizeof (struct led_op))) == NULL) {
+		ti_err(cbarg, "failed to allocate memory\n");
+		return (NULL);
+	}
+	cbarg->lcb_ops = op;
+	op += cbarg->lcb_nops;
+	(void) memset(op, 0, sizeof (struct led_op));
+	if ((op->lo_fmri = strdup(fmri)) == NULL) {
+		ti_err(cbarg, "failed to allocate memory\n");
+		return (NULL);
+	}
+	return (op);
+}
+
+/*
+ * Add an operation to the list.  fmri is copied.
+ */
+int
+add_op(struct led_cb_arg *cbarg, const char *fmri, const char *type,
+    const char *mode)
+{
+	struct led_op *op;
+	uint_t i;
+
+	for (i = 0; i < sizeof (ledtypes) / sizeof (ledtypes[0]); i++) {
+		if (strcmp(type, ledtypes[i].lt_name) == 0)
+			break;
+	}
+	if (i == sizeof (ledtypes) / sizeof (ledtypes[0])) {
+		ti_err(cbarg, "invalid LED type: %s\n", type);
+		return (-1);
+	}
+	if (strcmp(mode, "get") != 0 && strcmp(mode, "on") != 0 &&
+	    strcmp(mode, "off") != 0) {
+		ti_err(cbarg, "invalid mode: %s\n", mode);
+		return (-1);
+	}
+
+	if ((op = new_op(cbarg, fmri)) == NULL)
+		return (-1);
+	op->lo_ledtype = ledtypes[i].lt_type;
+	op->lo_ledtypestr = ledtypes[i].lt_name;
+	if (strcmp(mode, "get") == 0) {
+		op->lo_ledmode = LO_GET;
+		op->lo_ledmodestr = "get";
+	} else if (strcmp(mode, "on") == 0) {
+		op->lo_ledmode = TOPO_LED_STATE_ON;
+		op->lo_ledmodestr = "on";
+	} else {
+		op->lo_ledmode = TOPO_LED_STATE_OFF;
+		op->lo_ledmodestr = "off";
+	}
+	cbarg->lcb_nops++;
+	return (0);
+}
+
+/*
+ * Add a query for the nodes whose FMRIs match a pattern.
+ */
+int
+add_query(struct led_cb_arg *cbarg, const char *fmri)
+{
+	struct led_op *op;
+
+	if ((op = new_op(cbarg, fmri)) == NULL)
+		return (-1);
+	op->lo_ledmode = LO_QUERY;
+	op->lo_ledmodestr = "query";
+	cbarg->lcb_nops++;
+	return (0);
+}
+
+void
+free_ops(struct led_cb_arg *cbarg)
+{
+	uint_t i;
+
+	for (i = 0; i < cbarg->lcb_nops; i++)
+		free(cbarg->lcb_ops[i].lo_fmri);
+	free(cbarg->lcb_ops);
+	hcm_destroy(cbarg->lcb_hcm);
+	free(cbarg->lcb_res);
+	cbarg->lcb_ops = NULL;
+	cbarg->lcb_nops = 0;
+	cbarg->lcb_hcm = NULL;
+	cbarg->lcb_res = NULL;
+}
+
+/*
+ * Read "<FMRI> <type> <mode>" operations, one per line, skipping blank lines
+ * and comments.
+ */
 static int
-ledcb(topo_hdl_t *thp, tnode_t *node, void *arg)
+read_ops(struct led_cb_arg *cbarg, const char *file)
+{
+	char *line = NULL, *fields[4], *p, *last;
+	size_t linesz = 0;
+	uint_t lineno = 0, n;
+	FILE *fp;
+	int status = 0;
+
+	if (strcmp(file, "-") == 0) {
+		fp = stdin;
+	} else if ((fp = fopen(file, "r")) == NULL) {
+		(void) fprintf(stderr, "failed to open %s (%s)\n", file,
+		    strerror(errno));
+		return (-1);
+	}
+
+	while (getline(&line, &linesz, fp) >= 0) {
+		lineno++;
+		n = 0;
+		for (p = strtok_r(line, " \t\n", &last); p != NULL && n < 4;
+		    p = strtok_r(NULL, " \t\n", &last))
+			fields[n++] = p;
+		if (n == 0 || fields[0][0] == '#')
+			continue;
+		if (n != 3) {
+			(void) fprintf(stderr, "%s: line %u: expected "
+			    "\"<FMRI> <type> <mode>\"\n", file, lineno);
+			status = -1;
+			break;
+		}
+		if (add_op(cbarg, fields[0], fields[1], fields[2]) != 0) {
+			(void) fprintf(stderr, "%s: line %u: invalid "
+			    "operation\n", file, lineno);
+			status = -1;
+			break;
+		}
+	}
+	if (status == 0 && ferror(fp)) {
+		(void) fprintf(stderr, "failed to read %s (%s)\n", file,
+		    strerror(errno));
+		status = -1;
+	}
+	free(line);
+	if (fp != stdin)
+		(void) fclose(fp);
+	return (status);
+}
+
+static void
+ledop(tnode_t *node, struct led_cb_arg *cbarg, struct led_op *op)
+{
+	topo_led_state_t currmode;
+	int err;
+
+	op->lo_nfound++;
+	if (op->lo_ledmode == LO_GET) {
+		if (topo_prop_get_uint32(node, TOPO_PGROUP_FACILITY,
+		    TOPO_LED_MODE, &currmode, &err) != 0) {
+			ti_err(cbarg, "failed to get LED mode: %s\n",
+			    topo_strerror(err));
+			cbarg->lcb_nerrs++;
+			return;
+		}
+		ti_out(cbarg, "%s LED mode is %s\n", op->lo_ledtypestr,
+		    currmode ? "ON" : "OFF");
+	} else {
+		/* set op */
+		if (topo_prop_set_uint32(node, TOPO_PGROUP_FACILITY,
+		    TOPO_LED_MODE, TOPO_PROP_MUTABLE, op->lo_ledmode,
+		    &err) != 0) {
+			ti_err(cbarg, "failed to set LED mode: %s\n",
+			    topo_strerror(err));
+			cbarg->lcb_nerrs++;
+			return;
+		}
+		ti_out(cbarg, "%s LED mode set to %s\n", op->lo_ledtypestr,
+		    op->lo_ledmode ? "ON" : "OFF");
+	}
+}
+
+static int
+node_fmristr(topo_hdl_t *thp, tnode_t *node, struct led_cb_arg *cbarg,
+    char **fmristrp)
 {
 	nvlist_t *fmri = NULL;
-	char *fmristr = NULL;
 	int err;
-	struct led_cb_arg *cbarg = (struct led_cb_arg *)arg;
-	topo_faclist_t faclist, *lp;
-	topo_led_state_t currmode;
 
 	if (topo_node_resource(node, &fmri, &err) != 0 ||
-	    topo_fmri_nvl2str(thp, fmri, &fmristr, &err) != 0) {
-		(void) fprintf(stderr, "failed to get FMRI of node: %s",
+	    topo_fmri_nvl2str(thp, fmri, fmristrp, &err) != 0) {
+		ti_err(cbarg, "failed to get FMRI of node: %s\n",
 		    topo_strerror(err));
 		nvlist_free(fmri);
-		return (TOPO_WALK_ERR);
+		return (-1);
 	}
 	nvlist_free(fmri);
+	return (0);
+}
+
+static int
+ledcb(topo_hdl_t *thp, tnode_t *node, void *arg)
+{
+	char *fmristr = NULL;
+	int err;
+	struct led_cb_arg *cbarg = (struct led_cb_arg *)arg;
+	struct led_op *op;
+	topo_faclist_t faclist, *lp, *next;
+	boolean_t found = B_FALSE;
+	uint_t i;
+
+	switch (hcm_node(cbarg->lcb_hcm, node, cbarg->lcb_res)) {
+	case HCM_PRUNE:
+		return (TOPO_WALK_TERMINATE);
+	case -1:
+		ti_err(cbarg, "failed to allocate memory\n");
+		return (TOPO_WALK_ERR);
+	}
 
 	/*
-	 * Check if this is the node matches the pattern we're looking for
-	 * and bail, if not.
+	 * Carry out every operation whose pattern matches this node, on each
+	 * indicator of the operation's type that the node has.  The node's
+	 * FMRI string is only needed, and so only built, if one does.  A
+	 * query only needs the node to match.
 	 */
-	if (fnmatch(cbarg->lcb_fmri, fmristr, 0) != 0) {
+	for (i = 0; i < cbarg->lcb_nops; i++) {
+		op = &cbarg->lcb_ops[i];
+		if (cbarg->lcb_res[i] == HCM_NOMATCH)
+			continue;
+		if (fmristr == NULL &&
+		    node_fmristr(thp, node, cbarg, &fmristr) != 0)
+			return (TOPO_WALK_ERR);
+		if (cbarg->lcb_res[i] == HCM_CHECK &&
+		    !hcm_check(cbarg->lcb_hcm, i, fmristr))
+			continue;
+		if (!found) {
+			ti_out(cbarg, "Found node: %s\n", fmristr);
+			found = B_TRUE;
+		}
+		if (op->lo_ledmode == LO_QUERY) {
+			op->lo_nfound++;
+			continue;
+		}
+		if (topo_node_facility(thp, node, TOPO_FAC_TYPE_INDICATOR,
+		    op->lo_ledtype, &faclist, &err) != 0)
+			continue;
+		for (lp = topo_list_next(&faclist.tf_list); lp != NULL;
+		    lp = topo_list_next(lp))
+			ledop(lp->tf_node, cbarg, op);
+		for (lp = topo_list_next(&faclist.tf_list); lp != NULL;
+		    lp = next) {
+			next = topo_list_next(lp);
+			topo_hdl_free(thp, lp, sizeof (topo_faclist_t));
+		}
+	}
+	if (fmristr != NULL)
 		topo_hdl_strfree(thp, fmristr);
-		return (TOPO_WALK_NEXT);
+	return (TOPO_WALK_NEXT);
+}
+
+/*
+ * Carry out the operations during a single walk of thp's snapshot.  Returns
+ * the exit status: 0 if they all succeeded, 1 otherwise.  lo_nfound and
+ * lcb_nerrs are left as they are, so this can only be done once for a list
+ * of operations.
+ */
+int
+run_ops(topo_hdl_t *thp, struct led_cb_arg *cbarg)
+{
+	topo_walk_t *twp;
+	uint_t i;
+	int err;
+
+	if ((cbarg->lcb_hcm = hcm_create()) == NULL ||
+	    (cbarg->lcb_res = calloc(cbarg->lcb_nops, sizeof (uchar_t))) ==
+	    NULL) {
+		ti_err(cbarg, "failed to allocate memory\n");
+		return (1);
+	}
+	for (i = 0; i < cbarg->lcb_nops; i++) {
+		if (hcm_add(cbarg->lcb_hcm, cbarg->lcb_ops[i].lo_fmri) < 0) {
+			ti_err(cbarg, "failed to allocate memory\n");
+			return (1);
+		}
 	}
-	(void) printf("Found node: %s\n", fmristr);
-	topo_hdl_strfree(thp, fmristr);
+
+	if ((twp = topo_walk_init(thp, "hc", ledcb, cbarg, &err)) == NULL) {
+		ti_err(cbarg, "failed to init topo walker: %s\n",
+		    topo_strerror(err));
+		return (1);
+	}
+	if (topo_walk_step(twp, TOPO_WALK_CHILD) == TOPO_WALK_ERR) {
+		ti_err(cbarg, "failed to walk topology\n");
+		topo_walk_fini(twp);
+		return (1);
+	}
+	topo_walk_fini(twp);
 
 	/*
-	 * Ok, we found our node.  Now check if it has an indicator of the
-	 * correct type associated with it.  If not, bail out.
+	 * An operation that found nothing to act on is most likely a mistyped
+	 * pattern, or a bay that isn't there, so it's reported as a failure.
 	 */
-	if (topo_node_facility(thp, node, TOPO_FAC_TYPE_INDICATOR,
-	    cbarg->lcb_ledtype, &faclist, &err) != 0) {
-		return (TOPO_WALK_NEXT);
-	}
-
-	for (lp = topo_list_next(&faclist.tf_list); lp != NULL;
-	    lp = topo_list_next(lp)) {
-		if (cbarg->lcb_ledmode == -1) {
-			/* get op */
-			if (topo_prop_get_uint32(lp->tf_node,
-			    TOPO_PGROUP_FACILITY, TOPO_LED_MODE, &currmode,
-			    &err) != 0) {
-				(void) fprintf(stderr, "failed to get LED "
-				    "mode: %s\n", topo_strerror(err));
-			}
-			(void) printf("%s LED mode is %s\n",
-			    cbarg->lcb_ledtypestr,
-			    currmode ? "ON" : "OFF");
+	for (i = 0; i < cbarg->lcb_nops; i++) {
+		if (cbarg->lcb_ops[i].lo_nfound != 0)
+			continue;
+		if (cbarg->lcb_ops[i].lo_ledmode == LO_QUERY) {
+			ti_err(cbarg, "no nodes match %s\n",
+			    cbarg->lcb_ops[i].lo_fmri);
 		} else {
-			/* set op */
-			if (topo_prop_set_uint32(lp->tf_node,
-			    TOPO_PGROUP_FACILITY, TOPO_LED_MODE,
-			    TOPO_PROP_MUTABLE, cbarg->lcb_ledmode,
-			    &err) != 0) {
-				(void) fprintf(stderr, "failed to set LED "
-				    "mode: %s\n", topo_strerror(err));
-
-			}
-			(void) printf("%s LED mode set to %s\n",
-			    cbarg->lcb_ledtypestr,
-			    cbarg->lcb_ledmode ? "ON" : "OFF");
+			ti_err(cbarg, "no %s indicator found for %s\n",
+			    cbarg->lcb_ops[i].lo_ledtypestr,
+			    cbarg->lcb_ops[i].lo_fmri);
 		}
+		cbarg->lcb_nerrs++;
 	}
+	return (cbarg->lcb_nerrs == 0 ? 0 : 1);
 }
 
 int
 main(int argc, char *argv[])
 {
-	topo_hdl_t *thp;
-	topo_walk_t *twp;
+	topo_hdl_t *thp = NULL;
 	struct led_cb_arg cbarg = { 0 };
-	char c, *root = "/", *mode = NULL;
+	char c, *root = NULL, *mode = NULL, *type = NULL, *file = NULL;
+	char *serve = NULL, *sock = NULL;
+	char **operands, **queries;
+	boolean_t refresh = B_FALSE;
+	uint_t i, noperands = 0, nqueries = 0;
 	int err, status = 1;
 
 	pname = argv[0];
 
+	if ((operands = calloc(argc, sizeof (char *))) == NULL ||
+	    (queries = calloc(argc, sizeof (char *))) == NULL) {
+		(void) fprintf(stderr, "failed to allocate memory\n");
+		return (1);
+	}
 	while (optind < argc) {
 		while ((c = getopt(argc, argv, optstr)) != -1) {
 			switch (c) {
+			case 'D':
+				serve = optarg;
+				break;
+			case 'f':
+				file = optarg;
+				break;
 			case 'm':
 				mode = optarg;
 				break;
+			case 'Q':
+				queries[nqueries++] = optarg;
+				break;
+			case 'r':
+				refresh = B_TRUE;
+				break;
 			case 'R':
 				root = optarg;
 				break;
+			case 'S':
+				sock = optarg;
+				break;
 			case 't':
-				cbarg.lcb_ledtypestr = optarg;
+				type = optarg;
 				break;
 			default:
 				usage();
 				return (2);
 			}
 		}
-		if (optind < argc) {
-			if (cbarg.lcb_fmri != NULL) {
-				usage();
-				return (2);
-			} else {
-				cbarg.lcb_fmri = argv[optind++];
-			}
+		if (optind < argc)
+			operands[noperands++] = argv[optind++];
+	}
+
+	if (serve != NULL) {
+		if (sock != NULL || refresh || mode != NULL || type != NULL ||
+		    file != NULL || nqueries != 0 || noperands != 0) {
+			(void) fprintf(stderr, "-D only goes with -R\n");
+			usage();
+			return (2);
 		}
+		status = snapd_serve(root == NULL ? "/" : root, serve);
+		goto out;
 	}
-	if (cbarg.lcb_fmri == NULL || mode == NULL ||
-	    cbarg.lcb_ledtypestr == NULL) {
-		(void) fprintf(stderr, "-f/-m/-t options are required\n");
+	if (sock != NULL && root != NULL) {
+		(void) fprintf(stderr, "-R and -S can't be used together\n");
 		usage();
 		return (2);
 	}
-
-	if (strcmp(cbarg.lcb_ledtypestr, "locate") == 0) {
-		cbarg.lcb_ledtype = TOPO_LED_TYPE_LOCATE;
-	} else if (strcmp(cbarg.lcb_ledtypestr, "service") == 0) {
-		cbarg.lcb_ledtype = TOPO_LED_TYPE_SERVICE;
-	} else if (strcmp(cbarg.lcb_ledtypestr, "ok2rm") == 0) {
-		cbarg.lcb_ledtype = TOPO_LED_TYPE_OK2RM;
-	} else {
-		(void) fprintf(stderr, "invalid LED type: %s\n",
-		    cbarg.lcb_ledtypestr);
+	if (refresh && sock == NULL) {
+		(void) fprintf(stderr, "-r requires -S\n");
 		usage();
 		return (2);
 	}
 
-	if (strcmp(mode, "get") == 0) {
-		cbarg.lcb_ledmode = -1;
-	} else if (strcmp(mode, "on") == 0) {
-		cbarg.lcb_ledmode = TOPO_LED_STATE_ON;
-	} else if (strcmp(mode, "off") == 0) {
-		cbarg.lcb_ledmode = TOPO_LED_STATE_OFF;
+	if (mode != NULL || type != NULL) {
+		if (mode == NULL || type == NULL || file != NULL ||
+		    noperands != 1) {
+			(void) fprintf(stderr, "-m and -t require each other "
+			    "and a single FMRI\n");
+			usage();
+			return (2);
+		}
+		if (add_op(&cbarg, operands[0], type, mode) != 0) {
+			usage();
+			return (2);
+		}
 	} else {
-		(void) fprintf(stderr, "invalid mode: %s\n", mode);
-		usage();
+		if (noperands % 3 != 0 || (noperands == 0 && file == NULL &&
+		    nqueries == 0 && !refresh)) {
+			(void) fprintf(stderr, "operations are "
+			    "\"<FMRI> <type> <mode>\"\n");
+			usage();
+			return (2);
+		}
+		for (i = 0; i < noperands; i += 3) {
+			if (add_op(&cbarg, operands[i], operands[i + 1],
+			    operands[i + 2]) != 0) {
+				usage();
+				return (2);
+			}
+		}
+		if (file != NULL && read_ops(&cbarg, file) != 0)
+			return (2);
+	}
+	for (i = 0; i < nqueries; i++) {
+		if (add_query(&cbarg, queries[i]) != 0)
+			return (2);
+	}
+	if (cbarg.lcb_nops == 0 && !refresh) {
+		(void) fprintf(stderr, "no operations given\n");
 		return (2);
 	}
 
-	if ((thp = topo_open(TOPO_VERSION, root, &err)) == NULL) {
+	if (sock != NULL) {
+		status = snapd_send(sock, &cbarg, refresh);
+		goto out;
+	}
+
+	if ((thp = topo_open(TOPO_VERSION, root == NULL ? "/" : root,
+	    &err)) == NULL) {
 		(void) fprintf(stderr, "failed to get topo handle: %s\n",
 		    topo_strerror(err));
 		goto out;
@@ -177,23 +534,14 @@ main(int argc, char *argv[])
 		    topo_strerror(err));
 		goto out;
 	}
-	if ((twp = topo_walk_init(thp, "hc", ledcb, &cbarg, &err)) == NULL) {
-		(void) fprintf(stderr, "failed to init topo walker: %s\n",
-		    topo_strerror(err));
-		goto out;
-	}
-	if (topo_walk_step(twp, TOPO_WALK_CHILD) == TOPO_WALK_ERR) {
-		(void) fprintf(stderr, "failed to walk topology\n");
-		topo_walk_fini(twp);
-		goto out;
-	}
-	topo_walk_fini(twp);
-
-	status = 0;
+	status = run_ops(thp, &cbarg);
 out:
 	if (thp != NULL)  {
 		topo_snap_release(thp);
 		topo_close(thp);
 	}
+	free_ops(&cbarg);
+	free(operands);
+	free(queries);
 	return (status);
 }
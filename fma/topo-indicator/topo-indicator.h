@@ -0,0 +1,67 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 2026 MNX Cloud, Inc.
+ */
+
+#ifndef _TOPO_INDICATOR_H
+#define	_TOPO_INDICATOR_H
+
+/*
+ * Operations on indicators, and queries for nodes, shared between running
+ * them against a snapshot of our own (topo-indicator.c) and having a
+ * resident topo-indicator -D run them against its snapshot (snapd.c).
+ */
+
+#include <stdio.h>
+#include <sys/types.h>
+#include <fm/libtopo.h>
+
+#include "hcmatch.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/*
+ * Values of lo_ledmode other than the TOPO_LED_STATE_* ones.
+ */
+#define	LO_GET		-1	/* print the indicator's mode */
+#define	LO_QUERY	-2	/* print the matching nodes' FMRIs */
+
+struct led_op {
+	char *lo_fmri;
+	topo_led_type_t lo_ledtype;
+	const char *lo_ledtypestr;	/* NULL for LO_QUERY */
+	const char *lo_ledmodestr;
+	int lo_ledmode;
+	uint_t lo_nfound;	/* number of indicators (or nodes) found */
+};
+
+struct led_cb_arg {
+	struct led_op *lcb_ops;
+	uint_t lcb_nops;
+	uint_t lcb_nerrs;	/* number of operations that failed */
+	hcm_t *lcb_hcm;		/* compiled patterns of lcb_ops */
+	uchar_t *lcb_res;	/* each one's result for the current node */
+	FILE *lcb_reply;	/* if not NULL, where output goes, for -S */
+};
+
+extern int add_op(struct led_cb_arg *, const char *, const char *,
+    const char *);
+extern int add_query(struct led_cb_arg *, const char *);
+extern void free_ops(struct led_cb_arg *);
+extern int run_ops(topo_hdl_t *, struct led_cb_arg *);
+extern void ti_out(struct led_cb_arg *, const char *, ...);
+extern void ti_err(struct led_cb_arg *, const char *, ...);
+
+extern int snapd_serve(const char *, const char *);
+extern int snapd_send(const char *, const struct led_cb_arg *, boolean_t);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _TOPO_INDICATOR_H */
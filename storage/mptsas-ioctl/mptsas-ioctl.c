@@ -9,35 +9,42 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <fcntl.h>
-#include <libnvpair.h>
 #include <string.h>
-#include <stropts.h>
+#include <strings.h>
 #include <unistd.h>
 #include <sys/types.h>
 
+#include "compat.h"
+#include "iocap.h"
 #include "mptsas_ioctl.h"
+#include "pnvl.h"
 
 #define	EXIT_USAGE	2
 
 static const char *pname;
-static const char optstr[] = "d:i:";
+static const char optstr[] = "C:d:i:P:";
 
 static void
 usage()
 {
-	(void) fprintf(stderr, "usage: %s -d <devctl devpath> -i <ioctl>\n\n"
+	(void) fprintf(stderr, "usage: %s [-C file | -P file] "
+	    "-d <devctl devpath> -i <ioctl>\n\n"
 	    "where \'ioctl\' can be:\n"
-	    "getadapterdata\ngetdiskinfo\ngetpciinfo\ngetconninfo\n\n", pname);
+	    "getadapterdata\ngetdiskinfo\ngetpciinfo\ngetconninfo\n\n"
+	    "-C records every ioctl issued, and its output, to a capture file, "
+	    "and -P\nplays one back in place of the device.\n\n", pname);
 }
 
 static int
-do_getconninfo(int fd)
+do_getconninfo(iocap_t *ic)
 {
 	mptsas_get_connector_info_t ioc = { 0 };
-	nvlist_t *nvl = NULL;
+	pnvl_t nvl;
+	int err;
 	uint_t nphys;
 
-	if (ioctl(fd, MPTIOCTL_GET_CONNECTOR_INFO, &ioc) < 0) {
+	if (iocap_ioctl(ic, MPTIOCTL_GET_CONNECTOR_INFO, &ioc, sizeof (ioc),
+	    IOCAP_BUF(ioc.mci_buf, ioc.mci_bufsz)) < 0) {
 		(void) fprintf(stderr, "MPTIOCTL_GET_CONNECTOR_INFO ioctl "
 		    "failed (%s)\n", strerror(errno));
 		return (-1);
@@ -47,32 +54,36 @@ do_getconninfo(int fd)
 	if ((ioc.mci_buf = malloc(ioc.mci_bufsz)) == NULL)
 		return (-1);
 
-	if (ioctl(fd, MPTIOCTL_GET_CONNECTOR_INFO, &ioc) < 0) {
+	if (iocap_ioctl(ic, MPTIOCTL_GET_CONNECTOR_INFO, &ioc, sizeof (ioc),
+	    IOCAP_BUF(ioc.mci_buf, ioc.mci_bufsz)) < 0) {
 		(void) fprintf(stderr, "MPTIOCTL_GET_CONNECTOR_INFO ioctl "
 		    "failed (%s)\n", strerror(errno));
 		free(ioc.mci_buf);
 		return (-1);
 	}
 
-	if (nvlist_unpack(ioc.mci_buf, ioc.mci_bufsz, &nvl,
-	    NV_ENCODE_NATIVE) != 0) {
-		(void) fprintf(stderr, "failed to unpack nvlist");
+	/*
+	 * Print the packed nvlist where it lies rather than unpacking it.
+	 */
+	if ((err = pnvl_init(&nvl, ioc.mci_buf, ioc.mci_bufsz)) != 0 ||
+	    (err = pnvl_print(stdout, &nvl)) != 0) {
+		(void) fprintf(stderr, "failed to decode nvlist (%s)\n",
+		    strerror(err));
 		free(ioc.mci_buf);
 		return (-1);
 	}
 	free(ioc.mci_buf);
 
-	nvlist_print(stdout, nvl);
-
 	return (0);
 }
 
 static int
-do_getdiskinfo(int fd)
+do_getdiskinfo(iocap_t *ic)
 {
 	mptsas_get_disk_info_t ioc = { 0 };
 
-	if (ioctl(fd, MPTIOCTL_GET_DISK_INFO, &ioc) < 0) {
+	if (iocap_ioctl(ic, MPTIOCTL_GET_DISK_INFO, &ioc, sizeof (ioc),
+	    IOCAP_BUF(ioc.PtrDiskInfoArray, ioc.DiskInfoArraySize)) < 0) {
 		(void) fprintf(stderr, "MPTIOCTL_GET_DISK_INFO ioctl "
 		    "failed (%s)\n", strerror(errno));
 		return (-1);
@@ -83,7 +94,8 @@ do_getdiskinfo(int fd)
 	if ((ioc.PtrDiskInfoArray = malloc(ioc.DiskInfoArraySize)) == NULL)
 		return (-1);
 
-	if (ioctl(fd, MPTIOCTL_GET_DISK_INFO, &ioc) < 0) {
+	if (iocap_ioctl(ic, MPTIOCTL_GET_DISK_INFO, &ioc, sizeof (ioc),
+	    IOCAP_BUF(ioc.PtrDiskInfoArray, ioc.DiskInfoArraySize)) < 0) {
 		(void) fprintf(stderr, "MPTIOCTL_DISK_INFO ioctl "
 		    "failed (%s)\n", strerror(errno));
 		free(ioc.PtrDiskInfoArray);
@@ -106,13 +118,14 @@ do_getdiskinfo(int fd)
 }
 
 static int
-do_getadapter(int fd)
+do_getadapter(iocap_t *ic)
 {
 	mptsas_adapter_data_t ioc = { 0 };
 	char *type4 = "SAS-2", *type6 = "SAS-3", *typeX = "Unknown", *type;
 	char driver_ver[33];
 
-	if (ioctl(fd, MPTIOCTL_GET_ADAPTER_DATA, &ioc) < 0) {
+	if (iocap_ioctl(ic, MPTIOCTL_GET_ADAPTER_DATA, &ioc, sizeof (ioc),
+	    IOCAP_NOBUF) < 0) {
 		(void) fprintf(stderr, "MPTIOCTL_GET_ADAPTER_DATA ioctl "
 		    "failed (%s)\n", strerror(errno));
 		return (-1);
@@ -145,11 +158,12 @@ do_getadapter(int fd)
 }
 
 static int
-do_getpciinfo(int fd)
+do_getpciinfo(iocap_t *ic)
 {
 	mptsas_pci_info_t ioc = { 0 };
 
-	if (ioctl(fd, MPTIOCTL_GET_PCI_INFO, &ioc) < 0) {
+	if (iocap_ioctl(ic, MPTIOCTL_GET_PCI_INFO, &ioc, sizeof (ioc),
+	    IOCAP_NOBUF) < 0) {
 		(void) fprintf(stderr, "MPTIOCTL_GET_ADAPTER_DATA ioctl "
 		    "failed (%s)\n", strerror(errno));
 		return (-1);
@@ -166,19 +180,26 @@ do_getpciinfo(int fd)
 int
 main(int argc, char **argv)
 {
-	char c, *ioc = NULL, *devpath = NULL;
-	int cmd, fd, ret;
+	char c, *ioc = NULL, *devpath = NULL, *capout = NULL, *capin = NULL;
+	iocap_t *ic;
+	int cmd, ret;
 
 	pname = argv[0];
 	while (optind < argc) {
 		while ((c = getopt(argc, argv, optstr)) != -1) {
 			switch (c) {
+			case 'C':
+				capout = optarg;
+				break;
 			case 'd':
 				devpath = optarg;
 				break;
 			case 'i':
 				ioc = optarg;
 				break;
+			case 'P':
+				capin = optarg;
+				break;
 			default:
 				usage();
 				return (EXIT_USAGE);
@@ -191,6 +212,11 @@ main(int argc, char **argv)
 		usage();
 		return (EXIT_USAGE);
 	}
+	if (capout != NULL && capin != NULL) {
+		(void) fprintf(stderr, "-C and -P are mutually exclusive\n");
+		usage();
+		return (EXIT_USAGE);
+	}
 
 	if (strcasecmp(ioc, "getconninfo") == 0) {
 		cmd = MPTIOCTL_GET_CONNECTOR_INFO;
@@ -206,31 +232,42 @@ main(int argc, char **argv)
 		return (EXIT_USAGE);
 	}
 
-	if ((fd = open(devpath, O_RDONLY)) < 0) {
-		(void) fprintf(stderr, "failed to open %s (%s)\n", devpath,
-		    strerror(errno));
+#ifdef	IOCAP_PLAYBACK_ONLY
+	if (capin == NULL) {
+		(void) fprintf(stderr, "this build can only play captures "
+		    "back, with -P\n");
+		usage();
+		return (EXIT_USAGE);
+	}
+#endif
+	if ((ic = iocap_open(devpath, O_RDONLY, capout, capin)) == NULL) {
+		(void) fprintf(stderr, "failed to open %s (%s)\n",
+		    capin != NULL ? capin : devpath, strerror(errno));
 		return (EXIT_FAILURE);
 	}
 
 	switch (cmd) {
 	case MPTIOCTL_GET_CONNECTOR_INFO:
-		ret = do_getconninfo(fd);
+		ret = do_getconninfo(ic);
 		break;
 	case MPTIOCTL_GET_ADAPTER_DATA:
-		ret = do_getadapter(fd);
+		ret = do_getadapter(ic);
 		break;
 	case MPTIOCTL_GET_DISK_INFO:
-		ret = do_getdiskinfo(fd);
+		ret = do_getdiskinfo(ic);
 		break;
 	case MPTIOCTL_GET_PCI_INFO:
-		ret = do_getpciinfo(fd);
+		ret = do_getpciinfo(ic);
 		break;
 	default:
 		break;
 	}
 
 out:
-	(void) close(fd);
+	if (iocap_close(ic) != 0) {
+		(void) fprintf(stderr, "failed to write %s (%s)\n", capout,
+		    strerror(errno));
+	}
 
 	return ((ret < 0) ? EXIT_SUCCESS : EXIT_FAILURE);
 }